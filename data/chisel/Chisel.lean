@@ -53,6 +53,7 @@ import Chisel.DSL.Expr
 import Chisel.Render.Expr
 import Chisel.Render.DML
 import Chisel.Render.DDL
+import Chisel.Render.Params
 
 -- Parser
 import Chisel.Parser
@@ -0,0 +1,112 @@
+/-
+  Chisel.Render.Params
+  Lift literals out of statements into positional parameters
+
+  Rendering a parameterized statement gives the same SQL text for every set
+  of values, so drivers can reuse one prepared statement and bind the
+  collected literals instead of re-parsing SQL with the values inlined.
+-/
+import Chisel.Render.DML
+
+namespace Chisel
+
+/-- Literals collected while parameterizing, in placeholder order -/
+abbrev ParamM := StateM (Array Literal)
+
+/-- Replace a literal with the next positional placeholder.
+    NULL stays inline so `IS NULL` style comparisons read naturally. -/
+private def liftLiteral : Literal → ParamM Expr
+  | .null => return .lit .null
+  | v => do
+    let params ← get
+    set (params.push v)
+    let n := params.size + 1
+    return .param (some s!"p{n}") (some n)
+
+mutual
+
+/-- Replace literals in an expression with placeholders, in render order -/
+partial def parameterizeExpr : Expr → ParamM Expr
+  | .lit v => liftLiteral v
+  | .binary op left right => return .binary op (← parameterizeExpr left) (← parameterizeExpr right)
+  | .unary op operand => return .unary op (← parameterizeExpr operand)
+  | .between expr lower upper =>
+    return .between (← parameterizeExpr expr) (← parameterizeExpr lower) (← parameterizeExpr upper)
+  | .inValues expr values => return .inValues (← parameterizeExpr expr) (← values.mapM parameterizeExpr)
+  | .notInValues expr values => return .notInValues (← parameterizeExpr expr) (← values.mapM parameterizeExpr)
+  | .inSubquery expr subq => return .inSubquery (← parameterizeExpr expr) (← parameterizeSelect subq)
+  | .notInSubquery expr subq => return .notInSubquery (← parameterizeExpr expr) (← parameterizeSelect subq)
+  | .exists_ subq => return .exists_ (← parameterizeSelect subq)
+  | .notExists subq => return .notExists (← parameterizeSelect subq)
+  | .case_ cases else_ => do
+    let cases ← cases.mapM fun (cond, result) => do
+      return (← parameterizeExpr cond, ← parameterizeExpr result)
+    return .case_ cases (← else_.mapM parameterizeExpr)
+  | .cast expr typeName => return .cast (← parameterizeExpr expr) typeName
+  | .func name args => return .func name (← args.mapM parameterizeExpr)
+  | .agg func expr distinct => return .agg func (← expr.mapM parameterizeExpr) distinct
+  | .subquery subq => return .subquery (← parameterizeSelect subq)
+  | e => return e
+
+/-- Parameterize FROM, WHERE and HAVING of a SELECT.
+    The select list keeps its literals so result column names do not change,
+    and GROUP BY / ORDER BY keep theirs because `ORDER BY 1` is a column
+    ordinal, not a value. -/
+partial def parameterizeSelect (stmt : SelectCore) : ParamM SelectCore := do
+  let from_ ← stmt.from_.mapM parameterizeTableRef
+  let where_ ← stmt.where_.mapM parameterizeExpr
+  let having ← stmt.having.mapM parameterizeExpr
+  return .mk stmt.distinct stmt.columns from_ where_ stmt.groupBy having stmt.orderBy stmt.limit stmt.offset
+
+/-- Parameterize join conditions and subqueries in a table reference -/
+partial def parameterizeTableRef : TableRef → ParamM TableRef
+  | .table name alias_ => return .table name alias_
+  | .join type left right on =>
+    return .join type (← parameterizeTableRef left) (← parameterizeTableRef right) (← on.mapM parameterizeExpr)
+  | .subquery select alias_ => return .subquery (← parameterizeSelect select) alias_
+
+end
+
+/-- Parameterize the VALUES rows (or the source SELECT) of an INSERT -/
+def parameterizeInsert (stmt : InsertStmt) : ParamM InsertStmt := do
+  match stmt.fromSelect with
+  | some sel => return { stmt with fromSelect := some (← parameterizeSelect sel) }
+  | none => return { stmt with values := ← stmt.values.mapM (·.mapM parameterizeExpr) }
+
+/-- Parameterize SET values, FROM and WHERE of an UPDATE -/
+def parameterizeUpdate (stmt : UpdateStmt) : ParamM UpdateStmt := do
+  let set ← stmt.set.mapM fun a => do return { a with value := ← parameterizeExpr a.value }
+  let from_ ← stmt.from_.mapM parameterizeTableRef
+  let where_ ← stmt.where_.mapM parameterizeExpr
+  return { stmt with set, from_, where_ }
+
+/-- Parameterize the WHERE clause of a DELETE -/
+def parameterizeDelete (stmt : DeleteStmt) : ParamM DeleteStmt := do
+  return { stmt with where_ := ← stmt.where_.mapM parameterizeExpr }
+
+/-- Render an expression with placeholders, returning the values to bind -/
+def renderExprParams (ctx : RenderContext) (expr : Expr) : String × Array Literal :=
+  let (expr, params) := Id.run ((parameterizeExpr expr).run #[])
+  (renderExpr ctx expr, params)
+
+/-- Render a SELECT with placeholders, returning the values to bind -/
+def renderSelectParams (ctx : RenderContext) (stmt : SelectStmt) : String × Array Literal :=
+  let (stmt, params) := Id.run ((parameterizeSelect stmt).run #[])
+  (renderSelect ctx stmt, params)
+
+/-- Render an INSERT with placeholders, returning the values to bind -/
+def renderInsertParams (ctx : RenderContext) (stmt : InsertStmt) : String × Array Literal :=
+  let (stmt, params) := Id.run ((parameterizeInsert stmt).run #[])
+  (renderInsert ctx stmt, params)
+
+/-- Render an UPDATE with placeholders, returning the values to bind -/
+def renderUpdateParams (ctx : RenderContext) (stmt : UpdateStmt) : String × Array Literal :=
+  let (stmt, params) := Id.run ((parameterizeUpdate stmt).run #[])
+  (renderUpdate ctx stmt, params)
+
+/-- Render a DELETE with placeholders, returning the values to bind -/
+def renderDeleteParams (ctx : RenderContext) (stmt : DeleteStmt) : String × Array Literal :=
+  let (stmt, params) := Id.run ((parameterizeDelete stmt).run #[])
+  (renderDelete ctx stmt, params)
+
+end Chisel
@@ -7,6 +7,7 @@ import ChiselTests.Expr
 import ChiselTests.Select
 import ChiselTests.DML
 import ChiselTests.DDL
+import ChiselTests.Params
 import ChiselTests.Parser
 
 open Crucible
@@ -0,0 +1,68 @@
+/-
+  Parameterized rendering tests
+-/
+import Chisel
+import Crucible
+
+namespace ChiselTests.Params
+
+open Crucible
+open Chisel
+
+testSuite "Chisel Parameterized Rendering"
+
+test "select literals become placeholders in order" := do
+  let query := SelectM.build do
+    select_ (col "name")
+    from_ "users"
+    where_ (col "age" .>= val 18)
+    where_ (col "name" .== str "O'Brien")
+  let (sql, params) := renderSelectParams {} query
+  sql ≡ "SELECT name FROM users WHERE ((age >= ?) AND (name = ?))"
+  params ≡ #[.int 18, .string "O'Brien"]
+
+test "same shape renders the same SQL for different values" := do
+  let byId (n : Int) := SelectM.build do
+    selectAll
+    from_ "users"
+    where_ (col "id" .== val n)
+  (renderSelectParams {} (byId 1)).1 ≡ (renderSelectParams {} (byId 2)).1
+
+test "null and order by ordinals stay inline" := do
+  let query := SelectM.build do
+    selectAll
+    from_ "users"
+    where_ (col "deleted_at" .== null)
+    orderBy1 (val 1) .asc
+  let (sql, params) := renderSelectParams {} query
+  sql ≡ "SELECT * FROM users WHERE (deleted_at = NULL) ORDER BY 1"
+  params.size ≡ 0
+
+test "insert values are bound row by row" := do
+  let stmt := insertInto "users"
+    |>.columns ["name", "age"]
+    |>.values [str "Alice", val 30]
+    |>.values [str "Bob", val 25]
+    |>.build
+  let (sql, params) := renderInsertParams {} stmt
+  sql ≡ "INSERT INTO users (name, age) VALUES (?, ?), (?, ?)"
+  params ≡ #[.string "Alice", .int 30, .string "Bob", .int 25]
+
+test "update binds set values before the where clause" := do
+  let stmt := update "users"
+    |>.set "age" (val 31)
+    |>.where_ (col "id" .== val 7)
+    |>.build
+  let (sql, params) := renderUpdateParams {} stmt
+  sql ≡ "UPDATE users SET age = ? WHERE (id = ?)"
+  params ≡ #[.int 31, .int 7]
+
+test "dollar style numbers placeholders" := do
+  let stmt := deleteFrom "users"
+    |>.where_ ((col "id" .== val 1) .|| (col "id" .== val 2))
+    |>.build
+  let (sql, params) := renderDeleteParams { paramStyle := .dollar } stmt
+  sql ≡ "DELETE FROM users WHERE ((id = $1) OR (id = $2))"
+  params.size ≡ 2
+
+end ChiselTests.Params
@@ -5,14 +5,17 @@ import Ledger.Core.EntityId
 import Ledger.Core.Attribute
 import Ledger.Core.Value
 import Ledger.Core.Datom
+import Ledger.Core.AttrTable
 
 -- Index types and implementations
+import Ledger.Index.BTree
 import Ledger.Index.Types
 import Ledger.Index.EAVT
 import Ledger.Index.AEVT
 import Ledger.Index.AVET
 import Ledger.Index.VAET
 import Ledger.Index.Manager
+import Ledger.Index.Stats
 
 -- Transaction types
 import Ledger.Tx.Types
@@ -33,7 +36,9 @@ import Ledger.Query.AST
 import Ledger.Query.Binding
 import Ledger.Query.Unify
 import Ledger.Query.IndexSelect
+import Ledger.Query.Planner
 import Ledger.Query.Executor
+import Ledger.Query.Compiled
 import Ledger.Query.Aggregates
 import Ledger.Query.Rules
 
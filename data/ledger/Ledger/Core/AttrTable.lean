@@ -0,0 +1,140 @@
+/-
+  Ledger.Core.AttrTable
+
+  Attribute interning.
+  Every attribute a database has seen gets a dense `UInt32` id. Index keys
+  carry the id next to the name. EAVT orders keys by name, which fixes the
+  attribute order within an entity; AEVT, AVET and VAET order them by id,
+  so their inserts and seeks compare integers.
+-/
+
+import Std.Data.HashMap
+import Ledger.Core.Attribute
+
+namespace Ledger
+
+/-- Dense id of an interned attribute. -/
+structure AttrId where
+  val : UInt32
+  deriving Repr, DecidableEq, Hashable, Inhabited
+
+namespace AttrId
+
+instance : Ord AttrId where
+  compare a b := compare a.val b.val
+
+instance : ToString AttrId where
+  toString id := s!"#{id.val}"
+
+/-- Id of an attribute looked up without a table. Never assigned by `intern`. -/
+def unresolved : AttrId := ⟨0xFFFFFFFF⟩
+
+/-- Whether the id was assigned by a table. -/
+def isResolved (id : AttrId) : Bool := id != unresolved
+
+end AttrId
+
+/-- An attribute as stored in index keys: its interned id and its name.
+    `compare` and `==` go by name alone, so they agree for keys from any
+    tables. `compareById` is the faster order for keys of one table. -/
+structure AttrKey where
+  id : AttrId
+  attr : Attribute
+  deriving Repr, Inhabited
+
+namespace AttrKey
+
+/-- Key for an attribute with no table at hand. Compares by name. -/
+def ofAttr (a : Attribute) : AttrKey := { id := AttrId.unresolved, attr := a }
+
+instance : Coe Attribute AttrKey := ⟨ofAttr⟩
+
+instance : BEq AttrKey where
+  beq a b := a.attr == b.attr
+
+instance : Ord AttrKey where
+  compare a b := compare a.attr b.attr
+
+/-- Order by id, for indexes whose order across attributes is not part of
+    any contract. Unresolved keys sort after every interned one, by name
+    among themselves, so a probe for an attribute the table has never seen
+    matches nothing. Ids are only meaningful if both keys come from the same
+    table. -/
+def compareById (a b : AttrKey) : Ordering :=
+  match compare a.id b.id with
+  | .eq => if a.id.isResolved then .eq else compare a.attr b.attr
+  | o => o
+
+/-- Whether two keys name the same attribute, by id when both have one.
+    Both keys must come from the same table; range scans use this to check
+    entries against the key they seeked to. -/
+@[inline] def sameAttr (a b : AttrKey) : Bool :=
+  if a.id.isResolved && b.id.isResolved then a.id == b.id else a.attr == b.attr
+
+instance : ToString AttrKey where
+  toString k := k.attr.name
+
+end AttrKey
+
+/-- Bidirectional map between attributes and their ids.
+    Ids are handed out densely in order of first use and never change, so a
+    table only grows and an older table is a prefix of a newer one.
+    Each attribute is stored once; interned keys share that copy. -/
+structure AttrTable where
+  /-- Attribute to its key. -/
+  ids : Std.HashMap Attribute AttrKey := {}
+  /-- Keys by id. -/
+  keys : Array AttrKey := #[]
+  deriving Inhabited
+
+namespace AttrTable
+
+/-- A table with no attributes. -/
+def empty : AttrTable := {}
+
+/-- Number of interned attributes. -/
+def size (t : AttrTable) : Nat := t.keys.size
+
+/-- Id of an attribute, if interned. -/
+def find? (t : AttrTable) (a : Attribute) : Option AttrId :=
+  t.ids[a]?.map (·.id)
+
+/-- Attribute with a given id. -/
+def name? (t : AttrTable) (id : AttrId) : Option Attribute :=
+  t.keys[id.val.toNat]?.map (·.attr)
+
+/-- Key for looking an attribute up in indexes built with this table.
+    An attribute the table has never seen gets an unresolved key, which
+    matches nothing. -/
+def keyOf (t : AttrTable) (a : Attribute) : AttrKey :=
+  t.ids.getD a (AttrKey.ofAttr a)
+
+/-- Intern an attribute, giving it the next id if it is new.
+    Returns the shared key. -/
+def intern (t : AttrTable) (a : Attribute) : AttrKey × AttrTable :=
+  match t.ids[a]? with
+  | some k => (k, t)
+  | none =>
+    let k : AttrKey := { id := ⟨t.keys.size.toUInt32⟩, attr := a }
+    (k, { ids := t.ids.insert a k, keys := t.keys.push k })
+
+/-- The table's copy of an attribute, so datoms built from it share the name.
+    Unknown attributes come back as they are. -/
+def canonical (t : AttrTable) (a : Attribute) : Attribute :=
+  (t.keyOf a).attr
+
+/-- Intern several attributes. -/
+def internAll (t : AttrTable) (attrs : List Attribute) : AttrTable :=
+  attrs.foldl (fun t a => (t.intern a).2) t
+
+/-- Attributes in id order, for persistence. -/
+def names (t : AttrTable) : Array Attribute :=
+  t.keys.map (·.attr)
+
+/-- Rebuild a table from `names`, keeping every id. -/
+def ofNames (names : Array Attribute) : AttrTable :=
+  names.foldl (fun t a => (t.intern a).2) empty
+
+end AttrTable
+
+end Ledger
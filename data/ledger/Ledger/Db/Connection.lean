@@ -25,10 +25,18 @@ structure Connection where
   db : Db
   /-- Full transaction log for history/time-travel. -/
   txLog : TxLog
+  /-- Past database values, one every `checkpointInterval` transactions,
+      oldest first. `asOf` starts from one of these. -/
+  checkpoints : Array Db := #[]
   deriving Inhabited
 
 namespace Connection
 
+/-- Transactions between time-travel checkpoints. `asOf` replays fewer than
+    this many from the log. Checkpoints share their indexes with the live
+    database, so each one costs only the index nodes written since the last. -/
+def checkpointInterval : Nat := 64
+
 /-- Create a new connection with an empty database. -/
 def create : Connection :=
   { db := Db.empty
@@ -40,6 +48,17 @@ def current (conn : Connection) : Db := conn.db
 /-- Get the basis transaction of the current database. -/
 def basisT (conn : Connection) : TxId := conn.db.basisT
 
+/-- Log a transaction that produced `db`, taking a checkpoint when one is due.
+    Checkpoints are only taken while the log starts at the first transaction,
+    so that replaying the log from a checkpoint agrees with replaying it from
+    the start. -/
+def appendTx (conn : Connection) (db : Db) (entry : TxLogEntry) : Connection :=
+  let txLog := conn.txLog.add entry
+  let due := txLog.size == entry.txId.id && entry.txId.id % checkpointInterval == 0
+  let checkpoints :=
+    if due then conn.checkpoints.push db else conn.checkpoints
+  { db, txLog, checkpoints }
+
 /-- Process a transaction, returning a new connection and report.
     The transaction log is updated with the new transaction. -/
 def transact (conn : Connection) (tx : Transaction) (instant : Nat := 0)
@@ -52,11 +71,7 @@ def transact (conn : Connection) (tx : Transaction) (instant : Nat := 0)
     , txInstant := report.txInstant
     , datoms := report.txData }
 
-  let conn' : Connection :=
-    { db := db'
-    , txLog := conn.txLog.add logEntry }
-
-  return (conn', report)
+  return (conn.appendTx db' logEntry, report)
 
 /-- Process a transaction with a custom tx function registry. -/
 def transactWith (conn : Connection) (registry : TxFuncRegistry) (tx : Transaction)
@@ -69,11 +84,7 @@ def transactWith (conn : Connection) (registry : TxFuncRegistry) (tx : Transacti
     , txInstant := report.txInstant
     , datoms := report.txData }
 
-  let conn' : Connection :=
-    { db := db'
-    , txLog := conn.txLog.add logEntry }
-
-  return (conn', report)
+  return (conn.appendTx db' logEntry, report)
 
 /-- Allocate a new entity ID. -/
 def allocEntityId (conn : Connection) : EntityId × Connection :=
@@ -90,26 +101,26 @@ def allocEntityIds (conn : Connection) (n : Nat) : List EntityId × Connection :
 -- ============================================================
 
 /-- Get the database as it existed at a specific transaction.
-    This filters out any datoms added after txId and properly
-    handles retractions. -/
-def asOf (conn : Connection) (txId : TxId) : Db :=
-  -- Get all datoms from transactions up to txId
-  let relevantTxs := conn.txLog.upTo txId
-  let allDatoms := (relevantTxs.map fun entry => entry.datoms.toList).flatten
-
-  -- Filter to only visible datoms (handling retractions)
-  let visibleDatoms := TimeTravel.filterVisibleAt allDatoms txId
-
-  -- Rebuild indexes from visible datoms
-  let indexes := visibleDatoms.foldl Indexes.insertDatom Indexes.empty
-  let historyIndexes := allDatoms.foldl Indexes.insertDatom Indexes.empty
-  let currentFacts := Db.currentFactsFromDatoms visibleDatoms
-
-  { basisT := txId
-  , indexes := indexes
-  , historyIndexes := historyIndexes
-  , currentFacts := currentFacts
-  , nextEntityId := conn.db.nextEntityId }
+    Starts from the latest checkpoint at or before txId and replays the
+    logged transactions after it, so the cost is a binary search plus fewer
+    than `checkpointInterval` transactions, however long the history. -/
+def asOf (conn : Connection) (txId : TxId) : Db := Id.run do
+  let n := TimeTravel.countUpTo conn.checkpoints (·.basisT) txId
+  -- Without a checkpoint, start empty but keep the current attribute ids
+  -- and the attributes that have value histograms
+  let empty := Indexes.empty.withAttrs conn.db.attrs
+  let indexes := { empty with stats := { histograms := conn.db.indexes.stats.histograms } }
+  let mut db := if n > 0 then conn.checkpoints[n - 1]!
+    else { Db.empty with indexes, historyIndexes := empty.withoutStats }
+  let start := TimeTravel.countUpTo conn.txLog (·.txId) db.basisT
+  let stop := TimeTravel.countUpTo conn.txLog (·.txId) txId
+  for i in [start:stop] do
+    let entry := conn.txLog[i]!
+    db := db.replayTx entry.txId entry.datoms
+  return { basisT := txId
+         , indexes := db.indexes
+         , historyIndexes := db.historyIndexes
+         , nextEntityId := conn.db.nextEntityId }
 
 /-- Get all datoms that were asserted or retracted since a specific transaction.
     Returns the raw datoms including both assertions and retractions. -/
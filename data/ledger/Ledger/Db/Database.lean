@@ -9,6 +9,7 @@ import Ledger.Core.EntityId
 import Ledger.Core.Attribute
 import Ledger.Core.Value
 import Ledger.Core.Datom
+import Ledger.Core.AttrTable
 import Ledger.Index.Manager
 import Ledger.Tx.Types
 import Ledger.Tx.Functions
@@ -18,7 +19,7 @@ import Ledger.Schema.Install
 
 namespace Ledger
 
-/-- Fact key for current fact map. -/
+/-- Key of a fact: its entity, attribute and value. -/
 structure FactKey where
   entity : EntityId
   attr : Attribute
@@ -43,10 +44,8 @@ structure Db where
   basisT : TxId
   /-- All four indexes for efficient querying (current visible facts). -/
   indexes : Indexes
-  /-- Full history indexes (including retractions). -/
-  historyIndexes : Indexes := Indexes.empty
-  /-- Current visible facts keyed by (entity, attribute, value). -/
-  currentFacts : Std.HashMap FactKey Datom := {}
+  /-- Full history indexes (including retractions), without statistics. -/
+  historyIndexes : Indexes := Indexes.empty.withoutStats
   /-- Next available entity ID for new entities. -/
   nextEntityId : EntityId
   /-- Optional schema for validation (none = schema-free mode). -/
@@ -55,12 +54,6 @@ structure Db where
 
 namespace Db
 
-/-- Apply a datom to the current fact map. -/
-private def applyCurrentFact (facts : Std.HashMap FactKey Datom) (d : Datom) :
-    Std.HashMap FactKey Datom :=
-  let key := FactKey.ofDatom d
-  if d.added then facts.insert key d else facts.erase key
-
 /-- Set of entity IDs (using HashMap for membership). -/
 private abbrev EntitySet := Std.HashMap EntityId Unit
 
@@ -155,10 +148,6 @@ private def expandRetractEntities (db : Db) (tx : Transaction) : Except TxError
 
   return expanded
 
-/-- Build current fact map from a list of datoms (in transaction order). -/
-def currentFactsFromDatoms (datoms : DatomSeq) : Std.HashMap FactKey Datom :=
-  datoms.foldl (init := {}) fun acc d => applyCurrentFact acc d
-
 /-- Read-only view for tx functions. -/
 private def txFuncView (db : Db) : DbView :=
   let getOne := fun e a =>
@@ -183,13 +172,16 @@ private def txFuncView (db : Db) : DbView :=
 def empty : Db :=
   { basisT := TxId.genesis
   , indexes := Indexes.empty
-  , historyIndexes := Indexes.empty
-  , currentFacts := {}
+  , historyIndexes := Indexes.empty.withoutStats
   , nextEntityId := ⟨1⟩ }
 
 /-- Get the number of datoms in the database. -/
 def size (db : Db) : Nat := db.indexes.count
 
+/-- Interned ids of every attribute the database has seen.
+    Read from the history indexes, which every datom passes through. -/
+def attrs (db : Db) : AttrTable := db.historyIndexes.attrs
+
 /-- Allocate a new entity ID. Returns the ID and updated database. -/
 def allocEntityId (db : Db) : EntityId × Db :=
   let eid := db.nextEntityId
@@ -203,11 +195,10 @@ def allocEntityIds (db : Db) (n : Nat) : List EntityId × Db :=
   let db' := { db with nextEntityId := ⟨startId + n⟩ }
   (ids, db')
 
-/-- Check if a specific fact is currently asserted (not retracted).
-    Used to validate retractions. -/
-private def isFactAsserted (facts : Std.HashMap FactKey Datom)
-    (e : EntityId) (a : Attribute) (v : Value) : Bool :=
-  facts.contains (FactKey.of e a v)
+/-- The datom asserting a fact, if it is currently asserted (one EAVT probe). -/
+private def currentDatom? (indexes : Indexes)
+    (e : EntityId) (a : Attribute) (v : Value) : Option Datom :=
+  (indexes.datomsForEntityAttrValue e a v).head?
 
 /-- Process a transaction, producing a new database snapshot.
     This is a pure function - the original database is unchanged. -/
@@ -229,7 +220,6 @@ def transactWith (db : Db) (registry : TxFuncRegistry) (tx : Transaction) (insta
   let mut datoms : Array Datom := #[]
   let mut indexes := db.indexes
   let mut historyIndexes := db.historyIndexes
-  let mut currentFacts := db.currentFacts
 
   for op in expandedTx do
     match op with
@@ -237,23 +227,18 @@ def transactWith (db : Db) (registry : TxFuncRegistry) (tx : Transaction) (insta
       let datom := Datom.assert entity attr value newTxId
       datoms := datoms.push datom
       historyIndexes := historyIndexes.insertDatom datom
-      let key := FactKey.of entity attr value
-      if let some prev := currentFacts[key]? then
+      if let some prev := currentDatom? indexes entity attr value then
         indexes := indexes.removeDatom prev
       indexes := indexes.insertDatom datom
-      currentFacts := currentFacts.insert key datom
 
     | .retract entity attr value =>
       -- Validate that the fact exists in the pre-transaction state
-      if !isFactAsserted currentFacts entity attr value then
-        throw (.factNotFound entity attr value)
+      let some prev := currentDatom? indexes entity attr value
+        | throw (.factNotFound entity attr value)
       let datom := Datom.retract entity attr value newTxId
       datoms := datoms.push datom
       historyIndexes := historyIndexes.insertDatom datom
-      let key := FactKey.of entity attr value
-      if let some prev := currentFacts[key]? then
-        indexes := indexes.removeDatom prev
-      currentFacts := currentFacts.erase key
+      indexes := indexes.removeDatom prev
     | .retractEntity _ =>
       -- Should have been expanded away
       pure ()
@@ -265,8 +250,7 @@ def transactWith (db : Db) (registry : TxFuncRegistry) (tx : Transaction) (insta
     { db with
       basisT := newTxId
       indexes := indexes
-      historyIndexes := historyIndexes
-      currentFacts := currentFacts }
+      historyIndexes := historyIndexes }
 
   let report : TxReport :=
     { txId := newTxId
@@ -279,6 +263,21 @@ def transactWith (db : Db) (registry : TxFuncRegistry) (tx : Transaction) (insta
 def transact (db : Db) (tx : Transaction) (instant : Nat := 0) : Except TxError (Db × TxReport) :=
   db.transactWith TxFunctions.defaultRegistry tx instant
 
+/-- Apply the datoms of a logged transaction without validating them.
+    Time-travel views use this to roll forward from a checkpoint, and journal
+    replay to rebuild a connection. A fact's current datom is found in the
+    EAVT index. -/
+def replayTx (db : Db) (txId : TxId) (datoms : Array Datom) : Db := Id.run do
+  let mut indexes := db.indexes
+  let mut historyIndexes := db.historyIndexes
+  for d in datoms do
+    historyIndexes := historyIndexes.insertDatom d
+    for prev in indexes.datomsForEntityAttrValue d.entity d.attr d.value do
+      indexes := indexes.removeDatom prev
+    if d.added then
+      indexes := indexes.insertDatom d
+  return { db with basisT := txId, indexes, historyIndexes }
+
 -- ============================================================
 -- Entity-based queries (use EAVT index)
 -- ============================================================
@@ -387,9 +386,12 @@ def datoms (db : Db) : DatomSeq :=
 -- Schema configuration
 -- ============================================================
 
-/-- Enable schema validation on this database. -/
+/-- Enable schema validation on this database. Attributes the schema marks
+    `indexed` or `unique` also get a value histogram for the query planner. -/
 def withSchema (db : Db) (schema : Schema) (strict : Bool := false) : Db :=
-  { db with schemaConfig := some { schema := schema, strictMode := strict } }
+  let indexes := schema.toList.foldl (init := db.indexes) fun idx s =>
+    if s.indexed || s.unique.isSome then idx.trackValues s.ident else idx
+  { db with indexes, schemaConfig := some { schema := schema, strictMode := strict } }
 
 /-- Disable schema validation. -/
 def withoutSchema (db : Db) : Db :=
@@ -52,6 +52,17 @@ end TxLog
 
 namespace TimeTravel
 
+/-- Number of leading elements at or before `txId`, by binary search.
+    `txOf` must be nondecreasing along the array, as it is for the
+    transaction log and for checkpoints. -/
+def countUpTo {α : Type} [Inhabited α] (xs : Array α) (txOf : α → TxId) (txId : TxId) : Nat := Id.run do
+  let mut lo := 0
+  let mut hi := xs.size
+  while lo < hi do
+    let mid := (lo + hi) / 2
+    if (txOf xs[mid]!).id <= txId.id then lo := mid + 1 else hi := mid
+  return lo
+
 /-- Filter a list of datoms to only those visible at a specific transaction.
     Groups by (entity, attribute, value) and checks visibility for each. -/
 def filterVisibleAt (allDatoms : DatomSeq) (txId : TxId) : DatomSeq :=
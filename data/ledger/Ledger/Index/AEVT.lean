@@ -5,51 +5,68 @@
   Primary index for attribute-based queries (e.g., "all entities with :person/name").
 -/
 
-import Batteries.Data.RBMap
 import Batteries.Data.HashMap
 import Ledger.Core.Datom
 import Ledger.Index.Types
-import Ledger.Index.RBRange
+import Ledger.Index.BTree
 
 namespace Ledger
 
-/-- AEVT index using RBMap for ordered access. -/
-abbrev AEVTIndex := Batteries.RBMap AEVTKey Datom compare
+/-- AEVT index: a B+-tree of shared index entries in AEVT order. -/
+abbrev AEVTIndex := BTree IndexEntry IndexEntry.compareAEVT
 
 namespace AEVTIndex
 
+open IndexEntry (probe minEntity minValue minTx)
+
 /-- Create an empty AEVT index. -/
-def empty : AEVTIndex := Batteries.RBMap.empty
+def empty : AEVTIndex := BTree.empty
+
+/-- Create minimum entry for attribute-based range query. -/
+def minForAttr (a : AttrKey) : IndexEntry :=
+  probe minEntity a minValue minTx
+
+/-- Create minimum entry for attr+entity range query. -/
+def minForAttrEntity (a : AttrKey) (e : EntityId) : IndexEntry :=
+  probe e a minValue minTx
+
+/-- Check if entry matches attribute. -/
+def matchesAttr (a : AttrKey) (x : IndexEntry) : Bool := x.attr.sameAttr a
+
+/-- Check if entry matches attribute and entity. -/
+def matchesAttrEntity (a : AttrKey) (e : EntityId) (x : IndexEntry) : Bool :=
+  x.attr.sameAttr a && x.entity == e
+
+/-- Insert an entry shared with the other indexes. -/
+def insertEntry (idx : AEVTIndex) (x : IndexEntry) : AEVTIndex :=
+  idx.insert x
 
-/-- Create key from a datom. -/
-def keyOf (d : Datom) : AEVTKey :=
-  { attr := d.attr
-  , entity := d.entity
-  , value := d.value
-  , tx := d.tx }
+/-- Remove an entry. -/
+def removeEntry (idx : AEVTIndex) (x : IndexEntry) : AEVTIndex :=
+  idx.erase x
 
 /-- Insert a datom into the index. -/
-def insertDatom (idx : AEVTIndex) (d : Datom) : AEVTIndex :=
-  Batteries.RBMap.insert idx (keyOf d) d
+def insertDatom (idx : AEVTIndex) (d : Datom) (a : AttrKey := AttrKey.ofAttr d.attr) : AEVTIndex :=
+  idx.insert (IndexEntry.ofDatom d a)
 
 /-- Remove a datom from the index. -/
-def removeDatom (idx : AEVTIndex) (d : Datom) : AEVTIndex :=
-  Batteries.RBMap.erase idx (keyOf d)
+def removeDatom (idx : AEVTIndex) (d : Datom) (a : AttrKey := AttrKey.ofAttr d.attr) : AEVTIndex :=
+  idx.erase (IndexEntry.ofDatom d a)
 
 /-- Get all datoms for an attribute (range scan).
     Returns all entities that have this attribute.
     Uses early termination to avoid full index scan. -/
-def datomsForAttr (a : Attribute) (idx : AEVTIndex) : List Datom :=
-  RBRange.collectFromWhile idx (AEVTKey.minForAttr a) (AEVTKey.matchesAttr a)
+def datomsForAttr (a : AttrKey) (idx : AEVTIndex) : List Datom :=
+  (idx.collectFrom (minForAttr a) (matchesAttr a) (·.datom)).toList
 
 /-- Get all datoms for an attribute and entity.
     Uses early termination to avoid full index scan. -/
-def datomsForAttrEntity (a : Attribute) (e : EntityId) (idx : AEVTIndex) : List Datom :=
-  RBRange.collectFromWhile idx (AEVTKey.minForAttrEntity a e) (AEVTKey.matchesAttrEntity a e)
+def datomsForAttrEntity (a : AttrKey) (e : EntityId) (idx : AEVTIndex) : List Datom :=
+  (idx.collectFrom (minForAttrEntity a e) (matchesAttrEntity a e) (·.datom)).toList
 
 /-- Get all entities that have a specific attribute.
     Implementation: O(n) using HashMap instead of O(n²) eraseDups. -/
-def entitiesWithAttr (a : Attribute) (idx : AEVTIndex) : List EntityId :=
+def entitiesWithAttr (a : AttrKey) (idx : AEVTIndex) : List EntityId :=
   let datoms := datomsForAttr a idx
   -- Use HashMap as a set for O(n) deduplication instead of O(n²) eraseDups
   let seen : Std.HashMap EntityId Unit := {}
@@ -60,11 +77,11 @@ def entitiesWithAttr (a : Attribute) (idx : AEVTIndex) : List EntityId :=
 
 /-- Get all datoms in the index. -/
 def allDatoms (idx : AEVTIndex) : List Datom :=
-  (Batteries.RBMap.toList idx).map Prod.snd
+  (idx.foldl (fun acc x => acc.push x.datom) #[]).toList
 
 /-- Count of datoms in the index. -/
 def count (idx : AEVTIndex) : Nat :=
-  Batteries.RBMap.size idx
+  idx.size
 
 end AEVTIndex
 
@@ -6,60 +6,75 @@
   Especially useful for unique attributes.
 -/
 
-import Batteries.Data.RBMap
 import Batteries.Data.HashMap
 import Ledger.Core.Datom
 import Ledger.Index.Types
-import Ledger.Index.RBRange
+import Ledger.Index.BTree
 
 namespace Ledger
 
-/-- AVET index using RBMap for ordered access. -/
-abbrev AVETIndex := Batteries.RBMap AVETKey Datom compare
+/-- AVET index: a B+-tree of shared index entries in AVET order. -/
+abbrev AVETIndex := BTree IndexEntry IndexEntry.compareAVET
 
 namespace AVETIndex
 
+open IndexEntry (probe minEntity minValue minTx)
+
 /-- Create an empty AVET index. -/
-def empty : AVETIndex := Batteries.RBMap.empty
+def empty : AVETIndex := BTree.empty
+
+/-- Create minimum entry for attribute-based range query. -/
+def minForAttr (a : AttrKey) : IndexEntry :=
+  probe minEntity a minValue minTx
+
+/-- Create minimum entry for attr+value range query. -/
+def minForAttrValue (a : AttrKey) (v : Value) : IndexEntry :=
+  probe minEntity a v minTx
+
+/-- Check if entry matches attribute. -/
+def matchesAttr (a : AttrKey) (x : IndexEntry) : Bool := x.attr.sameAttr a
+
+/-- Check if entry matches attribute and value. -/
+def matchesAttrValue (a : AttrKey) (v : Value) (x : IndexEntry) : Bool :=
+  x.attr.sameAttr a && x.value == v
+
+/-- Insert an entry shared with the other indexes. -/
+def insertEntry (idx : AVETIndex) (x : IndexEntry) : AVETIndex :=
+  idx.insert x
 
-/-- Create key from a datom. -/
-def keyOf (d : Datom) : AVETKey :=
-  { attr := d.attr
-  , value := d.value
-  , entity := d.entity
-  , tx := d.tx }
+/-- Remove an entry. -/
+def removeEntry (idx : AVETIndex) (x : IndexEntry) : AVETIndex :=
+  idx.erase x
 
 /-- Insert a datom into the index. -/
-def insertDatom (idx : AVETIndex) (d : Datom) : AVETIndex :=
-  Batteries.RBMap.insert idx (keyOf d) d
+def insertDatom (idx : AVETIndex) (d : Datom) (a : AttrKey := AttrKey.ofAttr d.attr) : AVETIndex :=
+  idx.insert (IndexEntry.ofDatom d a)
 
 /-- Remove a datom from the index. -/
-def removeDatom (idx : AVETIndex) (d : Datom) : AVETIndex :=
-  Batteries.RBMap.erase idx (keyOf d)
+def removeDatom (idx : AVETIndex) (d : Datom) (a : AttrKey := AttrKey.ofAttr d.attr) : AVETIndex :=
+  idx.erase (IndexEntry.ofDatom d a)
 
 /-- Get all datoms for an attribute and value (range scan).
     Useful for finding entities with a specific attribute value.
     Only returns assertions (added = true), not retractions.
     Uses early termination to avoid full index scan. -/
-def datomsForAttrValue (a : Attribute) (v : Value) (idx : AVETIndex) : List Datom :=
-  RBRange.collectFromWhile idx (AVETKey.minForAttrValue a v) (AVETKey.matchesAttrValue a v)
+def datomsForAttrValue (a : AttrKey) (v : Value) (idx : AVETIndex) : List Datom :=
+  (idx.collectFrom (minForAttrValue a v) (matchesAttrValue a v) (·.datom)).toList
   |>.filter (·.added)
 
 /-- Get entities with a specific attribute value.
     Primary use case: lookup by unique attribute.
     Filters out entities where the fact has been retracted.
 
-    Implementation: Uses range query for O(s + k) range access, then
+    Implementation: Uses range query for O(log n + k) range access, then
     HashMap to track each entity's latest transaction state. -/
-def entitiesWithAttrValue (a : Attribute) (v : Value) (idx : AVETIndex) : List EntityId :=
+def entitiesWithAttrValue (a : AttrKey) (v : Value) (idx : AVETIndex) : List EntityId :=
   -- Seek to attr/value lower bound, then walk only matching range.
-  let datoms := RBRange.collectPairsFromWhile idx
-    (AVETKey.minForAttrValue a v)
-    (fun k => AVETKey.matchesAttrValue a v k)
+  let datoms := idx.collectFrom (minForAttrValue a v) (matchesAttrValue a v) (·.datom)
 
   -- Build HashMap of entity -> (latestTxId, isAdded)
   let entityState : Std.HashMap EntityId (Nat × Bool) :=
-    datoms.foldl (init := {}) fun acc (_, d) =>
+    datoms.foldl (init := {}) fun acc d =>
       match acc[d.entity]? with
       | none => acc.insert d.entity (d.tx.id, d.added)
       | some (prevTxId, _) =>
@@ -73,21 +88,21 @@ def entitiesWithAttrValue (a : Attribute) (v : Value) (idx : AVETIndex) : List E
 
 /-- Get the first entity with a specific attribute value.
     Useful for unique attributes where only one entity should match. -/
-def entityWithAttrValue (a : Attribute) (v : Value) (idx : AVETIndex) : Option EntityId :=
+def entityWithAttrValue (a : AttrKey) (v : Value) (idx : AVETIndex) : Option EntityId :=
   (entitiesWithAttrValue a v idx).head?
 
 /-- Get all datoms for an attribute (less efficient than AEVT for this).
     Uses early termination but still needs to scan all values for the attribute. -/
-def datomsForAttr (a : Attribute) (idx : AVETIndex) : List Datom :=
-  RBRange.collectWhile idx (fun k => k.attr == a)
+def datomsForAttr (a : AttrKey) (idx : AVETIndex) : List Datom :=
+  (idx.collectFrom (minForAttr a) (fun x => x.attr.sameAttr a) (·.datom)).toList
 
 /-- Get all datoms in the index. -/
 def allDatoms (idx : AVETIndex) : List Datom :=
-  (Batteries.RBMap.toList idx).map Prod.snd
+  (idx.foldl (fun acc x => acc.push x.datom) #[]).toList
 
 /-- Count of datoms in the index. -/
 def count (idx : AVETIndex) : Nat :=
-  Batteries.RBMap.size idx
+  idx.size
 
 end AVETIndex
 
@@ -0,0 +1,303 @@
+/-
+  Ledger.Index.BTree
+
+  Persistent B+-tree with wide nodes, used for the database indexes.
+  Elements sit in sorted arrays in the leaves, so a tree of n elements is
+  about n pointers plus a few small inner nodes, and a range scan reads
+  leaves front to back. An update copies one root-to-leaf path and shares
+  the rest with the previous version.
+-/
+
+namespace Ledger
+
+/-- Node of a B+-tree. A leaf holds sorted elements. An inner node holds its
+    children and, between each pair of neighbours, a separator that is above
+    every element on its left and at most every element on its right. -/
+inductive BNode (α : Type) where
+  | leaf (items : Array α)
+  | node (seps : Array α) (children : Array (BNode α))
+  deriving Inhabited
+
+namespace BNode
+
+/-- Most elements a leaf holds before it splits. -/
+def leafCapacity : Nat := 64
+
+/-- Most children an inner node holds before it splits. -/
+def nodeCapacity : Nat := 32
+
+variable {α : Type} [Inhabited α]
+
+/-- Whether a node is over capacity and must split. -/
+def overfull : BNode α → Bool
+  | .leaf items => items.size > leafCapacity
+  | .node _ children => children.size > nodeCapacity
+
+/-- Whether a node is below a quarter of its capacity and should be joined
+    with a neighbour. -/
+def underfull : BNode α → Bool
+  | .leaf items => items.size < leafCapacity / 4
+  | .node _ children => children.size < nodeCapacity / 4
+
+/-- First index whose element is not below the probe, where `cut x` compares
+    the probe with `x`. -/
+@[inline] def lowerBound (items : Array α) (cut : α → Ordering) : Nat := Id.run do
+  let mut lo := 0
+  let mut hi := items.size
+  while lo < hi do
+    let mid := (lo + hi) / 2
+    if cut items[mid]! == .gt then lo := mid + 1 else hi := mid
+  return lo
+
+/-- Child to descend into for a probe: the number of separators at or below it. -/
+@[inline] def childIndex (seps : Array α) (cut : α → Ordering) : Nat := Id.run do
+  let mut lo := 0
+  let mut hi := seps.size
+  while lo < hi do
+    let mid := (lo + hi) / 2
+    if cut seps[mid]! == .lt then hi := mid else lo := mid + 1
+  return lo
+
+private def insertAt (a : Array α) (i : Nat) (x : α) : Array α :=
+  (a.extract 0 i).push x ++ a.extract i a.size
+
+private def eraseAt (a : Array α) (i : Nat) : Array α :=
+  a.extract 0 i ++ a.extract (i + 1) a.size
+
+/-- Split a node into halves, with the separator between them. -/
+def split : BNode α → BNode α × α × BNode α
+  | .leaf items =>
+    let mid := items.size / 2
+    (.leaf (items.extract 0 mid), items[mid]!, .leaf (items.extract mid items.size))
+  | .node seps children =>
+    let mid := children.size / 2
+    (.node (seps.extract 0 (mid - 1)) (children.extract 0 mid), seps[mid - 1]!,
+     .node (seps.extract mid seps.size) (children.extract mid children.size))
+
+/-- Join neighbouring nodes of the same height, with `sep` between them. -/
+def join : BNode α → α → BNode α → BNode α
+  | .leaf a, _, .leaf b => .leaf (a ++ b)
+  | .node sa ca, sep, .node sb cb => .node (sa.push sep ++ sb) (ca ++ cb)
+  -- Neighbours always have the same height
+  | l, _, _ => l
+
+/-- Split a node if it is over capacity. -/
+private def splitIfOverfull (n : BNode α) : BNode α × Option (α × BNode α) :=
+  if n.overfull then
+    let (l, sep, r) := n.split
+    (l, some (sep, r))
+  else (n, none)
+
+/-- Insert an element, replacing one that compares equal. Returns the node,
+    the separator and right half if it split, and whether the element is new. -/
+partial def insert (cmp : α → α → Ordering) (x : α) :
+    BNode α → BNode α × Option (α × BNode α) × Bool
+  | .leaf items =>
+    let i := lowerBound items (cmp x ·)
+    if i < items.size && cmp x items[i]! == .eq then
+      (.leaf (items.set! i x), none, false)
+    else
+      let (n, up) := splitIfOverfull (.leaf (insertAt items i x))
+      (n, up, true)
+  | .node seps children =>
+    let j := childIndex seps (cmp x ·)
+    let child := children[j]!
+    -- Release the array's reference so a unique child is updated in place
+    let children := children.set! j default
+    let (child, up, added) := insert cmp x child
+    let children := children.set! j child
+    match up with
+    | none => (.node seps children, none, added)
+    | some (sep, right) =>
+      let (n, up) := splitIfOverfull (.node (insertAt seps j sep) (insertAt children (j + 1) right))
+      (n, up, added)
+
+/-- After child `j` shrank: join it with a neighbour if it is underfull, and
+    split the result again if that is too big. -/
+private def rebalance (seps : Array α) (children : Array (BNode α)) (j : Nat) : BNode α :=
+  if children.size < 2 || !children[j]!.underfull then .node seps children
+  else
+    let l := if j > 0 then j - 1 else j
+    let joined := join children[l]! seps[l]! children[l + 1]!
+    if joined.overfull then
+      let (a, sep, b) := joined.split
+      .node (seps.set! l sep) ((children.set! l a).set! (l + 1) b)
+    else
+      .node (eraseAt seps l) (eraseAt (children.set! l joined) (l + 1))
+
+/-- Remove the element comparing equal to `x`. Returns whether there was one. -/
+partial def erase (cmp : α → α → Ordering) (x : α) : BNode α → BNode α × Bool
+  | n@(.leaf items) =>
+    let i := lowerBound items (cmp x ·)
+    if i < items.size && cmp x items[i]! == .eq then (.leaf (eraseAt items i), true)
+    else (n, false)
+  | n@(.node seps children) =>
+    let j := childIndex seps (cmp x ·)
+    let (child, removed) := erase cmp x children[j]!
+    if removed then (rebalance seps (children.set! j child) j, true) else (n, false)
+
+/-- The element comparing equal to `x`. -/
+partial def find? (cmp : α → α → Ordering) (x : α) : BNode α → Option α
+  | .leaf items =>
+    let i := lowerBound items (cmp x ·)
+    if i < items.size && cmp x items[i]! == .eq then some items[i]! else none
+  | .node seps children => find? cmp x children[childIndex seps (cmp x ·)]!
+
+/-- Levels from this node down to the leaves, counting both. -/
+partial def height : BNode α → Nat
+  | .leaf _ => 1
+  | .node _ children => 1 + height children[0]!
+
+end BNode
+
+/-- A position in a tree, for walking its elements in order. -/
+structure BCursor (α : Type) where
+  /-- Children of each inner node above the leaf and the index taken, innermost first. -/
+  path : List (Array (BNode α) × Nat)
+  /-- The current leaf. -/
+  leaf : Array α
+  /-- Index of the next element in `leaf`. -/
+  idx : Nat
+
+namespace BCursor
+
+variable {α : Type} [Inhabited α]
+
+/-- Cursor at the first element of `node` at or after the probe, below `path`. -/
+def seek (node : BNode α) (cut : α → Ordering) (path : List (Array (BNode α) × Nat) := []) :
+    BCursor α := Id.run do
+  let mut node := node
+  let mut path := path
+  let mut leaf : Array α := #[]
+  let mut descending := true
+  while descending do
+    match node with
+    | .leaf items =>
+      leaf := items
+      descending := false
+    | .node seps children =>
+      let j := BNode.childIndex seps cut
+      path := (children, j) :: path
+      node := children[j]!
+  return { path, leaf, idx := BNode.lowerBound leaf cut }
+
+/-- The element under the cursor and the cursor past it. -/
+def next? (c : BCursor α) : Option (α × BCursor α) := Id.run do
+  let mut c := c
+  -- A leaf can end before the probe, so move right until there is an element
+  while c.idx ≥ c.leaf.size do
+    match c.path with
+    | [] => return none
+    | (children, j) :: rest =>
+      if j + 1 < children.size then
+        c := seek children[j + 1]! (fun _ => .lt) ((children, j + 1) :: rest)
+      else
+        c := { c with path := rest }
+  return some (c.leaf[c.idx]!, { c with idx := c.idx + 1 })
+
+end BCursor
+
+/-- A persistent B+-tree of elements ordered by `cmp`. An element replaces any
+    element comparing equal to it. -/
+structure BTree (α : Type) (cmp : α → α → Ordering) where
+  root : BNode α := .leaf #[]
+  /-- Number of elements, kept so counting is O(1). -/
+  size : Nat := 0
+  deriving Inhabited
+
+namespace BTree
+
+variable {α β : Type} {cmp : α → α → Ordering} [Inhabited α]
+
+/-- A tree with no elements. -/
+def empty : BTree α cmp := {}
+
+/-- Whether the tree has no elements. -/
+def isEmpty (t : BTree α cmp) : Bool := t.size == 0
+
+/-- Insert an element, replacing one that compares equal. -/
+def insert (t : BTree α cmp) (x : α) : BTree α cmp :=
+  let ⟨root, size⟩ := t
+  let (root, up, added) := root.insert cmp x
+  let root := match up with
+    | none => root
+    | some (sep, right) => .node #[sep] #[root, right]
+  { root, size := if added then size + 1 else size }
+
+/-- Remove the element comparing equal to `x`, if any. -/
+def erase (t : BTree α cmp) (x : α) : BTree α cmp :=
+  let ⟨root, size⟩ := t
+  let (root, removed) := root.erase cmp x
+  if !removed then { root, size }
+  else
+    -- An inner root left with one child gives way to it
+    let root := match root with
+      | .node _ children => if children.size == 1 then children[0]! else root
+      | r => r
+    { root, size := size - 1 }
+
+/-- The element comparing equal to `x`. -/
+def find? (t : BTree α cmp) (x : α) : Option α :=
+  t.root.find? cmp x
+
+/-- Whether an element comparing equal to `x` is present. -/
+def contains (t : BTree α cmp) (x : α) : Bool :=
+  (t.find? x).isSome
+
+/-- Cursor at the first element not below the probe; `cut x` compares the probe with `x`. -/
+def seek (t : BTree α cmp) (cut : α → Ordering) : BCursor α :=
+  BCursor.seek t.root cut
+
+/-- Fold over the elements from the probe on, while `inRange` holds.
+    Complexity: O(log n + k) for k elements in range. -/
+@[inline] def foldFromWhile (t : BTree α cmp) (cut : α → Ordering) (inRange : α → Bool)
+    (init : β) (f : β → α → β) : β := Id.run do
+  let mut acc := init
+  let mut c := t.seek cut
+  while true do
+    match c.next? with
+    | none => break
+    | some (x, c') =>
+      if !inRange x then break
+      acc := f acc x
+      c := c'
+  return acc
+
+/-- Elements from `lower` on while `inRange` holds, mapped through `f`.
+    `inRange` should describe a contiguous run starting at `lower`. -/
+@[inline] def collectFrom (t : BTree α cmp) (lower : α) (inRange : α → Bool) (f : α → β) :
+    Array β :=
+  t.foldFromWhile (cmp lower) inRange #[] fun acc x => acc.push (f x)
+
+/-- Count the elements from `lower` on while `inRange` holds, stopping at `limit`. -/
+def countFrom (t : BTree α cmp) (lower : α) (inRange : α → Bool) (limit : Nat) : Nat := Id.run do
+  let mut count := 0
+  let mut c := t.seek (cmp lower)
+  while count < limit do
+    match c.next? with
+    | none => break
+    | some (x, c') =>
+      if !inRange x then break
+      count := count + 1
+      c := c'
+  return count
+
+/-- Fold over all elements in order. -/
+@[inline] def foldl (f : β → α → β) (init : β) (t : BTree α cmp) : β :=
+  t.foldFromWhile (fun _ => .lt) (fun _ => true) init f
+
+/-- All elements in order. -/
+def toArray (t : BTree α cmp) : Array α :=
+  t.foldl Array.push #[]
+
+/-- All elements in order. -/
+def toList (t : BTree α cmp) : List α :=
+  t.toArray.toList
+
+/-- Height of the tree: 1 for a single leaf. -/
+def height (t : BTree α cmp) : Nat :=
+  t.root.height
+
+end BTree
+
+end Ledger
@@ -5,71 +5,93 @@
   Primary index for entity lookups.
 -/
 
-import Batteries.Data.RBMap
 import Ledger.Core.Datom
 import Ledger.Index.Types
-import Ledger.Index.RBRange
+import Ledger.Index.BTree
 
 namespace Ledger
 
-/-- EAVT index using RBMap for ordered access. -/
-abbrev EAVTIndex := Batteries.RBMap EAVTKey Datom compare
+/-- EAVT index: a B+-tree of shared index entries in EAVT order. -/
+abbrev EAVTIndex := BTree IndexEntry IndexEntry.compareEAVT
 
 namespace EAVTIndex
 
+open IndexEntry (probe minAttr minValue minTx)
+
 /-- Create an empty EAVT index. -/
-def empty : EAVTIndex := Batteries.RBMap.empty
+def empty : EAVTIndex := BTree.empty
+
+/-- Create minimum entry for entity-based range query. -/
+def minForEntity (e : EntityId) : IndexEntry :=
+  probe e minAttr minValue minTx
+
+/-- Create minimum entry for entity+attr range query. -/
+def minForEntityAttr (e : EntityId) (a : AttrKey) : IndexEntry :=
+  probe e a minValue minTx
+
+/-- Create minimum entry for entity+attr+value range query. -/
+def minForEntityAttrValue (e : EntityId) (a : AttrKey) (v : Value) : IndexEntry :=
+  probe e a v minTx
+
+/-- Check if entry matches entity. -/
+def matchesEntity (e : EntityId) (x : IndexEntry) : Bool := x.entity == e
+
+/-- Check if entry matches entity and attribute. -/
+def matchesEntityAttr (e : EntityId) (a : AttrKey) (x : IndexEntry) : Bool :=
+  x.entity == e && x.attr.sameAttr a
+
+/-- Check if entry matches entity, attribute, and value. -/
+def matchesEntityAttrValue (e : EntityId) (a : AttrKey) (v : Value) (x : IndexEntry) : Bool :=
+  x.entity == e && x.attr.sameAttr a && x.value == v
+
+/-- Insert an entry shared with the other indexes. -/
+def insertEntry (idx : EAVTIndex) (x : IndexEntry) : EAVTIndex :=
+  idx.insert x
 
-/-- Create key from a datom. -/
-def keyOf (d : Datom) : EAVTKey :=
-  { entity := d.entity
-  , attr := d.attr
-  , value := d.value
-  , tx := d.tx }
+/-- Remove an entry. -/
+def removeEntry (idx : EAVTIndex) (x : IndexEntry) : EAVTIndex :=
+  idx.erase x
 
 /-- Insert a datom into the index. -/
-def insertDatom (idx : EAVTIndex) (d : Datom) : EAVTIndex :=
-  Batteries.RBMap.insert idx (keyOf d) d
+def insertDatom (idx : EAVTIndex) (d : Datom) (a : AttrKey := AttrKey.ofAttr d.attr) : EAVTIndex :=
+  idx.insert (IndexEntry.ofDatom d a)
 
 /-- Remove a datom from the index. -/
-def removeDatom (idx : EAVTIndex) (d : Datom) : EAVTIndex :=
-  Batteries.RBMap.erase idx (keyOf d)
+def removeDatom (idx : EAVTIndex) (d : Datom) (a : AttrKey := AttrKey.ofAttr d.attr) : EAVTIndex :=
+  idx.erase (IndexEntry.ofDatom d a)
 
 /-- Look up a specific datom by its full key. -/
-def findByKey (idx : EAVTIndex) (key : EAVTKey) : Option Datom :=
-  Batteries.RBMap.find? idx key
+def findByKey (idx : EAVTIndex) (key : IndexEntry) : Option Datom :=
+  (idx.find? key).map (·.datom)
 
 /-- Get all datoms for an entity (range scan).
     Returns datoms in EAVT order.
-    Uses early termination for O(s + k) complexity where s = elements before range,
-    k = elements in range. Avoids full O(n) list allocation. -/
+    Seeks to the first match, then reads leaves in order: O(log n + k). -/
 def datomsForEntity (e : EntityId) (idx : EAVTIndex) : List Datom :=
-  RBRange.collectFromWhile idx (EAVTKey.minForEntity e) (EAVTKey.matchesEntity e)
+  (idx.collectFrom (minForEntity e) (matchesEntity e) (·.datom)).toList
 
 /-- Get all datoms for an entity and attribute (range scan).
     Uses early termination to avoid full index scan. -/
-def datomsForEntityAttr (e : EntityId) (a : Attribute) (idx : EAVTIndex) : List Datom :=
-  RBRange.collectFromWhile idx (EAVTKey.minForEntityAttr e a) (EAVTKey.matchesEntityAttr e a)
+def datomsForEntityAttr (e : EntityId) (a : AttrKey) (idx : EAVTIndex) : List Datom :=
+  (idx.collectFrom (minForEntityAttr e a) (matchesEntityAttr e a) (·.datom)).toList
 
 /-- Get all datoms for an entity, attribute, and value (range scan).
     Uses early termination to avoid full index scan. -/
-def datomsForEntityAttrValue (e : EntityId) (a : Attribute) (v : Value) (idx : EAVTIndex) : List Datom :=
-  RBRange.collectFromWhile idx
-    (EAVTKey.minForEntityAttrValue e a v)
-    (EAVTKey.matchesEntityAttrValue e a v)
+def datomsForEntityAttrValue (e : EntityId) (a : AttrKey) (v : Value) (idx : EAVTIndex) : List Datom :=
+  (idx.collectFrom (minForEntityAttrValue e a v) (matchesEntityAttrValue e a v) (·.datom)).toList
 
 /-- Get a specific value for an entity and attribute (most recent assertion).
     Note: This returns all matching datoms, caller should filter by tx for current value. -/
-def valuesForEntityAttr (e : EntityId) (a : Attribute) (idx : EAVTIndex) : List Value :=
-  (datomsForEntityAttr e a idx).map (·.value)
+def valuesForEntityAttr (e : EntityId) (a : AttrKey) (idx : EAVTIndex) : List Value :=
+  (idx.collectFrom (minForEntityAttr e a) (matchesEntityAttr e a) (·.value)).toList
 
 /-- Get all datoms in the index. -/
 def allDatoms (idx : EAVTIndex) : List Datom :=
-  (Batteries.RBMap.toList idx).map Prod.snd
+  (idx.foldl (fun acc x => acc.push x.datom) #[]).toList
 
 /-- Count of datoms in the index. -/
 def count (idx : EAVTIndex) : Nat :=
-  Batteries.RBMap.size idx
+  idx.size
 
 end EAVTIndex
 
@@ -3,12 +3,17 @@
 
   Unified management of all four database indexes.
   Provides atomic operations across all indexes.
+  Attributes are interned through the bundle's `AttrTable`, so every key
+  shares one `AttrKey` per attribute. Each datom is wrapped in one
+  `IndexEntry` that all four indexes point to.
 -/
 
 import Ledger.Index.EAVT
 import Ledger.Index.AEVT
 import Ledger.Index.AVET
 import Ledger.Index.VAET
+import Ledger.Index.Stats
+import Ledger.Core.AttrTable
 
 namespace Ledger
 
@@ -22,6 +27,13 @@ structure Indexes where
   avet : AVETIndex
   /-- Value-Attribute-Entity-Transaction (for reverse references) -/
   vaet : VAETIndex
+  /-- Per-attribute counts for the query planner -/
+  stats : IndexStats := IndexStats.empty
+  /-- Whether `stats` is maintained. History indexes are never planned
+      over and skip it. -/
+  trackStats : Bool := true
+  /-- Interned ids of the attributes in the keys -/
+  attrs : AttrTable := AttrTable.empty
   deriving Inhabited
 
 namespace Indexes
@@ -31,26 +43,86 @@ def empty : Indexes :=
   { eavt := EAVTIndex.empty
   , aevt := AEVTIndex.empty
   , avet := AVETIndex.empty
-  , vaet := VAETIndex.empty }
-
-/-- Insert a datom into all indexes atomically. -/
+  , vaet := VAETIndex.empty
+  , stats := IndexStats.empty
+  , attrs := AttrTable.empty }
+
+/-- Use a different attribute table. It must extend the current one, so that
+    ids already in the keys keep their meaning. -/
+def withAttrs (idx : Indexes) (attrs : AttrTable) : Indexes :=
+  { idx with attrs }
+
+/-- Stop maintaining statistics (for history indexes). -/
+def withoutStats (idx : Indexes) : Indexes :=
+  { idx with stats := IndexStats.empty, trackStats := false }
+
+/-- Key for looking an attribute up in these indexes. -/
+def attrKey (idx : Indexes) (a : Attribute) : AttrKey :=
+  idx.attrs.keyOf a
+
+/-- Whether some datom of attribute `a` has entity `e` (one AEVT probe). -/
+private def hasAttrEntity (idx : Indexes) (a : AttrKey) (e : EntityId) : Bool :=
+  idx.aevt.countFrom (AEVTIndex.minForAttrEntity a e) (AEVTIndex.matchesAttrEntity a e) 1 > 0
+
+/-- Whether some datom of attribute `a` has value `v` (one AVET probe). -/
+private def hasAttrValue (idx : Indexes) (a : AttrKey) (v : Value) : Bool :=
+  idx.avet.countFrom (AVETIndex.minForAttrValue a v) (AVETIndex.matchesAttrValue a v) 1 > 0
+
+/-- Insert a datom into all indexes atomically.
+    Its attribute is interned first if new, and the four indexes share one
+    entry for it. The distinct counts in the statistics move only if AEVT
+    (AVET) held no datom of the attribute with its entity (value) before. -/
 def insertDatom (idx : Indexes) (d : Datom) : Indexes :=
-  { eavt := idx.eavt.insertDatom d
-  , aevt := idx.aevt.insertDatom d
-  , avet := idx.avet.insertDatom d
-  , vaet := idx.vaet.insertDatom d }
-
-/-- Remove a datom from all indexes atomically. -/
+  let (a, attrs) := idx.attrs.intern d.attr
+  let x := IndexEntry.ofDatom d a
+  let stats :=
+    if !idx.trackStats then idx.stats
+    else match idx.eavt.find? x with
+      -- Same entity, attribute and value: only the datom itself changes
+      | some prev => (idx.stats.removeDatom prev.datom false false).insertDatom d false false
+      | none => idx.stats.insertDatom d (!idx.hasAttrEntity a d.entity) (!idx.hasAttrValue a d.value)
+  { idx with
+    eavt := idx.eavt.insertEntry x
+    aevt := idx.aevt.insertEntry x
+    avet := idx.avet.insertEntry x
+    vaet := idx.vaet.insertEntry x
+    stats
+    attrs }
+
+/-- Remove a datom from all indexes atomically. The distinct counts in the
+    statistics drop if AEVT (AVET) holds no other datom of the attribute with
+    its entity (value) afterwards. -/
 def removeDatom (idx : Indexes) (d : Datom) : Indexes :=
-  { eavt := idx.eavt.removeDatom d
-  , aevt := idx.aevt.removeDatom d
-  , avet := idx.avet.removeDatom d
-  , vaet := idx.vaet.removeDatom d }
+  let a := idx.attrKey d.attr
+  let x := IndexEntry.ofDatom d a
+  let idx' := { idx with
+    eavt := idx.eavt.removeEntry x
+    aevt := idx.aevt.removeEntry x
+    avet := idx.avet.removeEntry x
+    vaet := idx.vaet.removeEntry x }
+  if !idx.trackStats then idx'
+  else match idx.eavt.find? x with
+    | some stored =>
+      { idx' with stats := idx.stats.removeDatom stored.datom
+          (!idx'.hasAttrEntity a d.entity) (!idx'.hasAttrValue a d.value) }
+    | none => idx'
+
+/-- Keep a value histogram for attribute `a` (one AVET range scan to seed it). -/
+def trackValues (idx : Indexes) (a : Attribute) : Indexes :=
+  if !idx.trackStats || idx.stats.histograms.contains a then idx
+  else
+    let key := idx.attrKey a
+    let datoms := idx.avet.collectFrom (AVETIndex.minForAttr key) (AVETIndex.matchesAttr key) (·.datom)
+    { idx with stats := idx.stats.trackValues a datoms }
 
 /-- Insert multiple datoms into all indexes. -/
 def insertDatoms (idx : Indexes) (ds : List Datom) : Indexes :=
   ds.foldl insertDatom idx
 
+/-- Build indexes from datoms, starting from an attribute table. -/
+def ofDatoms (attrs : AttrTable) (ds : List Datom) (trackStats : Bool := true) : Indexes :=
+  ({ empty with trackStats }.withAttrs attrs).insertDatoms ds
+
 /-- Remove multiple datoms from all indexes. -/
 def removeDatoms (idx : Indexes) (ds : List Datom) : Indexes :=
   ds.foldl removeDatom idx
@@ -73,11 +145,11 @@ def datomsForEntity (e : EntityId) (idx : Indexes) : List Datom :=
 
 /-- Get all datoms for an entity and attribute. -/
 def datomsForEntityAttr (e : EntityId) (a : Attribute) (idx : Indexes) : List Datom :=
-  idx.eavt.datomsForEntityAttr e a
+  idx.eavt.datomsForEntityAttr e (idx.attrKey a)
 
 /-- Get all datoms for an entity, attribute, and value. -/
 def datomsForEntityAttrValue (e : EntityId) (a : Attribute) (v : Value) (idx : Indexes) : List Datom :=
-  idx.eavt.datomsForEntityAttrValue e a v
+  idx.eavt.datomsForEntityAttrValue e (idx.attrKey a) v
 
 /-- Remove all datoms for a specific fact (entity, attribute, value). -/
 def removeFact (e : EntityId) (a : Attribute) (v : Value) (idx : Indexes) : Indexes :=
@@ -85,7 +157,7 @@ def removeFact (e : EntityId) (a : Attribute) (v : Value) (idx : Indexes) : Inde
 
 /-- Get values for an entity's attribute. -/
 def valuesForEntityAttr (e : EntityId) (a : Attribute) (idx : Indexes) : List Value :=
-  idx.eavt.valuesForEntityAttr e a
+  idx.eavt.valuesForEntityAttr e (idx.attrKey a)
 
 -- ============================================================
 -- Attribute-based queries (use AEVT)
@@ -93,11 +165,11 @@ def valuesForEntityAttr (e : EntityId) (a : Attribute) (idx : Indexes) : List Va
 
 /-- Get all datoms with a specific attribute. -/
 def datomsForAttr (a : Attribute) (idx : Indexes) : List Datom :=
-  idx.aevt.datomsForAttr a
+  idx.aevt.datomsForAttr (idx.attrKey a)
 
 /-- Get all entities that have a specific attribute. -/
 def entitiesWithAttr (a : Attribute) (idx : Indexes) : List EntityId :=
-  idx.aevt.entitiesWithAttr a
+  idx.aevt.entitiesWithAttr (idx.attrKey a)
 
 -- ============================================================
 -- Value-based queries (use AVET)
@@ -105,15 +177,15 @@ def entitiesWithAttr (a : Attribute) (idx : Indexes) : List EntityId :=
 
 /-- Get all datoms with a specific attribute and value. -/
 def datomsForAttrValue (a : Attribute) (v : Value) (idx : Indexes) : List Datom :=
-  idx.avet.datomsForAttrValue a v
+  idx.avet.datomsForAttrValue (idx.attrKey a) v
 
 /-- Get entities with a specific attribute value. -/
 def entitiesWithAttrValue (a : Attribute) (v : Value) (idx : Indexes) : List EntityId :=
-  idx.avet.entitiesWithAttrValue a v
+  idx.avet.entitiesWithAttrValue (idx.attrKey a) v
 
 /-- Get the first entity with a specific attribute value (for unique attrs). -/
 def entityWithAttrValue (a : Attribute) (v : Value) (idx : Indexes) : Option EntityId :=
-  idx.avet.entityWithAttrValue a v
+  idx.avet.entityWithAttrValue (idx.attrKey a) v
 
 -- ============================================================
 -- Reverse reference queries (use VAET)
@@ -129,11 +201,11 @@ def entitiesReferencing (target : EntityId) (idx : Indexes) : List EntityId :=
 
 /-- Get datoms referencing an entity via a specific attribute. -/
 def datomsReferencingViaAttr (target : EntityId) (a : Attribute) (idx : Indexes) : List Datom :=
-  idx.vaet.datomsReferencingViaAttr target a
+  idx.vaet.datomsReferencingViaAttr target (idx.attrKey a)
 
 /-- Get entities referencing a target via a specific attribute. -/
 def entitiesReferencingViaAttr (target : EntityId) (a : Attribute) (idx : Indexes) : List EntityId :=
-  idx.vaet.entitiesReferencingViaAttr target a
+  idx.vaet.entitiesReferencingViaAttr target (idx.attrKey a)
 
 end Indexes
 
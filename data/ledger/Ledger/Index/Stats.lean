@@ -0,0 +1,117 @@
+/-
+  Ledger.Index.Stats
+
+  Per-attribute statistics for query planning.
+  Kept exact and updated incrementally as datoms enter and leave the indexes.
+  Only counts are stored per attribute; whether a datom brings a new entity
+  or value is decided by the caller, which probes AEVT/AVET around the update.
+  A value histogram is kept only for attributes that are looked up by value
+  (schema `indexed` or `unique`).
+  Only asserted datoms are counted, since those are all a query can match.
+-/
+
+import Batteries.Data.RBMap
+import Ledger.Core.Datom
+
+namespace Ledger
+
+/-- Statistics for one attribute. -/
+structure AttrStats where
+  /-- Asserted datoms with this attribute. -/
+  datoms : Nat := 0
+  /-- Entities with at least one such datom. -/
+  distinctEntities : Nat := 0
+  /-- Distinct values among these datoms. -/
+  distinctValues : Nat := 0
+  /-- Datoms per value, for attributes with a histogram. -/
+  values : Option (Batteries.RBMap Value Nat compare) := none
+  deriving Inhabited
+
+namespace AttrStats
+
+/-- Count one more datom. `newEntity`/`newValue` say whether no other datom
+    of the attribute had its entity/value. -/
+def add (s : AttrStats) (d : Datom) (newEntity newValue : Bool) : AttrStats :=
+  { datoms := s.datoms + 1
+  , distinctEntities := if newEntity then s.distinctEntities + 1 else s.distinctEntities
+  , distinctValues := if newValue then s.distinctValues + 1 else s.distinctValues
+  , values := s.values.map fun m => m.insert d.value (m.findD d.value 0 + 1) }
+
+/-- Count one datom fewer. `goneEntity`/`goneValue` say whether it was the
+    last datom of the attribute with its entity/value. -/
+def remove (s : AttrStats) (d : Datom) (goneEntity goneValue : Bool) : AttrStats :=
+  { datoms := s.datoms - 1
+  , distinctEntities := if goneEntity then s.distinctEntities - 1 else s.distinctEntities
+  , distinctValues := if goneValue then s.distinctValues - 1 else s.distinctValues
+  , values := s.values.map fun m =>
+      match m.find? d.value with
+      | some n => if n ≤ 1 then m.erase d.value else m.insert d.value (n - 1)
+      | none => m }
+
+/-- Datoms with a given value, if the attribute keeps a histogram. -/
+def valueCount? (s : AttrStats) (v : Value) : Option Nat :=
+  s.values.map (·.findD v 0)
+
+/-- Average datoms per entity that has the attribute. -/
+def perEntity (s : AttrStats) : Float :=
+  s.datoms.toFloat / (max s.distinctEntities 1).toFloat
+
+/-- Average datoms per distinct value. -/
+def perValue (s : AttrStats) : Float :=
+  s.datoms.toFloat / (max s.distinctValues 1).toFloat
+
+end AttrStats
+
+/-- Statistics over all attributes of an index set. -/
+structure IndexStats where
+  /-- Per-attribute statistics. -/
+  attrs : Batteries.RBMap Attribute AttrStats compare := Batteries.RBMap.empty
+  /-- Asserted datoms in total. -/
+  datoms : Nat := 0
+  /-- Attributes that keep a value histogram. -/
+  histograms : Batteries.RBSet Attribute compare := Batteries.RBSet.empty
+  deriving Inhabited
+
+namespace IndexStats
+
+/-- No datoms. -/
+def empty : IndexStats := {}
+
+/-- Count an asserted datom. Retractions are ignored. -/
+def insertDatom (s : IndexStats) (d : Datom) (newEntity newValue : Bool) : IndexStats :=
+  if !d.added then s
+  else
+    let init : AttrStats := { values := if s.histograms.contains d.attr then some {} else none }
+    let attr := (s.attrs.findD d.attr init).add d newEntity newValue
+    { s with attrs := s.attrs.insert d.attr attr, datoms := s.datoms + 1 }
+
+/-- Stop counting an asserted datom. Retractions are ignored. -/
+def removeDatom (s : IndexStats) (d : Datom) (goneEntity goneValue : Bool) : IndexStats :=
+  if !d.added then s
+  else match s.attrs.find? d.attr with
+    | none => s
+    | some attr =>
+      let attr := attr.remove d goneEntity goneValue
+      let attrs := if attr.datoms == 0 then s.attrs.erase d.attr else s.attrs.insert d.attr attr
+      { s with attrs, datoms := s.datoms - 1 }
+
+/-- Keep a value histogram for `a`, starting from the given asserted datoms
+    (all of the attribute's datoms in the indexes). -/
+def trackValues (s : IndexStats) (a : Attribute) (datoms : Array Datom) : IndexStats :=
+  if s.histograms.contains a then s
+  else
+    let histograms := s.histograms.insert a
+    match s.attrs.find? a with
+    | none => { s with histograms }
+    | some attr =>
+      let values := datoms.foldl (init := (Batteries.RBMap.empty : Batteries.RBMap Value Nat compare))
+        fun m d => if d.added then m.insert d.value (m.findD d.value 0 + 1) else m
+      { s with histograms, attrs := s.attrs.insert a { attr with values := some values } }
+
+/-- Statistics for an attribute, if any datom has it. -/
+def forAttr? (s : IndexStats) (a : Attribute) : Option AttrStats :=
+  s.attrs.find? a
+
+end IndexStats
+
+end Ledger
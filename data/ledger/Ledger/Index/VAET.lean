@@ -6,52 +6,65 @@
   Only indexes datoms where the value is a reference (Value.ref).
 -/
 
-import Batteries.Data.RBMap
 import Batteries.Data.HashMap
 import Ledger.Core.Datom
 import Ledger.Index.Types
-import Ledger.Index.RBRange
+import Ledger.Index.BTree
 
 namespace Ledger
 
-/-- VAET index using RBMap for ordered access.
+/-- VAET index: a B+-tree of shared index entries in VAET order.
     Only contains datoms where value is a reference. -/
-abbrev VAETIndex := Batteries.RBMap VAETKey Datom compare
+abbrev VAETIndex := BTree IndexEntry IndexEntry.compareVAET
 
 namespace VAETIndex
 
+open IndexEntry (probe minAttr minEntity minTx)
+
 /-- Create an empty VAET index. -/
-def empty : VAETIndex := Batteries.RBMap.empty
+def empty : VAETIndex := BTree.empty
+
+/-- Create minimum entry for value-based range query (for reverse references). -/
+def minForValue (v : Value) : IndexEntry :=
+  probe minEntity minAttr v minTx
+
+/-- Create minimum entry for value+attr range query. -/
+def minForValueAttr (v : Value) (a : AttrKey) : IndexEntry :=
+  probe minEntity a v minTx
+
+/-- Check if entry matches value. -/
+def matchesValue (v : Value) (x : IndexEntry) : Bool := x.value == v
 
-/-- Create key from a datom. -/
-def keyOf (d : Datom) : VAETKey :=
-  { value := d.value
-  , attr := d.attr
-  , entity := d.entity
-  , tx := d.tx }
+/-- Check if entry matches value and attribute. -/
+def matchesValueAttr (v : Value) (a : AttrKey) (x : IndexEntry) : Bool :=
+  x.value == v && x.attr.sameAttr a
+
+/-- Insert an entry shared with the other indexes.
+    Only inserts if the value is a reference. -/
+def insertEntry (idx : VAETIndex) (x : IndexEntry) : VAETIndex :=
+  if x.value.isRef then idx.insert x else idx
+
+/-- Remove an entry.
+    Only removes if the value is a reference. -/
+def removeEntry (idx : VAETIndex) (x : IndexEntry) : VAETIndex :=
+  if x.value.isRef then idx.erase x else idx
 
 /-- Insert a datom into the index.
     Only inserts if the value is a reference. -/
-def insertDatom (idx : VAETIndex) (d : Datom) : VAETIndex :=
-  if d.value.isRef then
-    Batteries.RBMap.insert idx (keyOf d) d
-  else
-    idx
+def insertDatom (idx : VAETIndex) (d : Datom) (a : AttrKey := AttrKey.ofAttr d.attr) : VAETIndex :=
+  idx.insertEntry (IndexEntry.ofDatom d a)
 
 /-- Remove a datom from the index.
     Only removes if the value is a reference. -/
-def removeDatom (idx : VAETIndex) (d : Datom) : VAETIndex :=
-  if d.value.isRef then
-    Batteries.RBMap.erase idx (keyOf d)
-  else
-    idx
+def removeDatom (idx : VAETIndex) (d : Datom) (a : AttrKey := AttrKey.ofAttr d.attr) : VAETIndex :=
+  idx.removeEntry (IndexEntry.ofDatom d a)
 
 /-- Get all datoms that reference a specific entity.
     This is the primary use case for VAET - finding "who points to me".
     Uses early termination to avoid full index scan. -/
 def datomsReferencingEntity (target : EntityId) (idx : VAETIndex) : List Datom :=
   let refValue := Value.ref target
-  RBRange.collectFromWhile idx (VAETKey.minForValue refValue) (VAETKey.matchesValue refValue)
+  (idx.collectFrom (minForValue refValue) (matchesValue refValue) (·.datom)).toList
 
 /-- Get all entities that reference a specific entity.
     Implementation: O(n) using HashMap instead of O(n²) eraseDups. -/
@@ -67,21 +80,21 @@ def entitiesReferencing (target : EntityId) (idx : VAETIndex) : List EntityId :=
 /-- Get all datoms that reference a specific entity via a specific attribute.
     E.g., "find all entities where :person/friend points to entity X"
     Uses early termination to avoid full index scan. -/
-def datomsReferencingViaAttr (target : EntityId) (a : Attribute) (idx : VAETIndex) : List Datom :=
+def datomsReferencingViaAttr (target : EntityId) (a : AttrKey) (idx : VAETIndex) : List Datom :=
   let refValue := Value.ref target
-  RBRange.collectFromWhile idx (VAETKey.minForValueAttr refValue a) (VAETKey.matchesValueAttr refValue a)
+  (idx.collectFrom (minForValueAttr refValue a) (matchesValueAttr refValue a) (·.datom)).toList
 
 /-- Get entities that reference a target via a specific attribute. -/
-def entitiesReferencingViaAttr (target : EntityId) (a : Attribute) (idx : VAETIndex) : List EntityId :=
+def entitiesReferencingViaAttr (target : EntityId) (a : AttrKey) (idx : VAETIndex) : List EntityId :=
   (datomsReferencingViaAttr target a idx).map (·.entity)
 
 /-- Get all datoms in the index. -/
 def allDatoms (idx : VAETIndex) : List Datom :=
-  (Batteries.RBMap.toList idx).map Prod.snd
+  (idx.foldl (fun acc x => acc.push x.datom) #[]).toList
 
 /-- Count of datoms in the index (only ref datoms). -/
 def count (idx : VAETIndex) : Nat :=
-  Batteries.RBMap.size idx
+  idx.size
 
 end VAETIndex
 
@@ -48,23 +48,11 @@ def readJournalSince (path : System.FilePath) (txId : TxId) : IO (Array TxLogEnt
 
 /-- Apply a log entry to a connection (replay). -/
 private def applyEntry (conn : Connection) (entry : TxLogEntry) : Connection := Id.run do
-  -- Update indexes (current + history)
-  let mut indexes := conn.db.indexes
-  let mut historyIndexes := conn.db.historyIndexes
-  let mut currentFacts := conn.db.currentFacts
-  for datom in entry.datoms do
-    historyIndexes := historyIndexes.insertDatom datom
-    if datom.added then
-      let key := FactKey.ofDatom datom
-      if let some prev := currentFacts[key]? then
-        indexes := indexes.removeDatom prev
-      indexes := indexes.insertDatom datom
-      currentFacts := currentFacts.insert key datom
-    else
-      let key := FactKey.ofDatom datom
-      if let some prev := currentFacts[key]? then
-        indexes := indexes.removeDatom prev
-      currentFacts := currentFacts.erase key
+  -- Share the interned attribute name rather than keep the parsed copy
+  let (_, datoms) := entry.datoms.foldl (init := (conn.db.attrs, (#[] : Array Datom)))
+    fun (attrs, datoms) d =>
+      let (key, attrs) := attrs.intern d.attr
+      (attrs, datoms.push { d with attr := key.attr })
 
   -- Find max entity ID to update nextEntityId
   let mut maxEntityId := conn.db.nextEntityId.id
@@ -72,18 +60,11 @@ private def applyEntry (conn : Connection) (entry : TxLogEntry) : Connection :=
     if datom.entity.id > maxEntityId then
       maxEntityId := datom.entity.id
 
-  -- Create new database state
-  let db' : Db := {
-    basisT := entry.txId
-    indexes := indexes
-    historyIndexes := historyIndexes
-    currentFacts := currentFacts
-    nextEntityId := ⟨maxEntityId + 1⟩
-  }
+  -- Update indexes (current + history)
+  let db' := { conn.db.replayTx entry.txId datoms with nextEntityId := ⟨maxEntityId + 1⟩ }
 
   -- Add to transaction log
-  let txLog' := conn.txLog.add entry
-  return { db := db', txLog := txLog' }
+  return conn.appendTx db' entry
 
 /-- Replay an array of entries into a connection. -/
 def replayEntries (conn : Connection) (entries : Array TxLogEntry) : Connection :=
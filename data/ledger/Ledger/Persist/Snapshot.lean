@@ -8,6 +8,7 @@ import Ledger.Core.EntityId
 import Ledger.Core.Attribute
 import Ledger.Core.Value
 import Ledger.Core.Datom
+import Ledger.Core.AttrTable
 import Ledger.Db.Database
 import Ledger.Db.Connection
 import Ledger.Index.Manager
@@ -42,6 +43,8 @@ structure Snapshot where
   nextEntityId : EntityId
   currentFacts : Array Datom
   txLog : Array TxLogEntry
+  /-- Interned attributes in id order, so ids survive a reload. -/
+  attrs : Array Attribute := #[]
   deriving Repr, Inhabited
 
 namespace Snapshot
@@ -52,14 +55,16 @@ def defaultPath (journalPath : System.FilePath) : System.FilePath :=
 
 /-- Build a snapshot from a connection using a retention policy. -/
 def fromConnectionWithRetention (conn : Connection) (retention : HistoryRetention) : Snapshot :=
-  let facts := conn.db.currentFacts.toList.map Prod.snd
+  -- The current indexes hold exactly the visible datoms
+  let facts := conn.db.indexes.allDatoms
   let txLog := match retention with
     | .bounded => #[]
     | .preserveFull => conn.txLog
   { basisT := conn.db.basisT
   , nextEntityId := conn.db.nextEntityId
   , currentFacts := facts.toArray
-  , txLog := txLog }
+  , txLog := txLog
+  , attrs := conn.db.attrs.names }
 
 /-- Build a snapshot from a connection. -/
 def fromConnection (conn : Connection) : Snapshot :=
@@ -67,15 +72,19 @@ def fromConnection (conn : Connection) : Snapshot :=
 
 /-- Build a connection from a snapshot. -/
 def toConnection (snap : Snapshot) : Connection :=
-  let currentFacts := Db.currentFactsFromDatoms snap.currentFacts.toList
-  let indexes := snap.currentFacts.toList.foldl Indexes.insertDatom Indexes.empty
   let historyDatoms := (snap.txLog.toList.map fun entry => entry.datoms.toList).flatten
-  let historyIndexes := historyDatoms.foldl Indexes.insertDatom Indexes.empty
+  -- Older snapshots carry no table; any attribute missing from it is
+  -- interned after the stored ones
+  let attrs := (AttrTable.ofNames snap.attrs).internAll <|
+    (snap.currentFacts.toList ++ historyDatoms).map (·.attr)
+  let share (d : Datom) : Datom := { d with attr := attrs.canonical d.attr }
+  let facts := snap.currentFacts.toList.map share
+  let indexes := Indexes.ofDatoms attrs facts
+  let historyIndexes := Indexes.ofDatoms attrs (historyDatoms.map share) (trackStats := false)
   let db : Db := {
     basisT := snap.basisT
     indexes := indexes
     historyIndexes := historyIndexes
-    currentFacts := currentFacts
     nextEntityId := snap.nextEntityId
   }
   { db := db, txLog := snap.txLog }
@@ -92,7 +101,9 @@ def toJson (snap : Snapshot) : String := Id.run do
     if i > 0 then logJson := logJson ++ ","
     logJson := logJson ++ txLogEntryToJson snap.txLog[i]!
 
-  s!"\{\"basisT\":{snap.basisT.id},\"nextEntityId\":{snap.nextEntityId.id},\"currentFacts\":[{factsJson}],\"txLog\":[{logJson}]}"
+  let attrsJson := ",".intercalate (snap.attrs.toList.map fun a => s!"\"{escapeString a.name}\"")
+
+  s!"\{\"basisT\":{snap.basisT.id},\"nextEntityId\":{snap.nextEntityId.id},\"attrs\":[{attrsJson}],\"currentFacts\":[{factsJson}],\"txLog\":[{logJson}]}"
 
 private def fromJsonValue (v : JValue) : Option Snapshot := do
   let basisT ← getNatField? "basisT" v
@@ -110,11 +121,18 @@ private def fromJsonValue (v : JValue) : Option Snapshot := do
     let entry ← txLogEntryFromJsonValue logVal
     entries := entries.push entry
 
+  -- Absent in snapshots written before attribute interning
+  let mut attrs : Array Attribute := #[]
+  for attrVal in (getArrField? "attrs" v).getD #[] do
+    let name ← (attrVal.getStr?).toOption
+    attrs := attrs.push ⟨name⟩
+
   return {
     basisT := ⟨basisT⟩
     nextEntityId := ⟨nextEntityId⟩
     currentFacts := facts
     txLog := entries
+    attrs := attrs
   }
 
 /-- Deserialize a snapshot from JSON string. -/
@@ -20,7 +20,7 @@ inductive BoundValue where
   | value (v : Value)
   /-- Bound to an attribute. -/
   | attr (a : Attribute)
-  deriving Repr, BEq, Inhabited
+  deriving Repr, BEq, Hashable, Inhabited
 
 namespace BoundValue
 
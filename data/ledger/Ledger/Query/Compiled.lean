@@ -0,0 +1,678 @@
+/-
+  Ledger.Query.Compiled
+
+  Compiled query engine.
+  Resolves query variables to slot numbers, evaluates clauses over columnar
+  tables, orders patterns by estimated cardinality as variables become bound,
+  and picks an index nested-loop join or a hash join for each pattern from
+  estimates taken at run time.
+-/
+
+import Std.Data.HashMap
+import Std.Data.HashSet
+import Ledger.Core.Datom
+import Ledger.Index.Manager
+import Ledger.Db.Database
+import Ledger.Query.AST
+import Ledger.Query.Binding
+import Ledger.Query.Predicate
+import Ledger.Query.PredicateEval
+import Ledger.Query.IndexSelect
+import Ledger.Query.Rules
+import Ledger.Query.Planner
+import Ledger.Query.Executor
+
+namespace Ledger
+
+namespace Query
+
+/-- Which engine evaluates a query. -/
+inductive Engine where
+  /-- Binding-at-a-time nested loops over `Relation` (`Query.execute`). -/
+  | nested
+  /-- Slot-compiled columnar evaluation with cost-based ordering and join selection. -/
+  | compiled
+  deriving Repr, BEq, Inhabited
+
+/-- A pattern position after compilation. -/
+inductive SlotTerm where
+  /-- A constant from the query. -/
+  | const (t : Term)
+  /-- A variable, by slot number. -/
+  | slot (i : Nat)
+  /-- A wildcard. -/
+  | blank
+  deriving Repr, Inhabited
+
+/-- A pattern with its variables resolved to slots. -/
+structure SlotPattern where
+  entity : SlotTerm
+  attr : SlotTerm
+  value : SlotTerm
+  deriving Repr, Inhabited
+
+/-- One step of a compiled query. -/
+inductive CompiledStep where
+  /-- Join the table with a pattern. -/
+  | pattern (p : SlotPattern)
+  /-- Keep the rows that satisfy a predicate; `slots` are its variables. -/
+  | predicate (p : Predicate) (slots : Array Nat)
+  /-- Any other clause (or, not, rule call), run by `executeClause`
+      on the table's rows as bindings. -/
+  | fallback (c : Clause)
+  deriving Repr, Inhabited
+
+/-- A query compiled to slot form. -/
+structure CompiledQuery where
+  /-- Variable held by each slot. -/
+  slots : Array Var
+  /-- Steps in execution order. -/
+  steps : Array CompiledStep
+  /-- Slot of each :find variable. -/
+  findSlots : Array Nat
+  /-- The :find variables. -/
+  find : List Var
+  deriving Repr, Inhabited
+
+namespace CompiledQuery
+
+private def compileTerm (slotIndex : Std.HashMap Var Nat) : Term → SlotTerm
+  | .var v =>
+    match slotIndex[v]? with
+    | some i => .slot i
+    | none => .blank
+  | .blank => .blank
+  | t => .const t
+
+/-- Compile a clause, flattening nested `and`s into consecutive steps. -/
+private def compileClause (slotIndex : Std.HashMap Var Nat) : Clause → Array CompiledStep
+  | .pattern p =>
+    #[.pattern { entity := compileTerm slotIndex p.entity
+               , attr := compileTerm slotIndex p.attr
+               , value := compileTerm slotIndex p.value }]
+  | .predicate p => #[.predicate p ((Predicate.vars p).toArray.filterMap fun v => slotIndex[v]?)]
+  | .and cs => (cs.map (compileClause slotIndex)).foldl (· ++ ·) #[]
+  | c => #[.fallback c]
+
+/-- Compile a query. Each variable gets a slot, in order of first appearance. -/
+def compile (query : Query) : CompiledQuery :=
+  let slots := (query.whereVars ++ query.find).eraseDups.toArray
+  let slotIndex : Std.HashMap Var Nat :=
+    (List.range slots.size).foldl (fun m i => m.insert slots[i]! i) {}
+  let steps := query.where_.foldl (fun acc c => acc ++ compileClause slotIndex c) #[]
+  { slots
+  , steps
+  , findSlots := query.find.toArray.map fun v => slotIndex[v]?.getD 0
+  , find := query.find }
+
+end CompiledQuery
+
+/-- An intermediate result stored by column, one array per slot.
+    A slot is either bound in every row or in none; an unbound slot's
+    column is empty. -/
+structure Table where
+  columns : Array (Array BoundValue)
+  bound : Array Bool
+  size : Nat
+  deriving Inhabited
+
+namespace Table
+
+/-- A single row with nothing bound, the input to every query. -/
+def unit (width : Nat) : Table :=
+  { columns := Array.replicate width #[]
+  , bound := Array.replicate width false
+  , size := 1 }
+
+/-- The value of a bound slot in a row. -/
+@[inline] def get (t : Table) (slot row : Nat) : BoundValue :=
+  t.columns[slot]![row]!
+
+/-- Keep the given rows, in the given order. Rows may repeat. -/
+def gather (t : Table) (rows : Array Nat) : Table := Id.run do
+  let mut columns := t.columns
+  for slot in [:columns.size] do
+    if t.bound[slot]! then
+      let col := t.columns[slot]!
+      columns := columns.set! slot (rows.map fun r => col[r]!)
+  return { t with columns, size := rows.size }
+
+/-- The bindings of one row. -/
+def rowBinding (t : Table) (slots : Array Var) (row : Nat) : Binding := Id.run do
+  let mut b := Binding.empty
+  for slot in [:slots.size] do
+    if t.bound[slot]! then
+      b := b.bind slots[slot]! (t.get slot row)
+  return b
+
+/-- Convert to a relation, one binding per row. -/
+def toRelation (t : Table) (slots : Array Var) : Relation :=
+  ⟨(List.range t.size).map (t.rowBinding slots)⟩
+
+/-- Convert from a relation. A variable counts as bound only if every
+    binding binds it. -/
+def ofRelation (rel : Relation) (slots : Array Var) : Table := Id.run do
+  let rows := rel.bindings.toArray
+  let mut columns : Array (Array BoundValue) := Array.replicate slots.size #[]
+  let mut bound := Array.replicate slots.size false
+  if !rows.isEmpty then
+    for slot in [:slots.size] do
+      let v := slots[slot]!
+      let values := rows.filterMap (·.lookup v)
+      if values.size == rows.size then
+        columns := columns.set! slot values
+        bound := bound.set! slot true
+  return { columns, bound, size := rows.size }
+
+end Table
+
+/-! ## Pattern joins -/
+
+/-- A datom field, and how the nested-loop engine's unification treats it. -/
+private inductive Field where
+  | entity
+  | attr
+  | value
+
+namespace Field
+
+/-- The field of a datom, as a bound value. -/
+private def read : Field → Datom → BoundValue
+  | .entity, d => .entity d.entity
+  | .attr, d => .attr d.attr
+  | .value, d => .value d.value
+
+/-- A bound value in the form `read` would produce for this field, or `none`
+    if no datom field can match it. Entities and refs are interchangeable,
+    as in `Unify`. -/
+private def normalize : Field → BoundValue → Option BoundValue
+  | .entity, bv => bv.asEntity?.map .entity
+  | .attr, bv@(.attr _) => some bv
+  | .attr, _ => none
+  | .value, bv => bv.asValue?.map .value
+
+/-- Whether a constant term matches this field of a datom. -/
+private def acceptsConst : Field → Term → Datom → Bool
+  | .entity, .entity e, d => e == d.entity
+  | .attr, .attr a, d => a == d.attr
+  | .value, .value v, d => v == d.value
+  | .value, .entity e, d => d.value == .ref e
+  | _, _, _ => false
+
+/-- Whether a value already bound to a variable matches this field of a datom. -/
+private def accepts (f : Field) (bv : BoundValue) (d : Datom) : Bool :=
+  f.normalize bv == some (f.read d)
+
+end Field
+
+/-- What one pattern position needs, given which slots the table binds. -/
+private inductive Pos where
+  /-- A constant. -/
+  | const (t : Term)
+  /-- A slot the table already binds. -/
+  | bound (slot : Nat)
+  /-- The first occurrence of a slot this pattern binds; `k` indexes `JoinSpec.fresh`. -/
+  | fresh (k : Nat)
+  /-- A later occurrence of fresh slot `k` in the same pattern. -/
+  | again (k : Nat)
+  /-- A wildcard. -/
+  | blank
+
+/-- A pattern specialised to the slots bound in a table. -/
+private structure JoinSpec where
+  entity : Pos
+  attr : Pos
+  value : Pos
+  /-- Slots the pattern binds, in order of first occurrence. -/
+  fresh : Array Nat
+
+private def classify (t : Table) (fresh : Array Nat) : SlotTerm → Pos × Array Nat
+  | .const c => (.const c, fresh)
+  | .blank => (.blank, fresh)
+  | .slot s =>
+    if t.bound[s]! then (.bound s, fresh)
+    else match fresh.findIdx? (· == s) with
+      | some k => (.again k, fresh)
+      | none => (.fresh fresh.size, fresh.push s)
+
+namespace JoinSpec
+
+private def build (p : SlotPattern) (t : Table) : JoinSpec :=
+  let (entity, fresh) := classify t #[] p.entity
+  let (attr, fresh) := classify t fresh p.attr
+  let (value, fresh) := classify t fresh p.value
+  { entity, attr, value, fresh }
+
+private def positions (spec : JoinSpec) : List (Field × Pos) :=
+  [(.entity, spec.entity), (.attr, spec.attr), (.value, spec.value)]
+
+/-- Slots shared with the table, as (field, slot) pairs. These are the join key. -/
+private def sharedSlots (spec : JoinSpec) : Array (Field × Nat) :=
+  spec.positions.foldl (init := #[]) fun acc (f, pos) =>
+    match pos with
+    | .bound s => acc.push (f, s)
+    | _ => acc
+
+private def stepField (f : Field) (pos : Pos) (t : Table) (row : Nat) (d : Datom)
+    (acc : Array BoundValue) : Option (Array BoundValue) :=
+  match pos with
+  | .const c => if f.acceptsConst c d then some acc else none
+  | .bound s => if f.accepts (t.get s row) d then some acc else none
+  | .fresh _ => some (acc.push (f.read d))
+  | .again k => if f.accepts acc[k]! d then some acc else none
+  | .blank => some acc
+
+/-- Match a datom against the pattern for one row. Returns the values of the
+    fresh slots, in `fresh` order. Same semantics as `Unify.unifyDatom`. -/
+private def extend (spec : JoinSpec) (t : Table) (row : Nat) (d : Datom) :
+    Option (Array BoundValue) :=
+  if !d.added then none
+  else do
+    let acc ← stepField .entity spec.entity t row d #[]
+    let acc ← stepField .attr spec.attr t row d acc
+    stepField .value spec.value t row d acc
+
+/-- The entity, attribute and value the pattern pins down, reading bound
+    slots from `row?` (or treating them as unknown when `row?` is `none`).
+    Returns `none` if a bound slot holds something no datom can match. -/
+private def lookupKey (spec : JoinSpec) (t : Table) (row? : Option Nat) :
+    Option (Option EntityId × Option Attribute × Option Value) := do
+  let e? ← match spec.entity, row? with
+    | .const (.entity e), _ => some (some e)
+    | .const _, _ => none
+    | .bound s, some row => (t.get s row).asEntity?.map some
+    | _, _ => some none
+  let a? ← match spec.attr, row? with
+    | .const (.attr a), _ => some (some a)
+    | .const _, _ => none
+    | .bound s, some row =>
+      match t.get s row with
+      | .attr a => some (some a)
+      | _ => none
+    | _, _ => some none
+  let v? ← match spec.value, row? with
+    | .const (.value v), _ => some (some v)
+    | .const (.entity e), _ => some (some (.ref e))
+    | .const _, _ => none
+    | .bound s, some row => (t.get s row).asValue?.map some
+    | _, _ => some none
+  return (e?, a?, v?)
+
+end JoinSpec
+
+/-- Join strategy for one pattern step. -/
+inductive JoinMethod where
+  /-- No variable shared with the table: fetch the matches once and pair
+      them with every row. -/
+  | scan
+  /-- Look up each row's matches in an index. -/
+  | indexNestedLoop
+  /-- Fetch the pattern's candidates once, hash them on the shared slots,
+      and probe with each row. -/
+  | hash
+  deriving Repr, BEq, Inhabited
+
+instance : ToString JoinMethod where
+  toString
+    | .scan => "scan"
+    | .indexNestedLoop => "index nested loop"
+    | .hash => "hash join"
+
+/-- Rows sampled to estimate the average index lookup size. -/
+private def probeSampleSize : Nat := 8
+
+/-- Most datoms counted per sampled lookup. -/
+private def probeLimit : Nat := 4096
+
+/-- Rough cost of one index seek, in datoms visited. -/
+private def seekCost : Nat := 8
+
+/-- Estimated cost of each join method, in datoms visited. Uses bounded
+    index counts, so estimating never costs more than the cheaper plan. -/
+private def estimateJoin (spec : JoinSpec) (t : Table) (idx : Indexes) : Nat × Nat := Id.run do
+  -- Nested loop: average lookup size over a few evenly spaced rows
+  let samples := min probeSampleSize t.size
+  let stride := max 1 (t.size / max samples 1)
+  let mut probed := 0
+  for i in [:samples] do
+    match spec.lookupKey t (some (i * stride)) with
+    | some (e?, a?, v?) => probed := probed + IndexSelect.countByKnown e? a? v? probeLimit idx
+    | none => pure ()
+  let avgProbe := probed / max samples 1
+  let nestedCost := t.size * (seekCost + avgProbe)
+  -- Hash: one fetch of the constant-only candidates, then one probe per row
+  let build := match spec.lookupKey t none with
+    | some (e?, a?, v?) => IndexSelect.countByKnown e? a? v? (nestedCost + 1) idx
+    | none => 0
+  return (nestedCost, build + t.size)
+
+/-- Extend the table with one pattern's matches: `rows` are the source rows,
+    `values` the matching fresh-slot values, in step. -/
+private def applyMatches (spec : JoinSpec) (t : Table) (rows : Array Nat)
+    (values : Array (Array BoundValue)) : Table := Id.run do
+  let mut out := t.gather rows
+  for k in [:spec.fresh.size] do
+    let slot := spec.fresh[k]!
+    out := { out with
+      columns := out.columns.set! slot (values.map (·[k]!))
+      bound := out.bound.set! slot true }
+  return out
+
+private def nestedLoopJoin (spec : JoinSpec) (t : Table) (idx : Indexes) : Table := Id.run do
+  let mut rows : Array Nat := #[]
+  let mut values : Array (Array BoundValue) := #[]
+  for row in [:t.size] do
+    if let some (e?, a?, v?) := spec.lookupKey t (some row) then
+      for d in IndexSelect.fetchByKnown e? a? v? idx do
+        if let some vals := spec.extend t row d then
+          rows := rows.push row
+          values := values.push vals
+  return applyMatches spec t rows values
+
+private def hashJoin (spec : JoinSpec) (t : Table) (idx : Indexes) : Table := Id.run do
+  let mut rows : Array Nat := #[]
+  let mut values : Array (Array BoundValue) := #[]
+  let some (e?, a?, v?) := spec.lookupKey t none
+    | return applyMatches spec t rows values
+  let shared := spec.sharedSlots
+  -- Build: candidates keyed by the fields the table shares with the pattern
+  let mut buckets : Std.HashMap (Array BoundValue) (Array Datom) := {}
+  for d in IndexSelect.fetchByKnown e? a? v? idx do
+    if d.added then
+      let key := shared.map fun (f, _) => f.read d
+      buckets := buckets.alter key fun
+        | some ds => some (ds.push d)
+        | none => some #[d]
+  -- Probe: each row's shared values, normalised the same way
+  for row in [:t.size] do
+    let key? := shared.mapM fun (f, s) => f.normalize (t.get s row)
+    if let some key := key? then
+      if let some ds := buckets[key]? then
+        for d in ds do
+          if let some vals := spec.extend t row d then
+            rows := rows.push row
+            values := values.push vals
+  return applyMatches spec t rows values
+
+/-- Join strategy the compiled engine would pick for a pattern against a table. -/
+private def chooseJoin (spec : JoinSpec) (t : Table) (idx : Indexes) : JoinMethod :=
+  if spec.sharedSlots.isEmpty then .scan
+  else
+    let (nestedCost, hashCost) := estimateJoin spec t idx
+    if hashCost < nestedCost then .hash else .indexNestedLoop
+
+/-- Join a table with a pattern, choosing the join method from estimates.
+    Also returns the method used, or `none` if the table was already empty. -/
+def joinPatternWith (p : SlotPattern) (t : Table) (idx : Indexes) : Table × Option JoinMethod :=
+  let spec := JoinSpec.build p t
+  if t.size == 0 then (applyMatches spec t #[] #[], none)
+  else
+    let method := chooseJoin spec t idx
+    let out := match method with
+      | .scan | .hash => hashJoin spec t idx
+      | .indexNestedLoop => nestedLoopJoin spec t idx
+    (out, some method)
+
+/-- Join a table with a pattern, choosing the join method from estimates. -/
+def joinPattern (p : SlotPattern) (t : Table) (idx : Indexes) : Table :=
+  (joinPatternWith p t idx).1
+
+/-! ## Planning and execution -/
+
+/-- One step as it ran. -/
+structure StepTrace where
+  step : CompiledStep
+  /-- Join method, for patterns. -/
+  join : Option JoinMethod := none
+  /-- Rows the planner expected after the step, when it had an estimate. -/
+  estimated : Option Nat := none
+  /-- Rows after the step. -/
+  actual : Nat
+  deriving Repr, Inhabited
+
+private def posInfo (t : Table) : SlotTerm → Planner.PosInfo
+  | .const c => .const c
+  | .slot s => if t.bound[s]! then .bound else .free
+  | .blank => .free
+
+/-- Expected rows after joining a pattern, from the index statistics. -/
+private def estimateStep (p : SlotPattern) (t : Table) (stats : IndexStats) : Float :=
+  t.size.toFloat * Planner.estimate stats (posInfo t p.entity) (posInfo t p.attr) (posInfo t p.value)
+
+private def slotsOf (p : SlotPattern) : List Nat :=
+  [p.entity, p.attr, p.value].filterMap fun
+    | .slot s => some s
+    | _ => none
+
+private def filterPredicate (cq : CompiledQuery) (p : Predicate) (t : Table) : Table :=
+  let vars := Predicate.vars p
+  let keep := (List.range t.size).toArray.filter fun row =>
+    let b := (t.rowBinding cq.slots row).project vars
+    Predicate.eval p b
+  t.gather keep
+
+/-- Rewrite a slot's column to the form the field it was first bound from
+    gives (entity vs. ref value), so reordering never changes output. -/
+private def restoreForm (t : Table) (slot : Nat) (f : Field) : Table :=
+  match f with
+  | .attr => t
+  | _ =>
+    { t with columns := t.columns.modify slot (·.map fun bv => (f.normalize bv).getD bv) }
+
+/-- The steps from `start` that the planner may reorder freely: patterns,
+    and predicates whose variables are all bound by then in the written
+    order. Stops at anything whose result depends on what is bound when it
+    runs (or, not, rule calls, predicates over unbound variables). -/
+private def segmentAt (steps : Array CompiledStep) (start : Nat) (bound : Array Bool) :
+    Array CompiledStep := Id.run do
+  let mut bound := bound
+  let mut seg : Array CompiledStep := #[]
+  for step in steps[start:] do
+    match step with
+    | .pattern p =>
+      seg := seg.push step
+      for s in slotsOf p do
+        bound := bound.set! s true
+    | .predicate _ slots =>
+      if slots.all (fun s => bound[s]!) then seg := seg.push step else break
+    | .fallback _ => break
+  return seg
+
+/-- Run a segment, picking at each point the pattern expected to produce the
+    fewest rows given what is bound, and filtering with each predicate as
+    soon as its variables are bound. -/
+private def runSegment (cq : CompiledQuery) (idx : Indexes) (seg : Array CompiledStep)
+    (t : Table) (trace : Array StepTrace) : Table × Array StepTrace := Id.run do
+  -- Field each slot would first be bound from in the written order
+  let mut firstForm : Array (Nat × Field) := #[]
+  let mut seen := t.bound
+  for step in seg do
+    if let .pattern p := step then
+      for (term, f) in [(p.entity, Field.entity), (p.attr, .attr), (p.value, .value)] do
+        if let .slot s := term then
+          if !seen[s]! then
+            seen := seen.set! s true
+            firstForm := firstForm.push (s, f)
+  let mut t := t
+  let mut trace := trace
+  let mut pending := seg
+  let mut reordered := false
+  while !pending.isEmpty do
+    let ready := pending.findIdx? fun
+      | .predicate _ slots => slots.all (fun s => t.bound[s]!)
+      | _ => false
+    match ready with
+    | some i =>
+      let step := pending[i]!
+      if let .predicate p _ := step then
+        t := filterPredicate cq p t
+      trace := trace.push { step, estimated := none, actual := t.size }
+      reordered := reordered || i != 0
+      pending := pending.eraseIdx! i
+    | none =>
+      -- Cheapest pattern; ties keep the written order
+      let mut best : Option (Nat × Float) := none
+      for i in [:pending.size] do
+        if let .pattern p := pending[i]! then
+          let est := estimateStep p t idx.stats
+          match best with
+          | some (_, cost) => if est < cost then best := some (i, est)
+          | none => best := some (i, est)
+      match best with
+      | some (i, est) =>
+        let step := pending[i]!
+        if let .pattern p := step then
+          let (t', join) := joinPatternWith p t idx
+          t := t'
+          trace := trace.push { step, join, estimated := some est.round.toUInt64.toNat, actual := t.size }
+        reordered := reordered || i != 0
+        pending := pending.eraseIdx! i
+      | none =>
+        -- Only predicates left; they are all ready by construction
+        let step := pending[0]!
+        if let .predicate p _ := step then
+          t := filterPredicate cq p t
+        trace := trace.push { step, estimated := none, actual := t.size }
+        pending := pending.eraseIdx! 0
+  if reordered then
+    for (s, f) in firstForm do
+      t := restoreForm t s f
+  return (t, trace)
+
+/-- Run a compiled query without projection, recording each step. -/
+def CompiledQuery.runTraced (cq : CompiledQuery) (idx : Indexes) (rules : RuleEnv) :
+    Table × Array StepTrace := Id.run do
+  let mut t := Table.unit cq.slots.size
+  let mut trace : Array StepTrace := #[]
+  let mut i := 0
+  while i < cq.steps.size do
+    let seg := segmentAt cq.steps i t.bound
+    if seg.isEmpty then
+      let step := cq.steps[i]!
+      t := match step with
+        | .predicate p _ => filterPredicate cq p t
+        | .fallback c => Table.ofRelation (executeClause c (t.toRelation cq.slots) idx rules) cq.slots
+        | .pattern p => joinPattern p t idx
+      trace := trace.push { step, actual := t.size }
+      i := i + 1
+    else
+      let (t', trace') := runSegment cq idx seg t trace
+      t := t'
+      trace := trace'
+      i := i + seg.size
+  return (t, trace)
+
+/-- Run a compiled query without projection. -/
+def CompiledQuery.run (cq : CompiledQuery) (idx : Indexes) (rules : RuleEnv) : Table :=
+  (cq.runTraced idx rules).1
+
+/-- Project a table onto the :find variables, dropping duplicate rows. -/
+private def projectDistinct (cq : CompiledQuery) (t : Table) : Relation := Id.run do
+  let found := (cq.find.toArray.zip cq.findSlots).filter fun (_, s) => t.bound[s]!
+  let mut seen : Std.HashSet (Array BoundValue) := {}
+  let mut out : Array Binding := #[]
+  for row in [:t.size] do
+    let key := found.map fun (_, s) => t.get s row
+    if !seen.contains key then
+      seen := seen.insert key
+      out := out.push (Binding.ofList (found.toList.map fun (v, s) => (v, t.get s row)))
+  return ⟨out.toList⟩
+
+/-- Execute a query with the compiled engine.
+    Patterns are reordered by estimated cardinality as variables become
+    bound, and each is joined by whichever method looks cheaper. Clauses whose
+    meaning depends on what is bound (or, not, rule calls) stay where they
+    are written. Returns the same rows as `execute`, possibly in a different
+    order. -/
+def executeCompiled (query : Query) (db : Db) : QueryResult :=
+  let cq := CompiledQuery.compile query
+  let ruleEnv := buildRuleEnv query.rules db.indexes
+  let table := cq.run db.indexes ruleEnv
+  { columns := query.find
+  , rows := projectDistinct cq table }
+
+/-- Execute a query with the chosen engine. -/
+def executeWith (engine : Engine) (query : Query) (db : Db) : QueryResult :=
+  match engine with
+  | .nested => execute query db
+  | .compiled => executeCompiled query db
+
+/-! ## Explain -/
+
+/-- One line of a query plan. -/
+structure PlanStep where
+  /-- The clause, in Datalog-like notation. -/
+  clause : String
+  /-- Join method, for patterns. -/
+  join : Option JoinMethod
+  /-- Rows the planner expected after the step. -/
+  estimated : Option Nat
+  /-- Rows after the step. -/
+  actual : Nat
+  deriving Repr, Inhabited
+
+/-- The plan the compiled engine chose for a query, with row counts. -/
+structure QueryPlan where
+  /-- Steps in the order they ran. -/
+  steps : Array PlanStep
+  /-- Rows after projection and de-duplication. -/
+  rows : Nat
+  deriving Repr, Inhabited
+
+private def termString (slots : Array Var) : SlotTerm → String
+  | .slot i => toString slots[i]!
+  | .blank => "_"
+  | .const (.entity e) => toString e
+  | .const (.attr a) => toString a
+  | .const (.value v) => toString v
+  | .const (.var v) => toString v
+  | .const .blank => "_"
+
+private def stepString (slots : Array Var) : CompiledStep → String
+  | .pattern p =>
+    s!"[{termString slots p.entity} {termString slots p.attr} {termString slots p.value}]"
+  | .predicate p _ =>
+    s!"predicate on {", ".intercalate ((Predicate.vars p).map toString)}"
+  | .fallback (.or cs) => s!"or ({cs.length} branches)"
+  | .fallback (.not _) => "not"
+  | .fallback (.rule call) => s!"rule {call.name}"
+  | .fallback _ => "clause"
+
+namespace QueryPlan
+
+/-- Render one step per line: clause, join method, estimated and actual rows. -/
+def format (plan : QueryPlan) : String := Id.run do
+  let mut lines : Array String := #[]
+  let mut n := 1
+  for step in plan.steps do
+    let join := match step.join with
+      | some j => s!"  {j}"
+      | none => ""
+    let est := match step.estimated with
+      | some e => toString e
+      | none => "-"
+    lines := lines.push s!"{n}. {step.clause}{join}  est {est}  actual {step.actual}"
+    n := n + 1
+  lines := lines.push s!"=> {plan.rows} rows"
+  return "\n".intercalate lines.toList
+
+instance : ToString QueryPlan := ⟨format⟩
+
+end QueryPlan
+
+/-- Run a query with the compiled engine and report the plan it chose,
+    with estimated and actual row counts per step. -/
+def explain (query : Query) (db : Db) : QueryPlan :=
+  let cq := CompiledQuery.compile query
+  let ruleEnv := buildRuleEnv query.rules db.indexes
+  let (table, trace) := cq.runTraced db.indexes ruleEnv
+  { steps := trace.map fun st =>
+      { clause := stepString cq.slots st.step
+      , join := st.join
+      , estimated := st.estimated
+      , actual := st.actual }
+  , rows := (projectDistinct cq table).size }
+
+end Query
+
+end Ledger
@@ -16,6 +16,7 @@ import Ledger.Query.Predicate
 import Ledger.Query.PredicateEval
 import Ledger.Query.IndexSelect
 import Ledger.Query.Rules
+import Ledger.Query.Planner
 
 namespace Ledger
 
@@ -50,21 +51,26 @@ def executePattern (pattern : Pattern) (b : Binding) (idx : Indexes) : Relation
   Unify.matchPattern pattern candidates b
 
 /-- Order patterns by selectivity for more efficient execution.
-    More bound patterns should execute first. -/
-def orderPatterns (patterns : List Pattern) (b : Binding) : List Pattern :=
-  patterns.toArray.qsort (fun p1 p2 =>
+    More bound patterns sort first; with `stats`, the planner then reorders
+    them by estimated row count. Without statistics this is the old
+    selectivity order. -/
+@[deprecated Planner.orderPatterns (since := "2026-10-16")]
+def orderPatterns (patterns : List Pattern) (b : Binding) (stats : IndexStats := {}) : List Pattern :=
+  let bySelectivity := patterns.toArray.qsort (fun p1 p2 =>
     IndexSelect.selectivity p1 b < IndexSelect.selectivity p2 b
   ) |>.toList
+  Planner.orderPatterns stats bySelectivity
 
 /-- Execute a list of patterns with join optimization.
-    Executes most selective patterns first and joins results. -/
+    Orders patterns by estimated row count from the index statistics,
+    then joins results. -/
 def executePatterns (patterns : List Pattern) (idx : Indexes) : Relation :=
   match patterns with
   | [] => Relation.singleton Binding.empty
   | [p] => executePattern p Binding.empty idx
   | ps =>
-    -- Order by selectivity
-    let ordered := orderPatterns ps Binding.empty
+    -- Order by estimated cardinality
+    let ordered := Planner.orderPatterns idx.stats ps
     -- Execute first pattern
     match ordered with
     | [] => Relation.empty
@@ -202,7 +208,8 @@ private def executeRuleDef (rule : RuleDef) (idx : Indexes) (rules : RuleEnv) :
   let projected := rel.bindings.filterMap (projectBindingOrdered rule.params)
   Relation.distinct ⟨projected⟩
 
-private def buildRuleEnv (ruleDefs : List RuleDef) (idx : Indexes) : RuleEnv := Id.run do
+/-- Evaluate rule definitions to a fixpoint, one table per rule name and arity. -/
+def buildRuleEnv (ruleDefs : List RuleDef) (idx : Indexes) : RuleEnv := Id.run do
   if ruleDefs.isEmpty then
     return RuleEnv.empty
 
@@ -124,6 +124,35 @@ def selectivity (pattern : Pattern) (b : Binding) : Nat :=
   -- More bound terms = more selective (lower score)
   3 - (eBound + aBound + vBound)
 
+/-- Fetch candidate datoms from whichever of entity, attribute and value are known,
+    with the same index priority as `chooseIndex`. -/
+def fetchByKnown (e? : Option EntityId) (a? : Option Attribute) (v? : Option Value)
+    (idx : Indexes) : List Datom :=
+  match e?, a?, v? with
+  | some e, some a, _ => idx.datomsForEntityAttr e a
+  | some e, none, _ => idx.datomsForEntity e
+  | none, some a, some v => idx.datomsForAttrValue a v
+  | none, some a, none => idx.datomsForAttr a
+  | none, none, some (.ref e) => idx.datomsReferencingEntity e
+  | _, _, _ => idx.allDatoms
+
+/-- Count the datoms `fetchByKnown` would return, stopping at `limit`.
+    Used for cardinality estimates, so it never walks more than `limit` entries. -/
+def countByKnown (e? : Option EntityId) (a? : Option Attribute) (v? : Option Value)
+    (limit : Nat) (idx : Indexes) : Nat :=
+  match e?, a?.map idx.attrKey, v? with
+  | some e, some a, _ =>
+    idx.eavt.countFrom (EAVTIndex.minForEntityAttr e a) (EAVTIndex.matchesEntityAttr e a) limit
+  | some e, none, _ =>
+    idx.eavt.countFrom (EAVTIndex.minForEntity e) (EAVTIndex.matchesEntity e) limit
+  | none, some a, some v =>
+    idx.avet.countFrom (AVETIndex.minForAttrValue a v) (AVETIndex.matchesAttrValue a v) limit
+  | none, some a, none =>
+    idx.aevt.countFrom (AEVTIndex.minForAttr a) (AEVTIndex.matchesAttr a) limit
+  | none, none, some (.ref e) =>
+    idx.vaet.countFrom (VAETIndex.minForValue (.ref e)) (VAETIndex.matchesValue (.ref e)) limit
+  | _, _, _ => min idx.eavt.size limit
+
 end IndexSelect
 
 end Ledger
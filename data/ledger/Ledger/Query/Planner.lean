@@ -0,0 +1,101 @@
+/-
+  Ledger.Query.Planner
+
+  Cardinality estimates and cost-based pattern ordering.
+  Estimates come from the per-attribute statistics kept on the indexes, so
+  planning never touches the indexes themselves.
+-/
+
+import Ledger.Index.Manager
+import Ledger.Index.Stats
+import Ledger.Query.AST
+import Ledger.Query.Binding
+
+namespace Ledger
+
+namespace Planner
+
+/-- What is known about a pattern position when the pattern runs. -/
+inductive PosInfo where
+  /-- A constant from the query. -/
+  | const (t : Term)
+  /-- A variable bound by an earlier clause. -/
+  | bound
+  /-- A variable not yet bound, or a blank. -/
+  | free
+  deriving Repr, Inhabited
+
+/-- Describe a pattern term given the variables bound so far. -/
+def PosInfo.ofTerm (bound : List Var) : Term → PosInfo
+  | .var v => if bound.contains v then .bound else .free
+  | .blank => .free
+  | t => .const t
+
+/-- Fraction of an attribute's datoms with value `v`, as numerator and
+    denominator: exact from the histogram if the attribute keeps one, else
+    one in `distinctValues`. -/
+private def valueFraction (s : AttrStats) (v : Value) : Nat × Nat :=
+  match s.valueCount? v with
+  | some n => (n, s.datoms)
+  | none => (1, s.distinctValues)
+
+/-- Expected datoms of one attribute matching the entity and value positions. -/
+private def estimateAttr (s : AttrStats) (e v : PosInfo) : Float :=
+  let rows := match e with
+    | .const (.entity _) | .bound => s.perEntity
+    | .const _ => 0
+    | .free => s.datoms.toFloat
+  -- Fraction of the attribute's datoms whose value matches, as num / den
+  let (num, den) := match v with
+    | .const (.value val) => valueFraction s val
+    | .const (.entity ent) => valueFraction s (.ref ent)
+    | .const _ => (0, 1)
+    | .bound => (1, s.distinctValues)
+    | .free => (1, 1)
+  rows * num.toFloat / (max den 1).toFloat
+
+/-- Expected matches of a pattern for one input row, assuming positions are
+    independent. An unknown attribute sums over every attribute; a bound
+    attribute variable averages over them. -/
+def estimate (stats : IndexStats) (e a v : PosInfo) : Float :=
+  match a with
+  | .const (.attr attr) =>
+    match stats.forAttr? attr with
+    | some s => estimateAttr s e v
+    | none => 0
+  | .const _ => 0
+  | .bound =>
+    let (sum, n) := stats.attrs.foldl (init := (0.0, 0)) fun (sum, n) _ s =>
+      (sum + estimateAttr s e v, n + 1)
+    sum / (max n 1).toFloat
+  | .free =>
+    stats.attrs.foldl (init := 0.0) fun sum _ s => sum + estimateAttr s e v
+
+/-- Expected matches of a pattern per input row, given the bound variables. -/
+def estimatePattern (stats : IndexStats) (p : Pattern) (bound : List Var) : Float :=
+  estimate stats (.ofTerm bound p.entity) (.ofTerm bound p.attr) (.ofTerm bound p.value)
+
+/-- Order patterns greedily: at each step take the pattern expected to
+    produce the fewest rows given what earlier patterns bind. Ties keep the
+    original order. -/
+def orderPatterns (stats : IndexStats) (patterns : List Pattern) : List Pattern := Id.run do
+  let mut pending := patterns.toArray
+  let mut bound : List Var := []
+  let mut ordered : Array Pattern := #[]
+  while !pending.isEmpty do
+    let mut best := 0
+    let mut bestCost := estimatePattern stats pending[0]! bound
+    for i in [1:pending.size] do
+      let cost := estimatePattern stats pending[i]! bound
+      if cost < bestCost then
+        best := i
+        bestCost := cost
+    let p := pending[best]!
+    ordered := ordered.push p
+    bound := bound ++ p.vars.filter (!bound.contains ·)
+    pending := pending.eraseIdx! best
+  return ordered.toList
+
+end Planner
+
+end Ledger
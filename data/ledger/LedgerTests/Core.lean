@@ -48,6 +48,50 @@ test "Attribute keyword" := do
   let a2 := Attribute.keyword "person" "age"
   a2.name ≡ ":person/age"
 
+test "AttrTable interns densely in both directions" := do
+  let name := Attribute.mk ":person/name"
+  let age := Attribute.mk ":person/age"
+  let (k1, t) := AttrTable.empty.intern name
+  let (k2, t) := t.intern age
+  let (k3, t) := t.intern name
+  k1.id.val ≡ 0
+  k2.id.val ≡ 1
+  k3.id.val ≡ 0
+  t.size ≡ 2
+  t.find? age ≡ some ⟨1⟩
+  t.name? ⟨0⟩ ≡ some name
+  t.name? ⟨2⟩ ≡ none
+  (AttrTable.ofNames t.names).find? age ≡ some ⟨1⟩
+
+test "AttrKey orders by name, not by id" := do
+  -- z is interned first, so it has the smaller id
+  let (z, t) := AttrTable.empty.intern (Attribute.mk ":z")
+  let (a, t) := t.intern (Attribute.mk ":a")
+  compare a z ≡ Ordering.lt
+  compare z z ≡ Ordering.eq
+  -- A key made without a table still meets the interned one
+  compare (AttrKey.ofAttr (Attribute.mk ":a")) a ≡ Ordering.eq
+  ensure (t.keyOf (Attribute.mk ":a") == a) "keyOf should find the interned key"
+  -- The same attribute gets another id in another table; == and compare agree
+  let (a', _) := AttrTable.empty.intern (Attribute.mk ":a")
+  ensure (a'.id != a.id) "tables number attributes independently"
+  ensure (a' == a) "keys of one attribute are equal across tables"
+  compare a' a ≡ Ordering.eq
+  ensure (a.sameAttr (t.keyOf (Attribute.mk ":a"))) "sameAttr matches by id"
+  ensure (!a.sameAttr z) "sameAttr tells attributes apart"
+
+test "AttrKey.compareById orders by id, unresolved keys last" := do
+  let (z, t) := AttrTable.empty.intern (Attribute.mk ":z")
+  let (a, t) := t.intern (Attribute.mk ":a")
+  AttrKey.compareById z a ≡ Ordering.lt
+  AttrKey.compareById a a ≡ Ordering.eq
+  let unknown := t.keyOf (Attribute.mk ":b")
+  AttrKey.compareById a unknown ≡ Ordering.lt
+  -- Keys without ids fall back to names among themselves
+  AttrKey.compareById (AttrKey.ofAttr (Attribute.mk ":c")) unknown ≡ Ordering.gt
+  AttrKey.compareById IndexEntry.minAttr z ≡ Ordering.lt
+  ensure (!(t.keyOf (Attribute.mk ":b")).id.isResolved) "unknown attribute should be unresolved"
+
 /-! ## Value Tests -/
 
 test "Value int equality" := do
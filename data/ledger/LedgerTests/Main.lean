@@ -21,6 +21,7 @@ import LedgerTests.RangeQuery
 import LedgerTests.Schema
 import LedgerTests.Aggregates
 import LedgerTests.Rules
+import LedgerTests.Planner
 import LedgerTests.Macros
 import LedgerTests.TxFunctions
 
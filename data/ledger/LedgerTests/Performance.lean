@@ -315,6 +315,252 @@ test "join query at scale" := do
   IO.println s!"  20 join queries (1000 employees, 4 managers): {elapsed}ms"
   ensure (elapsed < 60000) s!"Too slow: {elapsed}ms (O(n*m) join?)"
 
+test "join query: nested vs compiled engine" := do
+  -- 5000 employees under 50 managers; three patterns joined on ?m and ?e
+  let (db, managers) ← createPeople 50
+  let mut db := db
+  for i in [:5000] do
+    let (eid, db') := db.allocEntityId
+    let tx : Transaction := [
+      .add eid personName (.string s!"Employee{i}"),
+      .add eid personManager (.ref managers[i % 50]!)
+    ]
+    match db'.transact tx with
+    | .ok (db'', _) => db := db''
+    | .error e => throw <| IO.userError s!"Tx failed: {e}"
+
+  let query : Query := {
+    find := [⟨"ename"⟩, ⟨"mname"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"e"⟩, attr := .attr personManager, value := .var ⟨"m"⟩ },
+      .pattern { entity := .var ⟨"m"⟩, attr := .attr personName, value := .var ⟨"mname"⟩ },
+      .pattern { entity := .var ⟨"e"⟩, attr := .attr personName, value := .var ⟨"ename"⟩ }
+    ]
+  }
+
+  let (nestedRows, nestedMs) ← timeMs do
+    let mut rows := 0
+    for _ in [:5] do
+      rows := (Query.executeWith .nested query db).size
+    return rows
+  let (compiledRows, compiledMs) ← timeMs do
+    let mut rows := 0
+    for _ in [:5] do
+      rows := (Query.executeWith .compiled query db).size
+    return rows
+  IO.println s!"  5 three-way joins (5000 employees, 50 managers): nested {nestedMs}ms, compiled {compiledMs}ms"
+  nestedRows ≡ 5000
+  compiledRows ≡ nestedRows
+
+test "cost-based ordering: query written widest-first" := do
+  -- 5000 people in 5 departments plus one in "Research"; the selective
+  -- pattern comes last, so the written order joins everything first
+  let (db, people) ← createPeople 5000
+  let mut tx : Transaction := []
+  for i in [:people.size] do
+    let dept := if i == 4999 then "Research" else s!"Dept{i % 5}"
+    tx := tx ++ [.add people[i]! personDept (.string dept)]
+  let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
+
+  let query : Query := {
+    find := [⟨"name"⟩, ⟨"age"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"e"⟩, attr := .attr personName, value := .var ⟨"name"⟩ },
+      .pattern { entity := .var ⟨"e"⟩, attr := .attr personAge, value := .var ⟨"age"⟩ },
+      .pattern { entity := .var ⟨"e"⟩, attr := .attr personDept, value := .value (.string "Research") }
+    ]
+  }
+
+  let (nestedRows, nestedMs) ← timeMs do
+    let mut rows := 0
+    for _ in [:5] do
+      rows := (Query.executeWith .nested query db).size
+    return rows
+  let (plannedRows, plannedMs) ← timeMs do
+    let mut rows := 0
+    for _ in [:5] do
+      rows := (Query.executeWith .compiled query db).size
+    return rows
+  IO.println s!"  5 queries, selective pattern last (5000 people): written order {nestedMs}ms, planned {plannedMs}ms"
+  IO.println (Query.explain query db)
+  nestedRows ≡ 1
+  plannedRows ≡ nestedRows
+
+/-! ## Attribute Interning -/
+
+/-- The issue attributes of the tracker app's schema. -/
+def trackerIssueAttrs : Array Attribute := #[
+  ⟨":tracker/issue-id"⟩, ⟨":tracker/title"⟩, ⟨":tracker/status"⟩,
+  ⟨":tracker/priority"⟩, ⟨":tracker/created"⟩, ⟨":tracker/updated"⟩,
+  ⟨":tracker/description"⟩, ⟨":tracker/assignee"⟩, ⟨":tracker/project"⟩
+]
+
+/-- Datoms for `n` tracker issues, one per issue attribute. -/
+def trackerIssueDatoms (n : Nat) : Array Datom := Id.run do
+  let mut datoms : Array Datom := #[]
+  for i in [:n] do
+    let e : EntityId := ⟨Int.ofNat i + 1⟩
+    for j in [:trackerIssueAttrs.size] do
+      let v : Value := match j with
+        | 0 => .int (Int.ofNat i)
+        | 2 => .string s!"status{i % 4}"
+        | 3 => .string s!"p{i % 3}"
+        | 4 | 5 => .int (1700000000 + Int.ofNat i)
+        | 8 => .string s!"project{i % 10}"
+        | _ => .string s!"text {i}"
+      datoms := datoms.push (Datom.assert e trackerIssueAttrs[j]! v ⟨1⟩)
+  return datoms
+
+/-- Whether to run the 1M and 10M datom benchmarks (`LEDGER_BENCH_LARGE=1`). -/
+private def largeBenchEnabled : IO Bool := do
+  match (← IO.getEnv "LEDGER_BENCH_LARGE") with
+  | some flag =>
+    let flag := flag.trim.toLower
+    return flag == "1" || flag == "true" || flag == "yes"
+  | none => return false
+
+/-- AEVT and AVET insert and seek timings over `issues` tracker issues
+    (9 datoms each), with plain keys against interned keys. EAVT orders
+    attributes by name either way, so it is left out. -/
+def attrInterningBench (issues : Nat) : IO Unit := do
+  let datoms := trackerIssueDatoms issues
+  let status : Attribute := ⟨":tracker/status"⟩
+  let issueId : Attribute := ⟨":tracker/issue-id"⟩
+  -- Plain keys have no id, so AEVT and AVET compare attribute names
+  let ((plainAevt, plainAvet), plainInsertMs) ← timeMs do
+    let mut aevt := AEVTIndex.empty
+    let mut avet := AVETIndex.empty
+    for d in datoms do
+      aevt := aevt.insertDatom d
+      avet := avet.insertDatom d
+    return (aevt, avet)
+  -- Interned keys compare ids
+  let ((aevt, avet, attrs), internedInsertMs) ← timeMs do
+    let mut aevt := AEVTIndex.empty
+    let mut avet := AVETIndex.empty
+    let mut attrs := AttrTable.empty
+    for d in datoms do
+      let (a, attrs') := attrs.intern d.attr
+      attrs := attrs'
+      aevt := aevt.insertDatom d a
+      avet := avet.insertDatom d a
+    return (aevt, avet, attrs)
+  let statusKey := attrs.keyOf status
+  let issueIdKey := attrs.keyOf issueId
+  -- One attribute+entity seek in AEVT and one attribute+value seek in AVET per issue
+  let (plainRows, plainSeekMs) ← timeMs do
+    let mut rows := 0
+    for i in [:issues] do
+      rows := rows + (plainAevt.datomsForAttrEntity status ⟨Int.ofNat i + 1⟩).length
+      rows := rows + (plainAvet.datomsForAttrValue issueId (.int (Int.ofNat i))).length
+    return rows
+  let (internedRows, internedSeekMs) ← timeMs do
+    let mut rows := 0
+    for i in [:issues] do
+      rows := rows + (aevt.datomsForAttrEntity statusKey ⟨Int.ofNat i + 1⟩).length
+      rows := rows + (avet.datomsForAttrValue issueIdKey (.int (Int.ofNat i))).length
+    return rows
+  IO.println s!"  {datoms.size} datoms, AEVT+AVET insert: plain {plainInsertMs}ms, interned {internedInsertMs}ms"
+  IO.println s!"  {2 * issues} seeks: plain {plainSeekMs}ms, interned {internedSeekMs}ms"
+  attrs.size ≡ trackerIssueAttrs.size
+  plainRows ≡ 2 * issues
+  internedRows ≡ plainRows
+
+test "attribute interning: 180k datoms" := do
+  attrInterningBench 20000
+
+test "attribute interning: 1M datoms" := do
+  if !(← largeBenchEnabled) then
+    IO.println "Skipping 1M datom benchmark (set LEDGER_BENCH_LARGE=1)."
+    return ()
+  attrInterningBench 111112
+
+/-! ## Index Storage -/
+
+/-- Insert, point lookup and range scan timings over `issues` tracker issues
+    (9 datoms each). -/
+def indexStorageBench (issues : Nat) : IO Unit := do
+  let datoms := trackerIssueDatoms issues
+  let status : Attribute := ⟨":tracker/status"⟩
+  let title : Attribute := ⟨":tracker/title"⟩
+  let (idx, insertMs) ← timeMs do
+    let mut idx := Indexes.empty
+    for d in datoms do
+      idx := idx.insertDatom d
+    return idx
+  -- One exact entity/attribute/value lookup per issue
+  let (hits, lookupMs) ← timeMs do
+    let mut hits := 0
+    for i in [:issues] do
+      let e : EntityId := ⟨Int.ofNat i + 1⟩
+      hits := hits + (idx.datomsForEntityAttrValue e title (.string s!"text {i}")).length
+    return hits
+  -- Every entity's datoms, then one attribute/value run covering a quarter of the issues
+  let (scanned, scanMs) ← timeMs do
+    let mut rows := 0
+    for i in [:issues] do
+      rows := rows + (idx.datomsForEntity ⟨Int.ofNat i + 1⟩).length
+    return rows + (idx.datomsForAttrValue status (.string "status0")).length
+  IO.println s!"  {datoms.size} datoms: insert {insertMs}ms, {issues} point lookups {lookupMs}ms, range scans {scanMs}ms (tree height {idx.eavt.height})"
+  idx.count ≡ datoms.size
+  hits ≡ issues
+  scanned ≡ datoms.size + (issues + 3) / 4
+
+test "index storage: 100k datoms" := do
+  indexStorageBench 11112
+
+test "index storage: 1M datoms" := do
+  if !(← largeBenchEnabled) then
+    IO.println "Skipping 1M datom benchmark (set LEDGER_BENCH_LARGE=1)."
+    return ()
+  indexStorageBench 111112
+
+test "index storage: 10M datoms" := do
+  if !(← largeBenchEnabled) then
+    IO.println "Skipping 10M datom benchmark (set LEDGER_BENCH_LARGE=1)."
+    return ()
+  indexStorageBench 1111112
+
+/-! ## Time Travel -/
+
+test "time travel: stepping back through 10k transactions" := do
+  let txCount := 10000
+  let status : Attribute := ⟨":tracker/status"⟩
+  -- Each transaction files an issue and moves an earlier one along
+  let conn ← do
+    let mut conn := Connection.create
+    for i in [:txCount] do
+      let e : EntityId := ⟨Int.ofNat i + 1⟩
+      let moved : EntityId := ⟨Int.ofNat (i / 2) + 1⟩
+      let mut ops : Transaction := [.add e status (.string "open")]
+      if let some prev := conn.db.getOne moved status then
+        ops := ops ++ [.retract moved status prev, .add moved status (.string s!"step{i}")]
+      match conn.transact ops with
+      | .ok (conn', _) => conn := conn'
+      | .error err => throw <| IO.userError s!"Tx {i} failed: {err}"
+    pure conn
+  -- Step back one transaction at a time, reading the issue filed last in each view
+  let (found, stepMs) ← timeMs do
+    let mut found := 0
+    for i in [:txCount] do
+      let t := txCount - i
+      let db := conn.asOf ⟨t⟩
+      if (db.getOne ⟨Int.ofNat t⟩ status).isSome then found := found + 1
+    return found
+  -- Rebuilding from the start of the log, as asOf did before checkpoints
+  let samples := 20
+  let noCheckpoints := { conn with checkpoints := #[] }
+  let (rebuildRows, rebuildMs) ← timeMs do
+    let mut rows := 0
+    for i in [:samples] do
+      rows := rows + (noCheckpoints.asOf ⟨txCount - i * (txCount / samples)⟩).size
+    return rows
+  let checkpointRows := (List.range samples).foldl (init := 0) fun acc i =>
+    acc + (conn.asOf ⟨txCount - i * (txCount / samples)⟩).size
+  IO.println s!"  {txCount} asOf steps: {stepMs}ms; {samples} full rebuilds: {rebuildMs}ms ({conn.checkpoints.size} checkpoints)"
+  found ≡ txCount
+  rebuildRows ≡ checkpointRows
+
 /-! ## Stress Tests (larger scale to expose O(n²)) -/
 
 test "STRESS: Insert 10000 entities" := do
@@ -116,6 +116,37 @@ test "Snapshot: JSON roundtrip" := do
     snap'.txLog.size ≡ snap.txLog.size
   | none => throw <| IO.userError "Snapshot parse failed"
 
+test "Snapshot: a connection on an asOf view keeps its facts" := do
+  let conn := Connection.create
+  let (e, conn) := conn.allocEntityId
+  let name := Attribute.mk ":person/name"
+  let .ok (conn, first) := conn.transact [.add e name (Value.string "Alice")]
+    | throw <| IO.userError "Tx 1 failed"
+  let .ok (conn, _) := conn.transact [.add e (Attribute.mk ":person/age") (Value.int 30)]
+    | throw <| IO.userError "Tx 2 failed"
+  -- The snapshot reads the facts from the view's current indexes
+  let viewConn := { conn with db := conn.asOf first.txId }
+  let snap := Persist.Snapshot.fromConnectionWithRetention viewConn .bounded
+  snap.currentFacts.size ≡ 1
+  let some snap' := Persist.Snapshot.fromJson (Persist.Snapshot.toJson snap)
+    | throw <| IO.userError "Snapshot parse failed"
+  snap'.toConnection.db.getOne e name ≡ some (Value.string "Alice")
+
+test "Snapshot: attribute ids survive a reload" := do
+  let conn := Connection.create
+  let (e, conn) := conn.allocEntityId
+  let tx : Transaction := [
+    .add e (Attribute.mk ":person/name") (Value.string "Alice"),
+    .add e (Attribute.mk ":person/age") (Value.int 30)
+  ]
+  let .ok (conn, _) := conn.transact tx | throw <| IO.userError "Tx failed"
+  let json := Persist.Snapshot.toJson (Persist.Snapshot.fromConnectionWithRetention conn .bounded)
+  let some snap := Persist.Snapshot.fromJson json | throw <| IO.userError "Snapshot parse failed"
+  snap.attrs.size ≡ 2
+  let conn' := snap.toConnection
+  conn'.db.attrs.names ≡ conn.db.attrs.names
+  conn'.db.getOne e (Attribute.mk ":person/age") ≡ some (Value.int 30)
+
 test "JSON: Base64 empty roundtrip" := do
   let data := ByteArray.empty
   let encoded := Persist.JSON.base64Encode data
@@ -160,7 +191,6 @@ test "JSONL: Direct datom insertion with multiple values" := do
     basisT := TxId.mk 203
     indexes := indexes
     historyIndexes := indexes
-    currentFacts := Db.currentFactsFromDatoms datoms.toList
     nextEntityId := EntityId.mk 194
   }
 
@@ -192,7 +222,6 @@ test "JSONL: Many values same entity-attribute" := do
     basisT := TxId.mk 203
     indexes := indexes
     historyIndexes := indexes
-    currentFacts := Db.currentFactsFromDatoms datoms.toList
     nextEntityId := EntityId.mk 194
   }
 
@@ -243,12 +272,10 @@ test "JSONL: Replay builds correct indexes" := do
     for datom in entry.datoms do
       indexes := indexes.insertDatom datom
 
-  let allDatoms := (entries.toList.map fun entry => entry.datoms.toList).flatten
   let db : Db := {
     basisT := TxId.mk 3
     indexes := indexes
     historyIndexes := indexes
-    currentFacts := Db.currentFactsFromDatoms allDatoms
     nextEntityId := EntityId.mk 2
   }
 
@@ -0,0 +1,175 @@
+/-
+  Ledger.Tests.Planner - Index statistics, cost-based ordering and explain
+-/
+
+import Crucible
+import Ledger
+
+namespace Ledger.Tests.Planner
+
+open Crucible
+open Ledger
+
+testSuite "Query Planner"
+
+def personName : Attribute := ⟨":person/name"⟩
+def personCity : Attribute := ⟨":person/city"⟩
+def personFriend : Attribute := ⟨":person/friend"⟩
+
+/-- Cities are looked up by value, so they keep a value histogram. -/
+def townSchema : Schema :=
+  Schema.empty.insert { ident := personCity, valueType := .string, indexed := true }
+
+/-- `n` people, all but one in "Springfield", each befriending the next. -/
+def townDb (n : Nat) : IO (Db × Array EntityId) := do
+  let (ids, db) := (Db.empty.withSchema townSchema).allocEntityIds n
+  let ids := ids.toArray
+  let mut tx : Transaction := []
+  for i in [:n] do
+    let city := if i == 0 then "Shelbyville" else "Springfield"
+    tx := tx ++ [
+      .add ids[i]! personName (.string s!"Person{i}"),
+      .add ids[i]! personCity (.string city),
+      .add ids[i]! personFriend (.ref ids[(i + 1) % n]!)
+    ]
+  let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
+  pure (db, ids)
+
+/-- Rows of a result as a set of tuples, for comparing engines. -/
+def sameRows (a b : Query.QueryResult) : Bool :=
+  let ta := a.toTuples
+  let tb := b.toTuples
+  ta.length == tb.length && ta.all (tb.contains ·) && tb.all (ta.contains ·)
+
+test "Stats: counts, distinct values and histogram follow transactions" := do
+  let (db, ids) ← townDb 20
+  let some city := db.indexes.stats.forAttr? personCity | throw <| IO.userError "no stats"
+  city.datoms ≡ 20
+  city.distinctEntities ≡ 20
+  city.distinctValues ≡ 2
+  city.valueCount? (.string "Springfield") ≡ some 19
+  city.valueCount? (.string "Shelbyville") ≡ some 1
+  db.indexes.stats.datoms ≡ 60
+  let tx : Transaction := [
+    .retract ids[0]! personCity (.string "Shelbyville"),
+    .add ids[0]! personCity (.string "Springfield")
+  ]
+  let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
+  let some city := db.indexes.stats.forAttr? personCity | throw <| IO.userError "no stats"
+  city.datoms ≡ 20
+  city.distinctEntities ≡ 20
+  city.distinctValues ≡ 1
+  city.valueCount? (.string "Springfield") ≡ some 20
+  city.valueCount? (.string "Shelbyville") ≡ some 0
+
+test "Stats: attributes not indexed by value keep counts only" := do
+  let (db, ids) ← townDb 20
+  let some name := db.indexes.stats.forAttr? personName | throw <| IO.userError "no stats"
+  name.distinctValues ≡ 20
+  name.valueCount? (.string "Person3") ≡ none
+  -- Without a histogram a value is assumed to be one of distinctValues
+  let byName : Pattern := { entity := .var ⟨"p"⟩, attr := .attr personName, value := .value (.string "Person3") }
+  Planner.estimatePattern db.indexes.stats byName [] ≡ 1.0
+  -- A second datom for an entity leaves distinctEntities alone
+  let .ok (db, _) := db.transact [.add ids[0]! personName (.string "Alias")]
+    | throw <| IO.userError "Tx failed"
+  let some name := db.indexes.stats.forAttr? personName | throw <| IO.userError "no stats"
+  name.datoms ≡ 21
+  name.distinctEntities ≡ 20
+  name.distinctValues ≡ 21
+
+test "Stats: a histogram added later is seeded from AVET" := do
+  let (ids, db) := Db.empty.allocEntityIds 4
+  let tx : Transaction := ids.map fun e => .add e personCity (.string "Springfield")
+  let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
+  let some city := db.indexes.stats.forAttr? personCity | throw <| IO.userError "no stats"
+  city.valueCount? (.string "Springfield") ≡ none
+  let db := db.withSchema townSchema
+  let some city := db.indexes.stats.forAttr? personCity | throw <| IO.userError "no stats"
+  city.valueCount? (.string "Springfield") ≡ some 4
+
+test "Stats: retracting every datom of an attribute drops it" := do
+  let (db, ids) ← townDb 3
+  let tx : Transaction := (List.range 3).map fun i =>
+    .retract ids[i]! personFriend (.ref ids[(i + 1) % 3]!)
+  let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
+  (db.indexes.stats.forAttr? personFriend).isNone ≡ true
+  db.indexes.stats.datoms ≡ 6
+  -- History is never planned over and keeps no statistics
+  db.historyIndexes.stats.datoms ≡ 0
+
+test "Planner: estimates use the value histogram" := do
+  let (db, _) ← townDb 50
+  let stats := db.indexes.stats
+  let rare : Pattern := { entity := .var ⟨"p"⟩, attr := .attr personCity, value := .value (.string "Shelbyville") }
+  let common : Pattern := { entity := .var ⟨"p"⟩, attr := .attr personCity, value := .value (.string "Springfield") }
+  Planner.estimatePattern stats rare [] ≡ 1.0
+  Planner.estimatePattern stats common [] ≡ 49.0
+  -- With ?p bound, an entity has one city
+  let byEntity : Pattern := { entity := .var ⟨"p"⟩, attr := .attr personCity, value := .var ⟨"c"⟩ }
+  Planner.estimatePattern stats byEntity [⟨"p"⟩] ≡ 1.0
+
+test "Planner: orderPatterns starts from the rarest pattern" := do
+  let (db, _) ← townDb 50
+  let name : Pattern := { entity := .var ⟨"p"⟩, attr := .attr personName, value := .var ⟨"n"⟩ }
+  let springfield : Pattern := { entity := .var ⟨"p"⟩, attr := .attr personCity, value := .value (.string "Springfield") }
+  let shelbyville : Pattern := { entity := .var ⟨"p"⟩, attr := .attr personCity, value := .value (.string "Shelbyville") }
+  let ordered := Planner.orderPatterns db.indexes.stats [name, springfield, shelbyville]
+  ordered.head?.map (·.value) ≡ some (.value (.string "Shelbyville"))
+  (Query.executePatterns [name, springfield, shelbyville] db.indexes).size ≡ 0
+  (Query.executePatterns [name, shelbyville] db.indexes).size ≡ 1
+
+test "Planner: explain reorders a badly written query" := do
+  let (db, _) ← townDb 200
+  -- Written from the widest pattern to the narrowest
+  let query : Query := {
+    find := [⟨"fname"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr personFriend, value := .var ⟨"f"⟩ },
+      .pattern { entity := .var ⟨"f"⟩, attr := .attr personName, value := .var ⟨"fname"⟩ },
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr personCity, value := .value (.string "Shelbyville") }
+    ]
+  }
+  let plan := Query.explain query db
+  plan.steps.size ≡ 3
+  plan.rows ≡ 1
+  ensure ((plan.steps[0]!.clause).endsWith "\"Shelbyville\"]") s!"unexpected first step: {plan.steps[0]!.clause}"
+  plan.steps[0]!.estimated ≡ some 1
+  (plan.steps.map (·.actual)) ≡ #[1, 1, 1]
+  ensure (((toString plan).splitOn "\n").length == 4) s!"unexpected plan:\n{plan}"
+  ensure (sameRows (Query.execute query db) (Query.executeCompiled query db)) "engines disagree"
+
+test "Planner: reordering keeps entity and ref forms as written" := do
+  let (db, _) ← townDb 30
+  -- ?f is first bound from a value position, so it is a ref in the output,
+  -- even when the planner starts from the entity side
+  let query : Query := {
+    find := [⟨"f"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr personFriend, value := .var ⟨"f"⟩ },
+      .pattern { entity := .var ⟨"f"⟩, attr := .attr personCity, value := .value (.string "Shelbyville") }
+    ]
+  }
+  let compiled := Query.executeCompiled query db
+  compiled.size ≡ 1
+  ensure (sameRows (Query.execute query db) compiled) "engines disagree"
+  let isRef := compiled.rows.bindings.all fun b =>
+    match b.lookup ⟨"f"⟩ with
+    | some (.value (.ref _)) => true
+    | _ => false
+  ensure isRef "expected ?f as a ref value"
+
+test "Planner: negation stays where it is written" := do
+  let (db, _) ← townDb 20
+  -- The not runs before ?p is bound, so no rows survive (as in execute)
+  let query : Query := {
+    find := [⟨"p"⟩]
+    where_ := [
+      .not (.pattern { entity := .var ⟨"p"⟩, attr := .attr personCity, value := .value (.string "Shelbyville") }),
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr personName, value := .var ⟨"n"⟩ }
+    ]
+  }
+  (Query.execute query db).size ≡ 0
+  (Query.executeCompiled query db).size ≡ 0
+
+end Ledger.Tests.Planner
@@ -811,4 +811,177 @@ test "Query: isValid checks find vars appear in where" := do
   Query.isValid okQuery ≡ true
   Query.isValid badQuery ≡ false
 
+/-! ## Compiled Engine -/
+
+/-- Rows of a result as a set of tuples, for comparing engines. -/
+private def sameRows (a b : Query.QueryResult) : Bool :=
+  let ta := a.toTuples
+  let tb := b.toTuples
+  ta.length == tb.length && ta.all (tb.contains ·) && tb.all (ta.contains ·)
+
+/-- Run a query on both engines and check they agree. Returns the row count. -/
+private def checkEngines (query : Query) (db : Db) : IO Nat := do
+  let nested := Query.executeWith .nested query db
+  let compiled := Query.executeWith .compiled query db
+  ensure (sameRows nested compiled) s!"engines disagree: {nested.size} vs {compiled.size} rows"
+  pure compiled.size
+
+/-- People in departments, with friend refs and ages. -/
+private def orgDb (people : Nat) : IO Db := do
+  let mut db := Db.empty
+  let mut depts : Array EntityId := #[]
+  let mut tx : Transaction := []
+  for i in [:4] do
+    let (d, db') := db.allocEntityId
+    db := db'
+    depts := depts.push d
+    tx := tx ++ [.add d (Attribute.mk ":dept/name") (Value.string s!"dept-{i}")]
+  let mut ids : Array EntityId := #[]
+  for _ in [:people] do
+    let (p, db') := db.allocEntityId
+    db := db'
+    ids := ids.push p
+  for i in [:people] do
+    let p := ids[i]!
+    tx := tx ++ [
+      .add p (Attribute.mk ":person/name") (Value.string s!"person-{i}"),
+      .add p (Attribute.mk ":person/age") (Value.int (20 + (i % 30 : Nat))),
+      .add p (Attribute.mk ":person/dept") (Value.ref depts[i % 4]!),
+      .add p (Attribute.mk ":person/friend") (Value.ref ids[(i * 7 + 1) % people]!)
+    ]
+  let .ok (db', _) := db.transact tx | throw <| IO.userError "Tx failed"
+  pure db'
+
+test "Compiled: multi-way joins match nested" := do
+  let db ← orgDb 120
+  -- Person, department name: the second pattern is keyed on a bound ref
+  let byDept : Query := {
+    find := [⟨"name"⟩, ⟨"dname"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/dept"), value := .var ⟨"d"⟩ },
+      .pattern { entity := .var ⟨"d"⟩, attr := .attr (Attribute.mk ":dept/name"), value := .var ⟨"dname"⟩ },
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/name"), value := .var ⟨"name"⟩ }
+    ]
+  }
+  (← checkEngines byDept db) ≡ 120
+  -- Friends in the same department
+  let sameDept : Query := {
+    find := [⟨"p"⟩, ⟨"f"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/friend"), value := .var ⟨"f"⟩ },
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/dept"), value := .var ⟨"d"⟩ },
+      .pattern { entity := .var ⟨"f"⟩, attr := .attr (Attribute.mk ":person/dept"), value := .var ⟨"d"⟩ }
+    ]
+  }
+  let _ ← checkEngines sameDept db
+  -- Same age, any two people: a self-join on a value
+  let sameAge : Query := {
+    find := [⟨"a"⟩, ⟨"b"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"a"⟩, attr := .attr (Attribute.mk ":person/age"), value := .var ⟨"age"⟩ },
+      .pattern { entity := .var ⟨"b"⟩, attr := .attr (Attribute.mk ":person/age"), value := .var ⟨"age"⟩ }
+    ]
+  }
+  (← checkEngines sameAge db) ≡ 120 * 4
+
+test "Compiled: unrelated patterns give the cross product" := do
+  let db ← orgDb 10
+  let query : Query := {
+    find := [⟨"p"⟩, ⟨"dname"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/name"), value := .blank },
+      .pattern { entity := .blank, attr := .attr (Attribute.mk ":dept/name"), value := .var ⟨"dname"⟩ }
+    ]
+  }
+  (← checkEngines query db) ≡ 40
+
+test "Compiled: repeated, ref and attribute variables match nested" := do
+  let db ← orgDb 30
+  let selfFriend : Query := {
+    find := [⟨"e"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"e"⟩, attr := .attr (Attribute.mk ":person/friend"), value := .var ⟨"e"⟩ }
+    ]
+  }
+  let _ ← checkEngines selfFriend db
+  -- A ref bound in value position, then used as an entity
+  let friendNames : Query := {
+    find := [⟨"fname"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/friend"), value := .var ⟨"f"⟩ },
+      .pattern { entity := .var ⟨"f"⟩, attr := .attr (Attribute.mk ":person/name"), value := .var ⟨"fname"⟩ }
+    ]
+  }
+  let _ ← checkEngines friendNames db
+  -- An attribute variable joined across two patterns
+  let sharedAttr : Query := {
+    find := [⟨"a"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .var ⟨"a"⟩, value := .var ⟨"v"⟩ },
+      .pattern { entity := .var ⟨"q"⟩, attr := .var ⟨"a"⟩, value := .var ⟨"v"⟩ },
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/age"), value := .var ⟨"age"⟩ }
+    ]
+  }
+  let _ ← checkEngines sharedAttr db
+  -- A value variable reused as an entity cannot match
+  let mismatch : Query := {
+    find := [⟨"x"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/age"), value := .var ⟨"x"⟩ },
+      .pattern { entity := .var ⟨"x"⟩, attr := .attr (Attribute.mk ":person/name"), value := .blank }
+    ]
+  }
+  (← checkEngines mismatch db) ≡ 0
+
+test "Compiled: predicates, or, not and rules match nested" := do
+  let db ← orgDb 40
+  let query : Query := {
+    find := [⟨"p"⟩, ⟨"age"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/age"), value := .var ⟨"age"⟩ },
+      .predicate (Query.Predicate.gt (Query.PredExpr.var "age") (Query.PredExpr.int 35)),
+      .or [
+        .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/dept"), value := .var ⟨"d"⟩ },
+        .pattern { entity := .var ⟨"p"⟩, attr := .attr (Attribute.mk ":person/friend"), value := .var ⟨"d"⟩ }
+      ],
+      .not (.pattern { entity := .var ⟨"d"⟩, attr := .attr (Attribute.mk ":dept/name"), value := .value (Value.string "dept-0") })
+    ]
+  }
+  let _ ← checkEngines query db
+  let rule : RuleDef := {
+    name := "colleague"
+    params := [⟨"a"⟩, ⟨"b"⟩]
+    body := [
+      .pattern { entity := .var ⟨"a"⟩, attr := .attr (Attribute.mk ":person/dept"), value := .var ⟨"d"⟩ },
+      .pattern { entity := .var ⟨"b"⟩, attr := .attr (Attribute.mk ":person/dept"), value := .var ⟨"d"⟩ }
+    ]
+  }
+  let withRule : Query := {
+    find := [⟨"b"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"a"⟩, attr := .attr (Attribute.mk ":person/name"), value := .value (Value.string "person-3") },
+      .rule { name := "colleague", args := [.var ⟨"a"⟩, .var ⟨"b"⟩] }
+    ]
+    rules := [rule]
+  }
+  (← checkEngines withRule db) ≡ 10
+
+test "Compiled: retracted values are not returned" := do
+  let db := Db.empty
+  let (alice, db) := db.allocEntityId
+  let tx1 : Transaction := [.add alice (Attribute.mk ":person/name") (Value.string "Alice")]
+  let .ok (db, _) := db.transact tx1 | throw <| IO.userError "Tx failed"
+  let tx2 : Transaction := [
+    .retract alice (Attribute.mk ":person/name") (Value.string "Alice"),
+    .add alice (Attribute.mk ":person/name") (Value.string "Alicia")
+  ]
+  let .ok (db, _) := db.transact tx2 | throw <| IO.userError "Tx failed"
+  let query : Query := {
+    find := [⟨"name"⟩]
+    where_ := [
+      .pattern { entity := .var ⟨"e"⟩, attr := .attr (Attribute.mk ":person/name"), value := .var ⟨"name"⟩ }
+    ]
+  }
+  (← checkEngines query db) ≡ 1
+
 end Ledger.Tests.Query
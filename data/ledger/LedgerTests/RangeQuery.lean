@@ -4,7 +4,7 @@
 
 import Crucible
 import Ledger
-import Ledger.Index.RBRange
+import Ledger.Index.BTree
 
 namespace Ledger.Tests.RangeQuery
 
@@ -69,7 +69,7 @@ test "datomsForAttr finds all entities with attribute" := do
     .add charlie (Attribute.mk ":person/age") (Value.int 40)  -- no name
   ]
   let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
-  let nameDatoms := db.indexes.aevt.datomsForAttr (Attribute.mk ":person/name")
+  let nameDatoms := db.indexes.aevt.datomsForAttr (db.indexes.attrKey (Attribute.mk ":person/name"))
   nameDatoms.length ≡ 2
 
 test "datomsForAttrEntity filters correctly" := do
@@ -82,8 +82,8 @@ test "datomsForAttrEntity filters correctly" := do
     .add bob (Attribute.mk ":person/name") (Value.string "Bob")
   ]
   let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
-  let aliceName := db.indexes.aevt.datomsForAttrEntity (Attribute.mk ":person/name") alice
-  let bobName := db.indexes.aevt.datomsForAttrEntity (Attribute.mk ":person/name") bob
+  let aliceName := db.indexes.aevt.datomsForAttrEntity (db.indexes.attrKey (Attribute.mk ":person/name")) alice
+  let bobName := db.indexes.aevt.datomsForAttrEntity (db.indexes.attrKey (Attribute.mk ":person/name")) bob
   aliceName.length ≡ 1
   bobName.length ≡ 1
 
@@ -101,9 +101,9 @@ test "datomsForAttrValue finds matching entities" := do
   ]
   let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
   let engDatoms := db.indexes.avet.datomsForAttrValue
-    (Attribute.mk ":person/dept") (Value.string "Engineering")
+    (db.indexes.attrKey (Attribute.mk ":person/dept")) (Value.string "Engineering")
   let salesDatoms := db.indexes.avet.datomsForAttrValue
-    (Attribute.mk ":person/dept") (Value.string "Sales")
+    (db.indexes.attrKey (Attribute.mk ":person/dept")) (Value.string "Sales")
   engDatoms.length ≡ 2
   salesDatoms.length ≡ 1
 
@@ -121,7 +121,7 @@ test "entitiesWithAttrValue handles retractions" := do
   ]
   let .ok (db, _) := db.transact tx2 | throw <| IO.userError "Tx2 failed"
   let activeEntities := db.indexes.avet.entitiesWithAttrValue
-    (Attribute.mk ":person/status") (Value.string "active")
+    (db.indexes.attrKey (Attribute.mk ":person/status")) (Value.string "active")
   activeEntities.length ≡ 1
 
 /-! ## VAET Index Range Queries -/
@@ -149,8 +149,8 @@ test "datomsReferencingViaAttr filters by attribute" := do
     .add charlie (Attribute.mk ":person/manager") (Value.ref alice)
   ]
   let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
-  let friendRefs := db.indexes.vaet.datomsReferencingViaAttr alice (Attribute.mk ":person/friend")
-  let managerRefs := db.indexes.vaet.datomsReferencingViaAttr alice (Attribute.mk ":person/manager")
+  let friendRefs := db.indexes.vaet.datomsReferencingViaAttr alice (db.indexes.attrKey (Attribute.mk ":person/friend"))
+  let managerRefs := db.indexes.vaet.datomsReferencingViaAttr alice (db.indexes.attrKey (Attribute.mk ":person/manager"))
   friendRefs.length ≡ 1
   managerRefs.length ≡ 1
 
@@ -171,6 +171,102 @@ test "datomsForEntity preserves EAVT order" := do
     ensure (d1.attr.name < d2.attr.name) "Should be sorted by attribute"
   | _ => throw <| IO.userError "Expected 2 datoms"
 
+test "Plain attributes find datoms in EAVT, interned keys in every index" := do
+  let db := Db.empty
+  let (alice, db) := db.allocEntityId
+  let name := Attribute.mk ":person/name"
+  let tx : Transaction := [
+    .add alice name (Value.string "Alice"),
+    .add alice (Attribute.mk ":person/age") (Value.int 30)
+  ]
+  let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
+  -- EAVT orders attributes by name, so a plain Attribute finds its datoms;
+  -- Indexes resolves the id first
+  let plain := db.indexes.eavt.datomsForEntityAttr alice name
+  let interned := db.indexes.datomsForEntityAttr alice name
+  plain.length ≡ 1
+  interned.length ≡ 1
+  -- AEVT orders attributes by id: it needs the table's key, and an
+  -- unresolved key sorts after every interned one
+  (db.indexes.aevt.datomsForAttr (db.indexes.attrKey name)).length ≡ 1
+  (db.indexes.aevt.datomsForAttr name).length ≡ 0
+  (db.indexes.datomsForAttr (Attribute.mk ":person/unknown")).length ≡ 0
+  -- The Db's table numbers attributes in order of first use
+  db.attrs.size ≡ 2
+  db.attrs.find? name ≡ some ⟨0⟩
+
+/-! ## B+-tree -/
+
+private abbrev NatTree := BTree Nat compare
+
+private def natTree (xs : List Nat) : NatTree :=
+  xs.foldl BTree.insert BTree.empty
+
+test "BTree keeps order across splits" := do
+  -- Insert descending so every split happens at the left edge
+  let t := natTree ((List.range 5000).reverse)
+  t.size ≡ 5000
+  ensure (t.height > 2) "5000 elements should need inner nodes"
+  t.toList ≡ List.range 5000
+  t.find? 4321 ≡ some 4321
+  t.contains 5000 ≡ false
+
+test "BTree insert of an equal element replaces it" := do
+  let t := natTree [3, 1, 2, 1, 3]
+  t.size ≡ 3
+  t.toList ≡ [1, 2, 3]
+
+test "BTree erase joins nodes and keeps order" := do
+  let n := 3000
+  let t := natTree (List.range n)
+  -- Drop every element not divisible by 7, then the rest but one
+  let t := (List.range n).foldl (fun t i => if i % 7 == 0 then t else t.erase i) t
+  t.size ≡ (n + 6) / 7
+  t.toList ≡ (List.range n).filter (· % 7 == 0)
+  let t := (List.range n).foldl (fun t i => if i % 7 == 0 && i > 0 then t.erase i else t) t
+  t.toList ≡ [0]
+  t.size ≡ 1
+  (t.erase 0).isEmpty ≡ true
+  -- Erasing a missing element changes nothing
+  (t.erase 99).size ≡ 1
+
+test "BTree range scans start at the probe and stop at the range end" := do
+  let t := natTree ((List.range 2000).map (· * 2))
+  -- Probe between elements starts at the next one
+  (t.collectFrom 101 (· < 140) id).toList ≡ (List.range 19).map (102 + 2 * ·)
+  (t.collectFrom 3998 (fun _ => true) id).toList ≡ [3998]
+  (t.collectFrom 5000 (fun _ => true) id).size ≡ 0
+  t.countFrom 0 (fun _ => true) 10 ≡ 10
+  t.countFrom 1000 (· < 2000) 10000 ≡ 500
+
+test "BTree versions stay independent" := do
+  let t1 := natTree (List.range 500)
+  let t2 := (t1.erase 10).insert 1000
+  t1.size ≡ 500
+  t1.contains 10 ≡ true
+  t1.contains 1000 ≡ false
+  t2.size ≡ 500
+  t2.contains 10 ≡ false
+  t2.contains 1000 ≡ true
+
+test "Indexes share one entry per datom" := do
+  let db := Db.empty
+  let (alice, db) := db.allocEntityId
+  let (bob, db) := db.allocEntityId
+  let tx : Transaction := [
+    .add alice (Attribute.mk ":person/name") (Value.string "Alice"),
+    .add bob (Attribute.mk ":person/friend") (Value.ref alice)
+  ]
+  let .ok (db, _) := db.transact tx | throw <| IO.userError "Tx failed"
+  db.indexes.eavt.count ≡ 2
+  db.indexes.aevt.count ≡ 2
+  db.indexes.avet.count ≡ 2
+  -- Only the ref datom is in VAET
+  db.indexes.vaet.count ≡ 1
+  let entry := IndexEntry.ofDatom (db.indexes.datomsForEntity bob).head!
+  ensure (db.indexes.avet.contains entry) "AVET should hold the same datom"
+  ensure (db.indexes.vaet.contains entry) "VAET should hold the ref datom"
+
 /-! ## Boundary Tests -/
 
 test "Range query with first entity in db" := do
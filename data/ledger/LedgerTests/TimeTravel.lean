@@ -47,4 +47,68 @@ test "single transaction time-travel consistency" := do
   let history := conn.entityHistory alice
   history.length ≡ 1
 
+/-- A connection with `n` transactions that add, update and retract the
+    ages of a few entities. -/
+private def agingConnection (n : Nat) : IO Connection := do
+  let mut conn := Connection.create
+  let age := Attribute.mk ":person/age"
+  for i in [:n] do
+    let e : EntityId := ⟨Int.ofNat (i % 5) + 1⟩
+    let ops : Transaction :=
+      match conn.db.getOne e age with
+      | some prev =>
+        if i % 7 == 0 then [.retract e age prev]
+        else [.retract e age prev, .add e age (.int (Int.ofNat i))]
+      | none => [.add e age (.int (Int.ofNat i))]
+    match conn.transact ops with
+    | .ok (conn', _) => conn := conn'
+    | .error err => throw <| IO.userError s!"Tx {i} failed: {err}"
+  return conn
+
+test "asOf from checkpoints matches replay from the start" := do
+  let conn ← agingConnection 300
+  conn.checkpoints.size ≡ 300 / Connection.checkpointInterval
+  let noCheckpoints := { conn with checkpoints := #[] }
+  for t in [0, 1, 63, 64, 65, 127, 128, 200, 299, 300, 400] do
+    let txId : TxId := ⟨t⟩
+    let db := conn.asOf txId
+    let reference := noCheckpoints.asOf txId
+    db.basisT.id ≡ t
+    db.datoms ≡ reference.datoms
+    db.historyIndexes.count ≡ reference.historyIndexes.count
+    -- The old full rebuild: the visible datoms of the log up to txId
+    let logged := (conn.txLog.toList.map fun entry => entry.datoms.toList).flatten
+    db.size ≡ (TimeTravel.filterVisibleAt logged txId).length
+
+test "asOf latest matches the current database" := do
+  let conn ← agingConnection 130
+  let db := conn.asOf conn.basisT
+  db.datoms ≡ conn.db.datoms
+  db.historyIndexes.count ≡ conn.db.historyIndexes.count
+
+test "transacting on an asOf view sees the facts of that time" := do
+  let conn := Connection.create
+  let (alice, conn) := conn.allocEntityId
+  let name := Attribute.mk ":person/name"
+  let .ok (conn, first) := conn.transact [.add alice name (Value.string "Alice")]
+    | throw <| IO.userError "Tx 1 failed"
+  let .ok (conn, _) := conn.transact [.retract alice name (Value.string "Alice"),
+      .add alice name (Value.string "Alicia")]
+    | throw <| IO.userError "Tx 2 failed"
+  let view := conn.asOf first.txId
+  -- The retraction is checked against the view's EAVT
+  let .ok (renamed, _) := view.transact [.retract alice name (Value.string "Alice"),
+      .add alice name (Value.string "Ali")]
+    | throw <| IO.userError "Tx on view failed"
+  renamed.get alice name ≡ [Value.string "Ali"]
+  -- Re-asserting a fact replaces its datom instead of adding a second one
+  let .ok (again, _) := view.transact [.add alice name (Value.string "Alice")]
+    | throw <| IO.userError "Re-assert on view failed"
+  again.size ≡ 1
+  -- A fact that only exists later is not there to retract
+  match view.transact [.retract alice name (Value.string "Alicia")] with
+  | .ok _ => throw <| IO.userError "Expected factNotFound"
+  | .error (.factNotFound _ _ _) => pure ()
+  | .error err => throw <| IO.userError s!"Unexpected error: {err}"
+
 end Ledger.Tests.TimeTravel
@@ -35,12 +35,16 @@ import Quarry.Core.Error
 import Quarry.Core.Value
 import Quarry.Core.Row
 import Quarry.Core.Column
+import Quarry.Core.Batch
 import Quarry.FFI.Types
 import Quarry.FFI.Database
 import Quarry.FFI.Statement
 import Quarry.FFI.Backup
 import Quarry.FFI.Blob
+import Quarry.StmtCache
 import Quarry.Database
+import Quarry.Cursor
+import Quarry.Pool
 import Quarry.Backup
 import Quarry.Blob
 import Quarry.Bind
@@ -4,6 +4,7 @@
 -/
 import Chisel
 import Quarry.Database
+import Quarry.Cursor
 import Quarry.Chisel.Convert
 
 namespace Quarry
@@ -19,21 +20,40 @@ namespace Database
 -- SELECT Execution
 -- ============================================================================
 
-/-- Execute a Chisel SELECT statement -/
+/-- Execute a Chisel SELECT statement.
+    Literals are rendered as `?` placeholders and bound, so queries of the
+    same shape share one cached prepared statement. -/
 def execSelect (db : Database) (stmt : Chisel.SelectCore)
     (ctx : Chisel.RenderContext := sqliteContext) : IO (Array Row) :=
-  db.query (Chisel.renderSelect ctx stmt)
+  let (sql, params) := Chisel.renderSelectParams ctx stmt
+  db.queryParams sql (Quarry.Chisel.literalsToValues params)
 
 /-- Execute SELECT using monadic builder -/
 def select (db : Database) (build : Chisel.SelectM Unit)
     (ctx : Chisel.RenderContext := sqliteContext) : IO (Array Row) :=
   db.execSelect (Chisel.SelectM.build build) ctx
 
-/-- Execute SELECT, return first row -/
+/-- Open a cursor over a Chisel SELECT, streaming its rows -/
+def cursorSelect (db : Database) (stmt : Chisel.SelectCore)
+    (ctx : Chisel.RenderContext := sqliteContext)
+    (batchSize : Nat := Cursor.defaultBatchSize) : IO Cursor :=
+  let (sql, params) := Chisel.renderSelectParams ctx stmt
+  db.openCursor sql (Quarry.Chisel.literalsToValues params) batchSize
+
+/-- Execute SELECT, return first row (only the first row is stepped) -/
 def selectOne (db : Database) (build : Chisel.SelectM Unit)
     (ctx : Chisel.RenderContext := sqliteContext) : IO (Option Row) := do
-  let rows ← db.select build ctx
-  return rows[0]?
+  let cursor ← db.cursorSelect (Chisel.SelectM.build build) ctx (batchSize := 1)
+  try
+    cursor.next?
+  finally
+    cursor.close
+
+/-- Execute SELECT using monadic builder, streaming each row to `f` -/
+def selectForEach (db : Database) (build : Chisel.SelectM Unit) (f : Row → IO Unit)
+    (ctx : Chisel.RenderContext := sqliteContext) : IO Unit := do
+  for row in ← db.cursorSelect (Chisel.SelectM.build build) ctx do
+    f row
 
 /-- Set FROM with explicit TableRef -/
 def from_' (ref : Chisel.TableRef) : Chisel.SelectM Unit :=
@@ -43,45 +63,48 @@ def from_' (ref : Chisel.TableRef) : Chisel.SelectM Unit :=
 -- INSERT Execution
 -- ============================================================================
 
-/-- Execute a Chisel INSERT statement -/
+/-- Execute a Chisel INSERT statement with bound values -/
 def execInsert (db : Database) (stmt : Chisel.InsertStmt)
     (ctx : Chisel.RenderContext := sqliteContext) : IO Unit :=
-  db.execRaw (Chisel.renderInsert ctx stmt)
+  let (sql, params) := Chisel.renderInsertParams ctx stmt
+  db.execParams sql (Quarry.Chisel.literalsToValues params)
 
 /-- Execute INSERT and return last inserted rowid -/
 def execInsertReturning (db : Database) (stmt : Chisel.InsertStmt)
     (ctx : Chisel.RenderContext := sqliteContext) : IO Int := do
-  db.execRaw (Chisel.renderInsert ctx stmt)
+  db.execInsert stmt ctx
   db.lastInsertRowid
 
 -- ============================================================================
 -- UPDATE Execution
 -- ============================================================================
 
-/-- Execute a Chisel UPDATE statement -/
+/-- Execute a Chisel UPDATE statement with bound values -/
 def execUpdate (db : Database) (stmt : Chisel.UpdateStmt)
     (ctx : Chisel.RenderContext := sqliteContext) : IO Unit :=
-  db.execRaw (Chisel.renderUpdate ctx stmt)
+  let (sql, params) := Chisel.renderUpdateParams ctx stmt
+  db.execParams sql (Quarry.Chisel.literalsToValues params)
 
 /-- Execute UPDATE and return number of affected rows -/
 def execUpdateReturning (db : Database) (stmt : Chisel.UpdateStmt)
     (ctx : Chisel.RenderContext := sqliteContext) : IO Int := do
-  db.execRaw (Chisel.renderUpdate ctx stmt)
+  db.execUpdate stmt ctx
   db.changes
 
 -- ============================================================================
 -- DELETE Execution
 -- ============================================================================
 
-/-- Execute a Chisel DELETE statement -/
+/-- Execute a Chisel DELETE statement with bound values -/
 def execDelete (db : Database) (stmt : Chisel.DeleteStmt)
     (ctx : Chisel.RenderContext := sqliteContext) : IO Unit :=
-  db.execRaw (Chisel.renderDelete ctx stmt)
+  let (sql, params) := Chisel.renderDeleteParams ctx stmt
+  db.execParams sql (Quarry.Chisel.literalsToValues params)
 
 /-- Execute DELETE and return number of affected rows -/
 def execDeleteReturning (db : Database) (stmt : Chisel.DeleteStmt)
     (ctx : Chisel.RenderContext := sqliteContext) : IO Int := do
-  db.execRaw (Chisel.renderDelete ctx stmt)
+  db.execDelete stmt ctx
   db.changes
 
 -- ============================================================================
@@ -125,7 +148,9 @@ def queryWithParams (db : Database) (sql : String)
   | .ok expr =>
     match Chisel.Parser.bindPositional expr params with
     | .error e => throw (IO.userError s!"Bind error: {e}")
-    | .ok bound => db.query (Chisel.renderExpr ctx bound)
+    | .ok bound =>
+      let (sql, params) := Chisel.renderExprParams ctx bound
+      db.queryParams sql (Quarry.Chisel.literalsToValues params)
 
 /-- Execute a SQL query with named parameter binding -/
 def queryWithNamedParams (db : Database) (sql : String)
@@ -135,7 +160,9 @@ def queryWithNamedParams (db : Database) (sql : String)
   | .ok expr =>
     match Chisel.Parser.bindNamed expr params with
     | .error e => throw (IO.userError s!"Bind error: {e}")
-    | .ok bound => db.query (Chisel.renderExpr ctx bound)
+    | .ok bound =>
+      let (sql, params) := Chisel.renderExprParams ctx bound
+      db.queryParams sql (Quarry.Chisel.literalsToValues params)
 
 /-- Execute a SQL query with indexed parameter binding ($1, $2, etc) -/
 def queryWithIndexedParams (db : Database) (sql : String)
@@ -145,7 +172,9 @@ def queryWithIndexedParams (db : Database) (sql : String)
   | .ok expr =>
     match Chisel.Parser.bindIndexed expr params with
     | .error e => throw (IO.userError s!"Bind error: {e}")
-    | .ok bound => db.query (Chisel.renderExpr ctx bound)
+    | .ok bound =>
+      let (sql, params) := Chisel.renderExprParams ctx bound
+      db.queryParams sql (Quarry.Chisel.literalsToValues params)
 
 -- ============================================================================
 -- Unified SQL Execution (Single Entrypoint)
@@ -0,0 +1,174 @@
+/-
+  Quarry.Core.Batch
+  Columnar result batches
+
+  `quarry_stmt_fetch_batch` steps a statement up to N rows inside C and
+  returns the rows column by column, so a scan crosses the FFI boundary
+  once per batch instead of twice per cell.
+-/
+import Quarry.Core.Value
+import Quarry.Core.Column
+import Quarry.Core.Row
+
+namespace Quarry
+
+/-- Values of one column across the rows of a batch.
+    Typed vectors carry a null bitmap (bit `i % 8` of byte `i / 8` is set
+    when row `i` is NULL); NULL rows hold 0 / an empty slice in `data`.
+    A column whose rows have different storage classes is `mixed`. -/
+inductive ColumnVector where
+  /-- Every row is NULL -/
+  | null
+  /-- Signed 64-bit integers, 8 bytes per row, little-endian -/
+  | integer (data : ByteArray) (nulls : ByteArray)
+  /-- Doubles, one per row -/
+  | real (data : FloatArray) (nulls : ByteArray)
+  /-- UTF-8 text: row `i` is `data[offsets[i]:offsets[i+1]]`,
+      offsets are little-endian UInt32 with one more entry than rows -/
+  | text (offsets : ByteArray) (data : ByteArray) (nulls : ByteArray)
+  /-- Blobs, laid out like `text` -/
+  | blob (offsets : ByteArray) (data : ByteArray) (nulls : ByteArray)
+  /-- Rows of differing storage classes -/
+  | mixed (values : Array Value)
+  deriving Inhabited
+
+/-- One native fetch: the vectors plus whether the statement is exhausted -/
+structure FetchedBatch where
+  rowCount : Nat
+  vectors : Array ColumnVector
+  /-- The statement returned SQLITE_DONE -/
+  done : Bool
+  deriving Inhabited
+
+namespace ColumnVector
+
+/-- Read a little-endian signed 64-bit integer at byte offset `pos` -/
+private def readInt64LE (data : ByteArray) (pos : Nat) : Int := Id.run do
+  let mut v : UInt64 := 0
+  for i in [:8] do
+    v := v ||| ((data.get! (pos + i)).toUInt64 <<< (8 * i).toUInt64)
+  return v.toInt64.toInt
+
+/-- Read a little-endian UInt32 at byte offset `pos` -/
+private def readUInt32LE (data : ByteArray) (pos : Nat) : Nat := Id.run do
+  let mut v : Nat := 0
+  for i in [:4] do
+    v := v ||| ((data.get! (pos + i)).toNat <<< (8 * i))
+  return v
+
+/-- Byte range of row `row` in an offsets buffer -/
+private def sliceAt (offsets data : ByteArray) (row : Nat) : ByteArray :=
+  data.extract (readUInt32LE offsets (4 * row)) (readUInt32LE offsets (4 * (row + 1)))
+
+/-- Decode `data[start:stop]` the way per-cell reads do: invalid UTF-8
+    becomes U+FFFD instead of failing -/
+@[extern "quarry_text_decode"]
+private opaque decodeText (data : @& ByteArray) (start stop : USize) : String
+
+private def textAt (offsets data : ByteArray) (row : Nat) : String :=
+  decodeText data (readUInt32LE offsets (4 * row)).toUSize (readUInt32LE offsets (4 * (row + 1))).toUSize
+
+private def bitSet (nulls : ByteArray) (row : Nat) : Bool :=
+  (nulls.get! (row / 8) >>> (row % 8).toUInt8) &&& 1 == 1
+
+/-- Is row `row` NULL? -/
+def isNull (v : ColumnVector) (row : Nat) : Bool :=
+  match v with
+  | .null => true
+  | .integer _ nulls | .real _ nulls | .text _ _ nulls | .blob _ _ nulls => bitSet nulls row
+  | .mixed values => match values[row]? with
+    | some .null | none => true
+    | some _ => false
+
+/-- Integer at `row`, without building a `Value` -/
+def getInt? (v : ColumnVector) (row : Nat) : Option Int :=
+  match v with
+  | .integer data nulls => if bitSet nulls row then none else some (readInt64LE data (8 * row))
+  | .mixed values => match values[row]? with
+    | some (.integer n) => some n
+    | _ => none
+  | _ => none
+
+/-- Double at `row`, without building a `Value` -/
+def getFloat? (v : ColumnVector) (row : Nat) : Option Float :=
+  match v with
+  | .real data nulls => if bitSet nulls row then none else some (data.get! row)
+  | .mixed values => match values[row]? with
+    | some (.real f) => some f
+    | _ => none
+  | _ => none
+
+/-- Text at `row` -/
+def getText? (v : ColumnVector) (row : Nat) : Option String :=
+  match v with
+  | .text offsets data nulls =>
+    if bitSet nulls row then none else some (textAt offsets data row)
+  | .mixed values => match values[row]? with
+    | some (.text s) => some s
+    | _ => none
+  | _ => none
+
+/-- Value at `row` (NULL when out of range) -/
+def get (v : ColumnVector) (row : Nat) : Value :=
+  if v.isNull row then .null
+  else match v with
+    | .integer data _ => .integer (readInt64LE data (8 * row))
+    | .real data _ => .real (data.get! row)
+    | .text offsets data _ => .text (textAt offsets data row)
+    | .blob offsets data _ => .blob (sliceAt offsets data row)
+    | .mixed values => values[row]?.getD .null
+    | .null => .null
+
+end ColumnVector
+
+/-- A batch of result rows stored column by column -/
+structure ResultBatch where
+  columns : Array Column
+  vectors : Array ColumnVector
+  rowCount : Nat
+  deriving Inhabited
+
+namespace ResultBatch
+
+/-- Number of columns -/
+def columnCount (batch : ResultBatch) : Nat := batch.columns.size
+
+/-- Index of a column by name (case-insensitive) -/
+def columnIndex? (batch : ResultBatch) (name : String) : Option Nat :=
+  let nameLower := name.toLower
+  batch.columns.findIdx? (fun c => c.name.toLower == nameLower)
+
+/-- Column vector by name (case-insensitive) -/
+def column? (batch : ResultBatch) (name : String) : Option ColumnVector :=
+  batch.columnIndex? name >>= fun i => batch.vectors[i]?
+
+/-- Value at `row`, `col` -/
+def get? (batch : ResultBatch) (row col : Nat) : Option Value :=
+  if row < batch.rowCount then batch.vectors[col]?.map (·.get row) else none
+
+/-- Integer at `row`, `col` -/
+def getInt? (batch : ResultBatch) (row col : Nat) : Option Int :=
+  batch.vectors[col]? >>= (·.getInt? row)
+
+/-- Double at `row`, `col` -/
+def getFloat? (batch : ResultBatch) (row col : Nat) : Option Float :=
+  batch.vectors[col]? >>= (·.getFloat? row)
+
+/-- Text at `row`, `col` -/
+def getText? (batch : ResultBatch) (row col : Nat) : Option String :=
+  batch.vectors[col]? >>= (·.getText? row)
+
+/-- Materialize one row (all rows share the batch's column array) -/
+def row (batch : ResultBatch) (idx : Nat) : Row :=
+  ⟨batch.vectors.map (·.get idx), batch.columns⟩
+
+/-- Materialize every row -/
+def toRows (batch : ResultBatch) : Array Row := Id.run do
+  let mut rows : Array Row := Array.mkEmpty batch.rowCount
+  for i in [:batch.rowCount] do
+    rows := rows.push (batch.row i)
+  return rows
+
+end ResultBatch
+
+end Quarry
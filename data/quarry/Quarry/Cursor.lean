@@ -0,0 +1,131 @@
+/-
+  Quarry.Cursor
+  Streaming query results
+
+  A cursor owns a prepared statement and fetches rows in small native
+  batches as they are consumed, so scanning a large table keeps only one
+  batch in memory instead of the whole result.
+-/
+import Quarry.Database
+
+namespace Quarry
+
+/-- Mutable part of a cursor -/
+structure CursorState where
+  /-- Batch currently being read -/
+  batch : ResultBatch := default
+  /-- Next row of `batch` to yield -/
+  pos : Nat := 0
+  /-- The statement has no more rows -/
+  done : Bool := false
+  /-- The statement has gone back to the connection's cache -/
+  released : Bool := false
+
+/-- A running query that yields rows lazily.
+    Close it (or let a `for` loop over it finish) to return the statement
+    to the connection's cache. -/
+structure Cursor where
+  db : Database
+  sql : String
+  stmt : FFI.Statement
+  columns : Array Column
+  batchSize : Nat
+  state : IO.Ref CursorState
+
+/-- Rows fetched per native call by a cursor -/
+def Cursor.defaultBatchSize : Nat := 256
+
+namespace Cursor
+
+/-- Hand the statement back once; rows already fetched stay readable -/
+private def release (cursor : Cursor) : IO Unit := do
+  let st ← cursor.state.get
+  unless st.released do
+    cursor.state.set { st with released := true, done := true }
+    cursor.db.releaseStmt cursor.sql cursor.stmt
+
+/-- Stop the query: reset the statement, return it to the cache and drop
+    any rows not yet read. Safe to call more than once. -/
+def close (cursor : Cursor) : IO Unit := do
+  cursor.release
+  cursor.state.modify fun st => { st with batch := default, pos := 0 }
+
+/-- Next row, or none once the result is exhausted. The statement is
+    released as soon as SQLite reports the last row. -/
+def next? (cursor : Cursor) : IO (Option Row) := do
+  let st ← cursor.state.get
+  if st.pos < st.batch.rowCount then
+    cursor.state.set { st with pos := st.pos + 1 }
+    return some (st.batch.row st.pos)
+  if st.done then
+    return none
+  let (batch, finished) ← Database.fetchBatch cursor.stmt cursor.columns cursor.batchSize
+  cursor.state.set { st with batch, pos := if batch.rowCount > 0 then 1 else 0 }
+  if finished then
+    cursor.release
+  if batch.rowCount > 0 then
+    return some (batch.row 0)
+  else
+    return none
+
+/-- Column names of the result -/
+def columnNames (cursor : Cursor) : Array String :=
+  cursor.columns.map (·.name)
+
+end Cursor
+
+/-- Iterating a cursor consumes it; the cursor is closed when the loop ends,
+    including on `break` or an exception. -/
+instance : ForIn IO Cursor Row where
+  forIn cursor init f := do
+    try
+      let mut acc := init
+      repeat
+        match ← cursor.next? with
+        | none => break
+        | some row =>
+          match ← f row acc with
+          | .done a =>
+            acc := a
+            break
+          | .yield a => acc := a
+      return acc
+    finally
+      cursor.close
+
+namespace Database
+
+/-- Start a query with positional parameters and return a cursor over its rows -/
+def openCursor (db : Database) (sql : String) (params : Array Value := #[])
+    (batchSize : Nat := Cursor.defaultBatchSize) : IO Cursor := do
+  let stmt ← db.acquireStmt sql
+  try
+    bindAll stmt params
+    let columns ← statementColumns stmt
+    return { db, sql, stmt, columns, batchSize := max batchSize 1, state := ← IO.mkRef {} }
+  catch e =>
+    db.releaseStmt sql stmt
+    throw e
+
+/-- Run `f` with a cursor, closing it afterwards -/
+def withCursor (db : Database) (sql : String) (f : Cursor → IO α)
+    (params : Array Value := #[]) (batchSize : Nat := Cursor.defaultBatchSize) : IO α := do
+  let cursor ← db.openCursor sql params batchSize
+  try
+    f cursor
+  finally
+    cursor.close
+
+/-- Execute a query and return the first row (or none).
+    Only the first row is stepped. -/
+def queryOne (db : Database) (sql : String) : IO (Option Row) :=
+  db.withCursor sql (·.next?) (batchSize := 1)
+
+/-- Execute a query with a callback for each row, streaming the result -/
+def queryForEach (db : Database) (sql : String) (f : Row -> IO Unit) : IO Unit := do
+  for row in ← db.openCursor sql do
+    f row
+
+end Database
+
+end Quarry
@@ -6,8 +6,11 @@ import Quarry.Core.Error
 import Quarry.Core.Value
 import Quarry.Core.Row
 import Quarry.Core.Column
+import Quarry.Core.Batch
 import Quarry.FFI.Database
 import Quarry.FFI.Statement
+import Quarry.Bind
+import Quarry.StmtCache
 
 namespace Quarry
 
@@ -15,21 +18,29 @@ namespace Quarry
 structure Database where
   private mk ::
   handle : FFI.Database
+  /-- Idle prepared statements reused by `query`, `queryParams` and `execParams` -/
+  stmtCache : IO.Ref StmtCache
 
 namespace Database
 
 /-- Open a database file -/
 def openFile (path : String) : IO Database := do
   let handle ← FFI.dbOpen path
-  return ⟨handle⟩
+  return ⟨handle, ← IO.mkRef {}⟩
+
+/-- Open an existing database file read-only -/
+def openReadOnly (path : String) : IO Database := do
+  let handle ← FFI.dbOpenReadOnly path
+  return ⟨handle, ← IO.mkRef {}⟩
 
 /-- Open an in-memory database -/
 def openMemory : IO Database := do
   let handle ← FFI.dbOpenMemory
-  return ⟨handle⟩
+  return ⟨handle, ← IO.mkRef {}⟩
 
-/-- Close the database connection -/
-def close (db : Database) : IO Unit :=
+/-- Close the database connection (cached statements are released first) -/
+def close (db : Database) : IO Unit := do
+  db.stmtCache.modify (·.clear)
   FFI.dbClose db.handle
 
 /-- Execute raw SQL that doesn't return results (CREATE, INSERT, UPDATE, DELETE).
@@ -66,9 +77,32 @@ private def sqliteFloat : Int := 2
 private def sqliteText : Int := 3
 private def sqliteBlob : Int := 4
 
-/-- Execute a query and return all rows -/
-def query (db : Database) (sql : String) : IO (Array Row) := do
-  let stmt ← FFI.stmtPrepare db.handle sql
+/-- Take an idle cached statement for `sql` out of the cache, or prepare a new one.
+    Pair with `releaseStmt`. -/
+def acquireStmt (db : Database) (sql : String) : IO FFI.Statement := do
+  match ← db.stmtCache.modifyGet (·.take? sql) with
+  | some stmt => pure stmt
+  | none => FFI.stmtPrepare db.handle sql
+
+/-- Reset a statement, clear its bindings and return it to the cache -/
+def releaseStmt (db : Database) (sql : String) (stmt : FFI.Statement) : IO Unit := do
+  FFI.stmtReset stmt
+  FFI.stmtClearBindings stmt
+  db.stmtCache.modify (·.put sql stmt)
+
+/-- Run `f` with a prepared statement for `sql`, reusing an idle cached one
+    when available. Afterwards the statement is reset, its bindings cleared,
+    and it goes back to the cache. -/
+def withCachedStmt (db : Database) (sql : String) (f : FFI.Statement → IO α) : IO α := do
+  let stmt ← db.acquireStmt sql
+  try
+    f stmt
+  finally
+    db.releaseStmt sql stmt
+
+/-- Step a prepared statement to completion, reading each cell with its own
+    FFI calls. Kept as the reference path for `readRows`. -/
+def readRowsByCell (db : Database) (stmt : FFI.Statement) : IO (Array Row) := do
   let mut rows : Array Row := #[]
 
   -- Get column metadata
@@ -110,16 +144,116 @@ def query (db : Database) (sql : String) : IO (Array Row) := do
 
   return rows
 
-/-- Execute a query and return the first row (or none) -/
-def queryOne (db : Database) (sql : String) : IO (Option Row) := do
-  let rows ← db.query sql
-  return rows[0]?
+/-- Rows fetched per native call by `readRows` and `batches` -/
+def defaultBatchSize : Nat := 1024
 
-/-- Execute a query with a callback for each row -/
-def queryForEach (db : Database) (sql : String) (f : Row -> IO Unit) : IO Unit := do
-  let rows ← db.query sql
-  for row in rows do
-    f row
+/-- Column names of a prepared statement -/
+def statementColumns (stmt : FFI.Statement) : IO (Array Column) := do
+  let colCount ← FFI.stmtColumnCount stmt
+  let mut columns : Array Column := #[]
+  for i in [:colCount.toNat] do
+    let name ← FFI.stmtColumnName stmt i.toUInt32
+    columns := columns.push ⟨name, none, none⟩
+  return columns
+
+/-- Fetch up to `maxRows` rows in one native call.
+    The flag is true once the statement has no more rows. -/
+def fetchBatch (stmt : FFI.Statement) (columns : Array Column)
+    (maxRows : Nat := defaultBatchSize) : IO (ResultBatch × Bool) := do
+  let fetched ← FFI.stmtFetchBatch stmt (max maxRows 1).toUInt32
+  return ({ columns, vectors := fetched.vectors, rowCount := fetched.rowCount }, fetched.done)
+
+/-- Step a prepared statement to completion and collect its rows -/
+def readRows (stmt : FFI.Statement) : IO (Array Row) := do
+  let columns ← statementColumns stmt
+  let mut rows : Array Row := #[]
+  let mut done := false
+  while !done do
+    let (batch, finished) ← fetchBatch stmt columns
+    for i in [:batch.rowCount] do
+      rows := rows.push (batch.row i)
+    done := finished
+  return rows
+
+/-- Execute a query and return all rows -/
+def query (db : Database) (sql : String) : IO (Array Row) :=
+  db.withCachedStmt sql readRows
+
+/-- Execute a query with positional parameters (?1, ?2, ...) and return all rows -/
+def queryParams (db : Database) (sql : String) (params : Array Value) : IO (Array Row) :=
+  db.withCachedStmt sql fun stmt => do
+    bindAll stmt params
+    readRows stmt
+
+/-- Execute a statement with positional parameters, discarding any rows -/
+def execParams (db : Database) (sql : String) (params : Array Value) : IO Unit :=
+  db.withCachedStmt sql fun stmt => do
+    bindAll stmt params
+    let mut done := false
+    while !done do
+      let rc ← FFI.stmtStep stmt
+      if rc == sqliteDone then
+        done := true
+      else if rc != sqliteRow then
+        let msg ← FFI.dbErrmsg db.handle
+        throw (IO.userError msg)
+
+/-- Execute a query and return its rows as columnar batches -/
+def queryBatches (db : Database) (sql : String) (params : Array Value := #[])
+    (batchSize : Nat := defaultBatchSize) : IO (Array ResultBatch) :=
+  db.withCachedStmt sql fun stmt => do
+    bindAll stmt params
+    let columns ← statementColumns stmt
+    let mut batches : Array ResultBatch := #[]
+    let mut done := false
+    while !done do
+      let (batch, finished) ← fetchBatch stmt columns batchSize
+      if batch.rowCount > 0 then
+        batches := batches.push batch
+      done := finished
+    return batches
+
+/-- A query scanned batch by batch: `for batch in db.batches sql do ...` -/
+structure Batches where
+  db : Database
+  sql : String
+  params : Array Value := #[]
+  batchSize : Nat := defaultBatchSize
+
+/-- Scan a query's results in columnar batches of up to `batchSize` rows -/
+def batches (db : Database) (sql : String) (params : Array Value := #[])
+    (batchSize : Nat := defaultBatchSize) : Batches :=
+  { db, sql, params, batchSize }
+
+instance : ForIn IO Batches ResultBatch where
+  forIn scan init f :=
+    scan.db.withCachedStmt scan.sql fun stmt => do
+      bindAll stmt scan.params
+      let columns ← statementColumns stmt
+      let mut acc := init
+      let mut done := false
+      while !done do
+        let (batch, finished) ← fetchBatch stmt columns scan.batchSize
+        done := finished
+        if batch.rowCount > 0 then
+          match ← f batch acc with
+          | .done a =>
+            acc := a
+            done := true
+          | .yield a => acc := a
+      return acc
+
+/-- Statement cache hit/miss counters for this connection -/
+def stmtCacheStats (db : Database) : IO StmtCacheStats := do
+  return (← db.stmtCache.get).stats
+
+/-- Set how many idle prepared statements this connection keeps (0 disables caching) -/
+def setStmtCacheCapacity (db : Database) (capacity : Nat) : IO Unit :=
+  db.stmtCache.modify (·.resize capacity)
+
+/-- Drop all cached prepared statements -/
+def clearStmtCache (db : Database) : IO Unit :=
+  db.stmtCache.modify (·.clear)
 
 /-- Run operations inside a transaction -/
 def transaction (db : Database) (f : IO α) : IO α := do
@@ -11,6 +11,9 @@ namespace Quarry.FFI
 @[extern "quarry_db_open"]
 opaque dbOpen (path : @& String) : IO Database
 
+@[extern "quarry_db_open_readonly"]
+opaque dbOpenReadOnly (path : @& String) : IO Database
+
 @[extern "quarry_db_open_memory"]
 opaque dbOpenMemory : IO Database
 
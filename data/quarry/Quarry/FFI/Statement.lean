@@ -3,6 +3,7 @@
   Low-level FFI bindings for sqlite3_stmt operations
 -/
 import Quarry.FFI.Types
+import Quarry.Core.Batch
 
 namespace Quarry.FFI
 
@@ -81,6 +82,10 @@ opaque stmtColumnBlob (stmt : @& Statement) (idx : UInt32) : IO ByteArray
 @[extern "quarry_stmt_column_bytes"]
 opaque stmtColumnBytes (stmt : @& Statement) (idx : UInt32) : IO Int
 
+-- Batch fetch: step up to `maxRows` rows in C and return them column by column
+@[extern "quarry_stmt_fetch_batch"]
+opaque stmtFetchBatch (stmt : @& Statement) (maxRows : UInt32) : IO FetchedBatch
+
 -- SQL text
 @[extern "quarry_stmt_sql"]
 opaque stmtSql (stmt : @& Statement) : IO String
@@ -0,0 +1,269 @@
+/-
+  Quarry.Pool
+  Connection pool: WAL readers plus a single group-committing writer
+
+  A pool opens one writer connection and N read-only connections on the same
+  database file in WAL mode, so reads run concurrently with each other and
+  with the writer. Reads borrow an idle reader. Writes are queued to one
+  background writer, which runs every queued job inside a single
+  transaction (each job in its own savepoint) and commits once, so many
+  small writes share one fsync.
+-/
+import Std.Sync.Mutex
+import Quarry.Database
+import Quarry.Cursor
+
+namespace Quarry
+
+/-- Pool tuning -/
+structure PoolConfig where
+  /-- Read-only connections -/
+  readers : Nat := 4
+  /-- Most write jobs committed together in one transaction -/
+  maxGroupSize : Nat := 64
+  /-- Busy timeout for every connection, in milliseconds -/
+  busyTimeoutMs : UInt32 := 5000
+  deriving Repr, Inhabited
+
+/-- Pool counters -/
+structure PoolStats where
+  /-- Completed reads -/
+  reads : Nat := 0
+  /-- Write jobs run (committed or failed) -/
+  writes : Nat := 0
+  /-- Write jobs whose changes were rolled back -/
+  failedWrites : Nat := 0
+  /-- Transactions committed by the writer -/
+  commits : Nat := 0
+  /-- Total time reads waited for an idle reader, in milliseconds -/
+  readWaitMs : Nat := 0
+  /-- Total time write jobs waited in the queue, in milliseconds -/
+  writeWaitMs : Nat := 0
+  /-- Write jobs currently queued -/
+  queueDepth : Nat := 0
+  /-- Deepest the write queue has been -/
+  maxQueueDepth : Nat := 0
+  /-- Readers not currently lent out -/
+  idleReaders : Nat := 0
+  deriving Repr, Inhabited
+
+/-- A queued write -/
+structure WriteJob where
+  /-- Runs inside the group's transaction; the returned action delivers the
+      result once the group has committed -/
+  run : Database → IO (BaseIO Unit)
+  /-- Deliver an error instead -/
+  fail : IO.Error → BaseIO Unit
+  enqueuedMs : Nat
+
+/-- State shared under the pool mutex -/
+structure PoolState where
+  idle : Array Database
+  queue : Array WriteJob := #[]
+  stopping : Bool := false
+  stats : PoolStats := {}
+
+/-- A running connection pool -/
+structure Pool where
+  config : PoolConfig
+  path : String
+  state : Std.Mutex PoolState
+  /-- Signalled when a reader is returned -/
+  readerFree : Std.Condvar
+  /-- Signalled when a write job is queued -/
+  writerWake : Std.Condvar
+  writerConn : Database
+  readers : Array Database
+  writer : Task (Except IO.Error Unit)
+
+namespace Pool
+
+/-- Run one group of jobs in a single transaction. Returns how many failed.
+    If a savepoint statement itself fails, the transaction can no longer be
+    trusted: the whole group is rolled back and every job not yet failed
+    gets the error. -/
+private def runGroup (db : Database) (jobs : Array WriteJob) : IO Nat := do
+  try
+    db.execRaw "BEGIN IMMEDIATE"
+  catch e =>
+    for job in jobs do job.fail e
+    return jobs.size
+  let abort (e : IO.Error) (pending : Array (IO.Error → BaseIO Unit)) : IO Nat := do
+    try
+      db.execRaw "ROLLBACK"
+    catch _ =>
+      pure ()
+    for fail in pending do fail e
+    return jobs.size
+  let mut succeeded : Array (BaseIO Unit × (IO.Error → BaseIO Unit)) := #[]
+  let mut failed := 0
+  for i in [:jobs.size] do
+    let job := jobs[i]!
+    -- This job and the ones after it
+    let rest := (jobs.extract i jobs.size).map (·.fail)
+    try
+      db.execRaw "SAVEPOINT quarry_pool_job"
+    catch e =>
+      return ← abort e (succeeded.map (·.2) ++ rest)
+    match ← (job.run db).toBaseIO with
+    | .ok deliver =>
+      try
+        db.execRaw "RELEASE quarry_pool_job"
+      catch e =>
+        return ← abort e (succeeded.map (·.2) ++ rest)
+      succeeded := succeeded.push (deliver, job.fail)
+    | .error e =>
+      job.fail e
+      -- Undo only this job; the rest of the group still commits
+      try
+        db.execRaw "ROLLBACK TO quarry_pool_job"
+        db.execRaw "RELEASE quarry_pool_job"
+      catch e' =>
+        return ← abort e' (succeeded.map (·.2) ++ rest)
+      failed := failed + 1
+  try
+    db.execRaw "COMMIT"
+  catch e =>
+    try
+      db.execRaw "ROLLBACK"
+    catch _ =>
+      pure ()
+    for (_, fail) in succeeded do fail e
+    return jobs.size
+  for (deliver, _) in succeeded do deliver
+  return failed
+
+private partial def writerLoop (config : PoolConfig) (db : Database)
+    (state : Std.Mutex PoolState) (wake : Std.Condvar) : IO Unit := do
+  let (jobs, finished) ← state.atomicallyOnce wake
+      (do let st ← get; return st.stopping || !st.queue.isEmpty) do
+    modifyGet fun st =>
+      let n := min config.maxGroupSize st.queue.size
+      let rest := st.queue.extract n st.queue.size
+      ((st.queue.extract 0 n, st.stopping && rest.isEmpty),
+        { st with queue := rest, stats := { st.stats with queueDepth := rest.size } })
+  if !jobs.isEmpty then
+    let started ← IO.monoMsNow
+    let failed ← try runGroup db jobs catch e => do
+      -- The writer must outlive any one group, or every later write hangs
+      for job in jobs do job.fail e
+      pure jobs.size
+    let waited := jobs.foldl (fun acc job => acc + (started - job.enqueuedMs)) 0
+    state.atomically do
+      modify fun st => { st with stats := { st.stats with
+        writes := st.stats.writes + jobs.size
+        failedWrites := st.stats.failedWrites + failed
+        commits := st.stats.commits + (if failed < jobs.size then 1 else 0)
+        writeWaitMs := st.stats.writeWaitMs + waited } }
+  if !finished then
+    writerLoop config db state wake
+
+/-- Open a pool on a database file, creating it if needed.
+    The writer switches the file to WAL mode before the readers open. -/
+def openFile (path : String) (config : PoolConfig := {}) : IO Pool := do
+  let config := { config with maxGroupSize := max config.maxGroupSize 1 }
+  let writerConn ← Database.openFile path
+  writerConn.busyTimeout config.busyTimeoutMs
+  unless (← writerConn.enableWAL) do
+    throw (IO.userError s!"could not enable WAL on {path}")
+  let mut readers : Array Database := #[]
+  for _ in [:config.readers] do
+    let db ← Database.openReadOnly path
+    db.busyTimeout config.busyTimeoutMs
+    readers := readers.push db
+  let state ← Std.Mutex.new ({ idle := readers, stats := { idleReaders := readers.size } } : PoolState)
+  let readerFree ← Std.Condvar.new
+  let writerWake ← Std.Condvar.new
+  let writer ← IO.asTask (prio := .dedicated) (writerLoop config writerConn state writerWake)
+  pure { config, path, state, readerFree, writerWake, writerConn, readers, writer }
+
+/-- Queue a write job and return a task that resolves once its group commits.
+    Jobs run inside the writer's transaction, so they must not BEGIN or
+    COMMIT themselves (savepoints are fine). If a job throws, only its own
+    changes are rolled back. -/
+def submit (pool : Pool) (f : Database → IO α) : IO (Task (Except IO.Error α)) := do
+  let promise ← IO.Promise.new
+  let job : WriteJob := {
+    run := fun db => do
+      let result ← f db
+      return promise.resolve (.ok result)
+    fail := fun e => promise.resolve (.error e)
+    enqueuedMs := ← IO.monoMsNow }
+  let accepted ← pool.state.atomically do
+    let st ← get
+    if st.stopping then return false
+    let queue := st.queue.push job
+    set { st with queue, stats := { st.stats with
+      queueDepth := queue.size
+      maxQueueDepth := max st.stats.maxQueueDepth queue.size } }
+    return true
+  if accepted then
+    pool.writerWake.notifyOne
+  else
+    promise.resolve (.error (IO.userError "pool is closed"))
+  return promise.result!
+
+/-- Run a write job through the writer queue and wait for its group to commit -/
+def write (pool : Pool) (f : Database → IO α) : IO α := do
+  IO.ofExcept (← IO.wait (← pool.submit f))
+
+/-- Run `f` on an idle reader, waiting for one if all are busy.
+    With no readers configured, reads go through the writer queue. -/
+def read (pool : Pool) (f : Database → IO α) : IO α := do
+  if pool.readers.isEmpty then
+    return ← pool.write f
+  let start ← IO.monoMsNow
+  let db ← pool.state.atomicallyOnce pool.readerFree
+      (do let st ← get; return st.stopping || !st.idle.isEmpty) do
+    let st ← get
+    if st.stopping then
+      throw (IO.userError "pool is closed")
+    match st.idle.back? with
+    | some db =>
+      let waited := (← IO.monoMsNow) - start
+      set { st with
+        idle := st.idle.pop
+        stats := { st.stats with
+          readWaitMs := st.stats.readWaitMs + waited
+          idleReaders := st.idle.size - 1 } }
+      return db
+    | none => throw (IO.userError "no idle reader")
+  try
+    f db
+  finally
+    pool.state.atomically do
+      modify fun st => { st with
+        idle := st.idle.push db
+        stats := { st.stats with reads := st.stats.reads + 1, idleReaders := st.idle.size + 1 } }
+    pool.readerFree.notifyOne
+
+/-- Query on a reader connection -/
+def query (pool : Pool) (sql : String) (params : Array Value := #[]) : IO (Array Row) :=
+  pool.read (·.queryParams sql params)
+
+/-- First row of a query, on a reader connection -/
+def queryOne (pool : Pool) (sql : String) (params : Array Value := #[]) : IO (Option Row) :=
+  pool.read fun db => db.withCursor sql (·.next?) params (batchSize := 1)
+
+/-- Execute a statement through the writer queue -/
+def exec (pool : Pool) (sql : String) (params : Array Value := #[]) : IO Unit :=
+  pool.write (·.execParams sql params)
+
+/-- Current counters -/
+def stats (pool : Pool) : IO PoolStats :=
+  pool.state.atomically do return (← get).stats
+
+/-- Stop accepting work, commit what is queued and close every connection.
+    Reads still in progress should finish first. -/
+def close (pool : Pool) : IO Unit := do
+  pool.state.atomically (modify fun st => { st with stopping := true })
+  pool.writerWake.notifyAll
+  pool.readerFree.notifyAll
+  let _ ← IO.wait pool.writer
+  pool.writerConn.close
+  for db in pool.readers do
+    db.close
+
+end Pool
+
+end Quarry
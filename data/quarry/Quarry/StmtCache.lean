@@ -0,0 +1,80 @@
+/-
+  Quarry.StmtCache
+  Per-connection LRU cache of prepared statements, keyed by SQL text
+-/
+import Quarry.FFI.Statement
+import Std.Data.HashMap
+
+namespace Quarry
+
+/-- A cached prepared statement -/
+structure CachedStmt where
+  stmt : FFI.Statement
+  /-- Cache clock at the most recent use -/
+  lastUse : Nat
+
+/-- Statement cache hit/miss counters -/
+structure StmtCacheStats where
+  hits : Nat := 0
+  misses : Nat := 0
+  size : Nat := 0
+  capacity : Nat := 0
+  deriving Repr, BEq, Inhabited
+
+/-- LRU cache of idle prepared statements.
+    A statement is taken out of the cache while it runs and put back when
+    it finishes, so re-entrant queries (e.g. from a SQL function callback)
+    never share a statement that is mid-step. -/
+structure StmtCache where
+  entries : Std.HashMap String CachedStmt := {}
+  capacity : Nat := 64
+  clock : Nat := 0
+  hits : Nat := 0
+  misses : Nat := 0
+
+instance : Inhabited StmtCache := ⟨{}⟩
+
+namespace StmtCache
+
+/-- Take an idle statement for `sql` out of the cache, counting the hit or miss -/
+def take? (cache : StmtCache) (sql : String) : Option FFI.Statement × StmtCache :=
+  match cache.entries.get? sql with
+  | some entry => (some entry.stmt, { cache with entries := cache.entries.erase sql, hits := cache.hits + 1 })
+  | none => (none, { cache with misses := cache.misses + 1 })
+
+/-- Drop the least recently used statement -/
+def evict (cache : StmtCache) : StmtCache :=
+  let oldest := cache.entries.fold (init := (none : Option (String × Nat))) (fun acc sql entry =>
+    match acc with
+    | some (_, lastUse) => if entry.lastUse < lastUse then some (sql, entry.lastUse) else acc
+    | none => some (sql, entry.lastUse))
+  match oldest with
+  | some (sql, _) => { cache with entries := cache.entries.erase sql }
+  | none => cache
+
+/-- Return an idle statement to the cache, evicting the least recently used one when full.
+    Statements dropped from the cache are finalized once no longer referenced. -/
+def put (cache : StmtCache) (sql : String) (stmt : FFI.Statement) : StmtCache :=
+  if cache.capacity == 0 || cache.entries.contains sql then cache
+  else
+    let cache := if cache.entries.size >= cache.capacity then cache.evict else cache
+    { cache with
+      entries := cache.entries.insert sql ⟨stmt, cache.clock⟩
+      clock := cache.clock + 1 }
+
+/-- Change the capacity, evicting down to it -/
+partial def resize (cache : StmtCache) (capacity : Nat) : StmtCache :=
+  let cache := { cache with capacity }
+  if cache.entries.size > capacity then (cache.evict).resize capacity else cache
+
+/-- Drop all cached statements (counters are kept) -/
+def clear (cache : StmtCache) : StmtCache :=
+  { cache with entries := {} }
+
+/-- Current counters -/
+def stats (cache : StmtCache) : StmtCacheStats :=
+  { hits := cache.hits, misses := cache.misses, size := cache.entries.size, capacity := cache.capacity }
+
+end StmtCache
+
+end Quarry
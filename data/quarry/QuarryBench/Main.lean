@@ -0,0 +1,129 @@
+/-
+  Quarry scan benchmarks.
+
+  Compares reading a large result set cell by cell (two FFI calls per cell)
+  with the native batch fetch, both materialized as rows and consumed
+  directly as column vectors. Then runs a mixed read/write workload
+  (90% point reads, 10% inserts) against a `Pool` at several worker counts.
+  Run: lake exe quarry_bench [--rows=N] [--iterations=N] [--ops=N]
+-/
+import Quarry
+
+namespace QuarryBench
+
+open Quarry
+
+structure BenchConfig where
+  rowCount : Nat := 100000
+  iterations : Nat := 5
+  /-- Operations per worker in the pool benchmark -/
+  opsPerWorker : Nat := 2000
+  deriving Repr, Inhabited
+
+private def parseNatArg? (pfx : String) (arg : String) : Option Nat :=
+  if arg.startsWith pfx then
+    (arg.drop pfx.length).toNat?
+  else
+    none
+
+private partial def parseArgs (args : List String) (config : BenchConfig := {}) : BenchConfig :=
+  match args with
+  | [] => config
+  | arg :: rest =>
+    match parseNatArg? "--rows=" arg with
+    | some n => parseArgs rest { config with rowCount := n }
+    | none =>
+      match parseNatArg? "--iterations=" arg with
+      | some n => parseArgs rest { config with iterations := n }
+      | none =>
+        match parseNatArg? "--ops=" arg with
+        | some n => parseArgs rest { config with opsPerWorker := n }
+        | none => parseArgs rest config
+
+private def measureMs (action : IO α) : IO (α × Nat) := do
+  let start ← IO.monoMsNow
+  let value ← action
+  let elapsed := (← IO.monoMsNow) - start
+  pure (value, elapsed)
+
+private def withMetric (label : String) (rows : Nat) (action : IO α) : IO α := do
+  let (value, elapsed) ← measureMs action
+  let rate := if elapsed == 0 then 0 else rows * 1000 / elapsed
+  IO.println s!"  {label}: {elapsed}ms ({rate} rows/s)"
+  pure value
+
+private def scanSql : String := "SELECT id, score, name FROM items"
+
+private def seed (db : Database) (rowCount : Nat) : IO Unit := do
+  db.execRaw "CREATE TABLE items (id INTEGER PRIMARY KEY, score REAL, name TEXT)"
+  db.execRaw s!"WITH RECURSIVE n(k) AS (SELECT 1 UNION ALL SELECT k + 1 FROM n WHERE k < {rowCount})
+    INSERT INTO items SELECT k, k * 0.25, 'item-' || k FROM n"
+
+private def benchScan (cfg : BenchConfig) (db : Database) : IO Unit := do
+  let total := cfg.rowCount * cfg.iterations
+  IO.println s!"scan {cfg.rowCount} rows x{cfg.iterations}"
+
+  let _ ← withMetric "per-cell rows" total do
+    let mut n := 0
+    for _ in [:cfg.iterations] do
+      let rows ← db.withCachedStmt scanSql db.readRowsByCell
+      n := n + rows.size
+    pure n
+
+  let _ ← withMetric "batched rows" total do
+    let mut n := 0
+    for _ in [:cfg.iterations] do
+      let rows ← db.query scanSql
+      n := n + rows.size
+    pure n
+
+  let _ ← withMetric "batched columns (sum id)" total do
+    let mut sum : Int := 0
+    for _ in [:cfg.iterations] do
+      for batch in db.batches scanSql do
+        for i in [:batch.rowCount] do
+          sum := sum + (batch.getInt? i 0).getD 0
+    pure sum
+
+/-- One worker: every tenth operation is an insert, the rest are point reads -/
+private def poolWorker (pool : Pool) (worker ops keys : Nat) : IO Unit := do
+  for i in [:ops] do
+    if i % 10 == 0 then
+      pool.exec "INSERT INTO events (worker, seq) VALUES (?, ?)" #[.integer worker, .integer i]
+    else
+      let key := (worker * 7919 + i * 104729) % keys + 1
+      let _ ← pool.queryOne "SELECT name FROM items WHERE id = ?" #[.integer key]
+
+private def benchPool (cfg : BenchConfig) : IO Unit := do
+  let path := "/tmp/quarry_bench_pool.db"
+  IO.println s!"pool mixed 90/10 read/write, {cfg.opsPerWorker} ops per worker"
+  for workers in [1, 2, 4, 8] do
+    for suffix in ["", "-wal", "-shm"] do
+      try IO.FS.removeFile (path ++ suffix) catch _ => pure ()
+    let pool ← Pool.openFile path { readers := workers }
+    pool.write fun db => do
+      seed db cfg.rowCount
+      db.execRaw "CREATE TABLE events (worker INTEGER, seq INTEGER)"
+    let total := workers * cfg.opsPerWorker
+    withMetric s!"{workers} workers" total do
+      let tasks ← (List.range workers).mapM fun w =>
+        IO.asTask (prio := .dedicated) (poolWorker pool w cfg.opsPerWorker cfg.rowCount)
+      for task in tasks do
+        let _ ← IO.ofExcept (← IO.wait task)
+    let stats ← pool.stats
+    let groupSize := if stats.commits == 0 then 0 else stats.writes / stats.commits
+    IO.println s!"    commits {stats.commits}, avg group {groupSize}, max queue {stats.maxQueueDepth}, read wait {stats.readWaitMs}ms, write wait {stats.writeWaitMs}ms"
+    pool.close
+
+def run (args : List String) : IO Unit := do
+  let cfg := parseArgs args
+  let db ← Database.openMemory
+  seed db cfg.rowCount
+  benchScan cfg db
+  db.close
+  benchPool cfg
+
+end QuarryBench
+
+def main (args : List String) : IO Unit :=
+  QuarryBench.run args
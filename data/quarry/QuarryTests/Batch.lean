@@ -0,0 +1,104 @@
+/-
+  Columnar Batch Fetch Tests
+-/
+import Quarry
+import Crucible
+
+open Crucible
+open Quarry
+
+namespace QuarryTests.Batch
+
+testSuite "Columnar Batch Fetch"
+
+/-- Table with one column per storage class, NULLs every third row -/
+def setupTable (rows : Nat) : IO Database := do
+  let db ← Database.openMemory
+  db.execRaw "CREATE TABLE t (i INTEGER, r REAL, s TEXT, b BLOB)"
+  db.execRaw s!"WITH RECURSIVE n(k) AS (SELECT 1 UNION ALL SELECT k + 1 FROM n WHERE k < {rows})
+    INSERT INTO t SELECT
+      CASE WHEN k % 3 = 0 THEN NULL ELSE k END,
+      k * 0.5,
+      CASE WHEN k % 3 = 0 THEN NULL ELSE 'row ' || k END,
+      CASE WHEN k % 3 = 0 THEN NULL ELSE x'00ff' END
+    FROM n"
+  return db
+
+test "batches split rows and keep order" := do
+  let db ← setupTable 2500
+  let batches ← db.queryBatches "SELECT i FROM t" (batchSize := 1000)
+  batches.map (·.rowCount) ≡ #[1000, 1000, 500]
+  (batches[0]!).getInt? 0 0 ≡ some 1
+  (batches[2]!).getInt? 499 0 ≡ some 2500
+
+test "typed vectors match the per-cell path" := do
+  let db ← setupTable 50
+  let byCell ← db.withCachedStmt "SELECT * FROM t" db.readRowsByCell
+  let batched ← db.query "SELECT * FROM t"
+  batched.size ≡ byCell.size
+  for (a, b) in batched.zip byCell do
+    ensure (a.values == b.values) s!"row mismatch: {a} vs {b}"
+
+test "invalid UTF-8 text decodes the same as per-cell reads" := do
+  let db ← Database.openMemory
+  db.execRaw "CREATE TABLE u (s TEXT)"
+  db.execRaw "INSERT INTO u VALUES (CAST(x'61ff62' AS TEXT)), ('ok')"
+  let byCell ← db.withCachedStmt "SELECT s FROM u" db.readRowsByCell
+  let batched ← db.query "SELECT s FROM u"
+  for (a, b) in batched.zip byCell do
+    ensure (a.values == b.values) s!"row mismatch: {a} vs {b}"
+  let batch := (← db.queryBatches "SELECT s FROM u")[0]!
+  batch.getText? 0 0 ≡ some "a\uFFFDb"
+
+test "null bitmap marks NULL rows" := do
+  let db ← setupTable 6
+  let batches ← db.queryBatches "SELECT i, s FROM t"
+  let batch := batches[0]!
+  match batch.vectors[0]? with
+  | some v@(.integer ..) =>
+    v.isNull 2 ≡ true
+    v.isNull 3 ≡ false
+  | _ => throw (IO.userError "expected integer vector")
+  batch.getText? 0 1 ≡ some "row 1"
+  batch.getText? 2 1 ≡ none
+
+test "columns of mixed storage classes fall back to values" := do
+  let db ← Database.openMemory
+  let batches ← db.queryBatches "SELECT 1 UNION ALL SELECT 'two' UNION ALL SELECT NULL"
+  let batch := batches[0]!
+  match batch.vectors[0]? with
+  | some (.mixed _) => ensure true "mixed"
+  | _ => throw (IO.userError "expected mixed vector")
+  batch.get? 0 0 ≡ some (.integer 1)
+  batch.get? 1 0 ≡ some (.text "two")
+  batch.get? 2 0 ≡ some .null
+
+test "all-NULL column and empty result" := do
+  let db ← Database.openMemory
+  let batches ← db.queryBatches "SELECT NULL"
+  match batches[0]?.bind (·.vectors[0]?) with
+  | some .null => ensure true "null vector"
+  | _ => throw (IO.userError "expected null vector")
+  db.execRaw "CREATE TABLE empty (x INTEGER)"
+  (← db.queryBatches "SELECT x FROM empty").size ≡ 0
+
+test "for-in over batches supports early exit" := do
+  let db ← setupTable 3000
+  let mut seen := 0
+  for batch in db.batches "SELECT i FROM t WHERE i > ?" #[.integer 0] (batchSize := 256) do
+    seen := seen + batch.rowCount
+    if seen >= 512 then break
+  seen ≡ 512
+  -- The statement went back to the cache reset, so it can run again
+  let rows ← db.queryParams "SELECT i FROM t WHERE i > ?" #[.integer 2990]
+  rows.size ≡ 6
+
+test "column lookup by name" := do
+  let db ← setupTable 3
+  let batch := (← db.queryBatches "SELECT i AS Id, r FROM t")[0]!
+  batch.columnIndex? "id" ≡ some 0
+  match batch.column? "R" with
+  | some (.real data _) => data.size ≡ 3
+  | _ => throw (IO.userError "expected real vector")
+
+end QuarryTests.Batch
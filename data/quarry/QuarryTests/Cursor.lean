@@ -0,0 +1,96 @@
+/-
+  Streaming Cursor Tests
+-/
+import Quarry
+import Crucible
+
+open Crucible
+open Quarry
+
+namespace QuarryTests.Cursor
+
+testSuite "Streaming Cursor"
+
+def setupNumbers (count : Nat) : IO Database := do
+  let db ← Database.openMemory
+  db.execRaw "CREATE TABLE n (k INTEGER)"
+  db.execRaw s!"WITH RECURSIVE s(k) AS (SELECT 1 UNION ALL SELECT k + 1 FROM s WHERE k < {count})
+    INSERT INTO n SELECT k FROM s"
+  return db
+
+test "for-in over a cursor yields every row in order" := do
+  let db ← setupNumbers 1000
+  let mut expected : Int := 1
+  for row in ← db.openCursor "SELECT k FROM n ORDER BY k" (batchSize := 64) do
+    row.get? 0 ≡ some (.integer expected)
+    expected := expected + 1
+  expected ≡ 1001
+
+test "next? reads across batch boundaries and then stays empty" := do
+  let db ← setupNumbers 5
+  let cursor ← db.openCursor "SELECT k FROM n" (batchSize := 2)
+  let mut count := 0
+  while (← cursor.next?).isSome do
+    count := count + 1
+  count ≡ 5
+  (← cursor.next?).isNone ≡ true
+  cursor.close
+
+test "break closes the cursor and returns the statement to the cache" := do
+  let db ← setupNumbers 1000
+  let mut seen := 0
+  for _ in ← db.openCursor "SELECT k FROM n" (batchSize := 16) do
+    seen := seen + 1
+    if seen == 10 then break
+  seen ≡ 10
+  (← db.stmtCacheStats).size ≡ 1
+  -- The statement was reset, so reusing it starts from the first row
+  let row ← db.queryOne "SELECT k FROM n"
+  row.bind (·.get? 0) ≡ some (.integer 1)
+
+test "exception in the loop body still closes the cursor" := do
+  let db ← setupNumbers 10
+  try
+    for _ in ← db.openCursor "SELECT k FROM n" do
+      throw (IO.userError "stop")
+  catch _ => pure ()
+  (← db.stmtCacheStats).size ≡ 1
+
+test "cursor binds positional parameters" := do
+  let db ← setupNumbers 100
+  let mut total : Int := 0
+  for row in ← db.openCursor "SELECT k FROM n WHERE k > ? AND k <= ?" #[.integer 90, .integer 95] do
+    match row.get? 0 with
+    | some (.integer k) => total := total + k
+    | _ => pure ()
+  total ≡ 91 + 92 + 93 + 94 + 95
+
+test "queryOne steps only the first row" := do
+  let db ← setupNumbers 3
+  let row ← db.queryOne "SELECT k FROM n ORDER BY k DESC"
+  row.bind (·.get? 0) ≡ some (.integer 3)
+  (← db.queryOne "SELECT k FROM n WHERE k > 100").isNone ≡ true
+
+test "queryForEach streams rows to the callback" := do
+  let db ← setupNumbers 50
+  let sum ← IO.mkRef (0 : Int)
+  db.queryForEach "SELECT k FROM n" fun row => do
+    match row.get? 0 with
+    | some (.integer k) => sum.modify (· + k)
+    | _ => pure ()
+  (← sum.get) ≡ 1275
+
+test "Chisel selectOne and selectForEach use cursors" := do
+  let db ← setupNumbers 20
+  let row ← db.selectOne do
+    Chisel.selectAll
+    Chisel.from_ "n"
+    Chisel.where_ (Chisel.gt (Chisel.col "k") (Chisel.val 18))
+  row.bind (·.get? 0) ≡ some (.integer 19)
+  let count ← IO.mkRef 0
+  db.selectForEach (do
+    Chisel.selectAll
+    Chisel.from_ "n") fun _ => count.modify (· + 1)
+  (← count.get) ≡ 20
+
+end QuarryTests.Cursor
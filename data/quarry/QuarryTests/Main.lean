@@ -17,6 +17,10 @@ import QuarryTests.Blob
 import QuarryTests.Hook
 import QuarryTests.Serialize
 import QuarryTests.Chisel
+import QuarryTests.StmtCache
+import QuarryTests.Batch
+import QuarryTests.Cursor
+import QuarryTests.Pool
 
 open Crucible
 
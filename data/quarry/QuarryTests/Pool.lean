@@ -0,0 +1,107 @@
+/-
+  Connection Pool Tests
+-/
+import Quarry
+import Crucible
+
+open Crucible
+open Quarry
+
+namespace QuarryTests.Pool
+
+testSuite "Connection Pool"
+
+/-- Fresh database file (WAL and SHM files included) -/
+def freshPath (name : String) : IO String := do
+  let path := s!"/tmp/quarry_pool_{name}.db"
+  for suffix in ["", "-wal", "-shm"] do
+    try IO.FS.removeFile (path ++ suffix) catch _ => pure ()
+  return path
+
+test "writes are visible to readers after commit" := do
+  let pool ← Pool.openFile (← freshPath "visible") { readers := 2 }
+  pool.exec "CREATE TABLE t (x INTEGER)"
+  pool.exec "INSERT INTO t VALUES (?)" #[.integer 7]
+  let row ← pool.queryOne "SELECT x FROM t"
+  row.bind (·.get? 0) ≡ some (.integer 7)
+  pool.close
+
+test "readers are read-only" := do
+  let pool ← Pool.openFile (← freshPath "readonly") { readers := 1 }
+  pool.exec "CREATE TABLE t (x INTEGER)"
+  let result ← (pool.read (·.execRaw "INSERT INTO t VALUES (1)")).toBaseIO
+  match result with
+  | .error _ => ensure true "write rejected"
+  | .ok _ => throw (IO.userError "reader accepted a write")
+  pool.close
+
+test "concurrent writes are grouped into fewer commits" := do
+  let pool ← Pool.openFile (← freshPath "group") { readers := 1, maxGroupSize := 32 }
+  pool.exec "CREATE TABLE t (x INTEGER)"
+  let mut tasks : Array (Task (Except IO.Error Unit)) := #[]
+  for i in [:200] do
+    tasks := tasks.push (← pool.submit (·.execParams "INSERT INTO t VALUES (?)" #[.integer i]))
+  for task in tasks do
+    let _ ← IO.ofExcept (← IO.wait task)
+  let row ← pool.queryOne "SELECT count(*) FROM t"
+  row.bind (·.get? 0) ≡ some (.integer 200)
+  let stats ← pool.stats
+  stats.writes ≡ 201
+  shouldSatisfy (stats.commits < 201) "some writes shared a commit"
+  stats.queueDepth ≡ 0
+  pool.close
+
+test "a failing job rolls back only its own changes" := do
+  let pool ← Pool.openFile (← freshPath "failing") { readers := 1 }
+  pool.exec "CREATE TABLE t (x INTEGER PRIMARY KEY)"
+  let ok1 ← pool.submit (·.execParams "INSERT INTO t VALUES (?)" #[.integer 1])
+  let bad ← pool.submit fun db => do
+    db.execParams "INSERT INTO t VALUES (?)" #[.integer 2]
+    throw (IO.userError "boom")
+  let ok2 ← pool.submit (·.execParams "INSERT INTO t VALUES (?)" #[.integer 3])
+  let _ ← IO.ofExcept (← IO.wait ok1)
+  let _ ← IO.ofExcept (← IO.wait ok2)
+  match ← IO.wait bad with
+  | .error _ => ensure true "job failed"
+  | .ok _ => throw (IO.userError "expected failure")
+  let rows ← pool.query "SELECT x FROM t ORDER BY x"
+  rows.map (·.get? 0) ≡ #[some (.integer 1), some (.integer 3)]
+  (← pool.stats).failedWrites ≡ 1
+  pool.close
+
+test "a failing savepoint fails its group and keeps the writer running" := do
+  let pool ← Pool.openFile (← freshPath "savepoint") { readers := 1 }
+  pool.exec "CREATE TABLE t (x INTEGER)"
+  -- Releasing the pool's savepoint early makes the pool's own RELEASE fail
+  let bad ← pool.submit (·.execRaw "RELEASE quarry_pool_job")
+  let next ← pool.submit (·.execParams "INSERT INTO t VALUES (?)" #[.integer 1])
+  match ← IO.wait bad with
+  | .error _ => ensure true "job failed"
+  | .ok _ => throw (IO.userError "expected the savepoint failure")
+  -- Failed with the group or committed after it, but resolved either way
+  let _ ← IO.wait next
+  pool.exec "INSERT INTO t VALUES (2)"
+  let row ← pool.queryOne "SELECT count(*) FROM t WHERE x = 2"
+  row.bind (·.get? 0) ≡ some (.integer 1)
+  pool.close
+
+test "reads run on every reader and report stats" := do
+  let pool ← Pool.openFile (← freshPath "reads") { readers := 3 }
+  pool.exec "CREATE TABLE t (x INTEGER)"
+  let tasks ← (List.range 30).mapM fun _ =>
+    IO.asTask (pool.query "SELECT count(*) FROM t")
+  for task in tasks do
+    let _ ← IO.ofExcept (← IO.wait task)
+  let stats ← pool.stats
+  stats.reads ≡ 30
+  stats.idleReaders ≡ 3
+  pool.close
+
+test "closed pool rejects new work" := do
+  let pool ← Pool.openFile (← freshPath "closed") { readers := 1 }
+  pool.close
+  match ← IO.wait (← pool.submit (·.execRaw "CREATE TABLE t (x INTEGER)")) with
+  | .error _ => ensure true "rejected"
+  | .ok _ => throw (IO.userError "closed pool accepted a write")
+
+end QuarryTests.Pool
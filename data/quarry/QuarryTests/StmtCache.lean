@@ -0,0 +1,92 @@
+/-
+  Prepared Statement Cache Tests
+-/
+import Quarry
+import Crucible
+
+open Crucible
+open Quarry
+
+namespace QuarryTests.StmtCache
+
+testSuite "Prepared Statement Cache"
+
+test "repeated query reuses the cached statement" := do
+  let db ← Database.openMemory
+  let _ ← db.query "SELECT 1"
+  let _ ← db.query "SELECT 1"
+  let _ ← db.query "SELECT 1"
+  let stats ← db.stmtCacheStats
+  stats.misses ≡ 1
+  stats.hits ≡ 2
+  stats.size ≡ 1
+
+test "least recently used statement is evicted at capacity" := do
+  let db ← Database.openMemory
+  db.setStmtCacheCapacity 2
+  let _ ← db.query "SELECT 1"
+  let _ ← db.query "SELECT 2"
+  let _ ← db.query "SELECT 1"
+  let _ ← db.query "SELECT 3"
+  (← db.stmtCacheStats).size ≡ 2
+  -- SELECT 2 was least recently used, so it is prepared again
+  let _ ← db.query "SELECT 2"
+  let stats ← db.stmtCacheStats
+  stats.hits ≡ 1
+  stats.misses ≡ 4
+
+test "zero capacity disables caching" := do
+  let db ← Database.openMemory
+  db.setStmtCacheCapacity 0
+  let _ ← db.query "SELECT 1"
+  let _ ← db.query "SELECT 1"
+  let stats ← db.stmtCacheStats
+  stats.hits ≡ 0
+  stats.size ≡ 0
+
+test "queryParams rebinds values on a cached statement" := do
+  let db ← Database.openMemory
+  db.execSqlDdl "CREATE TABLE t (x INTEGER)"
+  db.execParams "INSERT INTO t VALUES (?)" #[.integer 1]
+  db.execParams "INSERT INTO t VALUES (?)" #[.integer 2]
+  let rows ← db.queryParams "SELECT x FROM t WHERE x = ?" #[.integer 2]
+  rows.size ≡ 1
+  match rows[0]?.bind (·.get? 0) with
+  | some (Value.integer 2) => ensure true "bound value"
+  | _ => throw (IO.userError "expected 2")
+  (← db.stmtCacheStats).hits ≡ 1
+
+test "Chisel inserts with different values share one statement" := do
+  let db ← Database.openMemory
+  db.execSqlDdl "CREATE TABLE users (name TEXT, age INTEGER)"
+  let _ ← db.execSqlInsert "INSERT INTO users (name, age) VALUES ('Alice', 30)"
+  let before ← db.stmtCacheStats
+  let _ ← db.execSqlInsert "INSERT INTO users (name, age) VALUES ('O''Brien', 41)"
+  let after ← db.stmtCacheStats
+  after.hits ≡ before.hits + 1
+  let rows ← db.execSqlSelect "SELECT name FROM users WHERE age = 41"
+  match rows[0]?.bind (·.get? 0) with
+  | some (Value.text "O'Brien") => ensure true "quote round-trips"
+  | _ => throw (IO.userError "expected O'Brien")
+
+test "nested query inside a function callback" := do
+  let db ← Database.openMemory
+  db.execSqlDdl "CREATE TABLE t (x INTEGER)"
+  let _ ← db.execSqlInsert "INSERT INTO t VALUES (1)"
+  let _ ← db.execSqlInsert "INSERT INTO t VALUES (2)"
+  db.createScalarFunction "count_t" 1 fun _ => do
+    let rows ← db.query "SELECT count(*) FROM t"
+    return rows[0]?.bind (·.get? 0) |>.getD .null
+  let rows ← db.query "SELECT count_t(x) FROM t"
+  rows.size ≡ 2
+  match rows[1]?.bind (·.get? 0) with
+  | some (Value.integer 2) => ensure true "nested query"
+  | _ => throw (IO.userError "expected 2")
+
+test "close releases cached statements" := do
+  let db ← Database.openMemory
+  let _ ← db.query "SELECT 1"
+  db.close
+  (← db.stmtCacheStats).size ≡ 0
+
+end QuarryTests.StmtCache
@@ -116,6 +116,24 @@ LEAN_EXPORT lean_obj_res quarry_db_open(b_lean_obj_arg path_obj, lean_obj_arg wo
     return lean_io_result_mk_ok(obj);
 }
 
+LEAN_EXPORT lean_obj_res quarry_db_open_readonly(b_lean_obj_arg path_obj, lean_obj_arg world) {
+    init_external_classes();
+
+    const char* path = lean_string_cstr(path_obj);
+    sqlite3* db = NULL;
+
+    int rc = sqlite3_open_v2(path, &db, SQLITE_OPEN_READONLY, NULL);
+    if (rc != SQLITE_OK) {
+        const char* err = db ? sqlite3_errmsg(db) : "Failed to open database";
+        lean_object* result = mk_io_error(err);
+        if (db) sqlite3_close(db);
+        return result;
+    }
+
+    lean_object* obj = lean_alloc_external(g_database_class, db);
+    return lean_io_result_mk_ok(obj);
+}
+
 LEAN_EXPORT lean_obj_res quarry_db_open_memory(lean_obj_arg world) {
     init_external_classes();
 
@@ -903,6 +921,340 @@ LEAN_EXPORT lean_obj_res quarry_stmt_sql(b_lean_obj_arg stmt_obj, lean_obj_arg w
     return lean_io_result_mk_ok(lean_mk_string(sql ? sql : ""));
 }
 
+/* ========================================================================== */
+/* Batch Fetch                                                                 */
+/* ========================================================================== */
+
+/* ColumnVector constructor tags (see Quarry/Core/Batch.lean) */
+#define VEC_NULL 0
+#define VEC_INTEGER 1
+#define VEC_REAL 2
+#define VEC_TEXT 3
+#define VEC_BLOB 4
+#define VEC_MIXED 5
+
+/* Growable byte buffer. A failed allocation sets `failed` and leaves the
+ * existing contents in place; later appends are dropped. */
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t cap;
+    int failed;
+} ByteBuf;
+
+static int bytebuf_reserve(ByteBuf* buf, size_t extra) {
+    if (buf->failed) return -1;
+    if (buf->size + extra <= buf->cap) return 0;
+    size_t cap = buf->cap ? buf->cap : 64;
+    while (cap < buf->size + extra) cap *= 2;
+    uint8_t* data = (uint8_t*)realloc(buf->data, cap);
+    if (data == NULL) {
+        buf->failed = 1;
+        return -1;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+static void bytebuf_append(ByteBuf* buf, const void* src, size_t n) {
+    if (n == 0) return;
+    if (bytebuf_reserve(buf, n) < 0) return;
+    memcpy(buf->data + buf->size, src, n);
+    buf->size += n;
+}
+
+static void bytebuf_append_u32le(ByteBuf* buf, uint32_t v) {
+    uint8_t bytes[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    bytebuf_append(buf, bytes, 4);
+}
+
+static void bytebuf_append_i64le(ByteBuf* buf, int64_t v) {
+    uint64_t u = (uint64_t)v;
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) bytes[i] = (uint8_t)(u >> (8 * i));
+    bytebuf_append(buf, bytes, 8);
+}
+
+static uint32_t bytebuf_u32le_at(const ByteBuf* buf, size_t pos) {
+    const uint8_t* p = buf->data + pos;
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int64_t bytebuf_i64le_at(const ByteBuf* buf, size_t pos) {
+    uint64_t u = 0;
+    for (int i = 0; i < 8; i++) u |= (uint64_t)buf->data[pos + i] << (8 * i);
+    return (int64_t)u;
+}
+
+/* Copy a buffer into a fresh Lean ByteArray */
+static lean_object* bytebuf_to_lean(const ByteBuf* buf) {
+    lean_object* arr = lean_alloc_sarray(1, buf->size, buf->size);
+    if (buf->size > 0) {
+        memcpy(lean_sarray_cptr(arr), buf->data, buf->size);
+    }
+    return arr;
+}
+
+/* Builds one ColumnVector while rows are stepped.
+ * kind is 0 until the first non-NULL value, then the SQLite storage class of
+ * the column, or -1 once rows of different classes have been seen. */
+typedef struct {
+    int kind;
+    ByteBuf nulls;    /* bitmap, bit set when the row is NULL */
+    ByteBuf data;     /* int64 / double / text and blob bytes */
+    ByteBuf offsets;  /* text and blob: uint32 offsets, one more than rows */
+    lean_object* values;  /* mixed: Array Value */
+} ColumnBuilder;
+
+static void column_builder_free(ColumnBuilder* col) {
+    free(col->nulls.data);
+    free(col->data.data);
+    free(col->offsets.data);
+    if (col->values) lean_dec(col->values);
+}
+
+/* Whether any of the column's buffers failed to grow */
+static int column_builder_failed(const ColumnBuilder* col) {
+    return col->nulls.failed || col->data.failed || col->offsets.failed;
+}
+
+static int column_builder_is_null(const ColumnBuilder* col, size_t row) {
+    return (col->nulls.data[row / 8] >> (row % 8)) & 1;
+}
+
+/* Slot for a NULL row (or a row before the kind was known) in a typed column */
+static void column_builder_push_empty(ColumnBuilder* col) {
+    switch (col->kind) {
+        case SQLITE_INTEGER:
+            bytebuf_append_i64le(&col->data, 0);
+            break;
+        case SQLITE_FLOAT: {
+            double zero = 0.0;
+            bytebuf_append(&col->data, &zero, sizeof(double));
+            break;
+        }
+        case SQLITE_TEXT:
+        case SQLITE_BLOB:
+            bytebuf_append_u32le(&col->offsets, (uint32_t)col->data.size);
+            break;
+    }
+}
+
+/* Decode bytes [start, stop) of a batch's text data. Goes through
+   lean_mk_string_from_bytes like per-cell reads, so invalid UTF-8 becomes
+   U+FFFD on both paths */
+LEAN_EXPORT lean_obj_res quarry_text_decode(b_lean_obj_arg data, size_t start, size_t stop) {
+    size_t size = lean_sarray_size(data);
+    if (stop > size) stop = size;
+    if (start > stop) start = stop;
+    return lean_mk_string_from_bytes((const char*)lean_sarray_cptr(data) + start, stop - start);
+}
+
+/* Rebuild row `row` of a typed column as a Lean Value */
+static lean_object* column_builder_value_at(const ColumnBuilder* col, size_t row) {
+    if (col->kind == 0 || column_builder_is_null(col, row)) {
+        return lean_alloc_ctor(0, 0, 0);  /* null */
+    }
+    switch (col->kind) {
+        case SQLITE_INTEGER: {
+            lean_object* obj = lean_alloc_ctor(1, 1, 0);
+            lean_ctor_set(obj, 0, lean_int64_to_int(bytebuf_i64le_at(&col->data, 8 * row)));
+            return obj;
+        }
+        case SQLITE_FLOAT: {
+            double d;
+            memcpy(&d, col->data.data + sizeof(double) * row, sizeof(double));
+            lean_object* obj = lean_alloc_ctor(2, 0, sizeof(double));
+            lean_ctor_set_float(obj, 0, d);
+            return obj;
+        }
+        case SQLITE_TEXT: {
+            uint32_t start = bytebuf_u32le_at(&col->offsets, 4 * row);
+            uint32_t end = bytebuf_u32le_at(&col->offsets, 4 * (row + 1));
+            lean_object* obj = lean_alloc_ctor(3, 1, 0);
+            lean_ctor_set(obj, 0, lean_mk_string_from_bytes((const char*)col->data.data + start, end - start));
+            return obj;
+        }
+        default: {  /* SQLITE_BLOB */
+            uint32_t start = bytebuf_u32le_at(&col->offsets, 4 * row);
+            uint32_t end = bytebuf_u32le_at(&col->offsets, 4 * (row + 1));
+            lean_object* arr = lean_alloc_sarray(1, end - start, end - start);
+            if (end > start) {
+                memcpy(lean_sarray_cptr(arr), col->data.data + start, end - start);
+            }
+            lean_object* obj = lean_alloc_ctor(4, 1, 0);
+            lean_ctor_set(obj, 0, arr);
+            return obj;
+        }
+    }
+}
+
+/* Switch a column to Array Value once it sees a second storage class */
+static void column_builder_make_mixed(ColumnBuilder* col, size_t rows) {
+    lean_object* values = lean_mk_empty_array_with_capacity(lean_box(rows));
+    for (size_t i = 0; i < rows; i++) {
+        values = lean_array_push(values, column_builder_value_at(col, i));
+    }
+    col->values = values;
+    col->kind = -1;
+}
+
+/* Append column `idx` of the current row; `row` rows are already stored */
+static void column_builder_push(ColumnBuilder* col, sqlite3_stmt* stmt, int idx, size_t row) {
+    int type = sqlite3_column_type(stmt, idx);
+
+    if (column_builder_failed(col)) return;
+    if (row % 8 == 0) {
+        uint8_t zero = 0;
+        bytebuf_append(&col->nulls, &zero, 1);
+        if (col->nulls.failed) return;
+    }
+    if (type == SQLITE_NULL) {
+        col->nulls.data[row / 8] |= (uint8_t)(1u << (row % 8));
+    }
+
+    if (col->kind == -1) {
+        col->values = lean_array_push(col->values, sqlite_value_to_lean(sqlite3_column_value(stmt, idx)));
+        return;
+    }
+    if (type == SQLITE_NULL) {
+        column_builder_push_empty(col);
+        return;
+    }
+    if (col->kind == 0) {
+        /* First non-NULL value fixes the column's type; backfill earlier rows */
+        col->kind = type;
+        if (type == SQLITE_TEXT || type == SQLITE_BLOB) {
+            bytebuf_append_u32le(&col->offsets, 0);
+        }
+        for (size_t i = 0; i < row; i++) {
+            column_builder_push_empty(col);
+        }
+    } else if (col->kind != type) {
+        column_builder_make_mixed(col, row);
+        col->values = lean_array_push(col->values, sqlite_value_to_lean(sqlite3_column_value(stmt, idx)));
+        return;
+    }
+
+    switch (type) {
+        case SQLITE_INTEGER:
+            bytebuf_append_i64le(&col->data, sqlite3_column_int64(stmt, idx));
+            break;
+        case SQLITE_FLOAT: {
+            double d = sqlite3_column_double(stmt, idx);
+            bytebuf_append(&col->data, &d, sizeof(double));
+            break;
+        }
+        case SQLITE_TEXT: {
+            const unsigned char* text = sqlite3_column_text(stmt, idx);
+            int len = sqlite3_column_bytes(stmt, idx);
+            bytebuf_append(&col->data, text, (size_t)len);
+            bytebuf_append_u32le(&col->offsets, (uint32_t)col->data.size);
+            break;
+        }
+        case SQLITE_BLOB: {
+            const void* data = sqlite3_column_blob(stmt, idx);
+            int len = sqlite3_column_bytes(stmt, idx);
+            bytebuf_append(&col->data, data, (size_t)len);
+            bytebuf_append_u32le(&col->offsets, (uint32_t)col->data.size);
+            break;
+        }
+    }
+}
+
+/* Finish a column as a Lean ColumnVector (consumes the builder's values) */
+static lean_object* column_builder_finish(ColumnBuilder* col) {
+    switch (col->kind) {
+        case 0:
+            return lean_box(VEC_NULL);
+        case -1: {
+            lean_object* obj = lean_alloc_ctor(VEC_MIXED, 1, 0);
+            lean_ctor_set(obj, 0, col->values);
+            col->values = NULL;
+            return obj;
+        }
+        case SQLITE_INTEGER: {
+            lean_object* obj = lean_alloc_ctor(VEC_INTEGER, 2, 0);
+            lean_ctor_set(obj, 0, bytebuf_to_lean(&col->data));
+            lean_ctor_set(obj, 1, bytebuf_to_lean(&col->nulls));
+            return obj;
+        }
+        case SQLITE_FLOAT: {
+            size_t n = col->data.size / sizeof(double);
+            lean_object* arr = lean_alloc_sarray(sizeof(double), n, n);
+            if (n > 0) {
+                memcpy(lean_float_array_cptr(arr), col->data.data, col->data.size);
+            }
+            lean_object* obj = lean_alloc_ctor(VEC_REAL, 2, 0);
+            lean_ctor_set(obj, 0, arr);
+            lean_ctor_set(obj, 1, bytebuf_to_lean(&col->nulls));
+            return obj;
+        }
+        default: {  /* SQLITE_TEXT, SQLITE_BLOB */
+            lean_object* obj = lean_alloc_ctor(col->kind == SQLITE_TEXT ? VEC_TEXT : VEC_BLOB, 3, 0);
+            lean_ctor_set(obj, 0, bytebuf_to_lean(&col->offsets));
+            lean_ctor_set(obj, 1, bytebuf_to_lean(&col->data));
+            lean_ctor_set(obj, 2, bytebuf_to_lean(&col->nulls));
+            return obj;
+        }
+    }
+}
+
+/* Step up to max_rows rows and return them as a FetchedBatch:
+ *   structure FetchedBatch where
+ *     rowCount : Nat
+ *     vectors : Array ColumnVector
+ *     done : Bool           -- scalar field after the two object fields
+ */
+LEAN_EXPORT lean_obj_res quarry_stmt_fetch_batch(b_lean_obj_arg stmt_obj, uint32_t max_rows, lean_obj_arg world) {
+    sqlite3_stmt* stmt = (sqlite3_stmt*)lean_get_external_data(stmt_obj);
+    int ncols = sqlite3_column_count(stmt);
+    ColumnBuilder* cols = (ColumnBuilder*)calloc(ncols > 0 ? (size_t)ncols : 1, sizeof(ColumnBuilder));
+    if (cols == NULL) {
+        return mk_io_error("Out of memory fetching a batch");
+    }
+
+    size_t rows = 0;
+    int done = 0;
+    while (rows < max_rows) {
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_DONE) {
+            done = 1;
+            break;
+        }
+        if (rc != SQLITE_ROW) {
+            for (int i = 0; i < ncols; i++) column_builder_free(&cols[i]);
+            free(cols);
+            return mk_sqlite_error(sqlite3_db_handle(stmt));
+        }
+        int failed = 0;
+        for (int i = 0; i < ncols; i++) {
+            column_builder_push(&cols[i], stmt, i, rows);
+            failed |= column_builder_failed(&cols[i]);
+        }
+        if (failed) {
+            for (int i = 0; i < ncols; i++) column_builder_free(&cols[i]);
+            free(cols);
+            return mk_io_error("Out of memory fetching a batch");
+        }
+        rows++;
+    }
+
+    lean_object* vectors = lean_mk_empty_array_with_capacity(lean_box(ncols));
+    for (int i = 0; i < ncols; i++) {
+        vectors = lean_array_push(vectors, column_builder_finish(&cols[i]));
+        column_builder_free(&cols[i]);
+    }
+    free(cols);
+
+    lean_object* batch = lean_alloc_ctor(0, 2, 1);
+    lean_ctor_set(batch, 0, lean_usize_to_nat(rows));
+    lean_ctor_set(batch, 1, vectors);
+    lean_ctor_set_uint8(batch, 2 * sizeof(void*), (uint8_t)done);
+    return lean_io_result_mk_ok(batch);
+}
+
 /* ========================================================================== */
 /* Backup Operations                                                           */
 /* ========================================================================== */
@@ -70,14 +70,8 @@ def changes [Timeline t] (ctx : TimelineCtx t) (d : Dynamic t a) : IO (Event t (
 /-- Deduplicate a Dynamic's updates (with explicit NodeId).
     Only fires when the value actually changes. -/
 def holdUniqDynWithId [Timeline t] [BEq a] (d : Dynamic t a) (nodeId : NodeId) : IO (Dynamic t a) := do
-  let initial ← d.sample
-  let currentRef ← IO.mkRef initial
-  let (result, updateResult) ← Reactive.Dynamic.newWithId initial nodeId
-  let _ ← Reactive.Event.subscribe d.updated fun newVal => do
-    let current ← currentRef.get
-    if newVal != current then
-      currentRef.set newVal
-      updateResult newVal
+  let (result, updateResult) ← Reactive.Dynamic.newUniqWithId (← d.sample) nodeId
+  let _ ← Reactive.Event.subscribe d.updated updateResult
   pure result
 
 /-- Deduplicate a Dynamic's updates.
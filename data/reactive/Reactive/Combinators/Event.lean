@@ -21,7 +21,7 @@ structure Fan (t : Type) (k : Type) (v : Type) where
     On each event occurrence, samples the behavior and returns that value. -/
 def tagWithId [Timeline t] (beh : Behavior t a) (e : Event t b) (nodeId : NodeId) : IO (Event t a) := do
   let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let _ ← Reactive.Event.subscribe e fun _ => do
+  let _ ← Reactive.Event.subscribeSample e fun _ => do
     let v ← beh.sample
     derived.fire v
   pure derived
@@ -50,7 +50,7 @@ abbrev sample := @tag
 /-- Attach the current behavior value to each event occurrence (with explicit NodeId). -/
 def attachWithId [Timeline t] (b : Behavior t a) (e : Event t c) (nodeId : NodeId) : IO (Event t (a × c)) := do
   let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let _ ← Reactive.Event.subscribe e fun c => do
+  let _ ← Reactive.Event.subscribeSample e fun c => do
     let a ← b.sample
     derived.fire (a, c)
   pure derived
@@ -78,7 +78,7 @@ abbrev snapshot := @attach
 def attachWithFnId [Timeline t] (f : a → c → d) (b : Behavior t a) (e : Event t c)
     (nodeId : NodeId) : IO (Event t d) := do
   let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let _ ← Reactive.Event.subscribe e fun c => do
+  let _ ← Reactive.Event.subscribeSample e fun c => do
     let a ← b.sample
     derived.fire (f a c)
   pure derived
@@ -93,7 +93,7 @@ def attachWith [Timeline t] (ctx : TimelineCtx t) (f : a → c → d) (b : Behav
     Only fires when the behavior is true. -/
 def gateWithId [Timeline t] (beh : Behavior t Bool) (e : Event t a) (nodeId : NodeId) : IO (Event t a) := do
   let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let _ ← Reactive.Event.subscribe e fun a => do
+  let _ ← Reactive.Event.subscribeSample e fun a => do
     let isOpen ← beh.sample
     if isOpen then derived.fire a else pure ()
   pure derived
@@ -119,7 +119,7 @@ def mergeListWithId [Timeline t] (events : List (Event t a)) (nodeId : NodeId) :
   let flushScheduledRef ← IO.mkRef false
 
   for e in events do
-    let _ ← Reactive.Event.subscribe e fun a => do
+    let _ ← Reactive.Event.subscribeFanIn e nodeId fun a => do
       -- Add value to buffer (O(1) amortized)
       bufferRef.modify (·.push a)
 
@@ -188,7 +188,7 @@ def leftmostWithId [Timeline t] (events : List (Event t a)) (nodeId : NodeId) :
       derived.fire value
 
   for e in events do
-    let _ ← Reactive.Event.subscribe e tryFire
+    let _ ← Reactive.Event.subscribeFanIn e nodeId tryFire
 
   pure derived
 
@@ -529,11 +529,11 @@ def zipEWithId [Timeline t] (e1 : Event t a) (e2 : Event t b) (nodeId : NodeId)
         else flushAction
       | none => flushAction
 
-  let _ ← Reactive.Event.subscribe e1 fun a => do
+  let _ ← Reactive.Event.subscribeFanIn e1 nodeId fun a => do
     value1Ref.set (some a)
     scheduleFlush
 
-  let _ ← Reactive.Event.subscribe e2 fun b => do
+  let _ ← Reactive.Event.subscribeFanIn e2 nodeId fun b => do
     value2Ref.set (some b)
     scheduleFlush
 
@@ -585,11 +585,11 @@ def differenceWithId [Timeline t] (e1 : Event t a) (e2 : Event t b) (nodeId : No
         else flushAction
       | none => flushAction
 
-  let _ ← Reactive.Event.subscribe e1 fun a => do
+  let _ ← Reactive.Event.subscribeFanIn e1 nodeId fun a => do
     value1Ref.set (some a)
     scheduleFlush
 
-  let _ ← Reactive.Event.subscribe e2 fun _ => do
+  let _ ← Reactive.Event.subscribeFanIn e2 nodeId fun _ => do
     value2FiredRef.set true
     scheduleFlush
 
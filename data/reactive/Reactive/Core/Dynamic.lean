@@ -58,6 +58,20 @@ protected def newWithId [Timeline t] (initial : a) (nodeId : NodeId) : IO (Dynam
     trigger newValue
   pure (⟨valueRef, changeEvent, trigger⟩, update)
 
+/-- Internal: like `newWithId`, but the returned update drops a value equal to
+    the current one, so no-op updates never reach the propagation queue.
+
+    WARNING: This is protected for internal use by combinators. -/
+protected def newUniqWithId [Timeline t] [BEq a] (initial : a) (nodeId : NodeId)
+    : IO (Dynamic t a × (a → IO Unit)) := do
+  let valueRef ← IO.mkRef initial
+  let (changeEvent, trigger) ← Event.newTriggerWithId nodeId
+  let update := fun newValue => do
+    if newValue != (← valueRef.get) then
+      valueRef.set newValue
+      trigger newValue
+  pure (⟨valueRef, changeEvent, trigger⟩, update)
+
 /-- Create a constant Dynamic that never changes (with explicit NodeId). -/
 def constantWithId [Timeline t] (x : a) (nodeId : NodeId) : IO (Dynamic t a) := do
   let valueRef ← IO.mkRef x
@@ -124,7 +138,7 @@ def zipWithId [Timeline t] [BEq c] (f : a → b → c) (da : Dynamic t a) (db :
   let (changeEvent, trigger) ← Event.newTriggerWithId nodeId
 
   -- Subscribe to changes in da
-  let _ ← Reactive.Event.subscribe da.changeEvent fun newA => do
+  let _ ← Reactive.Event.subscribeFanIn da.changeEvent nodeId fun newA => do
     let currentB ← db.sample
     let newC := f newA currentB
     let oldC ← valueRef.get
@@ -133,7 +147,7 @@ def zipWithId [Timeline t] [BEq c] (f : a → b → c) (da : Dynamic t a) (db :
       trigger newC
 
   -- Subscribe to changes in db
-  let _ ← Reactive.Event.subscribe db.changeEvent fun newB => do
+  let _ ← Reactive.Event.subscribeFanIn db.changeEvent nodeId fun newB => do
     let currentA ← da.sample
     let newC := f currentA newB
     let oldC ← valueRef.get
@@ -153,14 +167,14 @@ def zipWithIdRaw [Timeline t] (f : a → b → c) (da : Dynamic t a) (db : Dynam
   let (changeEvent, trigger) ← Event.newTriggerWithId nodeId
 
   -- Subscribe to changes in da
-  let _ ← Reactive.Event.subscribe da.changeEvent fun newA => do
+  let _ ← Reactive.Event.subscribeFanIn da.changeEvent nodeId fun newA => do
     let currentB ← db.sample
     let newC := f newA currentB
     valueRef.set newC
     trigger newC
 
   -- Subscribe to changes in db
-  let _ ← Reactive.Event.subscribe db.changeEvent fun newB => do
+  let _ ← Reactive.Event.subscribeFanIn db.changeEvent nodeId fun newB => do
     let currentA ← da.sample
     let newC := f currentA newB
     valueRef.set newC
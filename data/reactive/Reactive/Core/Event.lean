@@ -272,6 +272,30 @@ protected def subscribeScoped (e : Event t a) (scope : SubscriptionScope)
   scope.register unsub
   pure unsub
 
+/-- Subscribe on behalf of the fan-in node `key`, whose callbacks on different
+    upstream events share state (merge flags, buffers, latest values).
+    Parallel propagation never runs two fires that feed the same fan-in node
+    concurrently, so combinators with such shared state must subscribe with
+    this instead of `subscribe`. Pass `samples := true` if the callback also
+    samples behaviors (see `subscribeSample`). -/
+protected def subscribeFanIn (e : Event t a) (key : NodeId) (callback : Subscriber a)
+    (samples : Bool := false) : IO (IO Unit) := do
+  if let some queue ← getPropagationContext then
+    queue.addFanIn e.node.nodeId key
+    if samples then
+      queue.addSampler e.node.nodeId
+  e.node.subscribe callback
+
+/-- Subscribe a callback that samples behaviors. Parallel propagation runs a
+    level serially when one of its fires reaches such a callback, so the
+    sample never races a hold or dynamic being updated at the same height.
+    Combinators that sample (tag, attach, gate) must subscribe with this
+    instead of `subscribe`. -/
+protected def subscribeSample (e : Event t a) (callback : Subscriber a) : IO (IO Unit) := do
+  if let some queue ← getPropagationContext then
+    queue.addSampler e.node.nodeId
+  e.node.subscribe callback
+
 /-- Fire an event (internal use - normally done via trigger) -/
 protected def fire (e : Event t a) (value : a) : IO Unit :=
   e.node.fire value
@@ -284,22 +308,36 @@ def height (e : Event t a) : Height :=
 def nodeId (e : Event t a) : NodeId :=
   e.node.nodeId
 
-/-- Helper to create a derived event from a source event (with explicit NodeId).
-    Creates a new event at source.height + 1 and subscribes with the given handler.
-    The handler receives the source value and the derived event's fire function. -/
-private def deriveWithId [Timeline t] (source : Event t a) (derivedNodeId : NodeId)
-    (handler : a → (b → IO Unit) → IO Unit) : IO (Event t b) := do
+/-- Create a derived node fused into its source (with explicit NodeId).
+    Instead of subscribing eagerly, the node records how to connect a subscriber
+    through `step`, composed with the source's own connection when the source is
+    fused too. It connects to the nearest unfused ancestor when it gains its
+    first subscriber and disconnects when it loses its last, so a chain of pure
+    steps costs one upstream subscription and one queued fire per occurrence.
+    Each fused node that has subscribers connects on its own, so a chain with
+    a subscriber part way along splits there instead of sharing the prefix.
+
+    Returns the node and an action that detaches it for good: once run, the
+    node never fires again, nor do fused nodes derived from it. -/
+def fuseWithId [Timeline t] (source : Event t a) (derivedNodeId : NodeId)
+    (step : Subscriber b → Subscriber a) : IO (Event t b × IO Unit) := do
   let derived ← Event.newNodeWithId derivedNodeId (source.height.inc)
-  let _ ← Reactive.Event.subscribe source fun a => handler a derived.fire
-  pure derived
-
-/-- Helper to create a derived event from a source event.
-    Creates a new event at source.height + 1 and subscribes with the given handler.
-    The handler receives the source value and the derived event's fire function. -/
-private def deriveWith [Timeline t] (ctx : TimelineCtx t) (source : Event t a)
-    (handler : a → (b → IO Unit) → IO Unit) : IO (Event t b) := do
-  let nodeId ← ctx.freshNodeId
-  deriveWithId source nodeId handler
+  let alive ← IO.mkRef true
+  let guarded (cb : Subscriber b) : Subscriber a :=
+    let next := step cb
+    fun a => do if ← alive.get then next a
+  let composed : (Subscriber b → IO (IO Unit)) :=
+    match ← source.node.mapConnect.get with
+    | some connect => fun cb => connect (guarded cb)
+    | none => fun cb => source.node.subscribe (guarded cb)
+  derived.node.mapConnect.set (some composed)
+  let detach : IO Unit := do
+    alive.set false
+    derived.node.mapConnect.set none
+    if let some unsub ← derived.node.upstreamUnsub.get then
+      unsub
+      derived.node.upstreamUnsub.set none
+  pure (derived, detach)
 
 /-- Map a function over event values (with explicit NodeId).
     Creates a new derived event that transforms values from the source. -/
@@ -365,9 +403,10 @@ def mapAddConst [Timeline t] [HAdd a a a] (ctx : TimelineCtx t)
   mapAddConstWithId c source nodeId
 
 /-- Filter event occurrences by a predicate (with explicit NodeId).
-    Only values that satisfy the predicate pass through. -/
+    Only values that satisfy the predicate pass through.
+    The node is fused into its source (see `fuseWithId`). -/
 def filterWithId [Timeline t] (p : a → Bool) (source : Event t a) (derivedNodeId : NodeId) : IO (Event t a) :=
-  deriveWithId source derivedNodeId fun a fire =>
+  Prod.fst <$> fuseWithId source derivedNodeId fun fire a =>
     if p a then fire a else pure ()
 
 /-- Filter event occurrences by a predicate.
@@ -379,14 +418,15 @@ def filterWithId [Timeline t] (p : a → Bool) (source : Event t a) (derivedNode
     let positives ← Event.filterM (· > 0) numberEvent
     -- When numberEvent fires -5, 3, 0, 7: positives fires 3, 7
     ``` -/
-def filter [Timeline t] (ctx : TimelineCtx t) (p : a → Bool) (source : Event t a) : IO (Event t a) :=
-  deriveWith ctx source fun a fire =>
-    if p a then fire a else pure ()
+def filter [Timeline t] (ctx : TimelineCtx t) (p : a → Bool) (source : Event t a) : IO (Event t a) := do
+  let nodeId ← ctx.freshNodeId
+  filterWithId p source nodeId
 
 /-- Filter and map simultaneously (with explicit NodeId).
-    Only `some` results pass through; `none` results are dropped. -/
+    Only `some` results pass through; `none` results are dropped.
+    The node is fused into its source (see `fuseWithId`). -/
 def mapMaybeWithId [Timeline t] (f : a → Option b) (source : Event t a) (derivedNodeId : NodeId) : IO (Event t b) :=
-  deriveWithId source derivedNodeId fun a fire =>
+  Prod.fst <$> fuseWithId source derivedNodeId fun fire a =>
     match f a with
     | some b => fire b
     | none => pure ()
@@ -400,11 +440,9 @@ def mapMaybeWithId [Timeline t] (f : a → Option b) (source : Event t a) (deriv
     let parsed ← Event.mapMaybeM String.toNat? stringEvent
     -- When stringEvent fires "42", "hello", "7": parsed fires 42, 7
     ``` -/
-def mapMaybe [Timeline t] (ctx : TimelineCtx t) (f : a → Option b) (source : Event t a) : IO (Event t b) :=
-  deriveWith ctx source fun a fire =>
-    match f a with
-    | some b => fire b
-    | none => pure ()
+def mapMaybe [Timeline t] (ctx : TimelineCtx t) (f : a → Option b) (source : Event t a) : IO (Event t b) := do
+  let nodeId ← ctx.freshNodeId
+  mapMaybeWithId f source nodeId
 
 /-- Merge two events into one with left-bias (with explicit NodeId).
     When either fires, the merged event fires with that value.
@@ -438,8 +476,8 @@ def mergeWithId [Timeline t] (e1 : Event t a) (e2 : Event t a) (derivedNodeId :
       derived.fire value
 
   -- e1 (left) fires first due to subscription order
-  let _ ← Reactive.Event.subscribe e1 tryFire
-  let _ ← Reactive.Event.subscribe e2 tryFire
+  let _ ← Reactive.Event.subscribeFanIn e1 derivedNodeId tryFire
+  let _ ← Reactive.Event.subscribeFanIn e2 derivedNodeId tryFire
   pure derived
 
 /-- Merge two events into one with left-bias.
@@ -4,6 +4,8 @@
   Core type definitions for the Reactive FRP library.
   Defines the Timeline phantom type and related primitives.
 -/
+import Std.Data.HashMap
+import Std.Data.HashSet
 
 namespace Reactive
 
@@ -45,6 +47,10 @@ protected def new [Timeline t] : IO (TimelineCtx t) := do
 def freshNodeId [Timeline t] (ctx : TimelineCtx t) : IO NodeId := do
   ctx.nodeIdGen.modifyGet fun n => (NodeId.mk n, n + 1)
 
+/-- Number of nodes allocated in this context so far -/
+def nodeCount [Timeline t] (ctx : TimelineCtx t) : IO Nat :=
+  ctx.nodeIdGen.get
+
 end TimelineCtx
 
 /-- Height in the dependency graph for topological ordering.
@@ -83,7 +89,13 @@ structure Frame where
 The propagation queue enables glitch-free event handling by processing events
 in height order within each frame.
 
-Implementation uses a binary min-heap for O(log n) insert and pop operations. -/
+Heights are small dense integers, so pending fires are kept in one bucket per
+height with a bitmap of the non-empty buckets: insert and pop are O(1), and a
+bucket is only sorted by nodeId when its fires arrived out of order.
+
+For parallel propagation the queue also records which fires feed a shared
+fan-in node, and buffers the fires enqueued by each level worker thread so
+the draining thread can merge them back in a deterministic order. -/
 
 /-- A pending event occurrence waiting to be propagated.
     Stores the height and nodeId for ordering, plus the fire action as a closure. -/
@@ -107,100 +119,140 @@ instance : LT PendingFire where
 instance : LE PendingFire where
   le a b := compare a b != .gt
 
-/-- Propagation state during a frame.
-    Uses a binary min-heap for efficient priority queue operations. -/
+/-- The fires pending at one height. `fires[head:]` are still queued; they are
+    in pop order (by nodeId, then insertion order) whenever `sorted` is set. -/
+structure HeightBucket where
+  fires : Array PendingFire := #[]
+  head : Nat := 0
+  sorted : Bool := true
+  deriving Inhabited
+
+namespace HeightBucket
+
+/-- Put the queued fires in pop order. Stable, so fires of the same node keep
+    the order they were enqueued in. -/
+def normalize (b : HeightBucket) : HeightBucket :=
+  if b.sorted then b
+  else
+    let queued := (b.fires.extract b.head b.fires.size).toList.mergeSort
+      fun x y => x.nodeId.id ≤ y.nodeId.id
+    { fires := queued.toArray, head := 0, sorted := true }
+
+end HeightBucket
+
+/-- Pending fires bucketed by height, ordered by (height, nodeId). -/
+structure HeightQueue where
+  /-- Bucket `h` holds the fires pending at height `h` -/
+  buckets : Array HeightBucket := #[]
+  /-- Bit `h` is set iff bucket `h` has queued fires -/
+  occupied : Array UInt64 := #[]
+  /-- No bitmap word below this index has a bit set -/
+  lowWord : Nat := 0
+  /-- Total queued fires -/
+  size : Nat := 0
+  /-- Fires ever queued, for diagnostics -/
+  queued : Nat := 0
+  deriving Inhabited
+
+namespace HeightQueue
+
+@[inline] private def setBit (bits : Array UInt64) (h : Nat) (on : Bool) : Array UInt64 :=
+  let w := h / 64
+  let bits := if w < bits.size then bits else bits ++ Array.replicate (w + 1 - bits.size) 0
+  let mask : UInt64 := 1 <<< (h % 64).toUInt64
+  bits.modify w fun word => if on then word ||| mask else word &&& ~~~mask
+
+private partial def lowestFrom (bits : Array UInt64) (w : Nat) : Option Nat :=
+  match bits[w]? with
+  | none => none
+  | some word =>
+    if word == 0 then lowestFrom bits (w + 1)
+    -- `word &&& -word` isolates the lowest set bit
+    else some (w * 64 + (word &&& (0 - word)).toNat.log2)
+
+/-- The lowest height with queued fires. -/
+@[inline] def lowestHeight? (hq : HeightQueue) : Option Nat :=
+  lowestFrom hq.occupied hq.lowWord
+
+/-- Queue a fire. O(1) amortized. -/
+def insert (hq : HeightQueue) (p : PendingFire) : HeightQueue :=
+  let h := p.height.value
+  let buckets := if h < hq.buckets.size then hq.buckets
+    else hq.buckets ++ Array.replicate (h + 1 - hq.buckets.size) {}
+  let buckets := buckets.modify h fun b =>
+    let inOrder := b.fires.back?.all (·.nodeId.id ≤ p.nodeId.id)
+    { b with fires := b.fires.push p, sorted := b.sorted && inOrder }
+  { buckets
+    occupied := setBit hq.occupied h true
+    lowWord := min hq.lowWord (h / 64)
+    size := hq.size + 1
+    queued := hq.queued + 1 }
+
+/-- Remove the lowest (height, nodeId) fire. O(1) unless its bucket needs sorting. -/
+def popMin? (hq : HeightQueue) : Option PendingFire × HeightQueue :=
+  match hq.lowestHeight? with
+  | none => (none, hq)
+  | some h =>
+    let b := hq.buckets[h]!.normalize
+    let buckets := hq.buckets.set! h {}
+    match b.fires[b.head]? with
+    | none => (none, hq)
+    | some p =>
+      let b := { b with head := b.head + 1 }
+      let drained := b.head == b.fires.size
+      (some p, {
+        buckets := buckets.set! h (if drained then {} else b)
+        occupied := if drained then setBit hq.occupied h false else hq.occupied
+        lowWord := h / 64
+        size := hq.size - 1
+        queued := hq.queued })
+
+/-- Remove every fire at the lowest height, in nodeId order. -/
+def popLevel (hq : HeightQueue) : Array PendingFire × HeightQueue :=
+  match hq.lowestHeight? with
+  | none => (#[], hq)
+  | some h =>
+    let b := hq.buckets[h]!.normalize
+    let level := if b.head == 0 then b.fires else b.fires.extract b.head b.fires.size
+    (level, {
+      buckets := hq.buckets.set! h {}
+      occupied := setBit hq.occupied h false
+      lowWord := h / 64
+      size := hq.size - level.size
+      queued := hq.queued })
+
+end HeightQueue
+
+/-- Propagation state during a frame. -/
 structure PropagationQueue where
-  /-- Binary min-heap of pending fires, ordered by (height, nodeId) -/
-  pending : IO.Ref (Array PendingFire)
+  /-- Pending fires of the current frame, by height -/
+  pending : IO.Ref HeightQueue
   /-- Pending fires for the next frame (used by delayFrame) -/
-  nextFramePending : IO.Ref (Array PendingFire)
+  nextFramePending : IO.Ref HeightQueue
   /-- Whether we're currently inside a propagation frame -/
   inFrame : IO.Ref Bool
+  /-- Fan-in nodes fed by each node. Fires that feed the same fan-in node
+      write shared state and are never run in parallel. -/
+  fanIn : IO.Ref (Std.HashMap NodeId (Array NodeId))
+  /-- Nodes whose subscribers sample behaviors (tag, attach, gate). A level
+      firing one of them runs serially, since any hold or dynamic updated at
+      the same height may be what it reads. -/
+  samplers : IO.Ref (Std.HashSet NodeId)
+  /-- Buffers of the threads running a parallel level, by thread id.
+      Fires enqueued on those threads go to their buffer instead of the queue. -/
+  staged : IO.Ref (Std.HashMap UInt64 (IO.Ref (Array PendingFire)))
 
 namespace PropagationQueue
 
-/-! ### Binary Heap Operations
-
-Array-based binary min-heap where:
-- Parent of node i: (i - 1) / 2
-- Left child of i: 2*i + 1
-- Right child of i: 2*i + 2
-
-Heap property: parent ≤ children (for all nodes) -/
-
-/-- Get parent index -/
-@[inline] private def parentIdx (i : Nat) : Nat := (i - 1) / 2
-
-/-- Get left child index -/
-@[inline] private def leftChildIdx (i : Nat) : Nat := 2 * i + 1
-
-/-- Get right child index -/
-@[inline] private def rightChildIdx (i : Nat) : Nat := 2 * i + 2
-
-/-- Swap two elements in an array (unchecked for performance) -/
-@[inline] private def swap (arr : Array PendingFire) (i j : Nat) : Array PendingFire :=
-  let vi := arr[i]!
-  let vj := arr[j]!
-  (arr.set! i vj).set! j vi
-
-/-- Sift up: restore heap property after inserting at end.
-    Bubbles the element at index i up until heap property is satisfied.
-    O(log n) -/
-partial def siftUp (arr : Array PendingFire) (i : Nat) : Array PendingFire :=
-  if i == 0 then arr
-  else
-    let pi := parentIdx i
-    if pi < arr.size && i < arr.size then
-      if compare arr[i]! arr[pi]! == .lt then
-        siftUp (swap arr i pi) pi
-      else arr
-    else arr
-
-/-- Sift down: restore heap property after replacing root.
-    Bubbles the element at index i down until heap property is satisfied.
-    O(log n) -/
-partial def siftDown (arr : Array PendingFire) (i : Nat) : Array PendingFire :=
-  let left := leftChildIdx i
-  let right := rightChildIdx i
-  let size := arr.size
-
-  -- Find smallest among node and its children
-  let smallest :=
-    let s1 := if left < size && compare arr[left]! arr[i]! == .lt then left else i
-    if right < size && compare arr[right]! arr[s1]! == .lt then right else s1
-
-  -- If smallest is not the current node, swap and continue
-  if smallest != i && smallest < size then
-    siftDown (swap arr i smallest) smallest
-  else
-    arr
-
-/-- Insert a pending fire into a heap array. O(log n) -/
-@[inline] private def heapInsert (arr : Array PendingFire) (p : PendingFire) : Array PendingFire :=
-  let arr := arr.push p
-  siftUp arr (arr.size - 1)
-
-/-- Pop the minimum (lowest height) pending fire from a heap array. O(log n) -/
-@[inline] private def heapPopMin? (arr : Array PendingFire) : Option (PendingFire × Array PendingFire) :=
-  if arr.size == 0 then
-    none
-  else
-    let minElem := arr[0]!
-    if arr.size == 1 then
-      some (minElem, #[])
-    else
-      let last := arr.back!
-      let arr := arr.pop
-      let arr := arr.set! 0 last
-      let arr := siftDown arr 0
-      some (minElem, arr)
-
 /-- Create a new empty propagation queue. -/
 def new : IO PropagationQueue := do
-  let pending ← IO.mkRef #[]
-  let nextFramePending ← IO.mkRef #[]
+  let pending ← IO.mkRef {}
+  let nextFramePending ← IO.mkRef {}
   let inFrame ← IO.mkRef false
-  pure { pending, nextFramePending, inFrame }
+  let fanIn ← IO.mkRef {}
+  let samplers ← IO.mkRef {}
+  let staged ← IO.mkRef {}
+  pure { pending, nextFramePending, inFrame, fanIn, samplers, staged }
 
 /-- Check if the queue is currently inside a frame. -/
 @[inline] def isInFrame (q : PropagationQueue) : IO Bool :=
@@ -210,36 +262,78 @@ def new : IO PropagationQueue := do
 @[inline] def setInFrame (q : PropagationQueue) (value : Bool) : IO Unit :=
   q.inFrame.set value
 
-/-- Insert a pending fire into the current frame heap. -/
+/-- The staging buffer of the calling thread, if it is running a parallel level. -/
+def stagingBuffer? (q : PropagationQueue) : IO (Option (IO.Ref (Array PendingFire))) := do
+  let staged ← q.staged.get
+  if staged.isEmpty then
+    pure none
+  else
+    pure staged[← IO.getTID]?
+
+/-- Whether the calling thread is running fires of a parallel level. -/
+def isStagingThread (q : PropagationQueue) : IO Bool :=
+  return (← q.stagingBuffer?).isSome
+
+/-- Insert a pending fire into the current frame
+    (or the caller's staging buffer during a parallel level). -/
 @[inline] def insert (q : PropagationQueue) (p : PendingFire) : IO Unit := do
-  q.pending.modify fun arr => heapInsert arr p
+  if let some buffer ← q.stagingBuffer? then
+    buffer.modify (·.push p)
+  else
+    q.pending.modify (·.insert p)
 
-/-- Insert a pending fire into the next-frame heap. -/
+/-- Insert a pending fire into the next frame. -/
 @[inline] def insertNextFrame (q : PropagationQueue) (p : PendingFire) : IO Unit := do
-  q.nextFramePending.modify fun arr => heapInsert arr p
+  q.nextFramePending.modify (·.insert p)
 
 /-- Pop the minimum (lowest height) pending fire from the current frame. -/
-def popMin? (q : PropagationQueue) : IO (Option PendingFire) := do
-  let result ← q.pending.modifyGet fun arr =>
-    match heapPopMin? arr with
-    | none => (none, arr)
-    | some (minElem, arr') => (some minElem, arr')
-  pure result
-
-/-- Check if the current frame heap is empty. -/
+def popMin? (q : PropagationQueue) : IO (Option PendingFire) :=
+  q.pending.modifyGet HeightQueue.popMin?
+
+/-- Pop every pending fire at the lowest height, in (height, nodeId) order. -/
+def popLevel (q : PropagationQueue) : IO (Array PendingFire) :=
+  q.pending.modifyGet HeightQueue.popLevel
+
+/-- Record that `source` feeds the fan-in node `key`. -/
+def addFanIn (q : PropagationQueue) (source key : NodeId) : IO Unit :=
+  q.fanIn.modify fun m =>
+    let keys := m.getD source #[]
+    if keys.contains key then m else m.insert source (keys.push key)
+
+/-- Fan-in nodes fed by `source`. -/
+def fanInKeys (q : PropagationQueue) (source : NodeId) : IO (Array NodeId) :=
+  return (← q.fanIn.get).getD source #[]
+
+/-- Record that a subscriber of `source` samples behaviors. -/
+def addSampler (q : PropagationQueue) (source : NodeId) : IO Unit :=
+  q.samplers.modify (·.insert source)
+
+/-- Whether any fire of `level` runs a subscriber that samples behaviors. -/
+def samplesBehaviors (q : PropagationQueue) (level : Array PendingFire) : IO Bool := do
+  let samplers ← q.samplers.get
+  if samplers.isEmpty then
+    return false
+  return level.any (samplers.contains ·.nodeId)
+
+/-- Number of fires queued since the queue was created (current and next
+    frames), for diagnostics. -/
+def queuedCount (q : PropagationQueue) : IO Nat :=
+  return (← q.pending.get).queued + (← q.nextFramePending.get).queued
+
+/-- Check if the current frame is empty. -/
 @[inline] def isEmpty (q : PropagationQueue) : IO Bool := do
-  let arr ← q.pending.get
-  pure arr.isEmpty
+  let hq ← q.pending.get
+  pure (hq.size == 0)
 
 /-- Move next-frame pending fires into the current frame.
     Returns true if a new frame was started. -/
 def startNextFrame (q : PropagationQueue) : IO Bool := do
   let next ← q.nextFramePending.get
-  if next.isEmpty then
+  if next.size == 0 then
     pure false
   else
-    q.pending.set next
-    q.nextFramePending.set #[]
+    q.pending.modify fun cur => { next with queued := cur.queued + next.queued }
+    q.nextFramePending.set {}
     pure true
 
 end PropagationQueue
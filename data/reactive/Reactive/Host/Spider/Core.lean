@@ -55,6 +55,25 @@ def maxConstructionDepth : Nat := 10000
 /-- Maximum propagation depth before throwing an error (detects infinite event loops) -/
 def maxPropagationDepth : Nat := 10000
 
+/-- How `SpiderEnv.drainQueue` runs the fires pending at one height.
+    - `serial`: one at a time in (height, nodeId) order (the default)
+    - `parallel`: fires that neither share a node nor feed a common fan-in node
+      (merge, zip, switch, ...) run concurrently on up to `workers` threads,
+      the draining thread included. Levels smaller than `minBatch` run serially,
+      where handing fires to other threads costs more than it saves, and so do
+      levels that reach a behavior sampler (tag, attach, gate), which could
+      otherwise read a hold or dynamic while another thread updates it.
+
+    Heights are still processed one at a time, so propagation stays glitch-free,
+    and what each level enqueues is merged back in level order, so the result
+    does not depend on thread timing. Parallel mode assumes subscriber callbacks
+    at one height do not write state read by other callbacks at that height,
+    other than through the built-in fan-in combinators. -/
+inductive PropagationMode where
+  | serial
+  | parallel (workers : Nat := 4) (minBatch : Nat := 64)
+  deriving Repr, BEq, Inhabited
+
 structure SpiderEnv where
   /-- Timeline context for type-safe event creation -/
   timelineCtx : TimelineCtx Spider
@@ -74,6 +93,8 @@ structure SpiderEnv where
   constructionDepth : IO.Ref Nat
   /-- Propagation depth counter for infinite event loop detection -/
   propagationDepth : IO.Ref Nat
+  /-- Whether frames run the fires of each height serially or in parallel -/
+  propagationMode : IO.Ref PropagationMode
   /-- Recursive mutex to serialize frame execution across threads.
       Uses BaseRecursiveMutex to allow same-thread reentrant locking without deadlock. -/
   frameMutex : Std.BaseRecursiveMutex
@@ -90,10 +111,11 @@ def new (errorHandler : PropagationErrorHandler := defaultErrorHandler) : IO Spi
   let errorHandlerRef ← IO.mkRef errorHandler
   let constructionDepth ← IO.mkRef 0
   let propagationDepth ← IO.mkRef 0
+  let propagationMode ← IO.mkRef .serial
   let frameMutex ← Std.BaseRecursiveMutex.new
   -- Set global propagation context for frame-based firing
   setPropagationContext propagationQueue
-  pure { timelineCtx, postBuildActions, postBuildEvent, postBuildTrigger, propagationQueue, currentScope, errorHandler := errorHandlerRef, constructionDepth, propagationDepth, frameMutex }
+  pure { timelineCtx, postBuildActions, postBuildEvent, postBuildTrigger, propagationQueue, currentScope, errorHandler := errorHandlerRef, constructionDepth, propagationDepth, propagationMode, frameMutex }
 
 /-- Increment construction depth and throw if exceeded. Returns the new depth. -/
 def incrementDepth (env : SpiderEnv) (operation : String) : IO Nat := do
@@ -106,14 +128,120 @@ def incrementDepth (env : SpiderEnv) (operation : String) : IO Nat := do
 def decrementDepth (env : SpiderEnv) : IO Unit := do
   env.constructionDepth.modify (· - 1)
 
+private def propagationLoopError (count : Nat) : IO.Error :=
+  IO.userError s!"[Reactive] Infinite loop detected during event propagation ({count} events processed, exceeded {maxPropagationDepth}). This usually means an event subscriber is triggering events recursively."
+
+private partial def findRoot (parent : Array Nat) (i : Nat) : Nat :=
+  let p := parent[i]!
+  if p == i then i else findRoot parent p
+
+/-- Split a level into at most `workers` chunks of fire indices. Fires of the
+    same node, or feeding a common fan-in node, always share a chunk; each such
+    group goes to the least loaded chunk, in order of its first fire. -/
+private def chunkLevel (q : PropagationQueue) (level : Array PendingFire) (workers : Nat)
+    : IO (Array (Array Nat)) := do
+  -- Union-find over fire indices; the root of a group is its first fire
+  let mut parent := Array.range level.size
+  let mut owner : Std.HashMap NodeId Nat := {}
+  for i in [:level.size] do
+    let p := level[i]!
+    for key in (← q.fanInKeys p.nodeId).push p.nodeId do
+      match owner[key]? with
+      | none => owner := owner.insert key i
+      | some j =>
+        let ri := findRoot parent i
+        let rj := findRoot parent j
+        if ri != rj then
+          parent := parent.set! (max ri rj) (min ri rj)
+  let mut groupOf : Array (Option Nat) := Array.replicate level.size none
+  let mut groups : Array (Array Nat) := #[]
+  for i in [:level.size] do
+    let r := findRoot parent i
+    match groupOf[r]! with
+    | some g => groups := groups.modify g (·.push i)
+    | none =>
+      groupOf := groupOf.set! r (some groups.size)
+      groups := groups.push #[i]
+  let mut chunks : Array (Array Nat) := Array.replicate (min workers groups.size) #[]
+  for group in groups do
+    let idx := (List.range chunks.size).foldl
+      (fun best i => if chunks[i]!.size < chunks[best]!.size then i else best) 0
+    chunks := chunks.modify idx (· ++ group)
+  return chunks
+
+/-- Run the given fires of a level on the calling thread, stopping at the first
+    error in any chunk (signalled through `stop`). Returns, for each fire run,
+    its index, the fires it enqueued and the error it raised, if any. -/
+private def runChunk (q : PropagationQueue) (level : Array PendingFire) (chunk : Array Nat)
+    (stop : IO.Ref Bool) : IO (Array (Nat × Array PendingFire × Option IO.Error)) := do
+  let buffer ← IO.mkRef (#[] : Array PendingFire)
+  let tid ← IO.getTID
+  q.staged.modify (·.insert tid buffer)
+  try
+    let mut results := #[]
+    for i in chunk do
+      if ← stop.get then
+        break
+      let err? ← try
+        level[i]!.fire
+        pure none
+      catch e =>
+        pure (some e)
+      let enqueued ← buffer.modifyGet fun b => (b, #[])
+      results := results.push (i, enqueued, err?)
+      if err?.isSome then
+        stop.set true
+        break
+    return results
+  finally
+    q.staged.modify (·.erase tid)
+
+/-- Run one level across up to `workers` threads, then merge what each fire
+    enqueued back into the heap and report errors, both in level order.
+    An error stops every chunk from starting further fires, so a fatal one is
+    rethrown before the fires after it run; fires already running on other
+    threads finish, but nothing they enqueued is propagated. If the handler
+    lets propagation continue, the fires held back run serially in order. -/
+private def runLevelParallel (q : PropagationQueue) (errorHandler : PropagationErrorHandler)
+    (workers : Nat) (level : Array PendingFire) : IO Unit := do
+  let chunks ← chunkLevel q level workers
+  let stop ← IO.mkRef false
+  let mut tasks := #[]
+  for chunk in chunks[1:] do
+    tasks := tasks.push (← IO.asTask (runChunk q level chunk stop))
+  let mut results : Array (Option (Array PendingFire × Option IO.Error)) :=
+    Array.replicate level.size none
+  for (i, enqueued, err?) in ← runChunk q level chunks[0]! stop do
+    results := results.set! i (some (enqueued, err?))
+  for task in tasks do
+    for (i, enqueued, err?) in ← MonadExcept.ofExcept (← IO.wait task) do
+      results := results.set! i (some (enqueued, err?))
+  for i in [:level.size] do
+    match results[i]! with
+    | some (enqueued, err?) =>
+      for p in enqueued do
+        q.insert p
+      if let some e := err? then
+        unless ← errorHandler e do
+          throw e
+    | none =>
+      try
+        level[i]!.fire
+      catch e =>
+        unless ← errorHandler e do
+          throw e
+
 /-- Process all pending fires in height order until queue is empty.
     When current frame is empty, processes nextFramePending in a new sub-frame.
     Errors in subscriber callbacks are handled by the configured error handler.
-    Throws if total events processed exceeds maxPropagationDepth (detects infinite event loops). -/
+    Throws if total events processed exceeds maxPropagationDepth (detects infinite event loops).
+    In `.parallel` mode each height is drained as a level (see `PropagationMode`). -/
 partial def drainQueue (env : SpiderEnv) : IO Unit := do
   -- Cache error handler outside hot loop
   let errorHandler ← env.errorHandler.get
-  loop errorHandler 0
+  match ← env.propagationMode.get with
+  | .serial => loop errorHandler 0
+  | .parallel workers minBatch => levelLoop errorHandler workers minBatch 0
 where
   loop (errorHandler : PropagationErrorHandler) (count : Nat) : IO Unit := do
     let pendingOpt ← env.propagationQueue.popMin?
@@ -129,7 +257,7 @@ where
       -- Check total events processed for infinite loop detection
       let count' := count + 1
       if count' > maxPropagationDepth then
-        throw <| IO.userError s!"[Reactive] Infinite loop detected during event propagation ({count'} events processed, exceeded {maxPropagationDepth}). This usually means an event subscriber is triggering events recursively."
+        throw (propagationLoopError count')
       -- Execute the fire action with error handling
       try
         pending.fire
@@ -138,6 +266,25 @@ where
         if !shouldContinue then
           throw e
       loop errorHandler count'
+  levelLoop (errorHandler : PropagationErrorHandler) (workers minBatch count : Nat) : IO Unit := do
+    let level ← env.propagationQueue.popLevel
+    if level.isEmpty then
+      if ← env.propagationQueue.startNextFrame then
+        levelLoop errorHandler workers minBatch count
+      return ()
+    let count' := count + level.size
+    if count' > maxPropagationDepth then
+      throw (propagationLoopError count')
+    if level.size < minBatch || workers ≤ 1 || (← env.propagationQueue.samplesBehaviors level) then
+      for pending in level do
+        try
+          pending.fire
+        catch e =>
+          unless ← errorHandler e do
+            throw e
+    else
+      runLevelParallel env.propagationQueue errorHandler workers level
+    levelLoop errorHandler workers minBatch count'
 
 /-- Execute an action within a propagation frame.
     If already in a frame, just runs the action (it will enqueue).
@@ -146,8 +293,11 @@ where
     Thread-safety: Frame execution is serialized via a recursive mutex to prevent
     concurrent async completions from interleaving frame operations. The recursive
     mutex allows same-thread reentrant locking without deadlock, while blocking
-    other threads until the frame completes. -/
+    other threads until the frame completes. A thread running fires of a
+    parallel level is already inside the frame and does not take the mutex. -/
 def withFrame (env : SpiderEnv) (action : IO Unit) : IO Unit := do
+  if ← env.propagationQueue.isStagingThread then
+    return ← action
   -- Acquire recursive mutex - same thread can lock multiple times without blocking,
   -- but other threads will wait until we fully release
   env.frameMutex.lock
@@ -183,6 +333,13 @@ def createDynamic (ctx : TimelineCtx Spider) (initial : a) : IO (Dynamic Spider
     trigger newValue
   pure (Dynamic.mk valueRef changeEvent trigger, update)
 
+/-- Like `createDynamic`, but the update function drops values equal to the
+    current one before they are queued, as `holdUniqDyn` would downstream. -/
+def createUniqDynamic [BEq a] (ctx : TimelineCtx Spider) (initial : a)
+    : IO (Dynamic Spider a × (a → IO Unit)) := do
+  let nodeId ← ctx.freshNodeId
+  Dynamic.newUniqWithId initial nodeId
+
 /-- The Spider monad for building reactive networks.
 
     SpiderM provides:
@@ -229,6 +386,17 @@ def getErrorHandler : SpiderM PropagationErrorHandler :=
 def setErrorHandler (handler : PropagationErrorHandler) : SpiderM Unit :=
   ⟨fun env => env.errorHandler.set handler⟩
 
+/-- Get the current propagation mode -/
+def getPropagationMode : SpiderM PropagationMode :=
+  ⟨fun env => env.propagationMode.get⟩
+
+/-- Set how frames run the fires pending at one height.
+    - `.serial`: one at a time (default)
+    - `.parallel workers minBatch`: independent fires of large levels run concurrently
+    Takes effect from the next frame. -/
+def setPropagationMode (mode : PropagationMode) : SpiderM Unit :=
+  ⟨fun env => env.propagationMode.set mode⟩
+
 instance : Monad SpiderM where
   pure a := ⟨fun _ => pure a⟩
   bind ma f := ⟨fun env => do
@@ -146,14 +146,31 @@ def changesM (d : Dynamic Spider a) : SpiderM (Event Spider (a × a)) := ⟨fun
     Subscribes within the current scope for cleanup. -/
 def holdUniqDynM [BEq a] (d : Dynamic Spider a) : SpiderM (Dynamic Spider a) := ⟨fun env => do
   let _ ← env.incrementDepth "Dynamic.holdUniqDynM"
-  let initial ← d.sample
-  let currentRef ← IO.mkRef initial
-  let (result, updateResult) ← createDynamic env.timelineCtx initial
-  let unsub ← Reactive.Event.subscribe d.updated fun newVal => do
-    let current ← currentRef.get
-    if newVal != current then
-      currentRef.set newVal
-      updateResult newVal
+  let (result, updateResult) ← createUniqDynamic env.timelineCtx (← d.sample)
+  let unsub ← Reactive.Event.subscribe d.updated updateResult
+  env.currentScope.register unsub
+  env.decrementDepth
+  pure result⟩
+
+/-- Hold the latest value of an Event, firing only when it differs from the
+    current one. Same as `holdDyn` followed by `holdUniqDynM`, without the
+    extra node: repeated values are dropped before they are queued. -/
+def holdUniqM [BEq a] (initial : a) (event : Event Spider a) : SpiderM (Dynamic Spider a) := ⟨fun env => do
+  let _ ← env.incrementDepth "Dynamic.holdUniqM"
+  let (result, updateResult) ← createUniqDynamic env.timelineCtx initial
+  let unsub ← Reactive.Event.subscribe event updateResult
+  env.currentScope.register unsub
+  env.decrementDepth
+  pure result⟩
+
+/-- Fold over events, firing only when the state actually changes.
+    Same as `foldDyn` followed by `holdUniqDynM`, without the extra node. -/
+def foldDynUniqM [BEq b] (f : a → b → b) (initial : b) (event : Event Spider a)
+    : SpiderM (Dynamic Spider b) := ⟨fun env => do
+  let _ ← env.incrementDepth "Dynamic.foldDynUniqM"
+  let (result, updateResult) ← createUniqDynamic env.timelineCtx initial
+  let unsub ← Reactive.Event.subscribe event fun a => do
+    updateResult (f a (← result.sample))
   env.currentScope.register unsub
   env.decrementDepth
   pure result⟩
@@ -171,15 +188,16 @@ def switchM (dd : Dynamic Spider (Dynamic Spider a)) : SpiderM (Dynamic Spider a
   let subscribeToInner := fun (inner : Dynamic Spider a) => do
     let oldUnsub ← currentUnsubRef.get
     oldUnsub
-    let unsub ← Reactive.Event.subscribe inner.updated fun newValue => updateResult newValue
+    let unsub ← Reactive.Event.subscribeFanIn inner.updated result.updated.nodeId fun newValue => updateResult newValue
     currentUnsubRef.set unsub
     let currentValue ← inner.sample
     updateResult currentValue
 
-  let unsubInner ← Reactive.Event.subscribe initialInner.updated fun newValue => updateResult newValue
+  let unsubInner ← Reactive.Event.subscribeFanIn initialInner.updated result.updated.nodeId fun newValue => updateResult newValue
   currentUnsubRef.set unsubInner
 
-  let unsubOuter ← Reactive.Event.subscribe dd.updated subscribeToInner
+  let unsubOuter ← Reactive.Event.subscribeFanIn dd.updated result.updated.nodeId subscribeToInner
+    (samples := true)
 
   -- Register both the outer subscription and a cleanup for the current inner
   env.currentScope.register unsubOuter
@@ -219,7 +237,7 @@ def bindOptionM (d : Dynamic Spider (Option a)) (f : a → Dynamic Spider b) (de
   let subscribeToInner := fun (inner : Dynamic Spider b) => do
     let oldUnsub ← currentUnsubRef.get
     oldUnsub
-    let unsub ← Reactive.Event.subscribe inner.updated fun newValue => updateResult newValue
+    let unsub ← Reactive.Event.subscribeFanIn inner.updated result.updated.nodeId fun newValue => updateResult newValue
     currentUnsubRef.set unsub
     let currentValue ← inner.sample
     updateResult currentValue
@@ -228,12 +246,12 @@ def bindOptionM (d : Dynamic Spider (Option a)) (f : a → Dynamic Spider b) (de
   match initialOpt with
   | some v =>
     let inner := f v
-    let unsubInner ← Reactive.Event.subscribe inner.updated fun newValue => updateResult newValue
+    let unsubInner ← Reactive.Event.subscribeFanIn inner.updated result.updated.nodeId fun newValue => updateResult newValue
     currentUnsubRef.set unsubInner
   | none => pure ()
 
   -- Outer subscription
-  let unsubOuter ← Reactive.Event.subscribe d.updated fun opt => do
+  let unsubOuter ← Reactive.Event.subscribeFanIn (samples := true) d.updated result.updated.nodeId fun opt => do
     match opt with
     | some v => subscribeToInner (f v)
     | none =>
@@ -453,7 +471,7 @@ def sequenceM (dynamics : List (Dynamic Spider a)) : SpiderM (Dynamic Spider (Li
 
   -- Subscribe to each dynamic's updates
   for d in dynamics do
-    let unsub ← Reactive.Event.subscribe d.updated fun _ => resampleAll
+    let unsub ← Reactive.Event.subscribeFanIn d.updated result.updated.nodeId fun _ => resampleAll
     env.currentScope.register unsub
 
   env.decrementDepth
@@ -474,7 +492,7 @@ def sequenceArrayM (dynamics : Array (Dynamic Spider a)) : SpiderM (Dynamic Spid
 
   -- Subscribe to each dynamic's updates
   for d in dynamics do
-    let unsub ← Reactive.Event.subscribe d.updated fun _ => resampleAll
+    let unsub ← Reactive.Event.subscribeFanIn d.updated result.updated.nodeId fun _ => resampleAll
     env.currentScope.register unsub
 
   env.decrementDepth
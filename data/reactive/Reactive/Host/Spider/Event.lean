@@ -51,27 +51,27 @@ def mapAddConstM [HAdd a a a] (c : a) (e : Event Spider a) : SpiderM (Event Spid
   env.decrementDepth
   pure derived⟩
 
-/-- Filter an Event by a predicate, auto-allocating NodeId and registering with scope. -/
+/-- Filter an Event by a predicate, auto-allocating NodeId and registering with scope.
+    The node is fused into `e`, like `mapM`; disposing the scope detaches it. -/
 def filterM (p : a → Bool) (e : Event Spider a) : SpiderM (Event Spider a) := ⟨fun env => do
   let _ ← env.incrementDepth "Event.filterM"
   let nodeId ← env.timelineCtx.freshNodeId
-  let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let unsub ← Reactive.Event.subscribe e fun a =>
-    if p a then derived.fire a else pure ()
-  env.currentScope.register unsub
+  let (derived, detach) ← Event.fuseWithId e nodeId fun fire a =>
+    if p a then fire a else pure ()
+  env.currentScope.register detach
   env.decrementDepth
   pure derived⟩
 
-/-- Filter and map an Event, auto-allocating NodeId and registering with scope. -/
+/-- Filter and map an Event, auto-allocating NodeId and registering with scope.
+    The node is fused into `e`, like `mapM`; disposing the scope detaches it. -/
 def mapMaybeM (f : a → Option b) (e : Event Spider a) : SpiderM (Event Spider b) := ⟨fun env => do
   let _ ← env.incrementDepth "Event.mapMaybeM"
   let nodeId ← env.timelineCtx.freshNodeId
-  let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let unsub ← Reactive.Event.subscribe e fun a =>
+  let (derived, detach) ← Event.fuseWithId e nodeId fun fire a =>
     match f a with
-    | some b => derived.fire b
+    | some b => fire b
     | none => pure ()
-  env.currentScope.register unsub
+  env.currentScope.register detach
   env.decrementDepth
   pure derived⟩
 
@@ -116,8 +116,8 @@ def mergeM (e1 : Event Spider a) (e2 : Event Spider a) : SpiderM (Event Spider a
       derived.fire value
 
   -- e1 (left) fires first due to subscription order
-  let unsub1 ← Reactive.Event.subscribe e1 tryFire
-  let unsub2 ← Reactive.Event.subscribe e2 tryFire
+  let unsub1 ← Reactive.Event.subscribeFanIn e1 nodeId tryFire
+  let unsub2 ← Reactive.Event.subscribeFanIn e2 nodeId tryFire
   env.currentScope.register unsub1
   env.currentScope.register unsub2
   env.decrementDepth
@@ -143,7 +143,7 @@ def tagM (beh : Behavior Spider a) (e : Event Spider b) : SpiderM (Event Spider
   let _ ← env.incrementDepth "Event.tagM"
   let nodeId ← env.timelineCtx.freshNodeId
   let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let unsub ← Reactive.Event.subscribe e fun _ => do
+  let unsub ← Reactive.Event.subscribeSample e fun _ => do
     let v ← beh.sample
     derived.fire v
   env.currentScope.register unsub
@@ -158,7 +158,7 @@ def attachM (b : Behavior Spider a) (e : Event Spider c) : SpiderM (Event Spider
   let _ ← env.incrementDepth "Event.attachM"
   let nodeId ← env.timelineCtx.freshNodeId
   let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let unsub ← Reactive.Event.subscribe e fun c => do
+  let unsub ← Reactive.Event.subscribeSample e fun c => do
     let a ← b.sample
     derived.fire (a, c)
   env.currentScope.register unsub
@@ -174,7 +174,7 @@ def attachWithM (f : a → c → d) (b : Behavior Spider a) (e : Event Spider c)
   let _ ← env.incrementDepth "Event.attachWithM"
   let nodeId ← env.timelineCtx.freshNodeId
   let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let unsub ← Reactive.Event.subscribe e fun c => do
+  let unsub ← Reactive.Event.subscribeSample e fun c => do
     let a ← b.sample
     derived.fire (f a c)
   env.currentScope.register unsub
@@ -186,7 +186,7 @@ def gateM (beh : Behavior Spider Bool) (e : Event Spider a) : SpiderM (Event Spi
   let _ ← env.incrementDepth "Event.gateM"
   let nodeId ← env.timelineCtx.freshNodeId
   let derived ← Event.newNodeWithId nodeId (e.height.inc)
-  let unsub ← Reactive.Event.subscribe e fun a => do
+  let unsub ← Reactive.Event.subscribeSample e fun a => do
     let isOpen ← beh.sample
     if isOpen then derived.fire a else pure ()
   env.currentScope.register unsub
@@ -204,7 +204,7 @@ def mergeListM (events : List (Event Spider a)) : SpiderM (Event Spider (List a)
   let flushScheduledRef ← IO.mkRef false
 
   for e in events do
-    let unsub ← Reactive.Event.subscribe e fun a => do
+    let unsub ← Reactive.Event.subscribeFanIn e nodeId fun a => do
       bufferRef.modify (·.push a)
       let alreadyScheduled ← flushScheduledRef.get
       if !alreadyScheduled then
@@ -258,7 +258,7 @@ def leftmostM (events : List (Event Spider a)) : SpiderM (Event Spider a) := ⟨
       derived.fire value
 
   for e in events do
-    let unsub ← Reactive.Event.subscribe e tryFire
+    let unsub ← Reactive.Event.subscribeFanIn e nodeId tryFire
     env.currentScope.register unsub
   env.decrementDepth
   pure derived⟩
@@ -530,10 +530,10 @@ def zipEM (e1 : Event Spider a) (e2 : Event Spider b)
         else flushAction
       | none => flushAction
 
-  let unsub1 ← Reactive.Event.subscribe e1 fun a => do
+  let unsub1 ← Reactive.Event.subscribeFanIn e1 nodeId fun a => do
     value1Ref.set (some a)
     scheduleFlush
-  let unsub2 ← Reactive.Event.subscribe e2 fun b => do
+  let unsub2 ← Reactive.Event.subscribeFanIn e2 nodeId fun b => do
     value2Ref.set (some b)
     scheduleFlush
 
@@ -581,10 +581,10 @@ def differenceM (e1 : Event Spider a) (e2 : Event Spider b)
         else flushAction
       | none => flushAction
 
-  let unsub1 ← Reactive.Event.subscribe e1 fun a => do
+  let unsub1 ← Reactive.Event.subscribeFanIn e1 nodeId fun a => do
     value1Ref.set (some a)
     scheduleFlush
-  let unsub2 ← Reactive.Event.subscribe e2 fun _ => do
+  let unsub2 ← Reactive.Event.subscribeFanIn e2 nodeId fun _ => do
     value2FiredRef.set true
     scheduleFlush
 
@@ -610,13 +610,13 @@ def switchDynM (de : Dynamic Spider (Event Spider a)) : SpiderM (Event Spider a)
   let initialEvent ← de.sample
   let derivedHeight := Height.inc (max initialEvent.height de.updated.height)
   let derived ← Event.newNodeWithId nodeId derivedHeight
-  let unsub ← Reactive.Event.subscribe initialEvent derived.fire
+  let unsub ← Reactive.Event.subscribeFanIn initialEvent nodeId derived.fire
   currentUnsubRef.set unsub
 
-  let unsubOuter ← Reactive.Event.subscribe de.updated fun newEvent => do
+  let unsubOuter ← Reactive.Event.subscribeFanIn de.updated nodeId fun newEvent => do
     let oldUnsub ← currentUnsubRef.get
     oldUnsub
-    let unsub ← Reactive.Event.subscribe newEvent derived.fire
+    let unsub ← Reactive.Event.subscribeFanIn newEvent nodeId derived.fire
     currentUnsubRef.set unsub
 
   env.currentScope.register unsubOuter
@@ -22,6 +22,7 @@ inductive PoolCommand (jobId job : Type) where
   | updatePriority (id : jobId) (newPriority : Int)
   | resubmit (id : jobId) (job : job) (priority : Int)
   | submitDelayed (id : jobId) (job : job) (priority : Int) (delayMs : Nat)
+  | submitBatch (jobs : Array (jobId × job × Int))
   deriving Repr
 
 /-- Status of a job in the pool -/
@@ -51,10 +52,22 @@ private structure PendingJob (jobId job : Type) where
 instance [Inhabited jobId] [Inhabited job] : Inhabited (PendingJob jobId job) where
   default := { id := default, priority := default, payload := default }
 
+/-- How a pool hands pending jobs to its workers -/
+inductive PoolExecutor where
+  /-- One priority heap behind a mutex that every worker takes for each job -/
+  | sharedQueue
+  /-- Per-worker deques split into priority lanes; idle workers steal from
+      busy ones. Workers claim and settle up to `batchSize` jobs at a time. -/
+  | workStealing (batchSize : Nat := 64)
+  deriving Repr, BEq, Inhabited
+
 /-- Configuration for the worker pool -/
 structure WorkerPoolConfig where
   /-- Number of worker threads -/
   workerCount : Nat := 4
+  /-- Job dispatch strategy. Only `fromCommands` and `fromCommandsWithShutdown`
+      support `workStealing`; the other constructors always use the shared queue. -/
+  executor : PoolExecutor := .sharedQueue
   deriving Repr, BEq, Inhabited
 
 /-- Output structure from the FRP worker pool -/
@@ -303,7 +316,7 @@ private def trySubmitJob [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhabit
     (checkDuplicate : Bool := true) : SubmitResult jobId job :=
   if st.closed then
     .poolClosed
-  else if checkDuplicate && (st.pendingQueue.any (·.id == id) || st.runningJobs.contains id) then
+  else if checkDuplicate && (st.statuses[id]? == some .pending || st.runningJobs.contains id) then
     .duplicate
   else
     let seq := st.nextSequence
@@ -321,6 +334,17 @@ private def trySubmitJob [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhabit
       version := st.version + 1
     }
 
+/-- Submit a batch of jobs to state. Returns the new state, how many jobs
+    were accepted, and the IDs rejected as duplicates. -/
+private def trySubmitBatch [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhabited job]
+    (st : PoolState jobId job) (jobs : Array (jobId × job × Int))
+    : PoolState jobId job × Nat × Array jobId :=
+  jobs.foldl (init := (st, 0, (#[] : Array jobId))) fun (st, accepted, duplicates) (id, theJob, priority) =>
+    match trySubmitJob st id theJob priority with
+    | .success st' => (st', accepted + 1, duplicates)
+    | .duplicate => (st, accepted, duplicates.push id)
+    | .poolClosed => (st, accepted, duplicates)
+
 /-- Worker loop with versioned observable updates.
     Uses monotonic version numbers to ensure only the latest state is published,
     preventing stale snapshot races when multiple threads update concurrently. -/
@@ -417,9 +441,409 @@ structure PoolHandle where
   /-- Gracefully shutdown the pool -/
   shutdown : IO Unit
 
-/-- Create an FRP-based worker pool with shutdown handle.
-    Same as `fromCommands` but also returns a handle to gracefully shutdown the pool. -/
-def fromCommandsWithShutdown [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhabited job]
+/-! ## Work-stealing executor
+
+With `PoolExecutor.workStealing` every worker owns a deque of pending jobs,
+split into lanes by priority. A worker takes jobs from the front of its own
+highest lane; once its deque is empty it steals the back half of another
+worker's highest lane. A worker takes a batch of entries per deque lock, then
+claims each job just before running it, settling the previous one under the
+same lock of the job bookkeeping and publishing both in one frame. A job
+cancelled after its entry was taken but before it started is never run.
+Cancelled and reprioritised jobs are not searched for in the deques: their
+entries go stale and are dropped when claimed. -/
+
+/-- Pending jobs of one priority, oldest first from `head` -/
+structure Lane (α : Type) where
+  priority : Int
+  items : Array α := #[]
+  head : Nat := 0
+
+namespace Lane
+
+/-- Jobs still waiting in the lane -/
+def size (l : Lane α) : Nat := l.items.size - l.head
+
+/-- Drop the consumed prefix once it outweighs the waiting jobs -/
+def compact (l : Lane α) : Lane α :=
+  if l.head > 32 && l.head * 2 > l.items.size then
+    { l with items := l.items.extract l.head l.items.size, head := 0 }
+  else
+    l
+
+end Lane
+
+/-- One worker's pending jobs, in lanes of descending priority -/
+structure LaneDeque (α : Type) where
+  lanes : Array (Lane α) := #[]
+  size : Nat := 0
+
+namespace LaneDeque
+
+/-- Add a job to the back of its priority's lane -/
+def push (d : LaneDeque α) (priority : Int) (x : α) : LaneDeque α :=
+  match d.lanes.findIdx? (·.priority == priority) with
+  | some i =>
+    { lanes := d.lanes.modify i fun l => { l with items := l.items.push x }, size := d.size + 1 }
+  | none =>
+    let pos := (d.lanes.findIdx? (·.priority < priority)).getD d.lanes.size
+    let lane : Lane α := { priority, items := #[x] }
+    { lanes := (d.lanes.extract 0 pos).push lane ++ d.lanes.extract pos d.lanes.size
+      size := d.size + 1 }
+
+/-- Add jobs of one priority, oldest first -/
+def pushMany (d : LaneDeque α) (priority : Int) (xs : Array α) : LaneDeque α :=
+  xs.foldl (fun d x => d.push priority x) d
+
+/-- Take up to `n` jobs from the front: highest priority first, oldest first
+    within a priority -/
+def popFront (d : LaneDeque α) (n : Nat) : Array α × LaneDeque α := Id.run do
+  let mut taken : Array α := #[]
+  let mut lanes := d.lanes
+  while taken.size < n do
+    let some lane := lanes[0]? | break
+    let k := min (n - taken.size) lane.size
+    taken := taken ++ lane.items.extract lane.head (lane.head + k)
+    if k == lane.size then
+      lanes := lanes.extract 1 lanes.size
+    else
+      lanes := lanes.set! 0 (Lane.compact { lane with head := lane.head + k })
+  return (taken, { lanes, size := d.size - taken.size })
+
+/-- Take the back half of the highest priority lane, with its priority -/
+def stealHalf (d : LaneDeque α) : Option (Int × Array α) × LaneDeque α :=
+  match d.lanes[0]? with
+  | none => (none, d)
+  | some lane =>
+    let k := (lane.size + 1) / 2
+    let keep := lane.items.size - k
+    let stolen := lane.items.extract keep lane.items.size
+    let lanes :=
+      if keep == lane.head then d.lanes.extract 1 d.lanes.size
+      else d.lanes.set! 0 { lane with items := lane.items.extract 0 keep }
+    (some (lane.priority, stolen), { lanes, size := d.size - k })
+
+end LaneDeque
+
+/-- A job waiting in a worker's deque. The entry is stale once the job is
+    cancelled, reprioritised or resubmitted under a newer generation. -/
+private structure QueuedJob (jobId job : Type) where
+  id : jobId
+  payload : job
+  generation : Nat
+
+/-- Job bookkeeping shared by the work-stealing workers -/
+private structure StealState (jobId job : Type) [BEq jobId] [Hashable jobId] where
+  /-- Queued jobs with the generation of their live deque entry -/
+  pending : HashMap jobId (job × Nat) := {}
+  /-- Running jobs with the generation they were claimed under -/
+  running : HashMap jobId Nat := {}
+  /-- Job statuses for external observation -/
+  statuses : HashMap jobId JobStatus := {}
+  /-- Global generation counter per job ID -/
+  generations : HashMap jobId Nat := {}
+  /-- Whether the pool is closed -/
+  closed : Bool := false
+  /-- Monotonically increasing version for observable update ordering -/
+  version : Nat := 0
+  /-- Workers parked on the wake channel that no token has been sent for yet -/
+  sleepers : Nat := 0
+
+/-- Record jobs as pending. Returns their deque entries, the IDs rejected as
+    duplicates, and the new state; nothing is accepted once the pool is closed. -/
+private def stealSubmit [BEq jobId] [Hashable jobId]
+    (st : StealState jobId job) (jobs : Array (jobId × job × Int)) (checkDuplicate : Bool)
+    : (Array (Int × QueuedJob jobId job) × Array jobId) × StealState jobId job :=
+  if st.closed then
+    ((#[], #[]), st)
+  else
+    let init := ((#[] : Array (Int × QueuedJob jobId job)), (#[] : Array jobId), st)
+    let (entries, duplicates, st) := jobs.foldl (init := init)
+      fun (entries, duplicates, st) (id, theJob, priority) =>
+        if checkDuplicate && (st.pending.contains id || st.running.contains id) then
+          (entries, duplicates.push id, st)
+        else
+          let gen := st.generations[id]?.getD 0
+          (entries.push (priority, { id, payload := theJob, generation := gen }), duplicates,
+            { st with
+              pending := st.pending.insert id (theJob, gen)
+              statuses := st.statuses.insert id JobStatus.pending })
+    ((entries, duplicates), { st with version := st.version + 1 })
+
+/-- Cancel a pending or running job. Returns whether the job was found. -/
+private def stealCancel [BEq jobId] [Hashable jobId]
+    (st : StealState jobId job) (id : jobId) : Bool × StealState jobId job :=
+  if st.pending.contains id || st.running.contains id then
+    let (_, gens') := nextGeneration st.generations id
+    (true, { st with
+      pending := st.pending.erase id
+      running := st.running.erase id
+      statuses := st.statuses.insert id JobStatus.cancelled
+      generations := gens'
+      version := st.version + 1 })
+  else
+    (false, st)
+
+/-- Move a pending job to a new priority. Returns the entry to enqueue; the
+    old entry goes stale. -/
+private def stealReprioritize [BEq jobId] [Hashable jobId]
+    (st : StealState jobId job) (id : jobId) (newPriority : Int)
+    : Option (Int × QueuedJob jobId job) × StealState jobId job :=
+  match st.pending[id]? with
+  | none => (none, st)
+  | some (theJob, _) =>
+    let (gen, gens') := nextGeneration st.generations id
+    (some (newPriority, { id, payload := theJob, generation := gen }),
+      { st with pending := st.pending.insert id (theJob, gen), generations := gens' })
+
+/-- Claim the live jobs of a batch and drop its stale entries (workers claim
+    one entry at a time, right before running it).
+    Returns `none` once the pool is closed. -/
+private def stealClaim [BEq jobId] [Hashable jobId]
+    (st : StealState jobId job) (batch : Array (QueuedJob jobId job))
+    : Option (Array (QueuedJob jobId job)) × StealState jobId job :=
+  if st.closed then
+    (none, st)
+  else
+    let (live, st) := batch.foldl (init := ((#[] : Array (QueuedJob jobId job)), st)) fun (live, st) entry =>
+      match st.pending[entry.id]? with
+      | some (_, gen) =>
+        if gen == entry.generation then
+          (live.push entry, { st with
+            pending := st.pending.erase entry.id
+            running := st.running.insert entry.id gen
+            statuses := st.statuses.insert entry.id JobStatus.running })
+        else
+          (live, st)
+      | none => (live, st)
+    (some live, if live.isEmpty then st else { st with version := st.version + 1 })
+
+/-- Record the outcomes of a batch. Returns the outcomes of jobs that were
+    not cancelled while running, which are the ones to report. -/
+private def stealSettle [BEq jobId] [Hashable jobId]
+    (st : StealState jobId job) (outcomes : Array (QueuedJob jobId job × Except String result))
+    : Array (QueuedJob jobId job × Except String result) × StealState jobId job :=
+  let init := ((#[] : Array (QueuedJob jobId job × Except String result)), st)
+  let (current, st) := outcomes.foldl (init := init) fun (current, st) (entry, outcome) =>
+    if st.running[entry.id]? == some entry.generation then
+      let status := match outcome with
+        | .ok _ => JobStatus.completed
+        | .error _ => JobStatus.error
+      (current.push (entry, outcome), { st with
+        running := st.running.erase entry.id
+        statuses := st.statuses.insert entry.id status })
+    else
+      (current, st)
+  (current, if current.isEmpty then st else { st with version := st.version + 1 })
+
+/-- Take up to `n` jobs from worker `owner`'s deque. When it is empty, steal
+    from the other workers in turn, keeping what does not fit in the batch. -/
+private def takeWork (deques : Array (Std.Mutex (LaneDeque α))) (owner n : Nat) : IO (Array α) := do
+  let some own := deques[owner]? | return #[]
+  let batch ← own.atomically (modifyGet (·.popFront n))
+  if !batch.isEmpty then
+    return batch
+  for i in [1:deques.size] do
+    let some victim := deques[(owner + i) % deques.size]? | continue
+    match ← victim.atomically (modifyGet (·.stealHalf)) with
+    | some (priority, stolen) =>
+      if stolen.size > n then
+        own.atomically (modify (·.pushMany priority (stolen.extract n stolen.size)))
+      return stolen.extract 0 n
+    | none => pure ()
+  return #[]
+
+/-- Work-stealing worker loop. Sleeps on `wake` only when every deque is empty.
+    A worker counts itself in `sleepers` before its last look at the deques,
+    so an enqueue either sees it there or leaves work the look finds. -/
+private partial def stealingWorkerLoop [BEq jobId] [Hashable jobId]
+    (book : Std.Mutex (StealState jobId job))
+    (deques : Array (Std.Mutex (LaneDeque (QueuedJob jobId job))))
+    (wake : Std.CloseableChannel.Sync Unit)
+    (owner batchSize : Nat)
+    (publish : StealState jobId job → IO Unit → IO Unit)
+    (process : job → IO result)
+    (fireCompleted : (jobId × job × result) → IO Unit)
+    (fireErrored : (jobId × String) → IO Unit)
+    : IO Unit := do
+  let loop := stealingWorkerLoop book deques wake owner batchSize publish process fireCompleted fireErrored
+  let batch ← takeWork deques owner batchSize
+  let batch ← if !batch.isEmpty then pure batch else do
+    book.atomically (modify fun st => { st with sleepers := st.sleepers + 1 })
+    let batch ← takeWork deques owner batchSize
+    if !batch.isEmpty then
+      book.atomically (modify fun st => { st with sleepers := st.sleepers - 1 })
+    pure batch
+  if batch.isEmpty then
+    match ← wake.recv with
+    | none => return ()  -- Pool closed
+    | some () => loop
+  else
+    let report := fun (st : StealState jobId job)
+        (current : Array (QueuedJob jobId job × Except String result)) =>
+      publish st do
+        for (entry, outcome) in current do
+          match outcome with
+          | .ok r => fireCompleted (entry.id, entry.payload, r)
+          | .error msg => fireErrored (entry.id, msg)
+    -- The job that just finished, settled together with the next claim
+    let mut done : Array (QueuedJob jobId job × Except String result) := #[]
+    for entry in batch do
+      let (current, claimed?, st) ← book.atomically (modifyGet fun st =>
+        let (current, st) := stealSettle st done
+        let (claimed?, st) := stealClaim st #[entry]
+        ((current, claimed?, st), st))
+      let started := claimed?.any (!·.isEmpty)
+      if !current.isEmpty || started then
+        report st current
+      done := #[]
+      match claimed? with
+      | none => return ()  -- Pool closed
+      | some _ =>
+        if started then
+          let outcome : Except String result ←
+            try
+              let r ← process entry.payload
+              pure (.ok r)
+            catch e =>
+              pure (.error (toString e))
+          done := #[(entry, outcome)]
+    let (current, st) ← book.atomically (modifyGet fun st =>
+      let (current, st') := stealSettle st done
+      ((current, st'), st'))
+    if !current.isEmpty then
+      report st current
+    loop
+
+/-- `fromCommandsWithShutdown` on the work-stealing executor -/
+private def fromCommandsStealing [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhabited job]
+    (config : WorkerPoolConfig)
+    (batchSize : Nat)
+    (process : job → IO result)
+    (commands : Evt (PoolCommand jobId job))
+    : SpiderM (PoolOutput jobId job result × PoolHandle) := ⟨fun env => do
+  let (completedEvt, fireCompleted) ← Event.newTrigger env.timelineCtx
+  let (cancelledEvt, fireCancelled) ← Event.newTrigger env.timelineCtx
+  let (erroredEvt, fireErrored) ← Event.newTrigger env.timelineCtx
+
+  let (jobStatesDyn, updateJobStates) ← createDynamic env.timelineCtx ({} : HashMap jobId JobStatus)
+  let (pendingCountDyn, updatePendingCount) ← createDynamic env.timelineCtx (0 : Nat)
+  let (runningCountDyn, updateRunningCount) ← createDynamic env.timelineCtx (0 : Nat)
+
+  let batchSize := max batchSize 1
+  let workerCount := max config.workerCount 1
+  let book ← Std.Mutex.new ({} : StealState jobId job)
+  let mut deques : Array (Std.Mutex (LaneDeque (QueuedJob jobId job))) := #[]
+  for _ in [0:workerCount] do
+    deques := deques.push (← Std.Mutex.new ({} : LaneDeque (QueuedJob jobId job)))
+  let deques := deques
+  let wake : Std.CloseableChannel.Sync Unit ← Std.CloseableChannel.Sync.new
+  let nextWorker ← IO.mkRef 0
+  let lastPublishedVersion ← Std.Mutex.new (0 : Nat)
+
+  -- Same versioned frame update as the shared-queue pool
+  let publish := fun (st : StealState jobId job) (fireAction : IO Unit) =>
+    env.withFrame do
+      fireAction
+      let shouldUpdateState ← lastPublishedVersion.atomically do
+        let lastVer ← get
+        if st.version > lastVer then
+          set st.version
+          return true
+        else
+          return false
+      if shouldUpdateState then
+        updateJobStates st.statuses
+        updatePendingCount st.pending.size
+        updateRunningCount st.running.size
+
+  for worker in [0:workerCount] do
+    let _ ← IO.asTask (prio := .dedicated)
+      (stealingWorkerLoop book deques wake worker batchSize publish process fireCompleted fireErrored)
+
+  -- Spread entries over the deques in batch-sized chunks, then wake a parked
+  -- worker per chunk. Awake workers find the chunks without a token, so
+  -- unclaimed tokens stay bounded by the worker count.
+  let enqueue := fun (entries : Array (Int × QueuedJob jobId job)) => do
+    let chunks := (entries.size + batchSize - 1) / batchSize
+    let start ← nextWorker.modifyGet fun i => (i, i + chunks)
+    for c in [0:chunks] do
+      let chunk := entries.extract (c * batchSize) ((c + 1) * batchSize)
+      if let some deque := deques[(start + c) % workerCount]? then
+        deque.atomically (modify fun d => chunk.foldl (fun d (p, e) => d.push p e) d)
+    let toWake ← book.atomically (modifyGet fun st =>
+      let n := min chunks st.sleepers
+      (n, { st with sleepers := st.sleepers - n }))
+    for _ in [0:toWake] do
+      try let _ ← wake.send () catch _ => pure ()
+
+  let submitJobs := fun (jobs : Array (jobId × job × Int)) (checkDuplicate : Bool) => do
+    let ((entries, duplicates), st) ← book.atomically (modifyGet fun st =>
+      let (r, st') := stealSubmit st jobs checkDuplicate
+      ((r, st'), st'))
+    if !duplicates.isEmpty then
+      env.withFrame do
+        for id in duplicates do
+          fireErrored (id, "duplicate job ID")
+    if !entries.isEmpty then
+      publish st (pure ())
+      enqueue entries
+
+  let cancelJob := fun (id : jobId) => do
+    let (found, st) ← book.atomically (modifyGet fun st =>
+      let (found, st') := stealCancel st id
+      ((found, st'), st'))
+    if found then
+      publish st (fireCancelled id)
+
+  let processCommand := fun (cmd : PoolCommand jobId job) => do
+    match cmd with
+    | .submit id theJob priority => submitJobs #[(id, theJob, priority)] true
+    | .submitBatch jobs => submitJobs jobs true
+    | .cancel id => cancelJob id
+    | .updatePriority id newPriority =>
+      let entry? ← book.atomically (modifyGet fun st => stealReprioritize st id newPriority)
+      if let some entry := entry? then
+        enqueue #[entry]
+    | .resubmit id theJob priority =>
+      cancelJob id
+      submitJobs #[(id, theJob, priority)] false
+    | .submitDelayed id theJob priority delayMs =>
+      let _ ← IO.asTask (prio := .default) do
+        IO.sleep (UInt32.ofNat delayMs)
+        submitJobs #[(id, theJob, priority)] true
+
+  let unsub ← Reactive.Event.subscribe commands processCommand
+  env.currentScope.register unsub
+
+  let shutdownHandle : PoolHandle := {
+    shutdown := do
+      let (pendingIds, st) ← book.atomically (modifyGet fun st =>
+        let pendingIds := st.pending.fold (fun acc id _ => acc.push id) (#[] : Array jobId)
+        let statuses' := pendingIds.foldl (fun acc id => acc.insert id JobStatus.cancelled) st.statuses
+        let st' := { st with
+          closed := true
+          pending := {}
+          statuses := statuses'
+          version := st.version + 1 }
+        ((pendingIds, st'), st'))
+      publish st do
+        for id in pendingIds do
+          fireCancelled id
+      try let _ ← wake.close catch _ => pure ()
+  }
+
+  return ({
+    completed := completedEvt
+    cancelled := cancelledEvt
+    errored := erroredEvt
+    jobStates := jobStatesDyn
+    pendingCount := pendingCountDyn
+    runningCount := runningCountDyn
+  }, shutdownHandle)⟩
+
+/-- `fromCommandsWithShutdown` on the shared priority queue -/
+private def fromCommandsShared [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhabited job]
     (config : WorkerPoolConfig)
     (process : job → IO result)
     (commands : Evt (PoolCommand jobId job))
@@ -579,6 +1003,22 @@ def fromCommandsWithShutdown [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inh
           updateObservablesInFrame st st.version
           signalWorker sig
 
+    | .submitBatch jobs =>
+      let (st, accepted, duplicates, sig) ← mutexState.atomically do
+        let ms ← get
+        let (st', accepted, duplicates) := trySubmitBatch ms.state jobs
+        modify fun ms => { ms with state := st' }
+        return (st', accepted, duplicates, ms.signal)
+
+      if !duplicates.isEmpty then
+        env.withFrame do
+          for id in duplicates do
+            fireErrored (id, "duplicate job ID")
+      if accepted > 0 then
+        updateObservablesInFrame st st.version
+        for _ in [0:accepted] do
+          signalWorker sig
+
   let unsub ← Reactive.Event.subscribe commands processCommand
   env.currentScope.register unsub
 
@@ -635,6 +1075,17 @@ def fromCommandsWithShutdown [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inh
     runningCount := runningCountDyn
   }, shutdownHandle)⟩
 
+/-- Create an FRP-based worker pool with shutdown handle.
+    Same as `fromCommands` but also returns a handle to gracefully shutdown the pool. -/
+def fromCommandsWithShutdown [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhabited job]
+    (config : WorkerPoolConfig)
+    (process : job → IO result)
+    (commands : Evt (PoolCommand jobId job))
+    : SpiderM (PoolOutput jobId job result × PoolHandle) :=
+  match config.executor with
+  | .sharedQueue => fromCommandsShared config process commands
+  | .workStealing batchSize => fromCommandsStealing config batchSize process commands
+
 /-- Create an FRP-based worker pool from a command stream.
 
     Jobs are submitted, cancelled, and managed through the `commands` event stream.
@@ -922,6 +1373,22 @@ def fromCommandsWithCancel [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhab
           updateObservablesInFrame st st.version
           signalWorker sig
 
+    | .submitBatch jobs =>
+      let (st, accepted, duplicates, sig) ← mutexState.atomically do
+        let ms ← get
+        let (st', accepted, duplicates) := trySubmitBatch ms.state jobs
+        modify fun ms => { ms with state := st' }
+        return (st', accepted, duplicates, ms.signal)
+
+      if !duplicates.isEmpty then
+        env.withFrame do
+          for id in duplicates do
+            fireErrored (id, "duplicate job ID")
+      if accepted > 0 then
+        updateObservablesInFrame st st.version
+        for _ in [0:accepted] do
+          signalWorker sig
+
   let unsub ← Reactive.Event.subscribe commands processCommand
   env.currentScope.register unsub
 
@@ -1239,6 +1706,22 @@ def fromCommandsChainable [BEq jobId] [Hashable jobId] [Inhabited jobId] [Inhabi
           updateObservablesInFrame st st.version
           signalWorker sig
 
+    | .submitBatch jobs =>
+      let (st, accepted, duplicates, sig) ← mutexState.atomically do
+        let ms ← get
+        let (st', accepted, duplicates) := trySubmitBatch ms.state jobs
+        modify fun ms => { ms with state := st' }
+        return (st', accepted, duplicates, ms.signal)
+
+      if !duplicates.isEmpty then
+        env.withFrame do
+          for id in duplicates do
+            fireErrored (id, "duplicate job ID")
+      if accepted > 0 then
+        updateObservablesInFrame st st.version
+        for _ in [0:accepted] do
+          signalWorker sig
+
   let unsub ← Reactive.Event.subscribe commands processCommand
   env.currentScope.register unsub
 
@@ -1187,4 +1187,158 @@ test "submitDelayed command delays job submission" := do
   -- Elapsed time should be at least 100ms
   shouldSatisfy (result.fst >= 90) "delay was at least 90ms"
 
+test "worker pool submitBatch reports duplicates and runs the rest" := do
+  let result ← runSpider do
+    let config : WorkerPoolConfig := { workerCount := 2 }
+    let (cmdEvt, fireCmd) ← newTriggerEvent (t := Spider) (a := PoolCommand Nat Nat)
+    let (pool, handle) ← WorkerPool.fromCommandsWithShutdown config (fun (n : Nat) => pure (n * 2)) cmdEvt
+
+    let totalRef ← SpiderM.liftIO <| IO.mkRef (0 : Nat)
+    let erroredRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let _ ← pool.completed.subscribe fun (_, _, r) => totalRef.modify (· + r)
+    let _ ← pool.errored.subscribe fun (id, _) => erroredRef.modify (· ++ [id])
+
+    SpiderM.liftIO <| fireCmd (.submitBatch #[(1, 1, 0), (2, 2, 0), (1, 5, 0), (3, 3, 0)])
+
+    SpiderM.liftIO <| IO.sleep 100
+    SpiderM.liftIO handle.shutdown
+    pure (← SpiderM.liftIO totalRef.get, ← SpiderM.liftIO erroredRef.get)
+
+  shouldBe result.fst 12
+  shouldBe result.snd [1]
+
+test "work-stealing pool completes a large batch across workers" := do
+  let result ← runSpider do
+    let config : WorkerPoolConfig := { workerCount := 4, executor := .workStealing 16 }
+    let (cmdEvt, fireCmd) ← newTriggerEvent (t := Spider) (a := PoolCommand Nat Nat)
+    let (pool, handle) ← WorkerPool.fromCommandsWithShutdown config (fun (n : Nat) => pure n) cmdEvt
+
+    let totalRef ← SpiderM.liftIO <| IO.mkRef (0 : Nat)
+    let _ ← pool.completed.subscribe fun (_, _, r) => totalRef.modify (· + r)
+
+    SpiderM.liftIO <| fireCmd (.submitBatch ((Array.range 1000).map fun i => (i, i, 0)))
+
+    SpiderM.liftIO <| IO.sleep 200
+    SpiderM.liftIO handle.shutdown
+    let total ← SpiderM.liftIO totalRef.get
+    let pending ← pool.pendingCount.sample
+    let running ← pool.runningCount.sample
+    pure (total, pending, running)
+
+  shouldBe result (499500, 0, 0)
+
+test "work-stealing pool runs a worker's jobs in priority order" := do
+  let result ← runSpider do
+    let config : WorkerPoolConfig := { workerCount := 1, executor := .workStealing }
+    let resultsRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let (cmdEvt, fireCmd) ← newTriggerEvent (t := Spider) (a := PoolCommand Nat Nat)
+    let (pool, handle) ← WorkerPool.fromCommandsWithShutdown config (fun (n : Nat) => pure n) cmdEvt
+
+    let _ ← pool.completed.subscribe fun (_, _, r) =>
+      resultsRef.modify (· ++ [r])
+
+    -- One batch lands in the deque at once, so the order is deterministic
+    SpiderM.liftIO <| fireCmd (.submitBatch #[(1, 3, 1), (2, 2, 5), (3, 1, 3), (4, 4, 1)])
+
+    SpiderM.liftIO <| IO.sleep 100
+    SpiderM.liftIO handle.shutdown
+    SpiderM.liftIO resultsRef.get
+
+  shouldBe result [2, 1, 3, 4]
+
+test "work-stealing pool cancels and reprioritises pending jobs" := do
+  let result ← runSpider do
+    let config : WorkerPoolConfig := { workerCount := 1, executor := .workStealing 1 }
+    let completedRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let cancelledRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let (cmdEvt, fireCmd) ← newTriggerEvent (t := Spider) (a := PoolCommand Nat Nat)
+
+    let (pool, handle) ← WorkerPool.fromCommandsWithShutdown config
+      (fun (n : Nat) => do IO.sleep n.toUInt32; pure n)
+      cmdEvt
+
+    let _ ← pool.completed.subscribe fun (id, _, _) =>
+      completedRef.modify (· ++ [id])
+    let _ ← pool.cancelled.subscribe fun id =>
+      cancelledRef.modify (· ++ [id])
+
+    -- Keep the worker busy while the rest queue up
+    SpiderM.liftIO <| fireCmd (.submit 0 40 0)
+    SpiderM.liftIO <| IO.sleep 10
+    SpiderM.liftIO <| fireCmd (.submitBatch #[(1, 0, 0), (2, 0, 0), (3, 0, 0)])
+    SpiderM.liftIO <| fireCmd (.cancel 2)
+    SpiderM.liftIO <| fireCmd (.updatePriority 3 10)
+
+    SpiderM.liftIO <| IO.sleep 150
+    SpiderM.liftIO handle.shutdown
+    pure (← SpiderM.liftIO completedRef.get, ← SpiderM.liftIO cancelledRef.get)
+
+  shouldBe result.fst [0, 3, 1]
+  shouldBe result.snd [2]
+
+test "work-stealing pool never starts a job cancelled after its batch was taken" := do
+  let result ← runSpider do
+    let config : WorkerPoolConfig := { workerCount := 1, executor := .workStealing }
+    let startedRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let completedRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let cancelledRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let (cmdEvt, fireCmd) ← newTriggerEvent (t := Spider) (a := PoolCommand Nat Nat)
+
+    let (pool, handle) ← WorkerPool.fromCommandsWithShutdown config
+      (fun (n : Nat) => do
+        startedRef.modify (· ++ [n])
+        IO.sleep n.toUInt32
+        pure n)
+      cmdEvt
+
+    let _ ← pool.completed.subscribe fun (id, _, _) =>
+      completedRef.modify (· ++ [id])
+    let _ ← pool.cancelled.subscribe fun id =>
+      cancelledRef.modify (· ++ [id])
+
+    -- The worker takes all three entries at once and starts job 0
+    SpiderM.liftIO <| fireCmd (.submitBatch #[(0, 50, 0), (1, 1, 0), (2, 2, 0)])
+    SpiderM.liftIO <| IO.sleep 10
+    SpiderM.liftIO <| fireCmd (.cancel 1)
+
+    SpiderM.liftIO <| IO.sleep 150
+    SpiderM.liftIO handle.shutdown
+    pure (← SpiderM.liftIO startedRef.get, ← SpiderM.liftIO completedRef.get,
+      ← SpiderM.liftIO cancelledRef.get)
+
+  shouldBe result.1 [50, 2]
+  shouldBe result.2.1 [0, 2]
+  shouldBe result.2.2 [1]
+
+test "work-stealing pool soft-cancels running job and shuts down pending ones" := do
+  let result ← runSpider do
+    let config : WorkerPoolConfig := { workerCount := 1, executor := .workStealing 1 }
+    let completedRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let cancelledRef ← SpiderM.liftIO <| IO.mkRef ([] : List Nat)
+    let (cmdEvt, fireCmd) ← newTriggerEvent (t := Spider) (a := PoolCommand Nat Nat)
+
+    let (pool, handle) ← WorkerPool.fromCommandsWithShutdown config
+      (fun (n : Nat) => do IO.sleep n.toUInt32; pure n)
+      cmdEvt
+
+    let _ ← pool.completed.subscribe fun (id, _, _) =>
+      completedRef.modify (· ++ [id])
+    let _ ← pool.cancelled.subscribe fun id =>
+      cancelledRef.modify (· ++ [id])
+
+    SpiderM.liftIO <| fireCmd (.submit 1 50 0)
+    SpiderM.liftIO <| IO.sleep 10
+    SpiderM.liftIO <| fireCmd (.submit 2 50 0)
+    SpiderM.liftIO <| fireCmd (.cancel 1)
+    SpiderM.liftIO handle.shutdown
+
+    SpiderM.liftIO <| IO.sleep 100
+    let states ← pool.jobStates.sample
+    pure (← SpiderM.liftIO completedRef.get, ← SpiderM.liftIO cancelledRef.get, states[2]?)
+
+  -- Job 1's result is discarded; job 2 never starts
+  shouldBe result.1 []
+  shouldBe result.2.1 [1, 2]
+  shouldBe result.2.2 (some JobStatus.cancelled)
+
 end ReactiveTests.AsyncTests
@@ -0,0 +1,101 @@
+import Crucible
+import Reactive
+
+/-!
+# Fusion Tests
+
+Chains of pure event combinators (`mapM`, `filterM`, `mapMaybeM`) are fused
+into their source, and uniq dynamics drop no-op updates before queueing.
+These tests check both by counting queued fires.
+-/
+
+namespace ReactiveTests.FusionTests
+
+open Crucible
+open Reactive
+open Reactive.Host
+
+testSuite "Fusion Tests"
+
+/-- Fires queued by the current environment so far. -/
+def queuedFires : SpiderM Nat := do
+  let env ← SpiderM.getEnv
+  SpiderM.liftIO env.propagationQueue.queuedCount
+
+test "a six-step map/filter chain queues one fire per occurrence" := do
+  let (values, fires) ← runSpider do
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let e1 ← Event.mapM (· + 1) source
+    let e2 ← Event.filterM (· % 2 == 0) e1
+    let e3 ← Event.mapM (· * 10) e2
+    let e4 ← Event.mapMaybeM (fun n => if n > 20 then some (n - 20) else none) e3
+    let e5 ← Event.mapM (· + 1) e4
+    let e6 ← Event.filterM (· < 100) e5
+    let seenRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    let _ ← e6.subscribe fun v => seenRef.modify (·.push v)
+    let before ← queuedFires
+    for n in [:6] do
+      trigger n
+    let after ← queuedFires
+    pure (← SpiderM.liftIO seenRef.get, after - before)
+  -- 1 → 2 → 20 dropped; 3 → 4 → 40 → 21; 5 → 6 → 60 → 41
+  values ≡ #[21, 41]
+  -- One fire for the trigger and one for the end of the chain, when it passes
+  fires ≡ 6 + 2
+
+test "a subscriber part way along a fused chain sees its own values" := do
+  let (mid, last) ← runSpider do
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let evens ← Event.filterM (· % 2 == 0) source
+    let halves ← Event.mapM (· / 2) evens
+    let midRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    let lastRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    let _ ← halves.subscribe fun v => lastRef.modify (·.push v)
+    let _ ← evens.subscribe fun v => midRef.modify (·.push v)
+    for n in [:5] do
+      trigger n
+    pure (← SpiderM.liftIO midRef.get, ← SpiderM.liftIO lastRef.get)
+  mid ≡ #[0, 2, 4]
+  last ≡ #[0, 1, 2]
+
+test "disposing the scope detaches a fused filter and what derives from it" := do
+  let seen ← runSpider do
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let seenRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    let (positives, scope) ← SpiderM.withScope (Event.filterM (· > 0) source)
+    let doubled ← Event.mapM (· * 2) positives
+    let _ ← doubled.subscribe fun v => seenRef.modify (·.push v)
+    trigger 1
+    SpiderM.liftIO scope.dispose
+    trigger 2
+    SpiderM.liftIO seenRef.get
+  seen ≡ #[2]
+
+test "holdUniqM drops repeated values before they are queued" := do
+  let (updates, fires, value) ← runSpider do
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let held ← Dynamic.holdUniqM 0 source
+    let updatesRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    let _ ← held.updated.subscribe fun v => updatesRef.modify (·.push v)
+    let before ← queuedFires
+    for n in [1, 1, 2, 2, 2, 1] do
+      trigger n
+    let after ← queuedFires
+    pure (← SpiderM.liftIO updatesRef.get, after - before, ← SpiderM.liftIO held.sample)
+  updates ≡ #[1, 2, 1]
+  -- Six trigger fires, plus one per actual change
+  fires ≡ 6 + 3
+  value ≡ 1
+
+test "foldDynUniqM only fires when the state changes" := do
+  let updates ← runSpider do
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let best ← Dynamic.foldDynUniqM max 0 source
+    let updatesRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    let _ ← best.updated.subscribe fun v => updatesRef.modify (·.push v)
+    for n in [3, 1, 3, 5, 4] do
+      trigger n
+    SpiderM.liftIO updatesRef.get
+  updates ≡ #[3, 5]
+
+end ReactiveTests.FusionTests
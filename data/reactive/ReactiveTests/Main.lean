@@ -19,6 +19,8 @@ import ReactiveTests.TopologyTests
 import ReactiveTests.PerformanceTests
 import ReactiveTests.QueueBenchmarks
 import ReactiveTests.AsyncTests
+import ReactiveTests.ParallelPropagationTests
+import ReactiveTests.FusionTests
 
 open Crucible
 
@@ -0,0 +1,164 @@
+import Crucible
+import Reactive
+
+/-!
+# Parallel Propagation Tests
+
+`PropagationMode.parallel` runs the independent fires of one height on several
+threads. These tests check that a network observes exactly what it would in
+serial mode: same values, same merge bias, same error order.
+-/
+
+namespace ReactiveTests.ParallelPropagationTests
+
+open Crucible
+open Reactive
+open Reactive.Host
+
+testSuite "Parallel Propagation Tests"
+
+/-- Fan a source out to `width` mapped branches, each recording what it sees,
+    fire it `fires` times, and return every branch's history. -/
+def wideNetwork (mode : PropagationMode) (width fires : Nat) : IO (Array (Array Nat)) :=
+  runSpider do
+    SpiderM.setPropagationMode mode
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let mut refs := #[]
+    for i in [:width] do
+      let branch ← Event.mapM (· * (i + 1)) source
+      let ref ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+      let _ ← branch.subscribe fun v => ref.modify (·.push v)
+      refs := refs.push ref
+    for n in [:fires] do
+      trigger n
+    SpiderM.liftIO <| refs.mapM (·.get)
+
+test "parallel mode matches serial on a wide network" := do
+  let serial ← wideNetwork .serial 200 5
+  let parallel ← wideNetwork (.parallel 4 8) 200 5
+  parallel ≡ serial
+  serial[7]! ≡ #[0, 8, 16, 24, 32]
+
+test "merge keeps its left bias when its inputs fire in parallel" := do
+  let run (mode : PropagationMode) : IO (Array Nat × Nat) := runSpider do
+    SpiderM.setPropagationMode mode
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let left ← Event.mapM (· + 1) source
+    -- Filler branches make the level large enough to run in parallel
+    let countRef ← SpiderM.liftIO <| IO.mkRef (0 : Nat)
+    for _ in [:100] do
+      let filler ← Event.mapM id source
+      let _ ← filler.subscribe fun _ => countRef.modify (· + 1)
+    let right ← Event.mapM (· * 10) source
+    let merged ← Event.mergeM left right
+    let seenRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    let _ ← merged.subscribe fun v => seenRef.modify (·.push v)
+    trigger 1
+    trigger 2
+    pure (← SpiderM.liftIO seenRef.get, ← SpiderM.liftIO countRef.get)
+  let (seen, count) ← run (.parallel 4 2)
+  seen ≡ #[2, 3]
+  count ≡ 200
+  (← run .serial) ≡ (seen, count)
+
+test "zipE pairs values from branches that ran on different threads" := do
+  let run (mode : PropagationMode) : IO (Array (Nat × Nat)) := runSpider do
+    SpiderM.setPropagationMode mode
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let a ← Event.mapM (· + 1) source
+    for _ in [:50] do
+      let filler ← Event.mapM id source
+      let _ ← filler.subscribe fun _ => pure ()
+    let b ← Event.mapM (· + 2) source
+    let zipped ← Event.zipEM a b
+    let seenRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array (Nat × Nat))
+    let _ ← zipped.subscribe fun v => seenRef.modify (·.push v)
+    for n in [:3] do
+      trigger n
+    SpiderM.liftIO seenRef.get
+  (← run (.parallel 4 2)) ≡ #[(1, 2), (2, 3), (3, 4)]
+  (← run .serial) ≡ #[(1, 2), (2, 3), (3, 4)]
+
+test "triggers fired by parallel subscribers join the current frame" := do
+  let run (mode : PropagationMode) : IO (Array Nat) := runSpider do
+    SpiderM.setPropagationMode mode
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let (echo, fireEcho) ← newTriggerEvent (t := Spider) (a := Nat)
+    let seenRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    let _ ← echo.subscribe fun v => seenRef.modify (·.push v)
+    for i in [:20] do
+      let branch ← Event.mapM (· + i) source
+      let _ ← branch.subscribe fun v => if i == 19 then fireEcho v else pure ()
+    trigger 100
+    SpiderM.liftIO seenRef.get
+  (← run (.parallel 4 2)) ≡ #[119]
+  (← run .serial) ≡ #[119]
+
+test "errors reach the handler in serial order" := do
+  let run (mode : PropagationMode) : IO (Array String) := do
+    let errorsRef ← IO.mkRef (#[] : Array String)
+    let handler : PropagationErrorHandler := fun e => do
+      errorsRef.modify (·.push (toString e))
+      pure true
+    runSpiderWithErrorHandler (errorHandler := handler) do
+      SpiderM.setPropagationMode mode
+      let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+      for i in [:40] do
+        let branch ← Event.mapM id source
+        let _ ← branch.subscribe fun _ =>
+          if i % 10 == 3 then throw (IO.userError s!"branch {i}") else pure ()
+      trigger 0
+    errorsRef.get
+  let expected := #["branch 3", "branch 13", "branch 23", "branch 33"]
+  (← run (.parallel 4 2)) ≡ expected
+  (← run .serial) ≡ expected
+
+test "a tag sampling a hold updated at the same height sees serial values" := do
+  let run (mode : PropagationMode) : IO (Array Nat) := runSpider do
+    SpiderM.setPropagationMode mode
+    let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+    let seenRef ← SpiderM.liftIO <| IO.mkRef (#[] : Array Nat)
+    for i in [:40] do
+      -- Both branches sit at the same height; the hold's comes first
+      let writes ← Event.mapM (· + i) source
+      let total ← Behavior.hold 0 writes
+      let reads ← Event.mapM id source
+      let sampled ← Event.tagM total reads
+      let _ ← sampled.subscribe fun v => seenRef.modify (·.push v)
+    for n in [:5] do
+      trigger n
+    SpiderM.liftIO seenRef.get
+  let serial ← run .serial
+  serial.size ≡ 200
+  (← run (.parallel 4 2)) ≡ serial
+
+test "a fatal error stops the level before later fires run" := do
+  let run (mode : PropagationMode) : IO Nat := do
+    let ranRef ← IO.mkRef 0
+    try
+      runSpiderWithErrorHandler (errorHandler := strictErrorHandler) do
+        SpiderM.setPropagationMode mode
+        let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+        for i in [:200] do
+          let branch ← Event.mapM id source
+          let _ ← branch.subscribe fun _ =>
+            if i == 0 then throw (IO.userError "first branch") else ranRef.modify (· + 1)
+        trigger 0
+    catch _ =>
+      pure ()
+    ranRef.get
+  (← run .serial) ≡ 0
+  -- The failing fire is first in its chunk, so at least the rest of that
+  -- chunk never starts; other chunks may already be running
+  shouldSatisfy ((← run (.parallel 4 2)) < 199) "later fires were held back"
+
+test "popLevel takes every fire at the lowest height" := do
+  let queue ← PropagationQueue.new
+  for (h, n) in [(2, 5), (1, 4), (1, 2), (3, 1), (1, 7)] do
+    queue.insert { height := ⟨h⟩, nodeId := ⟨n⟩, fire := pure () }
+  let level ← queue.popLevel
+  (level.map (·.nodeId.id)) ≡ #[2, 4, 7]
+  let next ← queue.popLevel
+  (next.map (·.nodeId.id)) ≡ #[5]
+
+end ReactiveTests.ParallelPropagationTests
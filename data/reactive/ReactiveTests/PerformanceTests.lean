@@ -1088,4 +1088,90 @@ test "micro: IO.Ref.modify vs direct callback" := do
   IO.println s!"  [direct: {elapsed1}, with IO.Ref ops: {elapsed2}]"
 
 
+/-! ## Parallel Propagation Scaling -/
+
+/-- CPU-bound work for one subscriber callback. -/
+def spinWork (seed rounds : Nat) : Nat := Id.run do
+  let mut h := seed
+  for _ in [:rounds] do
+    h := (h * 1103515245 + 12345) % 2147483648
+  h
+
+test "perf: parallel propagation, 512 branches x 20 fires on 1/2/4/8 workers" := do
+  let mut baseline : Option Nat := none
+  for workers in [1, 2, 4, 8] do
+    let (checksum, elapsed) ← runSpider do
+      SpiderM.setPropagationMode (.parallel workers 16)
+      let (source, trigger) ← newTriggerEvent (t := Spider) (a := Nat)
+      let mut refs := #[]
+      for i in [:512] do
+        let branch ← Event.mapM (· + i) source
+        let ref ← SpiderM.liftIO <| IO.mkRef (0 : Nat)
+        let _ ← branch.subscribe fun v => ref.modify (· + spinWork v 2000)
+        refs := refs.push ref
+      let start ← SpiderM.liftIO Chronos.MonotonicTime.now
+      for n in [:20] do
+        trigger n
+      let elapsed ← SpiderM.liftIO start.elapsed
+      let totals ← SpiderM.liftIO <| refs.mapM (·.get)
+      pure (totals.foldl (· + ·) 0, elapsed)
+    -- Every worker count computes the same result
+    if let some expected := baseline then
+      checksum ≡ expected
+    else
+      baseline := some checksum
+    IO.println s!"  [parallel x{workers}: {elapsed}]"
+
+
+/-! ## Worker Pool Throughput -/
+
+/-- Push `jobs` no-op jobs through a pool in batches of 10k and wait (up to
+    two minutes) for them to complete. Returns how many completed. -/
+def runNoopJobs (label : String) (config : WorkerPoolConfig) (jobs : Nat) : IO Nat := runSpider do
+  let (cmdEvt, fireCmd) ← newTriggerEvent (t := Spider) (a := PoolCommand Nat Unit)
+  let (pool, handle) ← WorkerPool.fromCommandsWithShutdown config (fun (_ : Unit) => pure ()) cmdEvt
+  let doneRef ← SpiderM.liftIO <| IO.mkRef (0 : Nat)
+  let _ ← pool.completed.subscribe fun _ => doneRef.modify (· + 1)
+  SpiderM.liftIO do
+    let start ← Chronos.MonotonicTime.now
+    let mut next := 0
+    while next < jobs do
+      let count := min 10000 (jobs - next)
+      fireCmd (.submitBatch ((Array.range count).map fun i => (next + i, (), 0)))
+      next := next + count
+    let deadline := (← IO.monoMsNow) + 120000
+    while (← doneRef.get) < jobs && (← IO.monoMsNow) < deadline do
+      IO.sleep 1
+    let elapsed ← start.elapsed
+    IO.println s!"  [{label}: {elapsed}]"
+    handle.shutdown
+    doneRef.get
+
+/-- Whether to run the 1M job benchmark (`REACTIVE_BENCH_LARGE=1`). -/
+private def largeBenchEnabled : IO Bool := do
+  match (← IO.getEnv "REACTIVE_BENCH_LARGE") with
+  | some flag =>
+    let flag := flag.trim.toLower
+    return flag == "1" || flag == "true" || flag == "yes"
+  | none => return false
+
+test "perf: worker pool, 1M no-op jobs, work stealing on 1/2/4/8 workers" := do
+  if !(← largeBenchEnabled) then
+    IO.println "Skipping 1M job benchmark (set REACTIVE_BENCH_LARGE=1)."
+    return ()
+  for workers in [1, 2, 4, 8] do
+    let config : WorkerPoolConfig := { workerCount := workers, executor := .workStealing 1024 }
+    let done ← runNoopJobs s!"work stealing x{workers}" config 1000000
+    done ≡ 1000000
+
+-- Both executors publish a frame per job, and the shared queue also takes its
+-- mutex per job, so the default suite compares them on a small run
+test "perf: worker pool, 10k no-op jobs, shared queue vs work stealing" := do
+  for workers in [1, 2, 4, 8] do
+    let shared ← runNoopJobs s!"shared queue x{workers}" { workerCount := workers } 10000
+    shared ≡ 10000
+    let config : WorkerPoolConfig := { workerCount := workers, executor := .workStealing }
+    let stealing ← runNoopJobs s!"work stealing x{workers}" config 10000
+    stealing ≡ 10000
+
 end ReactiveTests.PerformanceTests
@@ -122,3 +122,117 @@ test "bench Drain Loop Sim 100" := do
   let elapsed ← start.elapsed
   IO.println s!"  [Drain Loop 100: {elapsed}]"
 
+
+/-! ## Bucket Queue vs Binary Heap
+
+`PropagationQueue` keeps one bucket per height. These benchmarks compare it
+against the binary min-heap it replaced, kept here as a reference. -/
+
+/-- Binary min-heap on (height, nodeId), as the propagation queue used to be. -/
+partial def refSiftUp (arr : Array PendingFire) (i : Nat) : Array PendingFire :=
+  if i == 0 then arr
+  else
+    let pi := (i - 1) / 2
+    if compare arr[i]! arr[pi]! == .lt then
+      refSiftUp ((arr.set! i arr[pi]!).set! pi arr[i]!) pi
+    else arr
+
+partial def refSiftDown (arr : Array PendingFire) (i : Nat) : Array PendingFire :=
+  let left := 2 * i + 1
+  let right := 2 * i + 2
+  let s1 := if left < arr.size && compare arr[left]! arr[i]! == .lt then left else i
+  let smallest := if right < arr.size && compare arr[right]! arr[s1]! == .lt then right else s1
+  if smallest != i then
+    refSiftDown ((arr.set! i arr[smallest]!).set! smallest arr[i]!) smallest
+  else arr
+
+def refHeapInsert (arr : Array PendingFire) (p : PendingFire) : Array PendingFire :=
+  let arr := arr.push p
+  refSiftUp arr (arr.size - 1)
+
+def refHeapPop? (arr : Array PendingFire) : Option PendingFire × Array PendingFire :=
+  match arr[0]? with
+  | none => (none, arr)
+  | some minElem =>
+    let last := arr.back!
+    let arr := arr.pop
+    if arr.isEmpty then (some minElem, arr)
+    else (some minElem, refSiftDown (arr.set! 0 last) 0)
+
+/-- `n` fires spread over 32 heights, with nodeIds out of order. -/
+def benchFires (n : Nat) : Array PendingFire :=
+  (Array.range n).map fun i =>
+    { height := ⟨i % 32⟩, nodeId := ⟨(i * 7919) % n⟩, fire := pure () }
+
+/-- Insert every fire, then pop them all. Returns the pop order and the time
+    taken by the bucket queue and by the reference heap. -/
+def compareQueues (fires : Array PendingFire)
+    : IO (Array (Nat × Nat) × Array (Nat × Nat) × Chronos.Duration × Chronos.Duration) := do
+  let queue ← PropagationQueue.new
+  queue.setInFrame true
+  let bucketStart ← Chronos.MonotonicTime.now
+  for p in fires do
+    queue.insert p
+  let mut bucketOrder : Array (Nat × Nat) := Array.mkEmpty fires.size
+  repeat
+    match ← queue.popMin? with
+    | some p => bucketOrder := bucketOrder.push (p.height.value, p.nodeId.id)
+    | none => break
+  let bucketElapsed ← bucketStart.elapsed
+
+  let heapRef ← IO.mkRef (#[] : Array PendingFire)
+  let heapStart ← Chronos.MonotonicTime.now
+  for p in fires do
+    heapRef.modify (refHeapInsert · p)
+  let mut heapOrder : Array (Nat × Nat) := Array.mkEmpty fires.size
+  repeat
+    match ← heapRef.modifyGet refHeapPop? with
+    | some p => heapOrder := heapOrder.push (p.height.value, p.nodeId.id)
+    | none => break
+  let heapElapsed ← heapStart.elapsed
+  return (bucketOrder, heapOrder, bucketElapsed, heapElapsed)
+
+test "bench bucket queue vs heap 100" := do
+  let (bucketOrder, heapOrder, bucket, heap) ← compareQueues (benchFires 100)
+  bucketOrder ≡ heapOrder
+  IO.println s!"  [Bucket 100: {bucket}, Heap 100: {heap}]"
+
+test "bench bucket queue vs heap 10000" := do
+  let (bucketOrder, heapOrder, bucket, heap) ← compareQueues (benchFires 10000)
+  bucketOrder ≡ heapOrder
+  IO.println s!"  [Bucket 10k: {bucket}, Heap 10k: {heap}]"
+
+test "bench bucket queue vs heap 1000000" := do
+  let (bucketOrder, heapOrder, bucket, heap) ← compareQueues (benchFires 1000000)
+  bucketOrder.size ≡ 1000000
+  bucketOrder ≡ heapOrder
+  IO.println s!"  [Bucket 1M: {bucket}, Heap 1M: {heap}]"
+
+test "bench bucket queue drain by level 1000000" := do
+  let queue ← PropagationQueue.new
+  queue.setInFrame true
+  let start ← Chronos.MonotonicTime.now
+  for p in benchFires 1000000 do
+    queue.insert p
+  let mut levels := 0
+  let mut total := 0
+  repeat
+    let level ← queue.popLevel
+    if level.isEmpty then break
+    levels := levels + 1
+    total := total + level.size
+  let elapsed ← start.elapsed
+  levels ≡ 32
+  total ≡ 1000000
+  IO.println s!"  [Bucket popLevel 1M: {elapsed}]"
+
+test "fires of one node pop in the order they were queued" := do
+  let queue ← PropagationQueue.new
+  let log ← IO.mkRef (#[] : Array Nat)
+  for (n, tag) in [(5, 1), (3, 2), (5, 3), (3, 4)] do
+    queue.insert { height := ⟨1⟩, nodeId := ⟨n⟩, fire := log.modify (·.push tag) }
+  repeat
+    match ← queue.popMin? with
+    | some p => p.fire
+    | none => break
+  (← log.get) ≡ #[2, 4, 1, 3]
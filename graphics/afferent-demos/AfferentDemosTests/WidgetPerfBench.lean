@@ -344,6 +344,26 @@ private def runBench (render : ComponentRender) (inputs : ReactiveInputs)
     hoverMs := avg accum.hoverMs frames
   }
 
+/-- Size of the reactive network and the fires its frames queued. -/
+private structure ReactiveStats where
+  nodes : Nat
+  queuedFires : Nat
+  frames : Nat
+
+private def ReactiveStats.format (label : String) (s : ReactiveStats) : String :=
+  let perFrame := if s.frames == 0 then 0.0 else s.queuedFires.toFloat / s.frames.toFloat
+  s!"{label}: reactive nodes={s.nodes}, queued fires={s.queuedFires} ({fmtMs perFrame}/frame)"
+
+/-- `runBench` on an app, also reporting its reactive network. -/
+private def runBenchApp (app : BenchApp) (registry : FontRegistry) (config : BenchConfig)
+    : IO (BenchResult × ReactiveStats) := do
+  let before ← app.spiderEnv.propagationQueue.queuedCount
+  let result ← runBench app.render app.inputs registry app.registry config
+  let after ← app.spiderEnv.propagationQueue.queuedCount
+  let nodes ← app.spiderEnv.timelineCtx.nodeCount
+  let frames := config.warmupFrames + config.sampleFrames
+  pure (result, { nodes, queuedFires := after - before, frames })
+
 open Crucible
 
 testSuite "WidgetPerf Bench"
@@ -361,11 +381,11 @@ test "switch pipeline baseline vs hover" := do
   try
     HoverMetrics.reset hoverMetrics
     DynWidgetMetrics.reset dynMetrics
-    let baseline ← runBench appBaseline.render appBaseline.inputs assets.registry appBaseline.registry baseConfig
+    let (baseline, baselineStats) ← runBenchApp appBaseline assets.registry baseConfig
 
     HoverMetrics.reset hoverMetrics
     DynWidgetMetrics.reset dynMetrics
-    let hover ← runBench appHover.render appHover.inputs assets.registry appHover.registry hoverConfig
+    let (hover, hoverStats) ← runBenchApp appHover assets.registry hoverConfig
     let delta := BenchResult.diff baseline hover
     let hoverSnap ← HoverMetrics.snapshot hoverMetrics
     let dynSnap ← DynWidgetMetrics.snapshot dynMetrics
@@ -373,6 +393,8 @@ test "switch pipeline baseline vs hover" := do
     IO.println (BenchResult.format "baseline" baseline)
     IO.println (BenchResult.format "hover" hover)
     IO.println (BenchResult.format "delta(hover-baseline)" delta)
+    IO.println (ReactiveStats.format "reactive baseline" baselineStats)
+    IO.println (ReactiveStats.format "reactive hover" hoverStats)
     IO.println s!"hover map: total={fmtNanosMs hoverSnap.mapNanos}ms, avg={fmtAvgNanosMs hoverSnap.mapNanos hoverSnap.mapCount}ms, count={hoverSnap.mapCount}"
     IO.println s!"hover map (switch): total={fmtNanosMs hoverSnap.mapSwitchNanos}ms, avg={fmtAvgNanosMs hoverSnap.mapSwitchNanos hoverSnap.mapSwitchCount}ms, count={hoverSnap.mapSwitchCount}"
     IO.println s!"hover update: total={fmtNanosMs hoverSnap.holdNanos}ms, avg={fmtAvgNanosMs hoverSnap.holdNanos hoverSnap.holdCount}ms, count={hoverSnap.holdCount}"
@@ -396,13 +418,15 @@ test "dropdown pipeline baseline vs hover" := do
   let hoverConfig : BenchConfig := { withHover := true }
 
   try
-    let baseline ← runBench appBaseline.render appBaseline.inputs assets.registry appBaseline.registry baseConfig
-    let hover ← runBench appHover.render appHover.inputs assets.registry appHover.registry hoverConfig
+    let (baseline, baselineStats) ← runBenchApp appBaseline assets.registry baseConfig
+    let (hover, hoverStats) ← runBenchApp appHover assets.registry hoverConfig
     let delta := BenchResult.diff baseline hover
 
     IO.println (BenchResult.format "baseline (dropdown)" baseline)
     IO.println (BenchResult.format "hover (dropdown)" hover)
     IO.println (BenchResult.format "delta(hover-baseline) (dropdown)" delta)
+    IO.println (ReactiveStats.format "reactive baseline (dropdown)" baselineStats)
+    IO.println (ReactiveStats.format "reactive hover (dropdown)" hoverStats)
 
     ensureTargetCountsStable "dropdown" baseline hover 200
   finally
@@ -419,13 +443,15 @@ test "stepper pipeline baseline vs hover" := do
   let hoverConfig : BenchConfig := { withHover := true }
 
   try
-    let baseline ← runBench appBaseline.render appBaseline.inputs assets.registry appBaseline.registry baseConfig
-    let hover ← runBench appHover.render appHover.inputs assets.registry appHover.registry hoverConfig
+    let (baseline, baselineStats) ← runBenchApp appBaseline assets.registry baseConfig
+    let (hover, hoverStats) ← runBenchApp appHover assets.registry hoverConfig
     let delta := BenchResult.diff baseline hover
 
     IO.println (BenchResult.format "baseline (stepper)" baseline)
     IO.println (BenchResult.format "hover (stepper)" hover)
     IO.println (BenchResult.format "delta(hover-baseline) (stepper)" delta)
+    IO.println (ReactiveStats.format "reactive baseline (stepper)" baselineStats)
+    IO.println (ReactiveStats.format "reactive hover (stepper)" hoverStats)
 
     ensureTargetCountsStable "stepper" baseline hover 1000
   finally
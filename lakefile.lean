@@ -521,6 +521,36 @@ lean_exe tracker_bench where
   root := `TrackerBench.Main
   moreLinkArgs := terminalUiLinkArgs
 
+lean_exe citadel_load_bench where
+  srcDir := "web/citadel/examples"
+  root := `LoadBench
+  moreLinkArgs := #[
+    ".native-libs/lib/libjack_native.a",
+    ".native-libs/lib/libcitadel_native.a",
+    "-L/opt/homebrew/lib",
+    "-L/opt/homebrew/opt/openssl@3/lib",
+    "-lssl",
+    "-lcrypto"
+  ]
+
+lean_exe stencil_bench where
+  srcDir := "web/stencil"
+  root := `Bench.Main
+
+lean_exe quarry_bench where
+  srcDir := "data/quarry"
+  root := `QuarryBench.Main
+  moreLinkArgs := #[
+    ".native-libs/lib/libquarry_native.a"
+  ]
+
+lean_exe conduit_bench where
+  srcDir := "util/conduit"
+  root := `ConduitBench.Main
+  moreLinkArgs := #[
+    ".native-libs/lib/libconduit_native.a"
+  ]
+
 lean_exe twenty48 where
   srcDir := "apps/twenty48"
   root := `Twenty48.Main
@@ -7,5 +7,7 @@ import Jack.Types
 import Jack.Address
 import Jack.Socket
 import Jack.Poll
+import Jack.Poller
 import Jack.Options
 import Jack.Async
+import Jack.Ring
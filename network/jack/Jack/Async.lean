@@ -1,11 +1,14 @@
 /-
   Jack Async Interface
-  Async-friendly API built on non-blocking sockets and Poll.wait.
+  Async-friendly API built on non-blocking sockets. A single manager thread
+  keeps waiters registered on a `Poller`, adding, modifying and removing
+  registrations as waiters come and go, so each wakeup costs O(ready) rather
+  than O(waiting).
 -/
 import Jack.Socket
 import Jack.Poll
+import Jack.Poller
 import Std.Data.HashMap
-import Std.Sync.Channel
 import Std.Sync.Mutex
 
 namespace Jack
@@ -22,114 +25,184 @@ structure CancelHandle where
   cancel : IO Unit
 
 private structure Waiter where
-  socket : Socket
-  events : Array PollEvent
+  mask : UInt16
   promise : IO.Promise (Except WaitError (Array PollEvent))
 
 private inductive Command where
-  | add (id : UInt64) (waiter : Waiter)
+  | add (id : UInt64) (socket : Socket) (waiter : Waiter)
   | cancel (id : UInt64)
+  | stop
 
 private structure Manager where
-  chan : Std.CloseableChannel.Sync Command
+  queue : Std.Mutex (Array Command)
+  wakeTx : Socket
   nextId : Std.Mutex UInt64
   worker : Task (Except IO.Error Unit)
 
-private structure EntryAgg where
+/-- Registration of one descriptor on the poller, with the waiters it serves.
+    The poller token is the descriptor itself. -/
+private structure Watch where
   socket : Socket
   mask : UInt16
-
-private def mergeMasks (a b : UInt16) : UInt16 :=
-  a ||| b
-
-private def buildEntries (pending : Std.HashMap UInt64 Waiter) : Array PollEntry := Id.run do
-  let mut agg : Std.HashMap UInt32 EntryAgg := {}
-  for (_, waiter) in pending.toList do
-    let fd := waiter.socket.fd
-    let mask := PollEvent.arrayToMask waiter.events
-    match agg.get? fd with
-    | some entry =>
-        agg := agg.insert fd { entry with mask := mergeMasks entry.mask mask }
-    | none =>
-        agg := agg.insert fd { socket := waiter.socket, mask }
-  let mut entries : Array PollEntry := #[]
-  for (_, entry) in agg.toList do
-    entries := entries.push { socket := entry.socket, events := PollEvent.maskToArray entry.mask }
-  return entries
-
-private def handleCommand
-    (pending : Std.HashMap UInt64 Waiter)
-    (cmd : Command) : IO (Std.HashMap UInt64 Waiter) := do
-  match cmd with
-  | .add id waiter =>
-      return pending.insert id waiter
-  | .cancel id =>
-      if let some waiter := pending.get? id then
-        waiter.promise.resolve (.error .canceled)
-      return pending.erase id
-
-private def drainCommands
-    (pending : Std.HashMap UInt64 Waiter)
-    (chan : Std.CloseableChannel.Sync Command) : IO (Std.HashMap UInt64 Waiter) := do
-  let mut pending := pending
-  let mut cmd? ← chan.tryRecv
-  while cmd?.isSome do
-    match cmd? with
-    | some cmd =>
-        pending ← handleCommand pending cmd
-    | none => pure ()
-    cmd? ← chan.tryRecv
-  return pending
-
-private def resolveReady
-    (pending : Std.HashMap UInt64 Waiter)
-    (results : Array PollResult) : IO (Std.HashMap UInt64 Waiter) := do
-  let mut eventMap : Std.HashMap UInt32 UInt16 := {}
-  for res in results do
-    let mask := PollEvent.arrayToMask res.events
-    eventMap := eventMap.insert res.socket.fd mask
-  let mut pending := pending
-  for (id, waiter) in pending.toList do
-    match eventMap.get? waiter.socket.fd with
-    | some mask =>
-        let requested := PollEvent.arrayToMask waiter.events
-        let matched := mask &&& requested
-        if matched != 0 then
-          waiter.promise.resolve (.ok (PollEvent.maskToArray matched))
-          pending := pending.erase id
-    | none => pure ()
-  return pending
-
-private def resolveAll
-    (pending : Std.HashMap UInt64 Waiter)
-    (err : WaitError) : IO Unit := do
-  for (_, waiter) in pending.toList do
-    waiter.promise.resolve (.error err)
-
-private partial def managerLoop (chan : Std.CloseableChannel.Sync Command) : IO Unit := do
-  let rec loop (pending : Std.HashMap UInt64 Waiter) : IO Unit := do
-    if pending.isEmpty then
-      let cmd? ← chan.recv
-      match cmd? with
-      | none =>
-          resolveAll pending .shutdown
-          return ()
-      | some cmd =>
-          let pending ← handleCommand pending cmd
-          loop pending
+  waiters : Array (UInt64 × Waiter)
+
+/-- Manager-thread state. Waiters are indexed by descriptor so a readiness
+    event or command only touches the registrations it concerns. -/
+private structure State where
+  poller : Poller
+  watches : Std.HashMap UInt32 Watch := {}
+  owners : Std.HashMap UInt64 UInt32 := {}
+
+private def combinedMask (waiters : Array (UInt64 × Waiter)) : UInt16 :=
+  waiters.foldl (fun acc (_, w) => acc ||| w.mask) 0
+
+/-- Drop the watch on `fd`, reporting an error to each of its waiters. -/
+private def failWatch (st : State) (fd : UInt32) (waiters : Array (UInt64 × Waiter)) : IO State := do
+  let mut owners := st.owners
+  for (id, waiter) in waiters do
+    waiter.promise.resolve (.ok #[.error])
+    owners := owners.erase id
+  return { st with watches := st.watches.erase fd, owners }
+
+/-- Register `watch` on the poller under `fd`. Modifies the existing
+    registration, or adds one if the poller has none (epoll drops a
+    descriptor's registration when it is closed). If neither works the
+    waiters are failed. -/
+private def register (st : State) (fd : UInt32) (watch : Watch) : IO State := do
+  let ok ← try
+      st.poller.modifyFd fd watch.mask fd.toUInt64
+      pure true
+    catch _ =>
+      try
+        st.poller.addFd fd watch.mask fd.toUInt64
+        pure true
+      catch _ =>
+        pure false
+  if ok then
+    return { st with watches := st.watches.insert fd watch }
+  failWatch st fd watch.waiters
+
+/-- Bring the poller registration for `fd` in line with its remaining waiters. -/
+private def sync (st : State) (fd : UInt32) (watch : Watch) (waiters : Array (UInt64 × Waiter))
+    : IO State := do
+  if waiters.isEmpty then
+    try st.poller.removeFd fd catch _ => pure ()
+    return { st with watches := st.watches.erase fd }
+  let mask := combinedMask waiters
+  if mask != watch.mask then
+    register st fd { watch with mask, waiters }
+  else
+    return { st with watches := st.watches.insert fd { watch with waiters } }
+
+private def addWaiter (st : State) (id : UInt64) (socket : Socket) (waiter : Waiter) : IO State := do
+  let fd := socket.fd
+  let mut st := { st with owners := st.owners.insert id fd }
+  if let some watch := st.watches.get? fd then
+    if watch.socket.same socket then
+      return ← sync st fd watch (watch.waiters.push (id, waiter))
+    -- The descriptor number was reused: closing the old socket dropped its
+    -- registration, so its waiters would never see an event
+    st ← failWatch st fd watch.waiters
+  try
+    st.poller.addFd fd waiter.mask fd.toUInt64
+    let watch : Watch := { socket, mask := waiter.mask, waiters := #[(id, waiter)] }
+    return { st with watches := st.watches.insert fd watch }
+  catch _ =>
+    -- Descriptor cannot be watched (closed or unsupported): report it as an error
+    waiter.promise.resolve (.ok #[.error])
+    return { st with owners := st.owners.erase id }
+
+private def cancelWaiter (st : State) (id : UInt64) : IO State := do
+  let some fd := st.owners.get? id | return st
+  let st := { st with owners := st.owners.erase id }
+  let some watch := st.watches.get? fd | return st
+  let mut rest := #[]
+  for (wid, waiter) in watch.waiters do
+    if wid == id then
+      waiter.promise.resolve (.error .canceled)
+    else
+      rest := rest.push (wid, waiter)
+  sync st fd watch rest
+
+/-- Resolve the waiters on `fd` whose requested events are in the ready mask. -/
+private def resolveReady (st : State) (fd : UInt32) (ready : UInt16) : IO State := do
+  let some watch := st.watches.get? fd | return st
+  let mut st := st
+  let mut rest := #[]
+  for (id, waiter) in watch.waiters do
+    let matched := ready &&& waiter.mask
+    if matched != 0 then
+      waiter.promise.resolve (.ok (PollEvent.maskToArray matched))
+      st := { st with owners := st.owners.erase id }
     else
-      let pending ← drainCommands pending chan
-      let entries := buildEntries pending
-      let results ← Poll.wait entries 100
-      let pending ← resolveReady pending results
-      loop pending
-  loop {}
+      rest := rest.push (id, waiter)
+  sync st fd watch rest
+
+private def resolveAll (st : State) (err : WaitError) : IO Unit := do
+  for (_, watch) in st.watches.toList do
+    for (_, waiter) in watch.waiters do
+      waiter.promise.resolve (.error err)
+
+/-- Discard pending wakeup bytes. -/
+private partial def drainWake (wakeRx : Socket) : IO Unit := do
+  match ← wakeRx.recvTry 512 with
+  | .ok data => if data.isEmpty then pure () else drainWake wakeRx
+  | _ => pure ()
+
+/-- Apply queued commands, reporting whether a stop was requested. -/
+private def drainCommands (st : State) (queue : Std.Mutex (Array Command)) : IO (State × Bool) := do
+  let cmds ← queue.atomically do
+    let cmds ← get
+    set (#[] : Array Command)
+    return cmds
+  let mut st := st
+  let mut stop := false
+  for cmd in cmds do
+    match cmd with
+    | .add id socket waiter => st ← addWaiter st id socket waiter
+    | .cancel id => st ← cancelWaiter st id
+    | .stop => stop := true
+  return (st, stop)
+
+private partial def managerLoop (poller : Poller) (wakeRx : Socket) (queue : Std.Mutex (Array Command))
+    : IO Unit := do
+  let wakeFd := wakeRx.fd
+  let rec loop (st : State) : IO Unit := do
+    let events ← poller.wait 256 (-1)
+    let mut st := st
+    for ev in events do
+      if ev.token == wakeFd.toUInt64 then
+        drainWake wakeRx
+      else
+        st ← resolveReady st ev.token.toUInt32 ev.mask
+    let (st, stop) ← drainCommands st queue
+    if stop then
+      resolveAll st .shutdown
+      poller.close
+      wakeRx.close
+    else
+      loop st
+  loop { poller }
 
 private def startManager : IO Manager := do
-  let chan ← Std.CloseableChannel.Sync.new
+  let poller ← Poller.new
+  let (wakeRx, wakeTx) ← Socket.pair .unix .stream .default
+  wakeRx.setNonBlocking true
+  wakeTx.setNonBlocking true
+  poller.addFd wakeRx.fd PollEvent.readable.toBit wakeRx.fd.toUInt64
+  let queue ← Std.Mutex.new (#[] : Array Command)
   let nextId ← Std.Mutex.new 1
-  let worker ← (managerLoop chan).asTask Task.Priority.dedicated
-  return { chan, nextId, worker }
+  let worker ← (managerLoop poller wakeRx queue).asTask Task.Priority.dedicated
+  return { queue, wakeTx, nextId, worker }
+
+/-- Queue a command, waking the manager when the queue was empty. -/
+private def submit (manager : Manager) (cmd : Command) : IO Unit := do
+  let wasEmpty ← manager.queue.atomically do
+    let cmds ← get
+    set (cmds.push cmd)
+    return cmds.isEmpty
+  if wasEmpty then
+    let _ ← manager.wakeTx.sendTry (ByteArray.mk #[1])
 
 initialize managerRef : IO.Ref (Option Manager) ← IO.mkRef none
 initialize managerMutex : Std.Mutex Unit ← Std.Mutex.new ()
@@ -157,9 +230,9 @@ def shutdown : IO Unit := do
   | none => pure ()
   | some m =>
       try
-        let _ ← Std.CloseableChannel.Sync.close m.chan
-        let _ := m.worker.get
-        pure ()
+        submit m .stop
+        let _ ← IO.wait m.worker
+        m.wakeTx.close
       catch _ =>
         pure ()
 
@@ -174,12 +247,10 @@ def awaitEventsCancelable
     set (current + 1)
     return current
   let promise : IO.Promise (Except WaitError (Array PollEvent)) ← IO.Promise.new
-  let waiter : Waiter := { socket := sock, events := events, promise := promise }
-  let _ ← Std.CloseableChannel.Sync.send manager.chan (.add id waiter)
+  let waiter : Waiter := { mask := PollEvent.arrayToMask events, promise := promise }
+  submit manager (.add id sock waiter)
   let cancel : CancelHandle := {
-    cancel := do
-      let _ ← Std.CloseableChannel.Sync.send manager.chan (.cancel id)
-      pure ()
+    cancel := submit manager (.cancel id)
   }
   let task : Task (Except WaitError (Array PollEvent)) := promise.result!
   return (task, cancel)
@@ -0,0 +1,135 @@
+/-
+  Jack Poller
+  Persistent readiness registration backed by epoll (Linux), kqueue (macOS/BSD),
+  or a poll(2) registration table elsewhere. Registrations are level-triggered
+  by default; `edge := true` requests edge-triggered delivery (EPOLLET /
+  EV_CLEAR), which the poll(2) fallback ignores.
+-/
+import Jack.Socket
+import Jack.Poll
+
+namespace Jack
+
+/-- Opaque readiness poller handle -/
+opaque PollerPointed : NonemptyType
+def Poller : Type := PollerPointed.type
+instance : Nonempty Poller := PollerPointed.property
+
+/-- A single readiness notification: the token given at registration and the ready mask -/
+structure PollerEvent where
+  token : UInt64
+  mask : UInt16
+  deriving Repr, BEq, Inhabited
+
+namespace PollerEvent
+
+/-- Ready events as `PollEvent`s -/
+def events (e : PollerEvent) : Array PollEvent := PollEvent.maskToArray e.mask
+
+def isReadable (e : PollerEvent) : Bool := e.mask &&& PollEvent.readable.toBit != 0
+def isWritable (e : PollerEvent) : Bool := e.mask &&& PollEvent.writable.toBit != 0
+def isError (e : PollerEvent) : Bool := e.mask &&& PollEvent.error.toBit != 0
+def isHangup (e : PollerEvent) : Bool := e.mask &&& PollEvent.hangup.toBit != 0
+
+end PollerEvent
+
+/-- Batch of readiness notifications, packed as 12-byte records
+    (token: u64 little-endian, mask: u32 little-endian). -/
+structure PollerEvents where
+  data : ByteArray
+
+namespace PollerEvents
+
+/-- Size in bytes of one packed record -/
+def recordSize : Nat := 12
+
+/-- Number of notifications in the batch -/
+def size (evs : PollerEvents) : Nat := evs.data.size / recordSize
+
+def isEmpty (evs : PollerEvents) : Bool := evs.size == 0
+
+private def readLE (data : ByteArray) (off width : Nat) : UInt64 := Id.run do
+  let mut v : UInt64 := 0
+  for k in [:width] do
+    v := v ||| ((data.get! (off + k)).toUInt64 <<< (8 * k).toUInt64)
+  return v
+
+/-- Token of the i-th notification -/
+def token (evs : PollerEvents) (i : Nat) : UInt64 :=
+  readLE evs.data (i * recordSize) 8
+
+/-- Ready mask of the i-th notification -/
+def mask (evs : PollerEvents) (i : Nat) : UInt16 :=
+  (readLE evs.data (i * recordSize + 8) 4).toUInt16
+
+/-- Decode the i-th notification -/
+def get (evs : PollerEvents) (i : Nat) : PollerEvent :=
+  { token := evs.token i, mask := evs.mask i }
+
+def toArray (evs : PollerEvents) : Array PollerEvent :=
+  (Array.range evs.size).map evs.get
+
+instance : ForIn m PollerEvents PollerEvent where
+  forIn evs init f := do
+    let mut acc := init
+    for i in [:evs.size] do
+      match ← f (evs.get i) acc with
+      | .done a => return a
+      | .yield a => acc := a
+    return acc
+
+end PollerEvents
+
+namespace Poller
+
+/-- Create a new poller -/
+@[extern "jack_poller_new"]
+opaque new : IO Poller
+
+/-- Name of the compiled-in backend: "epoll", "kqueue" or "poll" -/
+@[extern "jack_poller_backend"]
+opaque backend : IO String
+
+/-- Register a file descriptor with an interest mask (PollEvent bits) and token -/
+@[extern "jack_poller_add"]
+opaque addFd (poller : @& Poller) (fd : UInt32) (mask : UInt16) (token : UInt64) (edge : Bool := false) : IO Unit
+
+/-- Replace the interest mask and token of a registered file descriptor -/
+@[extern "jack_poller_modify"]
+opaque modifyFd (poller : @& Poller) (fd : UInt32) (mask : UInt16) (token : UInt64) (edge : Bool := false) : IO Unit
+
+/-- Remove a file descriptor from the poller -/
+@[extern "jack_poller_remove"]
+opaque removeFd (poller : @& Poller) (fd : UInt32) : IO Unit
+
+/-- Wait for readiness, returning up to maxEvents packed records.
+    timeoutMs: -1 for infinite wait, 0 for immediate return, >0 for milliseconds -/
+@[extern "jack_poller_wait"]
+opaque waitRaw (poller : @& Poller) (maxEvents : UInt32) (timeoutMs : Int32) : IO ByteArray
+
+/-- Close the poller. Registered sockets are not closed. -/
+@[extern "jack_poller_close"]
+opaque close (poller : Poller) : IO Unit
+
+/-- Register a socket for the given events under a token -/
+def add (poller : @& Poller) (sock : @& Socket) (events : Array PollEvent) (token : UInt64)
+    (edge : Bool := false) : IO Unit :=
+  poller.addFd sock.fd (PollEvent.arrayToMask events) token edge
+
+/-- Change the events a registered socket is watched for -/
+def modify (poller : @& Poller) (sock : @& Socket) (events : Array PollEvent) (token : UInt64)
+    (edge : Bool := false) : IO Unit :=
+  poller.modifyFd sock.fd (PollEvent.arrayToMask events) token edge
+
+/-- Stop watching a socket. Must be called before the socket is closed. -/
+def remove (poller : @& Poller) (sock : @& Socket) : IO Unit :=
+  poller.removeFd sock.fd
+
+/-- Wait for readiness on registered sockets -/
+def wait (poller : @& Poller) (maxEvents : UInt32 := 256) (timeoutMs : Int32 := -1) : IO PollerEvents := do
+  let data ← poller.waitRaw maxEvents timeoutMs
+  return { data }
+
+end Poller
+
+end Jack
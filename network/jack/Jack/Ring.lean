@@ -0,0 +1,143 @@
+/-
+  Jack Ring
+  Batched socket I/O: prepare many recv/send/accept/sendfile operations, then
+  submit them and reap their completions with one call. Uses io_uring on Linux
+  (registered buffers and fixed files included) and falls back to
+  non-blocking attempts parked on poll(2) when io_uring is unavailable.
+-/
+import Jack.Socket
+
+namespace Jack
+
+/-- Opaque batch I/O ring handle -/
+opaque RingPointed : NonemptyType
+def Ring : Type := RingPointed.type
+instance : Nonempty Ring := RingPointed.property
+
+/-- Result of one ring operation -/
+structure RingCompletion where
+  /-- Value given when the operation was prepared -/
+  userData : UInt64
+  /-- Bytes transferred, the accepted descriptor, or a negated errno -/
+  result : Int32
+  /-- Received bytes (plain `recv` only; registered-buffer receives stay in the buffer) -/
+  data : ByteArray
+  deriving Inhabited
+
+namespace RingCompletion
+
+def isOk (c : RingCompletion) : Bool := c.result >= 0
+
+/-- Positive errno of a failed operation -/
+def errno? (c : RingCompletion) : Option UInt32 :=
+  if c.result < 0 then some (-c.result.toInt).toNat.toUInt32 else none
+
+/-- Byte count or accepted descriptor of a successful operation -/
+def value (c : RingCompletion) : Nat := c.result.toInt.toNat
+
+end RingCompletion
+
+/-- Take ownership of a descriptor (e.g. from a ring accept) as a Socket -/
+@[extern "jack_socket_adopt_fd"]
+opaque Socket.adoptFd (fd : UInt32) : IO Socket
+
+namespace Ring
+
+/-- Create a ring sized for `entries` submissions per batch.
+    `forcePoll` skips io_uring and uses the poll(2) fallback. -/
+@[extern "jack_ring_new"]
+opaque new (entries : UInt32 := 256) (forcePoll : Bool := false) : IO Ring
+
+/-- Active backend: "io_uring" or "poll" -/
+@[extern "jack_ring_backend"]
+opaque backend (ring : @& Ring) : IO String
+
+/-- Queue a receive of up to maxBytes; the bytes arrive in `RingCompletion.data`.
+    With `fixed`, fd is an index into the registered file table. -/
+@[extern "jack_ring_prep_recv"]
+opaque prepRecv (ring : @& Ring) (fd : UInt32) (maxBytes : UInt32) (fixed : Bool) (userData : UInt64) : IO Unit
+
+/-- Queue a send of data (may complete partially, like `send`) -/
+@[extern "jack_ring_prep_send"]
+opaque prepSend (ring : @& Ring) (fd : UInt32) (data : @& ByteArray) (fixed : Bool) (userData : UInt64) : IO Unit
+
+/-- Queue an accept; the result is the new descriptor (see `Socket.adoptFd`) -/
+@[extern "jack_ring_prep_accept"]
+opaque prepAccept (ring : @& Ring) (fd : UInt32) (fixed : Bool) (userData : UInt64) : IO Unit
+
+/-- Queue one sendfile step of up to count bytes from fileFd at offset -/
+@[extern "jack_ring_prep_send_file"]
+opaque prepSendFile (ring : @& Ring) (fd : UInt32) (fileFd : UInt32) (offset : UInt64) (count : UInt32)
+    (fixed : Bool) (userData : UInt64) : IO Unit
+
+/-- Queue a receive of up to len bytes into registered buffer bufIndex -/
+@[extern "jack_ring_prep_recv_buffer"]
+opaque prepRecvBuffer (ring : @& Ring) (fd : UInt32) (bufIndex : UInt32) (len : UInt32) (fixed : Bool)
+    (userData : UInt64) : IO Unit
+
+/-- Queue a send of the first len bytes of registered buffer bufIndex -/
+@[extern "jack_ring_prep_send_buffer"]
+opaque prepSendBuffer (ring : @& Ring) (fd : UInt32) (bufIndex : UInt32) (len : UInt32) (fixed : Bool)
+    (userData : UInt64) : IO Unit
+
+/-- Allocate and register count buffers of size bytes (once per ring) -/
+@[extern "jack_ring_register_buffers"]
+opaque registerBuffers (ring : @& Ring) (count : UInt32) (size : UInt32) : IO Unit
+
+/-- Copy len bytes out of a registered buffer -/
+@[extern "jack_ring_read_buffer"]
+opaque readBuffer (ring : @& Ring) (bufIndex : UInt32) (len : UInt32) : IO ByteArray
+
+/-- Copy data into a registered buffer (truncated to the buffer size); returns bytes written -/
+@[extern "jack_ring_write_buffer"]
+opaque writeBuffer (ring : @& Ring) (bufIndex : UInt32) (data : @& ByteArray) : IO UInt32
+
+/-- Register a fixed-file table (once per ring) for operations with `fixed := true` -/
+@[extern "jack_ring_register_files"]
+opaque registerFiles (ring : @& Ring) (fds : @& Array UInt32) : IO Unit
+
+/-- Submit prepared operations without waiting; returns how many were submitted -/
+@[extern "jack_ring_submit"]
+opaque submit (ring : @& Ring) : IO UInt32
+
+/-- Submit prepared operations and wait until at least minComplete finish.
+    timeoutMs: -1 for infinite wait, 0 for immediate return, >0 for milliseconds -/
+@[extern "jack_ring_wait"]
+opaque submitAndWait (ring : @& Ring) (minComplete : UInt32 := 1) (timeoutMs : Int32 := -1) : IO (Array RingCompletion)
+
+/-- Close the ring, cancelling outstanding operations. Sockets are not closed. -/
+@[extern "jack_ring_close"]
+opaque close (ring : Ring) : IO Unit
+
+/-- Open a file read-only for `prepSendFile`, returning its descriptor -/
+@[extern "jack_fd_open"]
+opaque openFile (path : @& String) : IO UInt32
+
+/-- Close a descriptor returned by `openFile` -/
+@[extern "jack_fd_close"]
+opaque closeFile (fd : UInt32) : IO Unit
+
+/-- Reap finished operations without blocking -/
+def poll (ring : @& Ring) : IO (Array RingCompletion) :=
+  ring.submitAndWait 0 0
+
+/-- Queue a receive on a socket -/
+def recv (ring : @& Ring) (sock : @& Socket) (maxBytes : UInt32) (userData : UInt64) : IO Unit :=
+  ring.prepRecv sock.fd maxBytes false userData
+
+/-- Queue a send on a socket -/
+def send (ring : @& Ring) (sock : @& Socket) (data : @& ByteArray) (userData : UInt64) : IO Unit :=
+  ring.prepSend sock.fd data false userData
+
+/-- Queue an accept on a listening socket -/
+def accept (ring : @& Ring) (sock : @& Socket) (userData : UInt64) : IO Unit :=
+  ring.prepAccept sock.fd false userData
+
+/-- Queue a sendfile step from an open file descriptor -/
+def sendFile (ring : @& Ring) (sock : @& Socket) (fileFd : UInt32) (offset : UInt64) (count : UInt32)
+    (userData : UInt64) : IO Unit :=
+  ring.prepSendFile sock.fd fileFd offset count false userData
+
+end Ring
+
+end Jack
@@ -115,6 +115,11 @@ opaque sendAll (sock : @& Socket) (data : @& ByteArray) : IO Unit
 @[extern "jack_socket_send_file"]
 opaque sendFile (sock : @& Socket) (path : @& String) (offset : UInt64) (count : UInt64) : IO UInt64
 
+/-- One non-blocking sendfile() step of up to count bytes from an open file descriptor.
+    Returns bytes sent; callers advance offset and retry until done. -/
+@[extern "jack_socket_send_file_fd_try"]
+opaque sendFileFdTry (sock : @& Socket) (fileFd : UInt32) (offset : UInt64) (count : UInt64) : IO (SocketResult UInt64)
+
 /-- Send data from multiple buffers using sendmsg(). Returns bytes sent. -/
 @[extern "jack_socket_send_msg"]
 opaque sendMsg (sock : @& Socket) (chunks : @& Array ByteArray) : IO UInt32
@@ -190,6 +195,11 @@ def connectHostPort (host : String) (port : UInt16) : IO Socket := do
 @[extern "jack_socket_fd"]
 opaque fd (sock : @& Socket) : UInt32
 
+/-- Whether two values are the same socket. A closed socket's descriptor
+    number can be handed out again, so comparing `fd`s is not enough. -/
+@[extern "jack_socket_same"]
+opaque same (a : @& Socket) (b : @& Socket) : Bool
+
 /-- Set recv/send timeouts in seconds -/
 @[extern "jack_socket_set_timeout"]
 opaque setTimeout (sock : @& Socket) (timeoutSecs : UInt32) : IO Unit
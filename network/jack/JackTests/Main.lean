@@ -562,6 +562,185 @@ test "Poll.wait multiple sockets identifies correct socket" := do
   sock2.close
   sender.close
 
+-- ========== Poller Tests ==========
+
+testSuite "Jack.Poller"
+
+test "backend is known" := do
+  let name ← Poller.backend
+  ensure (name == "epoll" || name == "kqueue" || name == "poll") s!"unexpected backend {name}"
+
+test "wait times out with no ready sockets" := do
+  let poller ← Poller.new
+  let sock ← Socket.create .inet .dgram .udp
+  sock.bindAddr (SockAddr.ipv4Loopback 0)
+  poller.add sock #[.readable] 7
+  let events ← poller.wait 16 10
+  ensure events.isEmpty "no events before data arrives"
+  poller.remove sock
+  sock.close
+  poller.close
+
+test "readable socket reports its token" := do
+  let poller ← Poller.new
+  let quiet ← Socket.create .inet .dgram .udp
+  quiet.bindAddr (SockAddr.ipv4Loopback 0)
+  let target ← Socket.create .inet .dgram .udp
+  target.bindAddr (SockAddr.ipv4Loopback 0)
+  let targetAddr ← target.getLocalAddr
+  poller.add quiet #[.readable] 1
+  poller.add target #[.readable] 42
+
+  let sender ← Socket.create .inet .dgram .udp
+  sender.sendTo "ping".toUTF8 targetAddr
+
+  let events ← poller.wait 16 1000
+  ensure (events.size == 1) "exactly one socket ready"
+  let ev := events.get 0
+  ensure (ev.token == 42) "token of the ready socket"
+  ensure ev.isReadable "readable"
+
+  poller.remove quiet
+  poller.remove target
+  quiet.close
+  target.close
+  sender.close
+  poller.close
+
+test "modify switches interest" := do
+  let poller ← Poller.new
+  let sock ← Socket.create .inet .dgram .udp
+  sock.bindAddr (SockAddr.ipv4Loopback 0)
+  poller.add sock #[.readable] 3
+  let idle ← poller.wait 16 0
+  ensure idle.isEmpty "unbound readable interest is idle"
+
+  poller.modify sock #[.writable] 4
+  let events ← poller.wait 16 1000
+  ensure (events.size >= 1) "writable after modify"
+  let ev := events.get 0
+  ensure (ev.token == 4) "token updated by modify"
+  ensure ev.isWritable "writable"
+
+  poller.remove sock
+  let after ← poller.wait 16 0
+  ensure after.isEmpty "no events after remove"
+  sock.close
+  poller.close
+
+test "edge-triggered registration reports readiness once" := do
+  let (a, b) ← Socket.pair .unix .stream .default
+  let poller ← Jack.Poller.new
+  poller.add b #[.readable] 7 (edge := true)
+  a.sendAll "hello".toUTF8
+  let first ← poller.wait 16 1000
+  ensure (first.size == 1 && first.token 0 == 7) "edge event delivered"
+  let again ← poller.wait 16 0
+  if (← Jack.Poller.backend) != "poll" then
+    ensure again.isEmpty "edge event not repeated while data is unread"
+  poller.close
+  a.close
+  b.close
+
+-- ========== Ring Tests ==========
+
+testSuite "Jack.Ring"
+
+/-- Run a check against the native backend and the forced poll(2) fallback -/
+def withRings (check : Jack.Ring → IO Unit) : IO Unit := do
+  for forcePoll in [false, true] do
+    let ring ← Jack.Ring.new 64 forcePoll
+    check ring
+    ring.close
+
+test "backend name" := do
+  let ring ← Jack.Ring.new
+  let name ← ring.backend
+  ensure (name == "io_uring" || name == "poll") s!"known backend {name}"
+  ring.close
+  let fallback ← Jack.Ring.new 64 true
+  fallback.backend ≡ "poll"
+  fallback.close
+
+test "batched send and recv complete together" := do
+  withRings fun ring => do
+    let (a, b) ← Socket.pair .unix .stream .default
+    ring.recv b 64 1
+    ring.send a "hello".toUTF8 2
+    let done ← ring.submitAndWait 2 1000
+    done.size ≡ 2
+    for c in done do
+      if c.userData == 1 then
+        String.fromUTF8! c.data ≡ "hello"
+      else
+        c.value ≡ 5
+    a.close
+    b.close
+
+test "wait times out without completions" := do
+  withRings fun ring => do
+    let (a, b) ← Socket.pair .unix .stream .default
+    ring.recv b 64 1
+    let idle ← ring.submitAndWait 1 50
+    ensure idle.isEmpty "nothing completed"
+    a.sendAll "late".toUTF8
+    let done ← ring.submitAndWait 1 1000
+    ensure (done.size == 1 && String.fromUTF8! done[0]!.data == "late") "pending recv completes later"
+    a.close
+    b.close
+
+test "accept yields an adoptable descriptor" := do
+  withRings fun ring => do
+    let server ← Socket.new
+    server.bind "127.0.0.1" 0
+    server.listen 4
+    let addr ← server.getLocalAddr
+    ring.accept server 9
+    let client ← Socket.new
+    client.connectAddr addr
+    let done ← ring.submitAndWait 1 1000
+    ensure (done.size == 1 && done[0]!.isOk) "accept completed"
+    let conn ← Socket.adoptFd done[0]!.value.toUInt32
+    client.sendAll "hi".toUTF8
+    let data ← conn.recv 16
+    String.fromUTF8! data ≡ "hi"
+    conn.close
+    client.close
+    server.close
+
+test "registered buffers with fixed files" := do
+  withRings fun ring => do
+    let (a, b) ← Socket.pair .unix .stream .default
+    ring.registerBuffers 2 64
+    ring.registerFiles #[a.fd, b.fd]
+    let n ← ring.writeBuffer 0 "fixed".toUTF8
+    ring.prepSendBuffer 0 0 n true 1
+    ring.prepRecvBuffer 1 1 64 true 2
+    let done ← ring.submitAndWait 2 1000
+    done.size ≡ 2
+    let received ← ring.readBuffer 1 5
+    String.fromUTF8! received ≡ "fixed"
+    a.close
+    b.close
+
+test "sendFile step from an open file" := do
+  let dir : System.FilePath := "/tmp/jack-ring-test"
+  IO.FS.createDirAll dir
+  let path := dir / "payload.txt"
+  IO.FS.writeFile path "0123456789"
+  withRings fun ring => do
+    let (a, b) ← Socket.pair .unix .stream .default
+    let fd ← Jack.Ring.openFile path.toString
+    ring.sendFile a fd 2 5 1
+    ring.recv b 64 2
+    let done ← ring.submitAndWait 2 1000
+    Jack.Ring.closeFile fd
+    let recvd := done.find? (·.userData == 2)
+    ensure (recvd.map (fun c => String.fromUTF8! c.data) == some "23456") "file range received"
+    a.close
+    b.close
+  try IO.FS.removeFile path catch _ => pure ()
+
 -- ========== Async Tests ==========
 
 testSuite "Jack.Async"
@@ -601,6 +780,56 @@ test "connectAsync + acceptAsync" := do
   let _ ← IO.ofExcept acceptTask.get
   server.close
 
+test "cancel resolves a pending waiter" := do
+  let sock ← Socket.create .inet .dgram .udp
+  sock.bindAddr (SockAddr.ipv4Loopback 0)
+  let (task, handle) ← Jack.Async.awaitEventsCancelable sock #[.readable]
+  handle.cancel
+  match ← IO.wait task with
+  | .error .canceled => pure ()
+  | _ => ensure false "waiter canceled"
+  sock.close
+
+test "waiters on one socket share a registration" := do
+  let sock ← Socket.create .inet .dgram .udp
+  sock.bindAddr (SockAddr.ipv4Loopback 0)
+  let addr ← sock.getLocalAddr
+  let (readTask, _) ← Jack.Async.awaitEventsCancelable sock #[.readable]
+  let (writeTask, _) ← Jack.Async.awaitEventsCancelable sock #[.writable]
+  match ← IO.wait writeTask with
+  | .ok ev => ensure (ev.contains .writable) "writable resolved first"
+  | .error _ => ensure false "writable waiter resolved"
+  let sender ← Socket.create .inet .dgram .udp
+  sender.sendTo "ping".toUTF8 addr
+  match ← IO.wait readTask with
+  | .ok ev => ensure (ev.contains .readable) "readable resolved after send"
+  | .error _ => ensure false "readable waiter resolved"
+  sender.close
+  sock.close
+
+test "a reused descriptor number gets a fresh registration" (timeout := 5000) := do
+  let old ← Socket.create .inet .dgram .udp
+  old.bindAddr (SockAddr.ipv4Loopback 0)
+  let fd := old.fd
+  let (staleTask, _) ← Jack.Async.awaitEventsCancelable old #[.readable]
+  old.close
+  let sock ← Socket.create .inet .dgram .udp
+  sock.bindAddr (SockAddr.ipv4Loopback 0)
+  -- The lowest free descriptor is handed out, so the number is normally reused
+  if sock.fd == fd then
+    let addr ← sock.getLocalAddr
+    let (readTask, _) ← Jack.Async.awaitEventsCancelable sock #[.readable]
+    let sender ← Socket.create .inet .dgram .udp
+    sender.sendTo "ping".toUTF8 addr
+    match ← IO.wait readTask with
+    | .ok ev => ensure (ev.contains .readable) "new socket's waiter resolved"
+    | .error _ => ensure false "new socket's waiter resolved"
+    match ← IO.wait staleTask with
+    | .ok ev => ensure (ev.contains .error) "closed socket's waiter reported an error"
+    | .error _ => ensure false "closed socket's waiter resolved"
+    sender.close
+  sock.close
+
 test "async shutdown" := do
   Jack.Async.shutdown
 
@@ -1423,6 +1652,153 @@ test "poll scalability" := do
 
       IO.println s!"poll wait on {count} sockets: {nsToMs (stop - start)} ms"
 
+/-- Bind up to `count` idle UDP sockets, stopping early at the descriptor limit -/
+def openIdleSockets (count : Nat) : IO (Array Socket) := do
+  let mut sockets : Array Socket := #[]
+  let mut exhausted := false
+  for _ in [:count] do
+    if !exhausted then
+      try
+        let s ← Socket.create .inet .dgram .udp
+        s.bindAddr (SockAddr.ipv4Loopback 0)
+        sockets := sockets.push s
+      catch _ =>
+        exhausted := true
+  return sockets
+
+test "poller vs poll with idle sockets" := do
+  let rounds := 200
+  let activeCount := 4
+  for idleCount in [1000, 10000] do
+    let idle ← openIdleSockets idleCount
+    let active ← openIdleSockets activeCount
+    if active.size < activeCount || idle.size < idleCount then
+      IO.println s!"poller vs poll {idleCount} idle: skipped (opened {idle.size}, raise ulimit -n)"
+    else
+      let sender ← Socket.create .inet .dgram .udp
+      let mut addrs : Array SockAddr := #[]
+      for s in active do
+        addrs := addrs.push (← s.getLocalAddr)
+      let sockets := idle ++ active
+
+      -- Poll.wait: the whole interest set is rebuilt and scanned every round
+      let mut pollSamples : Array Nat := #[]
+      for _ in [:rounds] do
+        for addr in addrs do
+          sender.sendTo "x".toUTF8 addr
+        let start ← nowNs
+        let entries := sockets.map (fun s => { socket := s, events := #[.readable] : PollEntry })
+        let results ← Poll.wait entries 1000
+        let stop ← nowNs
+        pollSamples := pollSamples.push (stop - start)
+        for res in results do
+          let _ ← res.socket.recvFrom 64
+
+      -- Poller: registered once, each wait only reports the ready sockets
+      let poller ← Jack.Poller.new
+      for i in [:sockets.size] do
+        poller.add sockets[i]! #[.readable] i.toUInt64
+      let mut pollerSamples : Array Nat := #[]
+      let mut ready := 0
+      for _ in [:rounds] do
+        for addr in addrs do
+          sender.sendTo "x".toUTF8 addr
+        let start ← nowNs
+        let events ← poller.wait 256 1000
+        let stop ← nowNs
+        pollerSamples := pollerSamples.push (stop - start)
+        ready := ready + events.size
+        for ev in events do
+          let _ ← sockets[ev.token.toNat]!.recvFrom 64
+      poller.close
+
+      sender.close
+      for s in sockets do
+        s.close
+
+      ensure (ready >= rounds) "poller reported active sockets"
+      IO.println s!"{idleCount} idle + {activeCount} active, {rounds} rounds: Poll.wait avg {nsToMs (avgNs pollSamples)} ms p95 {nsToMs (percentile pollSamples 95)} ms, Poller ({← Jack.Poller.backend}) avg {nsToMs (avgNs pollerSamples)} ms p95 {nsToMs (percentile pollerSamples 95)} ms"
+
+test "async wakeup with idle waiters" := do
+  let rounds := 200
+  for idleCount in [1000, 10000] do
+    let idle ← openIdleSockets idleCount
+    if idle.size < idleCount then
+      IO.println s!"async wakeup {idleCount} idle waiters: skipped (opened {idle.size}, raise ulimit -n)"
+      for s in idle do
+        s.close
+    else
+      let mut handles : Array Jack.Async.CancelHandle := #[]
+      for s in idle do
+        let (_, handle) ← Jack.Async.awaitEventsCancelable s #[.readable]
+        handles := handles.push handle
+
+      let target ← Socket.create .inet .dgram .udp
+      target.bindAddr (SockAddr.ipv4Loopback 0)
+      let targetAddr ← target.getLocalAddr
+      let sender ← Socket.create .inet .dgram .udp
+      let mut samples : Array Nat := #[]
+      for _ in [:rounds] do
+        let start ← nowNs
+        sender.sendTo "x".toUTF8 targetAddr
+        let _ ← Jack.Async.recvFromAsync target 64
+        let stop ← nowNs
+        samples := samples.push (stop - start)
+
+      for h in handles do
+        h.cancel
+      Jack.Async.shutdown
+      sender.close
+      target.close
+      for s in idle do
+        s.close
+
+      ensure (samples.size == rounds) "async samples collected"
+      IO.println s!"async recvFrom with {idleCount} idle waiters, {rounds} rounds: avg {nsToMs (avgNs samples)} ms p95 {nsToMs (percentile samples 95)} ms"
+
+test "ring batch vs per-call send/recv" := do
+  let pairCount := 64
+  let rounds := 200
+  let payload := mkBytes 64 0x52
+  let mut pairs : Array (Socket × Socket) := #[]
+  for _ in [:pairCount] do
+    pairs := pairs.push (← Socket.pair .unix .stream .default)
+
+  let start1 ← nowNs
+  for _ in [:rounds] do
+    for (a, b) in pairs do
+      a.sendAll payload
+      let _ ← b.recv 64
+  let stop1 ← nowNs
+
+  let ring ← Jack.Ring.new 256
+  let start2 ← nowNs
+  let mut completed := 0
+  for _ in [:rounds] do
+    for i in [:pairs.size] do
+      let (a, b) := pairs[i]!
+      ring.send a payload (2 * i).toUInt64
+      ring.recv b 64 (2 * i + 1).toUInt64
+    let mut pending := 2 * pairs.size
+    while pending > 0 do
+      let done ← ring.submitAndWait pending.toUInt32 1000
+      if done.isEmpty then
+        pending := 0
+      else
+        pending := pending - min pending done.size
+        completed := completed + done.size
+  let stop2 ← nowNs
+  let backend ← ring.backend
+  ring.close
+
+  for (a, b) in pairs do
+    a.close
+    b.close
+
+  let ops := pairCount * rounds * 2
+  ensure (completed == ops) "ring completed every operation"
+  IO.println s!"{pairCount} pairs x {rounds} rounds: per-call {nsToMs (stop1 - start1)} ms, ring ({backend}) {nsToMs (stop2 - start2)} ms"
+
 test "async vs blocking recv" := do
   let totalBytes := 2 * 1024 * 1024
   let chunkSize := 16 * 1024
@@ -28,6 +28,24 @@
 #define JACK_HAVE_SENDFILE 1
 #endif
 #endif
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define JACK_POLLER_EPOLL 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#include <sys/event.h>
+#define JACK_POLLER_KQUEUE 1
+#endif
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define JACK_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+#include <time.h>
 
 /* ========== Socket Option Constants ========== */
 
@@ -1498,6 +1516,54 @@ LEAN_EXPORT lean_obj_res jack_socket_send_file(
     return lean_io_result_mk_ok(lean_box_uint64(sent_total));
 }
 
+/* One non-blocking sendfile step; returns bytes sent or -1 with errno set */
+static ssize_t jack_sendfile_once(int sock_fd, int file_fd, uint64_t offset, uint64_t count) {
+#if defined(JACK_HAVE_SENDFILE) && defined(__linux__)
+    off_t off = (off_t)offset;
+    size_t chunk = count > (uint64_t)SSIZE_MAX ? (size_t)SSIZE_MAX : (size_t)count;
+    return sendfile(sock_fd, file_fd, &off, chunk);
+#elif defined(JACK_HAVE_SENDFILE) && defined(__APPLE__)
+    off_t len = (off_t)(count > (uint64_t)INT64_MAX ? (uint64_t)INT64_MAX : count);
+    int rc = sendfile(file_fd, sock_fd, (off_t)offset, &len, NULL, 0);
+    if (len > 0) {
+        return (ssize_t)len;
+    }
+    return rc < 0 ? -1 : 0;
+#else
+    uint8_t buf[65536];
+    size_t chunk = count > sizeof(buf) ? sizeof(buf) : (size_t)count;
+    ssize_t r = pread(file_fd, buf, chunk, (off_t)offset);
+    if (r <= 0) {
+        return r;
+    }
+    int flags = MSG_DONTWAIT;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+    return send(sock_fd, buf, (size_t)r, flags);
+#endif
+}
+
+/* Non-blocking sendfile step from an open descriptor (single syscall) */
+LEAN_EXPORT lean_obj_res jack_socket_send_file_fd_try(
+    b_lean_obj_arg sock_obj,
+    uint32_t file_fd,
+    uint64_t offset,
+    uint64_t count,
+    lean_obj_arg world
+) {
+    jack_socket_t *sock = jack_socket_unbox(sock_obj);
+    ssize_t n = jack_sendfile_once(sock->fd, (int)file_fd, offset, count);
+    if (n < 0) {
+        int err = errno;
+        if (err == EINTR || is_wouldblock_error(err)) {
+            return lean_io_result_mk_ok(jack_socket_result_wouldblock());
+        }
+        return lean_io_result_mk_ok(jack_socket_result_error(err));
+    }
+    return lean_io_result_mk_ok(jack_socket_result_ok(lean_box_uint64((uint64_t)n)));
+}
+
 /* Send data from multiple buffers using sendmsg() */
 LEAN_EXPORT lean_obj_res jack_socket_send_msg(
     b_lean_obj_arg sock_obj,
@@ -2457,6 +2523,11 @@ LEAN_EXPORT uint32_t jack_socket_fd(b_lean_obj_arg sock_obj) {
     return (uint32_t)sock->fd;
 }
 
+/* Whether two socket objects are the same socket (not just the same fd number) */
+LEAN_EXPORT uint8_t jack_socket_same(b_lean_obj_arg a_obj, b_lean_obj_arg b_obj) {
+    return jack_socket_unbox(a_obj) == jack_socket_unbox(b_obj);
+}
+
 /* Set socket recv/send timeouts in seconds */
 LEAN_EXPORT lean_obj_res jack_socket_set_timeout(
     b_lean_obj_arg sock_obj,
@@ -2897,3 +2968,1487 @@ LEAN_EXPORT lean_obj_res jack_poll_wait(
     free(pfds);
     return lean_io_result_mk_ok(results);
 }
+
+/* ========== Readiness Poller ========== */
+
+/*
+ * Persistent readiness registration. Uses epoll on Linux, kqueue on BSD/macOS,
+ * and a poll(2) registration table elsewhere. Interest and result masks use the
+ * PollEvent bits (readable=0x01, writable=0x04, error=0x08, hangup=0x10).
+ *
+ * Registrations are level-triggered unless the edge flag is set (EPOLLET /
+ * EV_CLEAR); the poll(2) table is always level-triggered.
+ *
+ * Poller.wait returns a packed ByteArray of 12-byte records:
+ *   token (u64 little-endian) | mask (u32 little-endian)
+ */
+
+#define JACK_POLL_READABLE 0x01
+#define JACK_POLL_WRITABLE 0x04
+#define JACK_POLL_ERROR    0x08
+#define JACK_POLL_HANGUP   0x10
+#define JACK_POLLER_RECORD_SIZE 12
+
+typedef struct {
+    int fd;                 /* epoll/kqueue descriptor, -1 for the poll table */
+    int closed;
+    struct pollfd *pfds;    /* poll(2) fallback registrations */
+    uint64_t *tokens;
+    size_t count;
+    size_t capacity;
+} jack_poller_t;
+
+static lean_external_class *g_poller_class = NULL;
+
+static void jack_poller_release(jack_poller_t *poller) {
+    if (poller->fd >= 0) {
+        close(poller->fd);
+        poller->fd = -1;
+    }
+    free(poller->pfds);
+    free(poller->tokens);
+    poller->pfds = NULL;
+    poller->tokens = NULL;
+    poller->count = 0;
+    poller->capacity = 0;
+    poller->closed = 1;
+}
+
+static void jack_poller_finalizer(void *ptr) {
+    jack_poller_t *poller = (jack_poller_t *)ptr;
+    jack_poller_release(poller);
+    free(poller);
+}
+
+static void jack_poller_foreach(void *ptr, b_lean_obj_arg f) {
+    /* No nested Lean objects */
+}
+
+static inline lean_obj_res jack_poller_box(jack_poller_t *poller) {
+    if (g_poller_class == NULL) {
+        g_poller_class = lean_register_external_class(
+            jack_poller_finalizer,
+            jack_poller_foreach
+        );
+    }
+    return lean_alloc_external(g_poller_class, poller);
+}
+
+static inline jack_poller_t *jack_poller_unbox(lean_obj_arg obj) {
+    return (jack_poller_t *)lean_get_external_data(obj);
+}
+
+static lean_obj_res jack_poller_closed_error(void) {
+    return lean_io_result_mk_error(lean_mk_io_user_error(
+        lean_mk_string("Poller is closed")));
+}
+
+static void jack_poller_put_record(uint8_t *out, uint64_t token, uint32_t mask) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(token >> (8 * i));
+    }
+    for (int i = 0; i < 4; i++) {
+        out[8 + i] = (uint8_t)(mask >> (8 * i));
+    }
+}
+
+/* Create a new poller */
+LEAN_EXPORT lean_obj_res jack_poller_new(lean_obj_arg world) {
+    jack_poller_t *poller = calloc(1, sizeof(jack_poller_t));
+    if (!poller) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(
+            lean_mk_string("Failed to allocate poller")));
+    }
+    poller->fd = -1;
+
+#if defined(JACK_POLLER_EPOLL)
+    poller->fd = epoll_create1(EPOLL_CLOEXEC);
+    if (poller->fd < 0) {
+        int err = errno;
+        free(poller);
+        return jack_io_error_from_errno(err);
+    }
+#elif defined(JACK_POLLER_KQUEUE)
+    poller->fd = kqueue();
+    if (poller->fd < 0) {
+        int err = errno;
+        free(poller);
+        return jack_io_error_from_errno(err);
+    }
+    fcntl(poller->fd, F_SETFD, FD_CLOEXEC);
+#endif
+
+    return lean_io_result_mk_ok(jack_poller_box(poller));
+}
+
+/* Name of the readiness backend compiled in */
+LEAN_EXPORT lean_obj_res jack_poller_backend(lean_obj_arg world) {
+#if defined(JACK_POLLER_EPOLL)
+    return lean_io_result_mk_ok(lean_mk_string("epoll"));
+#elif defined(JACK_POLLER_KQUEUE)
+    return lean_io_result_mk_ok(lean_mk_string("kqueue"));
+#else
+    return lean_io_result_mk_ok(lean_mk_string("poll"));
+#endif
+}
+
+#if defined(JACK_POLLER_EPOLL)
+static uint32_t jack_mask_to_epoll(uint16_t mask, uint8_t edge) {
+    uint32_t ev = edge ? EPOLLET : 0;
+    if (mask & JACK_POLL_READABLE) ev |= EPOLLIN | EPOLLRDHUP;
+    if (mask & JACK_POLL_WRITABLE) ev |= EPOLLOUT;
+    /* EPOLLERR and EPOLLHUP are always reported */
+    return ev;
+}
+
+static uint32_t jack_epoll_to_mask(uint32_t ev) {
+    uint32_t mask = 0;
+    if (ev & EPOLLIN) mask |= JACK_POLL_READABLE;
+    if (ev & EPOLLOUT) mask |= JACK_POLL_WRITABLE;
+    if (ev & EPOLLERR) mask |= JACK_POLL_ERROR;
+    if (ev & (EPOLLHUP | EPOLLRDHUP)) mask |= JACK_POLL_HANGUP;
+    return mask;
+}
+
+static int jack_poller_ctl(jack_poller_t *poller, int op, int fd, uint16_t mask, uint64_t token, uint8_t edge) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = jack_mask_to_epoll(mask, edge);
+    ev.data.u64 = token;
+    return epoll_ctl(poller->fd, op, fd, &ev);
+}
+#elif defined(JACK_POLLER_KQUEUE)
+/* Apply one filter change; deleting a filter that was never added is not an error */
+static int jack_kevent_apply(jack_poller_t *poller, int fd, int16_t filter, int enable, uint64_t token, uint8_t edge) {
+    struct kevent change;
+    uint16_t flags = enable ? (EV_ADD | EV_ENABLE | (edge ? EV_CLEAR : 0)) : EV_DELETE;
+    EV_SET(&change, fd, filter, flags, 0, 0, (void *)(uintptr_t)token);
+    if (kevent(poller->fd, &change, 1, NULL, 0, NULL) < 0) {
+        if (!enable && errno == ENOENT) return 0;
+        return -1;
+    }
+    return 0;
+}
+
+static int jack_poller_ctl(jack_poller_t *poller, int fd, uint16_t mask, uint64_t token, uint8_t edge) {
+    if (jack_kevent_apply(poller, fd, EVFILT_READ, (mask & JACK_POLL_READABLE) != 0, token, edge) < 0) {
+        return -1;
+    }
+    return jack_kevent_apply(poller, fd, EVFILT_WRITE, (mask & JACK_POLL_WRITABLE) != 0, token, edge);
+}
+#else
+static short jack_mask_to_poll(uint16_t mask) {
+    short ev = 0;
+    if (mask & JACK_POLL_READABLE) ev |= POLLIN;
+    if (mask & JACK_POLL_WRITABLE) ev |= POLLOUT;
+    return ev;
+}
+
+static ssize_t jack_poller_find(jack_poller_t *poller, int fd) {
+    for (size_t i = 0; i < poller->count; i++) {
+        if (poller->pfds[i].fd == fd) return (ssize_t)i;
+    }
+    return -1;
+}
+#endif
+
+/* Register a descriptor with an interest mask and a caller-chosen token */
+LEAN_EXPORT lean_obj_res jack_poller_add(
+    b_lean_obj_arg poller_obj,
+    uint32_t fd,
+    uint16_t mask,
+    uint64_t token,
+    uint8_t edge,
+    lean_obj_arg world
+) {
+    jack_poller_t *poller = jack_poller_unbox(poller_obj);
+    if (poller->closed) return jack_poller_closed_error();
+
+#if defined(JACK_POLLER_EPOLL)
+    if (jack_poller_ctl(poller, EPOLL_CTL_ADD, (int)fd, mask, token, edge) < 0) {
+        return jack_io_error_from_errno(errno);
+    }
+#elif defined(JACK_POLLER_KQUEUE)
+    if (jack_poller_ctl(poller, (int)fd, mask, token, edge) < 0) {
+        return jack_io_error_from_errno(errno);
+    }
+#else
+    (void)edge;
+    if (jack_poller_find(poller, (int)fd) >= 0) {
+        return jack_io_error_from_errno(EEXIST);
+    }
+    if (poller->count == poller->capacity) {
+        size_t cap = poller->capacity == 0 ? 64 : poller->capacity * 2;
+        struct pollfd *pfds = realloc(poller->pfds, cap * sizeof(struct pollfd));
+        if (!pfds) return jack_io_error_from_errno(ENOMEM);
+        poller->pfds = pfds;
+        uint64_t *tokens = realloc(poller->tokens, cap * sizeof(uint64_t));
+        if (!tokens) return jack_io_error_from_errno(ENOMEM);
+        poller->tokens = tokens;
+        poller->capacity = cap;
+    }
+    poller->pfds[poller->count].fd = (int)fd;
+    poller->pfds[poller->count].events = jack_mask_to_poll(mask);
+    poller->pfds[poller->count].revents = 0;
+    poller->tokens[poller->count] = token;
+    poller->count++;
+#endif
+
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* Replace the interest mask and token of a registered descriptor */
+LEAN_EXPORT lean_obj_res jack_poller_modify(
+    b_lean_obj_arg poller_obj,
+    uint32_t fd,
+    uint16_t mask,
+    uint64_t token,
+    uint8_t edge,
+    lean_obj_arg world
+) {
+    jack_poller_t *poller = jack_poller_unbox(poller_obj);
+    if (poller->closed) return jack_poller_closed_error();
+
+#if defined(JACK_POLLER_EPOLL)
+    if (jack_poller_ctl(poller, EPOLL_CTL_MOD, (int)fd, mask, token, edge) < 0) {
+        return jack_io_error_from_errno(errno);
+    }
+#elif defined(JACK_POLLER_KQUEUE)
+    if (jack_poller_ctl(poller, (int)fd, mask, token, edge) < 0) {
+        return jack_io_error_from_errno(errno);
+    }
+#else
+    (void)edge;
+    ssize_t idx = jack_poller_find(poller, (int)fd);
+    if (idx < 0) {
+        return jack_io_error_from_errno(ENOENT);
+    }
+    poller->pfds[idx].events = jack_mask_to_poll(mask);
+    poller->tokens[idx] = token;
+#endif
+
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* Remove a descriptor from the poller */
+LEAN_EXPORT lean_obj_res jack_poller_remove(
+    b_lean_obj_arg poller_obj,
+    uint32_t fd,
+    lean_obj_arg world
+) {
+    jack_poller_t *poller = jack_poller_unbox(poller_obj);
+    if (poller->closed) return jack_poller_closed_error();
+
+#if defined(JACK_POLLER_EPOLL)
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    if (epoll_ctl(poller->fd, EPOLL_CTL_DEL, (int)fd, &ev) < 0) {
+        return jack_io_error_from_errno(errno);
+    }
+#elif defined(JACK_POLLER_KQUEUE)
+    if (jack_poller_ctl(poller, (int)fd, 0, 0, 0) < 0) {
+        return jack_io_error_from_errno(errno);
+    }
+#else
+    ssize_t idx = jack_poller_find(poller, (int)fd);
+    if (idx < 0) {
+        return jack_io_error_from_errno(ENOENT);
+    }
+    size_t last = poller->count - 1;
+    poller->pfds[idx] = poller->pfds[last];
+    poller->tokens[idx] = poller->tokens[last];
+    poller->count = last;
+#endif
+
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* Wait for readiness, returning up to max_events packed records */
+LEAN_EXPORT lean_obj_res jack_poller_wait(
+    b_lean_obj_arg poller_obj,
+    uint32_t max_events,
+    int32_t timeout_ms,
+    lean_obj_arg world
+) {
+    jack_poller_t *poller = jack_poller_unbox(poller_obj);
+    if (poller->closed) return jack_poller_closed_error();
+    if (max_events == 0) max_events = 1;
+
+#if defined(JACK_POLLER_EPOLL)
+    struct epoll_event *evs = malloc((size_t)max_events * sizeof(struct epoll_event));
+    if (!evs) return jack_io_error_from_errno(ENOMEM);
+
+    int n = epoll_wait(poller->fd, evs, (int)max_events, timeout_ms);
+    if (n < 0) {
+        int err = errno;
+        free(evs);
+        if (err == EINTR) {
+            return lean_io_result_mk_ok(lean_alloc_sarray(1, 0, 0));
+        }
+        return jack_io_error_from_errno(err);
+    }
+
+    size_t bytes = (size_t)n * JACK_POLLER_RECORD_SIZE;
+    lean_obj_res arr = lean_alloc_sarray(1, bytes, bytes);
+    uint8_t *out = lean_sarray_cptr(arr);
+    for (int i = 0; i < n; i++) {
+        jack_poller_put_record(out + (size_t)i * JACK_POLLER_RECORD_SIZE,
+                               evs[i].data.u64, jack_epoll_to_mask(evs[i].events));
+    }
+    free(evs);
+    return lean_io_result_mk_ok(arr);
+#elif defined(JACK_POLLER_KQUEUE)
+    struct kevent *evs = malloc((size_t)max_events * sizeof(struct kevent));
+    if (!evs) return jack_io_error_from_errno(ENOMEM);
+
+    struct timespec ts;
+    struct timespec *tsp = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+
+    int n = kevent(poller->fd, NULL, 0, evs, (int)max_events, tsp);
+    if (n < 0) {
+        int err = errno;
+        free(evs);
+        if (err == EINTR) {
+            return lean_io_result_mk_ok(lean_alloc_sarray(1, 0, 0));
+        }
+        return jack_io_error_from_errno(err);
+    }
+
+    size_t bytes = (size_t)n * JACK_POLLER_RECORD_SIZE;
+    lean_obj_res arr = lean_alloc_sarray(1, bytes, bytes);
+    uint8_t *out = lean_sarray_cptr(arr);
+    for (int i = 0; i < n; i++) {
+        uint32_t mask = 0;
+        if (evs[i].filter == EVFILT_READ) mask |= JACK_POLL_READABLE;
+        if (evs[i].filter == EVFILT_WRITE) mask |= JACK_POLL_WRITABLE;
+        if (evs[i].flags & EV_ERROR) mask |= JACK_POLL_ERROR;
+        if (evs[i].flags & EV_EOF) mask |= JACK_POLL_HANGUP;
+        jack_poller_put_record(out + (size_t)i * JACK_POLLER_RECORD_SIZE,
+                               (uint64_t)(uintptr_t)evs[i].udata, mask);
+    }
+    free(evs);
+    return lean_io_result_mk_ok(arr);
+#else
+    int n = poll(poller->pfds, poller->count, timeout_ms);
+    if (n < 0) {
+        int err = errno;
+        if (err == EINTR) {
+            return lean_io_result_mk_ok(lean_alloc_sarray(1, 0, 0));
+        }
+        return jack_io_error_from_errno(err);
+    }
+
+    size_t ready = (size_t)n < (size_t)max_events ? (size_t)n : (size_t)max_events;
+    size_t bytes = ready * JACK_POLLER_RECORD_SIZE;
+    lean_obj_res arr = lean_alloc_sarray(1, bytes, bytes);
+    uint8_t *out = lean_sarray_cptr(arr);
+    size_t idx = 0;
+    for (size_t i = 0; i < poller->count && idx < ready; i++) {
+        short rev = poller->pfds[i].revents;
+        if (rev == 0) continue;
+        uint32_t mask = 0;
+        if (rev & POLLIN) mask |= JACK_POLL_READABLE;
+        if (rev & POLLOUT) mask |= JACK_POLL_WRITABLE;
+        if (rev & (POLLERR | POLLNVAL)) mask |= JACK_POLL_ERROR;
+        if (rev & POLLHUP) mask |= JACK_POLL_HANGUP;
+        jack_poller_put_record(out + idx * JACK_POLLER_RECORD_SIZE, poller->tokens[i], mask);
+        idx++;
+    }
+    lean_sarray_set_size(arr, idx * JACK_POLLER_RECORD_SIZE);
+    return lean_io_result_mk_ok(arr);
+#endif
+}
+
+/* Close the poller and release its registrations */
+LEAN_EXPORT lean_obj_res jack_poller_close(
+    lean_obj_arg poller_obj,
+    lean_obj_arg world
+) {
+    jack_poller_t *poller = jack_poller_unbox(poller_obj);
+    jack_poller_release(poller);
+    lean_dec_ref(poller_obj);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* ========== Batch I/O Ring ========== */
+/*
+ * A ring batches socket operations: callers prepare any number of
+ * recv/send/accept/sendfile operations tagged with a 64-bit user value, then
+ * one wait call submits them and reaps completions.
+ *
+ * With io_uring (Linux), prepared operations become SQEs submitted by a
+ * single io_uring_enter, registered buffers and fixed files map to
+ * IORING_REGISTER_BUFFERS / IORING_REGISTER_FILES. sendfile has no io_uring
+ * opcode, so it runs in-process and re-arms with IORING_OP_POLL_ADD while the
+ * socket is full. Without io_uring (other platforms, old kernels, or when
+ * forced) each operation is attempted without blocking and parked on poll(2)
+ * until its descriptor is ready.
+ *
+ * Every operation completes with one result: bytes transferred, the accepted
+ * descriptor, or -errno.
+ */
+
+#define JACK_RING_OP_RECV      1
+#define JACK_RING_OP_SEND      2
+#define JACK_RING_OP_ACCEPT    3
+#define JACK_RING_OP_SENDFILE  4
+#define JACK_RING_OP_RECV_BUF  5
+#define JACK_RING_OP_SEND_BUF  6
+
+/* user_data of internal SQEs (cancellations, timeout removals) */
+#define JACK_RING_INTERNAL     UINT64_MAX
+/* user_data of the wait timeout, so it can be found and removed */
+#define JACK_RING_TIMEOUT      (UINT64_MAX - 1)
+/* Teardown waits at most this many rounds of JACK_RING_TEARDOWN_MS each */
+#define JACK_RING_TEARDOWN_ROUNDS 10
+#define JACK_RING_TEARDOWN_MS     100
+
+typedef struct {
+    int in_use;
+    int in_flight;          /* owned by the kernel (io_uring SQE or poll) */
+    int kind;
+    uint64_t user_data;
+    int fd;                 /* socket descriptor, or fixed-file index */
+    int fixed;
+    uint8_t *buf;           /* receive buffer owned by the op */
+    uint32_t len;
+    lean_object *payload;   /* send data, kept alive until completion */
+    int file_fd;
+    uint64_t offset;
+    uint32_t buf_index;
+} jack_ring_op_t;
+
+typedef struct {
+    uint64_t user_data;
+    int32_t result;
+    lean_object *data;
+} jack_ring_done_t;
+
+typedef struct {
+    int closed;
+    int uring;
+    uint32_t capacity;          /* maximum outstanding operations */
+    jack_ring_op_t *ops;
+    uint32_t *free_slots;
+    uint32_t free_count;
+    uint32_t *queued;           /* prepared, not yet submitted */
+    uint32_t queued_count;
+    uint32_t *parked;           /* poll fallback: waiting for readiness */
+    uint32_t parked_count;
+    struct pollfd *pfds;
+    jack_ring_done_t *done;
+    size_t done_count;
+    size_t done_capacity;
+    uint8_t *buffers;
+    uint32_t buffer_count;
+    uint32_t buffer_size;
+    int *files;
+    uint32_t file_count;
+#ifdef JACK_HAVE_IO_URING
+    int ring_fd;
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    uint32_t to_submit;
+    uint32_t in_flight;
+    uint32_t timeouts_pending;  /* timeout SQEs whose CQE has not been reaped */
+    struct __kernel_timespec ts;
+#endif
+    int leaked;                 /* ops were still in flight at teardown */
+} jack_ring_t;
+
+static lean_external_class *g_ring_class = NULL;
+
+static lean_obj_res jack_ring_error(const char *msg) {
+    return lean_io_result_mk_error(lean_mk_io_user_error(lean_mk_string(msg)));
+}
+
+static void jack_ring_release_slot(jack_ring_t *ring, uint32_t slot) {
+    jack_ring_op_t *op = &ring->ops[slot];
+    free(op->buf);
+    if (op->payload) {
+        lean_dec_ref(op->payload);
+    }
+    memset(op, 0, sizeof(*op));
+    ring->free_slots[ring->free_count++] = slot;
+}
+
+static int jack_ring_push_done(jack_ring_t *ring, uint64_t user_data, int32_t result, lean_object *data) {
+    if (ring->done_count == ring->done_capacity) {
+        size_t cap = ring->done_capacity ? ring->done_capacity * 2 : 64;
+        jack_ring_done_t *done = realloc(ring->done, cap * sizeof(jack_ring_done_t));
+        if (!done) {
+            return -1;
+        }
+        ring->done = done;
+        ring->done_capacity = cap;
+    }
+    ring->done[ring->done_count].user_data = user_data;
+    ring->done[ring->done_count].result = result;
+    ring->done[ring->done_count].data = data;
+    ring->done_count++;
+    return 0;
+}
+
+/* Record the completion of an operation and free its slot */
+static void jack_ring_finish(jack_ring_t *ring, uint32_t slot, int32_t result) {
+    jack_ring_op_t *op = &ring->ops[slot];
+    lean_object *data = NULL;
+    if (op->kind == JACK_RING_OP_RECV && result > 0) {
+        data = lean_alloc_sarray(1, (size_t)result, (size_t)result);
+        memcpy(lean_sarray_cptr(data), op->buf, (size_t)result);
+    }
+    if (jack_ring_push_done(ring, op->user_data, result, data) < 0) {
+        if (data) lean_dec_ref(data);
+        if (op->kind == JACK_RING_OP_ACCEPT && result >= 0) close(result);
+    }
+    jack_ring_release_slot(ring, slot);
+}
+
+static int jack_ring_real_fd(jack_ring_t *ring, jack_ring_op_t *op) {
+    if (!op->fixed) {
+        return op->fd;
+    }
+    if (op->fd < 0 || (uint32_t)op->fd >= ring->file_count) {
+        return -1;
+    }
+    return ring->files[op->fd];
+}
+
+static uint8_t *jack_ring_buffer(jack_ring_t *ring, uint32_t index) {
+    return ring->buffers + (size_t)index * ring->buffer_size;
+}
+
+/* Attempt an operation in-process without blocking.
+   Returns 1 when it completed (result recorded), 0 when it would block. */
+static int jack_ring_attempt(jack_ring_t *ring, uint32_t slot) {
+    jack_ring_op_t *op = &ring->ops[slot];
+    int fd = jack_ring_real_fd(ring, op);
+    if (fd < 0) {
+        jack_ring_finish(ring, slot, -EBADF);
+        return 1;
+    }
+    int send_flags = MSG_DONTWAIT;
+#ifdef MSG_NOSIGNAL
+    send_flags |= MSG_NOSIGNAL;
+#endif
+    ssize_t n = -1;
+    switch (op->kind) {
+    case JACK_RING_OP_RECV:
+        n = recv(fd, op->buf, op->len, MSG_DONTWAIT);
+        break;
+    case JACK_RING_OP_RECV_BUF:
+        n = recv(fd, jack_ring_buffer(ring, op->buf_index), op->len, MSG_DONTWAIT);
+        break;
+    case JACK_RING_OP_SEND:
+        n = send(fd, lean_sarray_cptr(op->payload), op->len, send_flags);
+        break;
+    case JACK_RING_OP_SEND_BUF:
+        n = send(fd, jack_ring_buffer(ring, op->buf_index), op->len, send_flags);
+        break;
+    case JACK_RING_OP_ACCEPT: {
+        /* Listening sockets may be blocking; only accept once readable */
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int rc = poll(&pfd, 1, 0);
+        if (rc == 0) {
+            return 0;
+        }
+        n = rc < 0 ? -1 : accept(fd, NULL, NULL);
+        break;
+    }
+    case JACK_RING_OP_SENDFILE: {
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        int rc = poll(&pfd, 1, 0);
+        if (rc == 0) {
+            return 0;
+        }
+        n = rc < 0 ? -1 : jack_sendfile_once(fd, op->file_fd, op->offset, op->len);
+        break;
+    }
+    default:
+        errno = EINVAL;
+        break;
+    }
+    if (n < 0) {
+        int err = errno;
+        if (err == EINTR || is_wouldblock_error(err)) {
+            return 0;
+        }
+        jack_ring_finish(ring, slot, -err);
+        return 1;
+    }
+    jack_ring_finish(ring, slot, (int32_t)(n > INT32_MAX ? INT32_MAX : n));
+    return 1;
+}
+
+static short jack_ring_poll_events(int kind) {
+    switch (kind) {
+    case JACK_RING_OP_SEND:
+    case JACK_RING_OP_SEND_BUF:
+    case JACK_RING_OP_SENDFILE:
+        return POLLOUT;
+    default:
+        return POLLIN;
+    }
+}
+
+static int64_t jack_ring_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* ---- poll(2) fallback ---- */
+
+static void jack_ring_fallback_flush(jack_ring_t *ring) {
+    for (uint32_t i = 0; i < ring->queued_count; i++) {
+        uint32_t slot = ring->queued[i];
+        if (!jack_ring_attempt(ring, slot)) {
+            ring->parked[ring->parked_count++] = slot;
+        }
+    }
+    ring->queued_count = 0;
+}
+
+static int jack_ring_fallback_pump(jack_ring_t *ring, int wait_ms) {
+    jack_ring_fallback_flush(ring);
+    if (ring->parked_count == 0) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < ring->parked_count; i++) {
+        jack_ring_op_t *op = &ring->ops[ring->parked[i]];
+        ring->pfds[i].fd = jack_ring_real_fd(ring, op);
+        ring->pfds[i].events = jack_ring_poll_events(op->kind);
+        ring->pfds[i].revents = 0;
+    }
+    int rc = poll(ring->pfds, (nfds_t)ring->parked_count, wait_ms);
+    if (rc < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < ring->parked_count; i++) {
+        uint32_t slot = ring->parked[i];
+        if (ring->pfds[i].revents & POLLNVAL) {
+            jack_ring_finish(ring, slot, -EBADF);
+        } else if (ring->pfds[i].revents == 0 || !jack_ring_attempt(ring, slot)) {
+            ring->parked[kept++] = slot;
+        }
+    }
+    ring->parked_count = kept;
+    return 0;
+}
+
+/* ---- io_uring ---- */
+
+#ifdef JACK_HAVE_IO_URING
+
+static int jack_ring_enter(jack_ring_t *ring, unsigned min_complete) {
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int rc = (int)syscall(__NR_io_uring_enter, ring->ring_fd, ring->to_submit, min_complete, flags, NULL, 0);
+    if (rc < 0) {
+        return (errno == EINTR || errno == EAGAIN || errno == EBUSY) ? 0 : -1;
+    }
+    ring->to_submit -= (uint32_t)rc;
+    return 0;
+}
+
+/* Next free SQE. The tail is published immediately: without SQPOLL the
+   kernel only reads the queue inside io_uring_enter. */
+static struct io_uring_sqe *jack_ring_get_sqe(jack_ring_t *ring) {
+    unsigned tail = *ring->sq_tail;
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= ring->sq_entries) {
+        if (jack_ring_enter(ring, 0) < 0) {
+            return NULL;
+        }
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head >= ring->sq_entries) {
+            return NULL;
+        }
+    }
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+    return sqe;
+}
+
+static int jack_ring_queue_sqe(jack_ring_t *ring, uint32_t slot) {
+    jack_ring_op_t *op = &ring->ops[slot];
+    struct io_uring_sqe *sqe = jack_ring_get_sqe(ring);
+    if (!sqe) {
+        return -1;
+    }
+    sqe->fd = op->fd;
+    if (op->fixed) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+    sqe->user_data = slot;
+    switch (op->kind) {
+    case JACK_RING_OP_RECV:
+        sqe->opcode = IORING_OP_RECV;
+        sqe->addr = (uint64_t)(uintptr_t)op->buf;
+        sqe->len = op->len;
+        break;
+    case JACK_RING_OP_SEND:
+        sqe->opcode = IORING_OP_SEND;
+        sqe->addr = (uint64_t)(uintptr_t)lean_sarray_cptr(op->payload);
+        sqe->len = op->len;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        break;
+    case JACK_RING_OP_ACCEPT:
+        sqe->opcode = IORING_OP_ACCEPT;
+        break;
+    case JACK_RING_OP_RECV_BUF:
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = (uint64_t)(uintptr_t)jack_ring_buffer(ring, op->buf_index);
+        sqe->len = op->len;
+        sqe->buf_index = (uint16_t)op->buf_index;
+        break;
+    case JACK_RING_OP_SEND_BUF:
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->addr = (uint64_t)(uintptr_t)jack_ring_buffer(ring, op->buf_index);
+        sqe->len = op->len;
+        sqe->buf_index = (uint16_t)op->buf_index;
+        break;
+    case JACK_RING_OP_SENDFILE:
+        /* Wait for the socket to drain, then retry the sendfile in-process */
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->poll32_events = POLLOUT;
+        break;
+    }
+    op->in_flight = 1;
+    ring->in_flight++;
+    return 0;
+}
+
+static int jack_ring_uring_flush(jack_ring_t *ring) {
+    uint32_t i = 0;
+    for (; i < ring->queued_count; i++) {
+        uint32_t slot = ring->queued[i];
+        if (ring->ops[slot].kind == JACK_RING_OP_SENDFILE && jack_ring_attempt(ring, slot)) {
+            continue;
+        }
+        if (jack_ring_queue_sqe(ring, slot) < 0) {
+            break;
+        }
+    }
+    /* Keep anything the submission queue could not take */
+    memmove(ring->queued, ring->queued + i, (ring->queued_count - i) * sizeof(uint32_t));
+    ring->queued_count -= i;
+    return 0;
+}
+
+/* Reap CQEs. With discard set, results are dropped (used while closing). */
+static void jack_ring_reap(jack_ring_t *ring, int discard) {
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        uint64_t user_data = cqe->user_data;
+        int32_t res = cqe->res;
+        head++;
+        if (user_data == JACK_RING_TIMEOUT) {
+            ring->timeouts_pending--;
+            continue;
+        }
+        if (user_data == JACK_RING_INTERNAL || user_data >= ring->capacity) {
+            continue;
+        }
+        uint32_t slot = (uint32_t)user_data;
+        jack_ring_op_t *op = &ring->ops[slot];
+        if (!op->in_use || !op->in_flight) {
+            continue;
+        }
+        op->in_flight = 0;
+        ring->in_flight--;
+        if (discard) {
+            if (op->kind == JACK_RING_OP_ACCEPT && res >= 0) close(res);
+            jack_ring_release_slot(ring, slot);
+        } else if (op->kind == JACK_RING_OP_SENDFILE && res >= 0) {
+            if (!jack_ring_attempt(ring, slot)) {
+                ring->queued[ring->queued_count++] = slot;
+            }
+        } else {
+            jack_ring_finish(ring, slot, res);
+        }
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* Queue a timeout that completes after `count` CQEs or `wait_ms`, whichever
+   comes first. The kernel copies the timespec when the SQE is submitted. */
+static void jack_ring_arm_timeout(jack_ring_t *ring, int wait_ms, unsigned count) {
+    struct io_uring_sqe *sqe = jack_ring_get_sqe(ring);
+    if (!sqe) {
+        return;
+    }
+    ring->ts.tv_sec = wait_ms / 1000;
+    ring->ts.tv_nsec = (long long)(wait_ms % 1000) * 1000000;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)&ring->ts;
+    sqe->len = 1;
+    sqe->off = count;
+    sqe->user_data = JACK_RING_TIMEOUT;
+    ring->timeouts_pending++;
+}
+
+/* Remove a timeout whose wait already ended, so it does not stay in the ring
+   until it expires. Its CQE (-ECANCELED) is reaped later. */
+static void jack_ring_disarm_timeout(jack_ring_t *ring) {
+    struct io_uring_sqe *sqe = jack_ring_get_sqe(ring);
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = JACK_RING_TIMEOUT;
+    sqe->user_data = JACK_RING_INTERNAL;
+    jack_ring_enter(ring, 0);
+}
+
+static int jack_ring_uring_pump(jack_ring_t *ring, int wait_ms, uint32_t want) {
+    jack_ring_uring_flush(ring);
+    unsigned min_complete = 0;
+    int armed = 0;
+    if (want > 0 && wait_ms != 0 && ring->in_flight > 0) {
+        min_complete = 1;
+        if (wait_ms > 0) {
+            uint32_t before = ring->timeouts_pending;
+            jack_ring_arm_timeout(ring, wait_ms, want);
+            armed = ring->timeouts_pending > before;
+        }
+    }
+    if ((ring->to_submit > 0 || min_complete > 0) && jack_ring_enter(ring, min_complete) < 0) {
+        return -1;
+    }
+    jack_ring_reap(ring, 0);
+    if (armed && ring->timeouts_pending > 0) {
+        jack_ring_disarm_timeout(ring);
+    }
+    return 0;
+}
+
+static int jack_ring_uring_setup(jack_ring_t *ring, uint32_t entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return -1;
+    }
+    ring->ring_fd = fd;
+
+    /* Only use io_uring when the socket opcodes exist (Linux 5.6+) */
+    size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, probe_size);
+    int supported = probe != NULL &&
+        syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+        probe->last_op >= IORING_OP_SEND &&
+        (probe->ops[IORING_OP_RECV].flags & IO_URING_OP_SUPPORTED) &&
+        (probe->ops[IORING_OP_SEND].flags & IO_URING_OP_SUPPORTED) &&
+        (probe->ops[IORING_OP_ACCEPT].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    if (!supported) {
+        close(fd);
+        ring->ring_fd = -1;
+        errno = ENOSYS;
+        return -1;
+    }
+
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size) ring->sq_size = ring->cq_size;
+        ring->cq_size = ring->sq_size;
+    }
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        ring->sq_ptr = NULL;
+        return -1;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            ring->cq_ptr = NULL;
+            return -1;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        return -1;
+    }
+
+    uint8_t *sq = ring->sq_ptr;
+    uint8_t *cq = ring->cq_ptr;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->sq_entries = params.sq_entries;
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    /* Never have more operations outstanding than the CQ can hold */
+    ring->capacity = params.cq_entries;
+    return 0;
+}
+
+static void jack_ring_uring_teardown(jack_ring_t *ring) {
+    if (ring->ring_fd >= 0 && ring->in_flight > 0) {
+        /* Cancel in-flight operations so the kernel is done with their buffers */
+        for (uint32_t slot = 0; slot < ring->capacity; slot++) {
+            if (!ring->ops[slot].in_flight) continue;
+            struct io_uring_sqe *sqe = jack_ring_get_sqe(ring);
+            if (!sqe) break;
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = slot;
+            sqe->user_data = JACK_RING_INTERNAL;
+        }
+        /* Each round waits for one completion or the round's timeout, so an
+           operation that ignores its cancellation cannot hang the close */
+        for (int round = 0; round < JACK_RING_TEARDOWN_ROUNDS && ring->in_flight > 0; round++) {
+            jack_ring_arm_timeout(ring, JACK_RING_TEARDOWN_MS, 1);
+            if (jack_ring_enter(ring, 1) < 0) break;
+            jack_ring_reap(ring, 1);
+        }
+        if (ring->in_flight > 0) {
+            /* The kernel may still write these buffers: leak them rather
+               than free them under it */
+            for (uint32_t slot = 0; slot < ring->capacity; slot++) {
+                if (!ring->ops[slot].in_flight) continue;
+                ring->ops[slot].buf = NULL;
+                ring->ops[slot].payload = NULL;
+            }
+            ring->leaked = 1;
+        }
+    }
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr) munmap(ring->cq_ptr, ring->cq_size);
+    if (ring->sq_ptr) munmap(ring->sq_ptr, ring->sq_size);
+    if (ring->ring_fd >= 0) close(ring->ring_fd);
+    ring->sqes = NULL;
+    ring->cq_ptr = NULL;
+    ring->sq_ptr = NULL;
+    ring->ring_fd = -1;
+}
+
+#endif /* JACK_HAVE_IO_URING */
+
+static void jack_ring_release(jack_ring_t *ring) {
+    if (ring->closed) {
+        return;
+    }
+#ifdef JACK_HAVE_IO_URING
+    jack_ring_uring_teardown(ring);
+#endif
+    if (ring->ops) {
+        for (uint32_t slot = 0; slot < ring->capacity; slot++) {
+            if (ring->ops[slot].in_use) {
+                jack_ring_release_slot(ring, slot);
+            }
+        }
+    }
+    for (size_t i = 0; i < ring->done_count; i++) {
+        if (ring->done[i].data) lean_dec_ref(ring->done[i].data);
+    }
+    free(ring->ops);
+    free(ring->free_slots);
+    free(ring->queued);
+    free(ring->parked);
+    free(ring->pfds);
+    free(ring->done);
+    if (!ring->leaked) free(ring->buffers);
+    free(ring->files);
+    ring->ops = NULL;
+    ring->free_slots = NULL;
+    ring->queued = NULL;
+    ring->parked = NULL;
+    ring->pfds = NULL;
+    ring->done = NULL;
+    ring->buffers = NULL;
+    ring->files = NULL;
+    ring->done_count = 0;
+    ring->closed = 1;
+}
+
+static void jack_ring_finalizer(void *ptr) {
+    jack_ring_t *ring = (jack_ring_t *)ptr;
+    jack_ring_release(ring);
+    free(ring);
+}
+
+static void jack_ring_foreach(void *ptr, b_lean_obj_arg f) {
+    /* Pending send payloads are owned references released by the ring */
+}
+
+static inline lean_obj_res jack_ring_box(jack_ring_t *ring) {
+    if (g_ring_class == NULL) {
+        g_ring_class = lean_register_external_class(
+            jack_ring_finalizer,
+            jack_ring_foreach
+        );
+    }
+    return lean_alloc_external(g_ring_class, ring);
+}
+
+static inline jack_ring_t *jack_ring_unbox(lean_obj_arg obj) {
+    return (jack_ring_t *)lean_get_external_data(obj);
+}
+
+/* Create a ring with room for `entries` submissions per batch */
+LEAN_EXPORT lean_obj_res jack_ring_new(
+    uint32_t entries,
+    uint8_t force_poll,
+    lean_obj_arg world
+) {
+    if (entries == 0) entries = 256;
+    jack_ring_t *ring = calloc(1, sizeof(jack_ring_t));
+    if (!ring) {
+        return jack_ring_error("Failed to allocate ring");
+    }
+    ring->capacity = entries * 2;
+#ifdef JACK_HAVE_IO_URING
+    ring->ring_fd = -1;
+    if (!force_poll) {
+        if (jack_ring_uring_setup(ring, entries) == 0) {
+            ring->uring = 1;
+        } else {
+            /* Kernel without io_uring (or seccomp-filtered): use the poll path */
+            jack_ring_uring_teardown(ring);
+            ring->capacity = entries * 2;
+        }
+    }
+#else
+    (void)force_poll;
+#endif
+    ring->ops = calloc(ring->capacity, sizeof(jack_ring_op_t));
+    ring->free_slots = malloc(ring->capacity * sizeof(uint32_t));
+    ring->queued = malloc(ring->capacity * sizeof(uint32_t));
+    ring->parked = malloc(ring->capacity * sizeof(uint32_t));
+    ring->pfds = malloc(ring->capacity * sizeof(struct pollfd));
+    if (!ring->ops || !ring->free_slots || !ring->queued || !ring->parked || !ring->pfds) {
+        jack_ring_release(ring);
+        free(ring);
+        return jack_ring_error("Failed to allocate ring");
+    }
+    for (uint32_t i = 0; i < ring->capacity; i++) {
+        ring->free_slots[i] = ring->capacity - 1 - i;
+    }
+    ring->free_count = ring->capacity;
+    return lean_io_result_mk_ok(jack_ring_box(ring));
+}
+
+/* Name of the active backend: "io_uring" or "poll" */
+LEAN_EXPORT lean_obj_res jack_ring_backend(
+    b_lean_obj_arg ring_obj,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    return lean_io_result_mk_ok(lean_mk_string(ring->uring ? "io_uring" : "poll"));
+}
+
+/* Reserve a slot for a new operation, or NULL with an IO error in *err */
+static jack_ring_op_t *jack_ring_prep(jack_ring_t *ring, int kind, uint32_t fd, uint8_t fixed,
+                                      uint64_t user_data, lean_obj_res *err) {
+    if (ring->closed) {
+        *err = jack_ring_error("Ring is closed");
+        return NULL;
+    }
+    if (ring->free_count == 0) {
+        *err = jack_ring_error("Ring is full: wait for completions before preparing more operations");
+        return NULL;
+    }
+    if (fixed && fd >= ring->file_count) {
+        *err = jack_io_error_from_errno(EBADF);
+        return NULL;
+    }
+    uint32_t slot = ring->free_slots[--ring->free_count];
+    jack_ring_op_t *op = &ring->ops[slot];
+    memset(op, 0, sizeof(*op));
+    op->in_use = 1;
+    op->kind = kind;
+    op->fd = (int)fd;
+    op->fixed = fixed ? 1 : 0;
+    op->user_data = user_data;
+    op->file_fd = -1;
+    ring->queued[ring->queued_count++] = slot;
+    return op;
+}
+
+static jack_ring_op_t *jack_ring_prep_buffer(jack_ring_t *ring, int kind, uint32_t fd, uint32_t buf_index,
+                                             uint32_t len, uint8_t fixed, uint64_t user_data, lean_obj_res *err) {
+    if (buf_index >= ring->buffer_count || len > ring->buffer_size) {
+        *err = jack_ring_error("Invalid registered buffer index or length");
+        return NULL;
+    }
+    jack_ring_op_t *op = jack_ring_prep(ring, kind, fd, fixed, user_data, err);
+    if (op) {
+        op->buf_index = buf_index;
+        op->len = len;
+    }
+    return op;
+}
+
+/* Undo the most recent prep after a later failure */
+static void jack_ring_unprep(jack_ring_t *ring) {
+    uint32_t slot = ring->queued[--ring->queued_count];
+    jack_ring_release_slot(ring, slot);
+}
+
+LEAN_EXPORT lean_obj_res jack_ring_prep_recv(
+    b_lean_obj_arg ring_obj,
+    uint32_t fd,
+    uint32_t max_bytes,
+    uint8_t fixed,
+    uint64_t user_data,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    lean_obj_res err = NULL;
+    jack_ring_op_t *op = jack_ring_prep(ring, JACK_RING_OP_RECV, fd, fixed, user_data, &err);
+    if (!op) return err;
+    op->buf = malloc(max_bytes > 0 ? max_bytes : 1);
+    if (!op->buf) {
+        jack_ring_unprep(ring);
+        return jack_ring_error("Failed to allocate receive buffer");
+    }
+    op->len = max_bytes;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res jack_ring_prep_send(
+    b_lean_obj_arg ring_obj,
+    uint32_t fd,
+    b_lean_obj_arg data,
+    uint8_t fixed,
+    uint64_t user_data,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    lean_obj_res err = NULL;
+    jack_ring_op_t *op = jack_ring_prep(ring, JACK_RING_OP_SEND, fd, fixed, user_data, &err);
+    if (!op) return err;
+    size_t len = lean_sarray_size(data);
+    op->len = len > UINT32_MAX ? UINT32_MAX : (uint32_t)len;
+    lean_inc_ref(data);
+    op->payload = data;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res jack_ring_prep_accept(
+    b_lean_obj_arg ring_obj,
+    uint32_t fd,
+    uint8_t fixed,
+    uint64_t user_data,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    lean_obj_res err = NULL;
+    jack_ring_op_t *op = jack_ring_prep(ring, JACK_RING_OP_ACCEPT, fd, fixed, user_data, &err);
+    if (!op) return err;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* Queue one sendfile step of up to count bytes from file_fd at offset */
+LEAN_EXPORT lean_obj_res jack_ring_prep_send_file(
+    b_lean_obj_arg ring_obj,
+    uint32_t fd,
+    uint32_t file_fd,
+    uint64_t offset,
+    uint32_t count,
+    uint8_t fixed,
+    uint64_t user_data,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    lean_obj_res err = NULL;
+    jack_ring_op_t *op = jack_ring_prep(ring, JACK_RING_OP_SENDFILE, fd, fixed, user_data, &err);
+    if (!op) return err;
+    op->file_fd = (int)file_fd;
+    op->offset = offset;
+    op->len = count;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res jack_ring_prep_recv_buffer(
+    b_lean_obj_arg ring_obj,
+    uint32_t fd,
+    uint32_t buf_index,
+    uint32_t len,
+    uint8_t fixed,
+    uint64_t user_data,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    lean_obj_res err = NULL;
+    jack_ring_op_t *op = jack_ring_prep_buffer(ring, JACK_RING_OP_RECV_BUF, fd, buf_index, len, fixed,
+                                               user_data, &err);
+    if (!op) return err;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res jack_ring_prep_send_buffer(
+    b_lean_obj_arg ring_obj,
+    uint32_t fd,
+    uint32_t buf_index,
+    uint32_t len,
+    uint8_t fixed,
+    uint64_t user_data,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    lean_obj_res err = NULL;
+    jack_ring_op_t *op = jack_ring_prep_buffer(ring, JACK_RING_OP_SEND_BUF, fd, buf_index, len, fixed,
+                                               user_data, &err);
+    if (!op) return err;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* Allocate and register count buffers of size bytes each (once per ring) */
+LEAN_EXPORT lean_obj_res jack_ring_register_buffers(
+    b_lean_obj_arg ring_obj,
+    uint32_t count,
+    uint32_t size,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    if (ring->closed) {
+        return jack_ring_error("Ring is closed");
+    }
+    if (ring->buffers) {
+        return jack_io_error_from_errno(EBUSY);
+    }
+    if (count == 0 || size == 0 || count > 1024) {
+        return jack_io_error_from_errno(EINVAL);
+    }
+    uint8_t *buffers = calloc(count, size);
+    if (!buffers) {
+        return jack_ring_error("Failed to allocate registered buffers");
+    }
+#ifdef JACK_HAVE_IO_URING
+    if (ring->uring) {
+        struct iovec *iov = malloc(count * sizeof(struct iovec));
+        if (!iov) {
+            free(buffers);
+            return jack_ring_error("Failed to allocate registered buffers");
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            iov[i].iov_base = buffers + (size_t)i * size;
+            iov[i].iov_len = size;
+        }
+        int rc = (int)syscall(__NR_io_uring_register, ring->ring_fd, IORING_REGISTER_BUFFERS, iov, count);
+        int err = errno;
+        free(iov);
+        if (rc < 0) {
+            free(buffers);
+            return jack_io_error_from_errno(err);
+        }
+    }
+#endif
+    ring->buffers = buffers;
+    ring->buffer_count = count;
+    ring->buffer_size = size;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* Copy len bytes out of a registered buffer */
+LEAN_EXPORT lean_obj_res jack_ring_read_buffer(
+    b_lean_obj_arg ring_obj,
+    uint32_t index,
+    uint32_t len,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    if (index >= ring->buffer_count || len > ring->buffer_size) {
+        return jack_ring_error("Invalid registered buffer index or length");
+    }
+    lean_obj_res arr = lean_alloc_sarray(1, len, len);
+    memcpy(lean_sarray_cptr(arr), jack_ring_buffer(ring, index), len);
+    return lean_io_result_mk_ok(arr);
+}
+
+/* Copy data into a registered buffer, returning the byte count written */
+LEAN_EXPORT lean_obj_res jack_ring_write_buffer(
+    b_lean_obj_arg ring_obj,
+    uint32_t index,
+    b_lean_obj_arg data,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    if (index >= ring->buffer_count) {
+        return jack_ring_error("Invalid registered buffer index");
+    }
+    size_t len = lean_sarray_size(data);
+    if (len > ring->buffer_size) len = ring->buffer_size;
+    memcpy(jack_ring_buffer(ring, index), lean_sarray_cptr(data), len);
+    return lean_io_result_mk_ok(lean_box_uint32((uint32_t)len));
+}
+
+/* Register a fixed-file table; operations with fixed set use indexes into it */
+LEAN_EXPORT lean_obj_res jack_ring_register_files(
+    b_lean_obj_arg ring_obj,
+    b_lean_obj_arg fds_obj,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    if (ring->closed) {
+        return jack_ring_error("Ring is closed");
+    }
+    if (ring->files) {
+        return jack_io_error_from_errno(EBUSY);
+    }
+    size_t count = lean_array_size(fds_obj);
+    if (count == 0) {
+        return jack_io_error_from_errno(EINVAL);
+    }
+    int *files = malloc(count * sizeof(int));
+    if (!files) {
+        return jack_ring_error("Failed to allocate file table");
+    }
+    for (size_t i = 0; i < count; i++) {
+        files[i] = (int)lean_unbox_uint32(lean_array_get_core(fds_obj, i));
+    }
+#ifdef JACK_HAVE_IO_URING
+    if (ring->uring &&
+        syscall(__NR_io_uring_register, ring->ring_fd, IORING_REGISTER_FILES, files, (unsigned)count) < 0) {
+        int err = errno;
+        free(files);
+        return jack_io_error_from_errno(err);
+    }
+#endif
+    ring->files = files;
+    ring->file_count = (uint32_t)count;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+static int jack_ring_pump(jack_ring_t *ring, int wait_ms, uint32_t want) {
+#ifdef JACK_HAVE_IO_URING
+    if (ring->uring) {
+        return jack_ring_uring_pump(ring, wait_ms, want);
+    }
+#endif
+    return jack_ring_fallback_pump(ring, want > 0 ? wait_ms : 0);
+}
+
+static int jack_ring_has_pending(jack_ring_t *ring) {
+#ifdef JACK_HAVE_IO_URING
+    if (ring->uring && ring->in_flight > 0) return 1;
+#endif
+    return ring->queued_count > 0 || ring->parked_count > 0;
+}
+
+/* Submit prepared operations without waiting for completions */
+LEAN_EXPORT lean_obj_res jack_ring_submit(
+    b_lean_obj_arg ring_obj,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    if (ring->closed) {
+        return jack_ring_error("Ring is closed");
+    }
+    uint32_t queued = ring->queued_count;
+    if (jack_ring_pump(ring, 0, 0) < 0) {
+        return jack_io_error_from_errno(errno);
+    }
+    return lean_io_result_mk_ok(lean_box_uint32(queued - ring->queued_count));
+}
+
+/* Completion object: data (ByteArray), then userData (u64) and result (i32) scalars */
+static lean_obj_res jack_ring_completion_mk(jack_ring_done_t *done) {
+    lean_object *obj = lean_alloc_ctor(0, 1, sizeof(uint64_t) + sizeof(uint32_t));
+    lean_ctor_set(obj, 0, done->data ? done->data : lean_alloc_sarray(1, 0, 0));
+    lean_ctor_set_uint64(obj, sizeof(void *), done->user_data);
+    lean_ctor_set_uint32(obj, sizeof(void *) + sizeof(uint64_t), (uint32_t)done->result);
+    return obj;
+}
+
+/* Submit prepared operations and wait until min_complete have completed.
+   timeout_ms: -1 for infinite wait, 0 for immediate return, >0 for milliseconds */
+LEAN_EXPORT lean_obj_res jack_ring_wait(
+    b_lean_obj_arg ring_obj,
+    uint32_t min_complete,
+    int32_t timeout_ms,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    if (ring->closed) {
+        return jack_ring_error("Ring is closed");
+    }
+    int64_t deadline = timeout_ms > 0 ? jack_ring_now_ms() + timeout_ms : 0;
+    for (;;) {
+        uint32_t want = ring->done_count >= min_complete ? 0 : min_complete - (uint32_t)ring->done_count;
+        int wait_ms = timeout_ms;
+        if (timeout_ms > 0) {
+            int64_t left = deadline - jack_ring_now_ms();
+            wait_ms = left > 0 ? (int)left : 0;
+        }
+        if (want == 0) wait_ms = 0;
+        if (jack_ring_pump(ring, wait_ms, want) < 0) {
+            return jack_io_error_from_errno(errno);
+        }
+        if (ring->done_count >= min_complete || wait_ms == 0 || !jack_ring_has_pending(ring)) {
+            break;
+        }
+    }
+
+    lean_object *arr = lean_alloc_array(ring->done_count, ring->done_count);
+    for (size_t i = 0; i < ring->done_count; i++) {
+        lean_array_set_core(arr, i, jack_ring_completion_mk(&ring->done[i]));
+    }
+    ring->done_count = 0;
+    return lean_io_result_mk_ok(arr);
+}
+
+/* Close the ring, cancelling outstanding operations. Sockets are not closed. */
+LEAN_EXPORT lean_obj_res jack_ring_close(
+    lean_obj_arg ring_obj,
+    lean_obj_arg world
+) {
+    jack_ring_t *ring = jack_ring_unbox(ring_obj);
+    jack_ring_release(ring);
+    lean_dec_ref(ring_obj);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* Wrap a descriptor (e.g. from a ring accept) in a Socket that owns it */
+LEAN_EXPORT lean_obj_res jack_socket_adopt_fd(
+    uint32_t fd,
+    lean_obj_arg world
+) {
+    jack_socket_t *sock = malloc(sizeof(jack_socket_t));
+    if (!sock) {
+        return lean_io_result_mk_error(lean_mk_io_user_error(
+            lean_mk_string("Failed to allocate socket")));
+    }
+    sock->fd = (int)fd;
+    return lean_io_result_mk_ok(jack_socket_box(sock));
+}
@@ -63,4 +63,6 @@ import Conduit.Channel.Combinators
 import Conduit.Select.Types
 import Conduit.Select
 import Conduit.Select.DSL
+import Conduit.Pipeline.StagePool
+import Conduit.Pipeline
 import Conduit.Broadcast
@@ -7,6 +7,7 @@
 
 import Conduit.Channel
 import Conduit.Channel.Combinators
+import Conduit.Pipeline.StagePool
 
 namespace Conduit
 namespace Broadcast
@@ -25,15 +26,12 @@ def create (source : Channel α) (numSubscribers : Nat)
   for _ in [:numSubscribers] do
     let ch ← Channel.newBuffered α bufferSize
     subscribers := subscribers.push ch
-  -- Spawn distributor task
+  -- Distribute on the shared stage pool; close all subscribers when source exhausted
   let subs := subscribers
-  let _ ← IO.asTask (prio := .dedicated) do
-    Channel.forEach source fun v => do
-      for sub in subs do
-        let _ ← sub.send v
-    -- Close all subscribers when source exhausted
+  let stage ← Stage.fanOut source (pure subs) do
     for sub in subs do
       sub.close
+  (← StagePool.shared).spawn stage
   pure subscribers
 
 /-- A broadcast hub allowing dynamic subscriber addition.
@@ -53,17 +51,14 @@ structure Hub (α : Type) where
 def hub (source : Channel α) (bufferSize : Nat := 16) : IO (Hub α) := do
   let state ← IO.mkRef { subscribers := (#[] : Array (Channel α)), closed := false }
   let h : Hub α := ⟨state, bufferSize⟩
-  -- Spawn distributor task
-  let _ ← IO.asTask (prio := .dedicated) do
-    Channel.forEach source fun v => do
-      let currentSubs := (← state.get).subscribers
-      for sub in currentSubs do
-        let _ ← sub.send v
+  -- Distribute on the shared stage pool, reading the subscribers once per batch
+  let stage ← Stage.fanOut source (HubState.subscribers <$> state.get) do
     -- Mark closed and close all current subscribers
     let currentSubs ← state.modifyGet fun st =>
       (st.subscribers, { st with closed := true })
     for sub in currentSubs do
       sub.close
+  (← StagePool.shared).spawn stage
   pure h
 
 /-- Subscribe to the hub, receiving all future values.
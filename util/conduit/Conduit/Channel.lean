@@ -21,6 +21,21 @@ opaque new (α : Type) : IO (Channel α)
 @[extern "conduit_channel_new_buffered"]
 opaque newBuffered (α : Type) (capacity : Nat) : IO (Channel α)
 
+/-- Create a bounded channel of the given kind.
+    The lock-free kinds (`spsc`, `mpmc`) round the capacity up to a power of
+    two; capacity 0 always gives an unbuffered mutex channel. -/
+@[extern "conduit_channel_new_kind"]
+opaque newOfKind (α : Type) (kind : ChannelKind) (capacity : Nat) : IO (Channel α)
+
+/-- Create a lock-free single-producer/single-consumer channel.
+    At most one task may send and one task may receive at a time. -/
+def newSpsc (α : Type) (capacity : Nat) : IO (Channel α) :=
+  newOfKind α .spsc capacity
+
+/-- Create a lock-free multi-producer/multi-consumer channel. -/
+def newMpmc (α : Type) (capacity : Nat) : IO (Channel α) :=
+  newOfKind α .mpmc capacity
+
 /-- Blocking send. Returns true if sent, false if channel is closed. -/
 @[extern "conduit_channel_send"]
 opaque send (ch : @& Channel α) (value : α) : IO Bool
@@ -29,6 +44,29 @@ opaque send (ch : @& Channel α) (value : α) : IO Bool
 @[extern "conduit_channel_recv"]
 opaque recv (ch : @& Channel α) : IO (Option α)
 
+/-- Blocking send of every value in order, moving as many per wakeup as the
+    buffer allows. Returns how many were sent; fewer than `values.size` only
+    if the channel closed part way. -/
+@[extern "conduit_channel_send_many"]
+opaque sendMany (ch : @& Channel α) (values : @& Array α) : IO Nat
+
+/-- Block until at least one value is available, then take up to `max`
+    (and at most the channel's capacity) without blocking further.
+    Returns an empty array once the channel is closed and drained. -/
+@[extern "conduit_channel_recv_many"]
+opaque recvMany (ch : @& Channel α) (max : @& Nat) : IO (Array α)
+
+/-- Non-blocking send of `values[start:]` in order, stopping at the first
+    value that does not fit. Returns how many were sent (0 if the channel is
+    full or closed). -/
+@[extern "conduit_channel_try_send_many"]
+opaque trySendMany (ch : @& Channel α) (values : @& Array α) (start : @& Nat := 0) : IO Nat
+
+/-- Non-blocking receive of up to `max` values (and at most the channel's
+    capacity) that are available now. -/
+@[extern "conduit_channel_try_recv_many"]
+opaque tryRecvMany (ch : @& Channel α) (max : @& Nat) : IO (Array α)
+
 /-- Non-blocking send attempt.
     Returns 0 = success, 1 = would block, 2 = closed. -/
 @[extern "conduit_channel_try_send"]
@@ -79,6 +117,20 @@ opaque recvTimeout (ch : @& Channel α) (timeoutMs : @& Nat) : IO (Option (Optio
 @[extern "conduit_channel_close"]
 opaque close (ch : @& Channel α) : IO Unit
 
+/-- Wake every task blocked on this channel, including selects over it.
+    Blocked operations never poll, so `IO.cancel` alone does not reach them:
+    after cancelling a task, interrupt the channel it waits on. Operations in
+    cancelled tasks then return as if the channel were closed (`send` gives
+    false, `recv` none, timeouts none); other waiters go back to sleep.
+    An operation that would block in an already-cancelled task returns at once. -/
+@[extern "conduit_channel_interrupt"]
+opaque interrupt (ch : @& Channel α) : IO Unit
+
+/-- Cancel a task and wake it if it is blocked on this channel. -/
+def cancelWaiter {β : Type} (ch : Channel α) (task : Task β) : IO Unit := do
+  IO.cancel task
+  ch.interrupt
+
 /-- Check if the channel is closed (non-blocking). -/
 @[extern "conduit_channel_is_closed"]
 opaque isClosed (ch : @& Channel α) : IO Bool
@@ -91,6 +143,10 @@ opaque len (ch : @& Channel α) : IO Nat
 @[extern "conduit_channel_capacity"]
 opaque capacity (ch : @& Channel α) : IO Nat
 
+/-- How the channel stores its values. -/
+@[extern "conduit_channel_kind"]
+opaque kind (ch : @& Channel α) : IO ChannelKind
+
 end Conduit.Channel
 
 namespace Conduit.Channel.Debug
@@ -106,4 +162,9 @@ opaque getAllocStats : IO (Nat × Nat)
 @[extern "conduit_reset_alloc_stats"]
 opaque resetAllocStats : IO Unit
 
+/-- Number of times a blocked channel operation or select has woken up.
+    Idle waiters do not add to it, so it measures wakeup overhead. -/
+@[extern "conduit_get_wakeup_count"]
+opaque getWakeupCount : IO Nat
+
 end Conduit.Channel.Debug
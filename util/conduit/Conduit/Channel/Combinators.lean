@@ -6,6 +6,7 @@
 
 import Conduit.Core
 import Conduit.Channel
+import Conduit.Pipeline.StagePool
 
 namespace Conduit.Channel
 
@@ -77,48 +78,46 @@ def fromList (lst : List α) : IO (Channel α) := do
 /-- Default buffer size for combinator output channels. -/
 private def defaultBufferSize : Nat := 16
 
+/-- Output channel for a combinator. Buffered outputs use the lock-free
+    MPMC ring, since the caller may share them between any number of tasks. -/
+private def newOutput (β : Type) (bufferSize : Nat) : IO (Channel β) :=
+  if bufferSize == 0 then Channel.new β else Channel.newMpmc β bufferSize
+
 /-- Map a function over values received from a channel, sending results to a new channel.
-    Spawns a background task to perform the mapping.
+    Runs as a stage on the shared `StagePool` rather than on its own thread.
     The output channel is closed when the input channel is exhausted. -/
 def map (ch : Channel α) (f : α → β) (bufferSize : Nat := defaultBufferSize) : IO (Channel β) := do
-  let out ← Channel.newBuffered β bufferSize
-  let _ ← IO.asTask (prio := .dedicated) do
-    ch.forEach fun v => do
-      let _ ← out.send (f v)
-    out.close
+  let out ← newOutput β bufferSize
+  (← StagePool.shared).spawn (← Stage.forward ch out (·.map f) out.close)
   pure out
 
 /-- Filter values from a channel based on a predicate.
-    Spawns a background task to perform the filtering.
+    Runs as a stage on the shared `StagePool` rather than on its own thread.
     The output channel is closed when the input channel is exhausted. -/
 def filter (ch : Channel α) (p : α → Bool) (bufferSize : Nat := defaultBufferSize) : IO (Channel α) := do
-  let out ← Channel.newBuffered α bufferSize
-  let _ ← IO.asTask (prio := .dedicated) do
-    ch.forEach fun v => do
-      if p v then
-        let _ ← out.send v
-    out.close
+  let out ← newOutput α bufferSize
+  (← StagePool.shared).spawn (← Stage.forward ch out (·.filter p) out.close)
   pure out
 
 /-- Merge multiple channels into one.
     Values are received from all channels and sent to the output.
-    Spawns a task for each input channel.
+    Each input gets a stage on the shared `StagePool`.
     The output channel is closed when all input channels are exhausted. -/
 def merge (channels : Array (Channel α)) (bufferSize : Nat := defaultBufferSize) : IO (Channel α) := do
-  let out ← Channel.newBuffered α bufferSize
+  let out ← newOutput α bufferSize
   let remaining ← IO.mkRef channels.size
 
   if channels.isEmpty then
     out.close
     return out
 
+  let pool ← StagePool.shared
   for ch in channels do
-    let _ ← IO.asTask (prio := .dedicated) do
-      ch.forEach fun v => do
-        let _ ← out.send v
+    let stage ← Stage.forward ch out id do
       let count ← remaining.modifyGet fun n => (n - 1, n - 1)
       if count == 0 then
         out.close
+    pool.spawn stage
 
   pure out
 
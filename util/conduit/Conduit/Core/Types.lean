@@ -6,6 +6,16 @@
 
 namespace Conduit
 
+/-- How a channel stores its buffered values.
+    - mutex: buffer guarded by a mutex; any number of senders and receivers
+    - spsc: lock-free ring for exactly one sending and one receiving task
+    - mpmc: lock-free ring for any number of senders and receivers -/
+inductive ChannelKind where
+  | mutex
+  | spsc
+  | mpmc
+  deriving Repr, BEq, Inhabited
+
 /-- Result of a send operation -/
 inductive SendResult where
   | ok      -- Successfully sent
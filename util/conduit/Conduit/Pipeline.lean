@@ -0,0 +1,76 @@
+/-
+  Conduit.Pipeline
+
+  Fused channel pipelines.
+
+  Chaining `map` and `filter` on channels puts a channel and a stage between
+  every step. A `Pipeline` composes the pure steps into one function
+  instead, so `ch.through p` runs the whole chain as a single stage with one
+  output channel. Intermediate channels are only needed where values fan in
+  (`Channel.merge`) or fan out (`Broadcast`).
+
+  ```lean
+  let p := Pipeline.start Nat |>.map (· + 1) |>.filter (· % 2 == 0) |>.map toString
+  let out ← input.through p
+  ```
+-/
+
+import Conduit.Core
+import Conduit.Channel
+import Conduit.Pipeline.StagePool
+
+namespace Conduit
+
+/-- A fused chain of pure per-value steps from `α` to `β` -/
+structure Pipeline (α β : Type) where
+  /-- Run every step on one value; `none` drops it -/
+  step : α → Option β
+
+namespace Pipeline
+
+variable {α β γ : Type}
+
+/-- The pipeline that passes every value through unchanged -/
+def start (α : Type) : Pipeline α α := ⟨some⟩
+
+/-- Append a mapping step -/
+@[inline] def map (p : Pipeline α β) (f : β → γ) : Pipeline α γ :=
+  ⟨fun a => (p.step a).map f⟩
+
+/-- Append a filtering step -/
+@[inline] def filter (p : Pipeline α β) (pred : β → Bool) : Pipeline α β :=
+  ⟨fun a => (p.step a).filter pred⟩
+
+/-- Append a step that maps and filters at once -/
+@[inline] def filterMap (p : Pipeline α β) (f : β → Option γ) : Pipeline α γ :=
+  ⟨fun a => (p.step a).bind f⟩
+
+/-- Run `q` on the output of `p` -/
+@[inline] def andThen (p : Pipeline α β) (q : Pipeline β γ) : Pipeline α γ :=
+  ⟨fun a => (p.step a).bind q.step⟩
+
+/-- Run the pipeline over a batch -/
+def run (p : Pipeline α β) (values : Array α) : Array β :=
+  values.filterMap p.step
+
+end Pipeline
+
+namespace Channel
+
+variable {α β : Type}
+
+/-- Run a fused pipeline over the values of a channel as one stage, on `pool`
+    or the shared `StagePool`. The output channel (an MPMC ring, or
+    unbuffered when `bufferSize` is 0) is closed when `ch` is exhausted. -/
+def through (ch : Channel α) (p : Pipeline α β) (bufferSize : Nat := 16)
+    (pool : Option StagePool := none) : IO (Channel β) := do
+  let out ← if bufferSize == 0 then Channel.new β else Channel.newMpmc β bufferSize
+  let pool ← match pool with
+    | some pool => pure pool
+    | none => StagePool.shared
+  pool.spawn (← Stage.forward ch out p.run out.close)
+  pure out
+
+end Channel
+
+end Conduit
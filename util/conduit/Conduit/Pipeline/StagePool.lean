@@ -0,0 +1,254 @@
+/-
+  Conduit.Pipeline.StagePool
+
+  A bounded pool of worker threads that run channel stages cooperatively.
+
+  A stage is a non-blocking step over its channels: each poll moves what it
+  can with `trySendMany`/`tryRecvMany` and reports whether it got anywhere.
+  A worker polls its stages in turn, and when none can move it blocks in a
+  single `Select.wait` on the cases its stages are waiting for plus its own
+  wake channel. Any number of stages share a fixed number of OS threads,
+  instead of each holding a dedicated one.
+-/
+
+import Std.Sync.Mutex
+import Conduit.Core
+import Conduit.Channel
+import Conduit.Select
+
+namespace Conduit
+
+/-- Result of polling a stage once -/
+inductive StageStatus where
+  /-- Moved at least one value; poll again before sleeping -/
+  | progress
+  /-- Nothing to do until one of its wake cases is ready -/
+  | blocked
+  /-- Done; the worker drops the stage -/
+  | finished
+  deriving Repr, BEq, Inhabited
+
+/-- A cooperatively scheduled channel stage. Only the worker that owns a
+    stage ever polls it. -/
+structure Stage where
+  /-- Move what can be moved without blocking -/
+  poll : IO StageStatus
+  /-- Add the select cases that make the stage worth polling again -/
+  wakeOn : Select.Builder → IO Select.Builder
+
+/-- One pool thread and the stages handed to it -/
+structure StageWorker where
+  /-- Stages given by `StagePool.spawn`, adopted on the worker's next pass -/
+  inbox : IO.Ref (Array Stage)
+  /-- Holds a token while the inbox has news; closed on shutdown -/
+  wake : Channel Unit
+  /-- Stages owned, including any still in the inbox -/
+  load : IO.Ref Nat
+
+/-- A fixed set of workers running stages -/
+structure StagePool where
+  workers : Array StageWorker
+  tasks : Array (Task (Except IO.Error Unit))
+
+namespace Stage
+
+variable {α β : Type}
+
+/-- Most values a stage receives per poll -/
+def batchSize : Nat := 64
+
+/-- Receive an available batch (possibly empty), or `none` once `ch` is
+    closed and drained. A closed channel is read once more before giving
+    up, so values sent just before the close are not lost. -/
+private def tryRecvBatch (ch : Channel α) : IO (Option (Array α)) := do
+  let batch ← ch.tryRecvMany batchSize
+  if !batch.isEmpty || !(← ch.isClosed) then
+    return some batch
+  let batch ← ch.tryRecvMany batchSize
+  return if batch.isEmpty then none else some batch
+
+/-- Results a forwarding stage has not yet handed to its output -/
+private structure Pending (β : Type) where
+  values : Array β := #[]
+  sent : Nat := 0
+
+/-- A stage that moves batches from `input` through `f` into `output`, then
+    runs `onDone` once `input` is closed and drained. If the output is closed
+    by its reader, unsent results are dropped and the stage stops early. -/
+def forward (input : Channel α) (output : Channel β) (f : Array α → Array β)
+    (onDone : IO Unit) : IO Stage := do
+  let pending ← IO.mkRef ({} : Pending β)
+  let poll : IO StageStatus := do
+    let p ← pending.get
+    let mut flushed := false
+    if p.sent < p.values.size then
+      let n ← output.trySendMany p.values p.sent
+      if p.sent + n < p.values.size then
+        if n == 0 && (← output.isClosed) then
+          pending.set {}
+          onDone
+          return .finished
+        pending.set { p with sent := p.sent + n }
+        return if n > 0 then .progress else .blocked
+      pending.set {}
+      flushed := true
+    match ← tryRecvBatch input with
+    | none =>
+      onDone
+      return .finished
+    | some batch =>
+      if batch.isEmpty then
+        return if flushed then .progress else .blocked
+      let results := f batch
+      let n ← if results.isEmpty then pure 0 else output.trySendMany results
+      if n < results.size then
+        pending.set { values := results, sent := n }
+      return .progress
+  let wakeOn (b : Select.Builder) : IO Select.Builder := do
+    let p ← pending.get
+    match p.values[p.sent]? with
+    | some v => return b.addSend output v
+    | none => return b.addRecv input
+  return { poll, wakeOn }
+
+/-- A batch a fan-out stage is still copying, with each unfinished
+    subscriber and how much of the batch it has taken -/
+private structure Copying (α : Type) where
+  values : Array α := #[]
+  targets : Array (Channel α × Nat) := #[]
+
+/-- A stage that copies every batch from `input` to each channel returned by
+    `subscribers`, read once per batch, then runs `onDone` once `input` is
+    closed and drained. A slow subscriber holds back the next batch;
+    subscribers closed by their reader are skipped. -/
+def fanOut (input : Channel α) (subscribers : IO (Array (Channel α)))
+    (onDone : IO Unit) : IO Stage := do
+  let copying ← IO.mkRef ({} : Copying α)
+  let poll : IO StageStatus := do
+    let c ← copying.get
+    let mut progressed := false
+    if !c.targets.isEmpty then
+      let mut targets : Array (Channel α × Nat) := #[]
+      for (sub, sent) in c.targets do
+        let n ← sub.trySendMany c.values sent
+        if n > 0 then
+          progressed := true
+        if sent + n < c.values.size && !(n == 0 && (← sub.isClosed)) then
+          targets := targets.push (sub, sent + n)
+      if !targets.isEmpty then
+        copying.set { c with targets }
+        return if progressed then .progress else .blocked
+      copying.set {}
+      progressed := true
+    match ← tryRecvBatch input with
+    | none =>
+      onDone
+      return .finished
+    | some batch =>
+      if batch.isEmpty then
+        return if progressed then .progress else .blocked
+      let subs ← subscribers
+      copying.set { values := batch, targets := subs.map (·, 0) }
+      return .progress
+  let wakeOn (b : Select.Builder) : IO Select.Builder := do
+    let c ← copying.get
+    if c.targets.isEmpty then
+      return b.addRecv input
+    return c.targets.foldl (init := b) fun b (sub, sent) =>
+      match c.values[sent]? with
+      | some v => b.addSend sub v
+      | none => b
+  return { poll, wakeOn }
+
+end Stage
+
+namespace StagePool
+
+/-- Poll every stage once. Returns the stages still running, whether any
+    made progress or finished, and how many finished. A stage whose poll
+    (or completion action) throws is dropped as finished, so one failing
+    stage does not stop the others on its worker. -/
+private def pollAll (stages : Array Stage) : IO (Array Stage × Bool × Nat) := do
+  let mut live : Array Stage := #[]
+  let mut progressed := false
+  let mut finished := 0
+  for stage in stages do
+    match ← stage.poll.toBaseIO with
+    | .ok .progress =>
+      progressed := true
+      live := live.push stage
+    | .ok .blocked =>
+      live := live.push stage
+    | .ok .finished | .error _ =>
+      progressed := true
+      finished := finished + 1
+  return (live, progressed, finished)
+
+private partial def workerLoop (w : StageWorker) (stages : Array Stage) : IO Unit := do
+  let adopted ← w.inbox.modifyGet fun inbox => (inbox, #[])
+  let (stages, progressed, finished) ← pollAll (stages ++ adopted)
+  if finished > 0 then
+    w.load.modify (· - finished)
+  if (← w.wake.isClosed) || (← IO.checkCanceled) then
+    return
+  unless progressed do
+    -- Sleep until a stage's channel is ready or closed, or a new stage arrives
+    let cases ← stages.foldlM (fun b stage => stage.wakeOn b) (Select.Builder.empty.addRecv w.wake)
+    let _ ← Select.wait cases
+    let _ ← w.wake.tryRecv
+  workerLoop w stages
+
+/-- Start a pool with the given number of worker threads (at least one) -/
+def new (workers : Nat := 4) : IO StagePool := do
+  let mut ws : Array StageWorker := #[]
+  let mut tasks : Array (Task (Except IO.Error Unit)) := #[]
+  for _ in [:max workers 1] do
+    let w : StageWorker := {
+      inbox := ← IO.mkRef (#[] : Array Stage)
+      wake := ← Channel.newBuffered Unit 1
+      load := ← IO.mkRef 0 }
+    tasks := tasks.push (← IO.asTask (prio := .dedicated) (workerLoop w #[]))
+    ws := ws.push w
+  return { workers := ws, tasks }
+
+/-- Hand a stage to the least loaded worker -/
+def spawn (pool : StagePool) (stage : Stage) : IO Unit := do
+  let loads ← pool.workers.mapM (·.load.get)
+  let idx := (List.range loads.size).foldl
+    (fun best i => if loads[i]! < loads[best]! then i else best) 0
+  match pool.workers[idx]? with
+  | some w =>
+    w.load.modify (· + 1)
+    w.inbox.modify (·.push stage)
+    let _ ← w.wake.trySend ()
+  | none => throw (IO.userError "stage pool has no workers")
+
+/-- Stages currently owned by each worker -/
+def loads (pool : StagePool) : IO (Array Nat) :=
+  pool.workers.mapM (·.load.get)
+
+/-- Stop every worker and wait for it to exit. Stages still running are
+    abandoned without running their completion actions. -/
+def shutdown (pool : StagePool) : IO Unit := do
+  for w in pool.workers do
+    w.wake.close
+  for t in pool.tasks do
+    let _ ← IO.wait t
+
+initialize sharedRef : IO.Ref (Option StagePool) ← IO.mkRef none
+initialize sharedMutex : Std.Mutex Unit ← Std.Mutex.new ()
+
+/-- The process-wide pool used by the channel combinators, started on first use -/
+def shared : IO StagePool := do
+  sharedMutex.atomically do
+    let current ← sharedRef.get
+    match current with
+    | some pool => return pool
+    | none =>
+      let pool ← StagePool.new
+      sharedRef.set (some pool)
+      return pool
+
+end StagePool
+
+end Conduit
@@ -0,0 +1,185 @@
+/-
+  Conduit channel throughput benchmarks.
+
+  Pushes messages between dedicated tasks through the mutex channel and the
+  lock-free SPSC and MPMC rings, one value per call and in batches with
+  `sendMany`/`recvMany`, then with several producers and consumers.
+  Finally compares a 10-stage map pipeline run on a dedicated thread per
+  stage, as chained pool stages, and as one fused `Pipeline`.
+  Run: lake exe conduit_bench [--messages=N] [--capacity=N] [--batch=N]
+-/
+import Conduit
+
+namespace ConduitBench
+
+open Conduit
+
+structure BenchConfig where
+  messages : Nat := 1000000
+  capacity : Nat := 1024
+  batch : Nat := 64
+  deriving Repr, Inhabited
+
+private def parseNatArg? (pfx : String) (arg : String) : Option Nat :=
+  if arg.startsWith pfx then
+    (arg.drop pfx.length).toNat?
+  else
+    none
+
+private partial def parseArgs (args : List String) (config : BenchConfig := {}) : BenchConfig :=
+  match args with
+  | [] => config
+  | arg :: rest =>
+    match parseNatArg? "--messages=" arg with
+    | some n => parseArgs rest { config with messages := n }
+    | none =>
+      match parseNatArg? "--capacity=" arg with
+      | some n => parseArgs rest { config with capacity := n }
+      | none =>
+        match parseNatArg? "--batch=" arg with
+        | some n => parseArgs rest { config with batch := max n 1 }
+        | none => parseArgs rest config
+
+private def withMetric (label : String) (messages : Nat) (action : IO Nat) : IO Unit := do
+  let start ← IO.monoNanosNow
+  let received ← action
+  let elapsed := (← IO.monoNanosNow) - start
+  let rate := if elapsed == 0 then 0 else messages * 1000000000 / elapsed
+  let check := if received == messages then "" else s!" [received {received}]"
+  IO.println s!"  {label}: {elapsed / 1000000}ms ({rate} msg/s){check}"
+
+private def kindName : ChannelKind → String
+  | .mutex => "mutex"
+  | .spsc => "spsc"
+  | .mpmc => "mpmc"
+
+/-- Consume until closed, one value per call -/
+private def countSingle (ch : Channel Nat) : IO Nat := do
+  let mut n := 0
+  for _ in ch do
+    n := n + 1
+  return n
+
+/-- Consume until closed, in batches -/
+private partial def countBatched (ch : Channel Nat) (batch : Nat) (n : Nat := 0) : IO Nat := do
+  let values ← ch.recvMany batch
+  if values.isEmpty then return n
+  countBatched ch batch (n + values.size)
+
+/-- Run `producers` senders and `consumers` receivers over one channel,
+    returning how many messages arrived -/
+private def transfer (ch : Channel Nat) (cfg : BenchConfig) (producers consumers : Nat)
+    (batched : Bool) : IO Nat := do
+  let perProducer := cfg.messages / producers
+  let receivers ← (List.range consumers).mapM fun _ =>
+    IO.asTask (prio := .dedicated) do
+      if batched then countBatched ch cfg.batch else countSingle ch
+  let senders ← (List.range producers).mapM fun _ =>
+    IO.asTask (prio := .dedicated) do
+      if batched then
+        let chunk := Array.range cfg.batch
+        let mut sent := 0
+        while sent < perProducer do
+          let n := min cfg.batch (perProducer - sent)
+          let _ ← ch.sendMany (if n == cfg.batch then chunk else chunk.extract 0 n)
+          sent := sent + n
+      else
+        for i in [:perProducer] do
+          let _ ← ch.send i
+  for s in senders do
+    let _ ← IO.wait s
+  ch.close
+  let mut total := 0
+  for r in receivers do
+    total := total + (← IO.ofExcept (← IO.wait r))
+  return total
+
+private def benchKinds (cfg : BenchConfig) (kinds : List ChannelKind)
+    (producers consumers : Nat) : IO Unit := do
+  let messages := cfg.messages / producers * producers
+  IO.println s!"{producers} producer(s) -> {consumers} consumer(s), {messages} messages, capacity {cfg.capacity}"
+  for kind in kinds do
+    withMetric s!"{kindName kind} single" messages do
+      transfer (← Channel.newOfKind Nat kind cfg.capacity) cfg producers consumers false
+    withMetric s!"{kindName kind} batch {cfg.batch}" messages do
+      transfer (← Channel.newOfKind Nat kind cfg.capacity) cfg producers consumers true
+
+/-- Threads in this process, from /proc (0 where unavailable) -/
+private def threadCount : IO Nat := do
+  try
+    let status ← IO.FS.readFile "/proc/self/status"
+    for line in status.splitOn "\n" do
+      if line.startsWith "Threads:" then
+        return ((line.replace "Threads:" "").trim.toNat?).getD 0
+    return 0
+  catch _ =>
+    return 0
+
+/-- Stages in the pipeline benchmark -/
+private def stageCount : Nat := 10
+
+/-- A map stage on its own dedicated thread, as the combinators ran before
+    the stage pool -/
+private def dedicatedMap (ch : Channel Nat) (f : Nat → Nat) (capacity batch : Nat) :
+    IO (Channel Nat) := do
+  let out ← Channel.newMpmc Nat capacity
+  let _ ← IO.asTask (prio := .dedicated) do
+    repeat
+      let values ← ch.recvMany batch
+      if values.isEmpty then break
+      let _ ← out.sendMany (values.map f)
+    out.close
+  pure out
+
+/-- Feed a pipeline built by `build` and report time per element and the
+    process thread count while it runs -/
+private def pipelineMetric (label : String) (cfg : BenchConfig)
+    (build : Channel Nat → IO (Channel Nat)) : IO Unit := do
+  let source ← Channel.newMpmc Nat cfg.capacity
+  let start ← IO.monoNanosNow
+  let out ← build source
+  let threads ← threadCount
+  let producer ← IO.asTask (prio := .dedicated) do
+    let chunk := Array.range cfg.batch
+    let mut sent := 0
+    while sent < cfg.messages do
+      let n := min cfg.batch (cfg.messages - sent)
+      let _ ← source.sendMany (if n == cfg.batch then chunk else chunk.extract 0 n)
+      sent := sent + n
+    source.close
+  let received ← countBatched out cfg.batch
+  let _ ← IO.wait producer
+  let elapsed := (← IO.monoNanosNow) - start
+  let perElement := if cfg.messages == 0 then 0 else elapsed / cfg.messages
+  let check := if received == cfg.messages then "" else s!" [received {received}]"
+  IO.println s!"  {label}: {elapsed / 1000000}ms ({perElement} ns/element, {threads} threads){check}"
+
+private def benchPipelines (cfg : BenchConfig) : IO Unit := do
+  IO.println s!"{stageCount}-stage map pipeline, {cfg.messages} messages, capacity {cfg.capacity}"
+  pipelineMetric "dedicated thread per stage" cfg fun source => do
+    let mut ch := source
+    for _ in [:stageCount] do
+      ch ← dedicatedMap ch (· + 1) cfg.capacity cfg.batch
+    pure ch
+  pipelineMetric "pool stages" cfg fun source => do
+    let mut ch := source
+    for _ in [:stageCount] do
+      ch ← ch.map (· + 1) cfg.capacity
+    pure ch
+  pipelineMetric "fused pipeline" cfg fun source => do
+    let mut p := Pipeline.start Nat
+    for _ in [:stageCount] do
+      p := p.map (· + 1)
+    source.through p cfg.capacity
+
+def run (args : List String) : IO Unit := do
+  let cfg := parseArgs args
+  IO.println s!"Conduit throughput benchmark ({repr cfg})"
+  benchKinds cfg [.mutex, .spsc, .mpmc] 1 1
+  benchKinds cfg [.mutex, .mpmc] 4 4
+  benchPipelines cfg
+
+end ConduitBench
+
+def main (args : List String) : IO Unit :=
+  ConduitBench.run args
@@ -16,3 +16,5 @@ import ConduitTests.BroadcastTests
 import ConduitTests.EdgeCaseTests
 import ConduitTests.StressTests
 import ConduitTests.ResourceTests
+import ConduitTests.RingTests
+import ConduitTests.PipelineTests
@@ -411,6 +411,68 @@ test "rapid send-recv-close cycle" := do
   -- If we get here without hanging or crashing, test passes
   pure ()
 
+testSuite "Cancellation"
+
+test "cancelled recv wakes on interrupt and returns none" := do
+  let ch ← Channel.new Nat
+  let receiver ← IO.asTask (prio := .dedicated) ch.recv
+  -- Let the receiver block
+  IO.sleep 20
+  ch.cancelWaiter receiver
+  let v ← IO.ofExcept (← IO.wait receiver)
+  v ≡ none
+  (← ch.isClosed) ≡ false
+
+test "cancelled send gives up and leaves the channel usable" := do
+  let ch ← Channel.new Nat
+  let sender ← IO.asTask (prio := .dedicated) (ch.send 1)
+  IO.sleep 20
+  ch.cancelWaiter sender
+  let sent ← IO.ofExcept (← IO.wait sender)
+  sent ≡ false
+  -- The retracted value is gone; a fresh handoff still works
+  let sender2 ← IO.asTask (prio := .dedicated) (ch.send 2)
+  let v ← ch.recv
+  let _ ← IO.wait sender2
+  v ≡? 2
+
+test "cancelled buffered send on a full channel returns false" := do
+  let ch ← Channel.newBuffered Nat 1
+  let _ ← ch.send 0
+  let sender ← IO.asTask (prio := .dedicated) (ch.send 1)
+  IO.sleep 20
+  ch.cancelWaiter sender
+  let sent ← IO.ofExcept (← IO.wait sender)
+  sent ≡ false
+  (← ch.len) ≡ 1
+
+test "interrupt does not disturb tasks that were not cancelled" := do
+  let ch ← Channel.newBuffered Nat 1
+  let receiver ← IO.asTask (prio := .dedicated) ch.recv
+  IO.sleep 20
+  ch.interrupt
+  let _ ← ch.send 7
+  let v ← IO.ofExcept (← IO.wait receiver)
+  v ≡? 7
+
+test "cancelled select returns none" := do
+  let ch ← Channel.new Nat
+  let waiter ← IO.asTask (prio := .dedicated) (selectWait (recvCase ch))
+  IO.sleep 20
+  ch.cancelWaiter waiter
+  let r ← IO.ofExcept (← IO.wait waiter)
+  r ≡ none
+
+test "cancelled recvTimeout returns before its deadline" := do
+  let ch ← Channel.new Nat
+  let start ← IO.monoMsNow
+  let receiver ← IO.asTask (prio := .dedicated) (ch.recvTimeout 5000)
+  IO.sleep 20
+  ch.cancelWaiter receiver
+  let r ← IO.ofExcept (← IO.wait receiver)
+  r.isNone ≡ true
+  ensure ((← IO.monoMsNow) - start < 2000) "recvTimeout should return once cancelled"
+
 
 
 end ConduitTests.ConcurrencyTests
@@ -17,6 +17,8 @@ import ConduitTests.BroadcastTests
 import ConduitTests.EdgeCaseTests
 import ConduitTests.StressTests
 import ConduitTests.ResourceTests
+import ConduitTests.RingTests
+import ConduitTests.PipelineTests
 
 open Crucible
 
@@ -0,0 +1,153 @@
+/-
+  ConduitTests.PipelineTests
+
+  Tests for fused pipelines, the stage pool and non-blocking batches.
+-/
+
+import Conduit
+import Crucible
+
+namespace ConduitTests.PipelineTests
+
+open Crucible
+open Conduit
+
+testSuite "Non-blocking Batches"
+
+test "trySendMany sends what fits and resumes from an offset" := do
+  for ch in [← Channel.newMpmc Nat 4, ← Channel.newBuffered Nat 4] do
+    let values := #[1, 2, 3, 4, 5, 6]
+    (← ch.trySendMany values) ≡ 4
+    (← ch.trySendMany values 4) ≡ 0
+    (← ch.recvMany 2) ≡ #[1, 2]
+    (← ch.trySendMany values 4) ≡ 2
+    (← ch.tryRecvMany 8) ≡ #[3, 4, 5, 6]
+    (← ch.trySendMany values 9) ≡ 0
+
+test "tryRecvMany returns empty without blocking" := do
+  let ch ← Channel.newSpsc Nat 8
+  (← ch.tryRecvMany 8) ≡ #[]
+  let _ ← ch.send 1
+  (← ch.tryRecvMany 8) ≡ #[1]
+
+test "trySendMany on unbuffered needs a waiting receiver" := do
+  let ch ← Channel.new Nat
+  (← ch.trySendMany #[1, 2]) ≡ 0
+  (← ch.tryRecvMany 4) ≡ #[]
+
+test "trySendMany on a closed channel sends nothing" := do
+  let ch ← Channel.newMpmc Nat 8
+  ch.close
+  (← ch.trySendMany #[1, 2]) ≡ 0
+
+testSuite "Pipeline"
+
+test "pipeline fuses steps in order" := do
+  let p := Pipeline.start Nat |>.map (· + 1) |>.filter (· % 2 == 0) |>.map (· * 10)
+  p.run #[1, 2, 3, 4] ≡ #[20, 40]
+
+test "andThen and filterMap compose" := do
+  let parse := Pipeline.start String |>.filterMap String.toNat?
+  let p := parse.andThen (Pipeline.start Nat |>.map (· * 2))
+  p.run #["1", "x", "3"] ≡ #[2, 6]
+
+test "through runs a fused pipeline as one stage" := do
+  let input ← Channel.fromArray (Array.range 1000)
+  let p := Pipeline.start Nat |>.filter (· % 3 == 0) |>.map (· + 1)
+  let out ← input.through p
+  (← out.drain) ≡ ((Array.range 1000).filter (· % 3 == 0)).map (· + 1)
+
+test "through closes its output when the input closes" := do
+  let input ← Channel.newMpmc Nat 4
+  let out ← input.through (Pipeline.start Nat)
+  let _ ← input.send 5
+  input.close
+  (← out.recv) ≡ some 5
+  (← out.recv) ≡ none
+
+test "through with an unbuffered output" := do
+  let input ← Channel.fromList [1, 2, 3]
+  let out ← input.through (Pipeline.start Nat |>.map (· * 2)) (bufferSize := 0)
+  (← out.drain) ≡ #[2, 4, 6]
+
+testSuite "Stage Pool"
+
+test "many chained stages share a small pool" := do
+  let pool ← StagePool.new 2
+  let input ← Channel.newMpmc Nat 8
+  let mut ch := input
+  for _ in [:20] do
+    ch ← ch.through (Pipeline.start Nat |>.map (· + 1)) (bufferSize := 4) (pool := some pool)
+  let out := ch
+  let producer ← IO.asTask (prio := .dedicated) do
+    let _ ← input.sendMany (Array.range 500)
+    input.close
+  let received ← out.drain
+  let _ ← IO.wait producer
+  received ≡ (Array.range 500).map (· + 20)
+  pool.shutdown
+
+test "spawn balances stages across workers" := do
+  let pool ← StagePool.new 2
+  let a ← Channel.newMpmc Nat 4
+  let b ← Channel.newMpmc Nat 4
+  let _ ← a.through (Pipeline.start Nat) (pool := some pool)
+  let _ ← b.through (Pipeline.start Nat) (pool := some pool)
+  (← pool.loads) ≡ #[1, 1]
+  a.close
+  b.close
+  pool.shutdown
+
+/-- Wait (up to about a second) until every worker has dropped its stages -/
+private def waitIdle (pool : StagePool) : IO Bool := do
+  for _ in [:100] do
+    if (← pool.loads).all (· == 0) then
+      return true
+    IO.sleep 10
+  return false
+
+test "a stage stops when its reader closes the output mid-stream" := do
+  let pool ← StagePool.new 1
+  let input ← Channel.newMpmc Nat 64
+  let out ← input.through (Pipeline.start Nat) (bufferSize := 2) (pool := some pool)
+  let _ ← input.sendMany (Array.range 50)
+  (← out.recv) ≡ some 0
+  -- The stage is now blocked sending into the full output
+  out.close
+  shouldSatisfy (← waitIdle pool) "stage dropped its closed output"
+  -- The worker is still serving new stages
+  let next ← (← Channel.fromList [1, 2, 3]).through (Pipeline.start Nat) (pool := some pool)
+  (← next.drain) ≡ #[1, 2, 3]
+  input.close
+  pool.shutdown
+
+test "a throwing stage does not stop its worker" := do
+  let pool ← StagePool.new 1
+  pool.spawn { poll := throw (IO.userError "boom"), wakeOn := pure }
+  shouldSatisfy (← waitIdle pool) "failed stage dropped"
+  let out ← (← Channel.fromList [1, 2]).through (Pipeline.start Nat) (pool := some pool)
+  (← out.drain) ≡ #[1, 2]
+  pool.shutdown
+
+test "stages wake on an unbuffered input" := do
+  let input ← Channel.new Nat
+  let out ← input.map (· + 1)
+  let sender ← IO.asTask (prio := .dedicated) do
+    for i in [:100] do
+      let _ ← input.send i
+    input.close
+  let received ← out.drain
+  let _ ← IO.wait sender
+  received ≡ (Array.range 100).map (· + 1)
+
+test "combinators do not start a thread per stage" := do
+  let pool ← StagePool.shared
+  let before := pool.workers.size
+  let input ← Channel.fromArray (Array.range 100)
+  let mut ch := input
+  for _ in [:10] do
+    ch ← ch.map (· + 1)
+  (← ch.drain) ≡ (Array.range 100).map (· + 10)
+  (← StagePool.shared).workers.size ≡ before
+
+end ConduitTests.PipelineTests
@@ -0,0 +1,172 @@
+/-
+  ConduitTests.RingTests
+
+  Tests for lock-free SPSC/MPMC channels and batched send/receive.
+-/
+
+import Conduit
+import Crucible
+
+namespace ConduitTests.RingTests
+
+open Crucible
+open Conduit
+
+testSuite "Channel Kinds"
+
+test "newOfKind reports its kind" := do
+  let spsc ← Channel.newSpsc Nat 8
+  let mpmc ← Channel.newMpmc Nat 8
+  let mutex ← Channel.newBuffered Nat 8
+  (← spsc.kind) ≡ ChannelKind.spsc
+  (← mpmc.kind) ≡ ChannelKind.mpmc
+  (← mutex.kind) ≡ ChannelKind.mutex
+
+test "ring capacity rounds up to a power of two" := do
+  let spsc ← Channel.newSpsc Nat 5
+  let mpmc ← Channel.newMpmc Nat 1
+  (← spsc.capacity) ≡ 8
+  (← mpmc.capacity) ≡ 2
+
+test "capacity 0 gives an unbuffered mutex channel" := do
+  let ch ← Channel.newSpsc Nat 0
+  (← ch.kind) ≡ ChannelKind.mutex
+  (← ch.capacity) ≡ 0
+
+testSuite "SPSC Channel"
+
+test "spsc preserves order across tasks" := do
+  let ch ← Channel.newSpsc Nat 16
+  let producer ← IO.asTask (prio := .dedicated) do
+    for i in [:10000] do
+      let _ ← ch.send i
+    ch.close
+  let received ← ch.drain
+  let _ ← IO.wait producer
+  received.size ≡ 10000
+  received ≡ Array.range 10000
+
+test "spsc trySend reports full and tryRecv empty" := do
+  let ch ← Channel.newSpsc Nat 2
+  (← ch.trySend 1) ≡ TrySendResult.ok
+  (← ch.trySend 2) ≡ TrySendResult.ok
+  (← ch.trySend 3) ≡ TrySendResult.full
+  (← ch.len) ≡ 2
+  let _ ← ch.recv
+  let _ ← ch.recv
+  (← ch.tryRecv).isEmpty ≡ true
+
+test "spsc close drains remaining values then returns none" := do
+  let ch ← Channel.newSpsc Nat 4
+  let _ ← ch.send 1
+  let _ ← ch.send 2
+  ch.close
+  (← ch.send 3) ≡ false
+  (← ch.recv) ≡ some 1
+  (← ch.recv) ≡ some 2
+  (← ch.recv) ≡ none
+  (← ch.tryRecv).isClosed ≡ true
+
+test "spsc timeouts expire on empty and full rings" := do
+  let ch ← Channel.newSpsc Nat 1
+  shouldBeNone (← ch.recvTimeout 20)
+  let _ ← ch.send 1
+  shouldBeNone (← ch.sendTimeout 2 20)
+  (← ch.recvTimeout 20) ≡ some (some 1)
+
+testSuite "MPMC Channel"
+
+test "mpmc delivers every value once with many producers and consumers" := do
+  let ch ← Channel.newMpmc Nat 32
+  let producers ← (List.range 4).mapM fun p =>
+    IO.asTask (prio := .dedicated) do
+      for i in [:2500] do
+        let _ ← ch.send (p * 2500 + i + 1)
+  let consumers ← (List.range 4).mapM fun _ =>
+    IO.asTask (prio := .dedicated) do
+      let mut sum := 0
+      let mut count := 0
+      for v in ch do
+        sum := sum + v
+        count := count + 1
+      return (sum, count)
+  for p in producers do
+    let _ ← IO.wait p
+  ch.close
+  let mut sum := 0
+  let mut count := 0
+  for c in consumers do
+    let (s, n) ← IO.ofExcept (← IO.wait c)
+    sum := sum + s
+    count := count + n
+  count ≡ 10000
+  sum ≡ 10000 * 10001 / 2
+
+test "select wakes on an mpmc channel" := do
+  let ch ← Channel.newMpmc Nat 4
+  let sender ← IO.asTask (prio := .dedicated) do
+    IO.sleep 20
+    let _ ← ch.send 7
+  let result ← selectWait (recvCase ch)
+  result ≡? 0
+  (← ch.recv) ≡ some 7
+  let _ ← IO.wait sender
+
+test "select send case sees space in a full ring" := do
+  let ch ← Channel.newMpmc Nat 2
+  let _ ← ch.send 1
+  let _ ← ch.send 2
+  shouldBeNone (← selectPoll (sendCase ch 3))
+  let _ ← ch.recv
+  (← selectPoll (sendCase ch 3)) ≡? 0
+
+testSuite "Batched Send/Receive"
+
+test "sendMany and recvMany move batches in order" := do
+  for ch in [← Channel.newSpsc Nat 64, ← Channel.newMpmc Nat 64, ← Channel.newBuffered Nat 64] do
+    (← ch.sendMany #[1, 2, 3, 4, 5]) ≡ 5
+    (← ch.recvMany 3) ≡ #[1, 2, 3]
+    (← ch.recvMany 10) ≡ #[4, 5]
+
+test "sendMany blocks until a consumer makes room" := do
+  let ch ← Channel.newSpsc Nat 4
+  let consumer ← IO.asTask (prio := .dedicated) ch.drain
+  let sent ← ch.sendMany (Array.range 1000)
+  ch.close
+  let received ← IO.ofExcept (← IO.wait consumer)
+  sent ≡ 1000
+  received ≡ Array.range 1000
+
+test "recvMany returns empty once closed and drained" := do
+  let ch ← Channel.newMpmc Nat 8
+  let _ ← ch.sendMany #[1, 2]
+  ch.close
+  (← ch.recvMany 8) ≡ #[1, 2]
+  (← ch.recvMany 8) ≡ #[]
+
+test "sendMany on a closed channel sends nothing" := do
+  let ch ← Channel.newMpmc Nat 8
+  ch.close
+  (← ch.sendMany #[1, 2, 3]) ≡ 0
+
+test "batches work on unbuffered channels" := do
+  let ch ← Channel.new Nat
+  let sender ← IO.asTask (prio := .dedicated) do
+    let n ← ch.sendMany #[1, 2, 3]
+    ch.close
+    return n
+  let mut received : Array Nat := #[]
+  repeat
+    let batch ← ch.recvMany 8
+    if batch.isEmpty then break
+    received := received ++ batch
+  received ≡ #[1, 2, 3]
+  (← IO.ofExcept (← IO.wait sender)) ≡ 3
+
+test "combinator outputs use mpmc rings" := do
+  let input ← Channel.fromList [1, 2, 3]
+  let output ← input.map (· * 10)
+  (← output.kind) ≡ ChannelKind.mpmc
+  (← output.drain) ≡ #[10, 20, 30]
+
+end ConduitTests.RingTests
@@ -298,6 +298,90 @@ test "many small channels with data" := do
     total := total + arr.size
   total ≡ 1000
 
+testSuite "Handoff Latency"
+
+/-- Average round trip, in nanoseconds, of `rounds` ping-pongs between the
+    caller and an echo task over a pair of channels -/
+def pingPongNanos (ping pong : Channel Nat) (rounds : Nat) : IO Nat := do
+  let echo ← IO.asTask (prio := .dedicated) do
+    for v in ping do
+      let _ ← pong.send v
+  -- Warm up so the echo task is running and blocked
+  let _ ← ping.send 0
+  let _ ← pong.recv
+  let start ← IO.monoNanosNow
+  for i in [:rounds] do
+    let _ ← ping.send i
+    let _ ← pong.recv
+  let elapsed := (← IO.monoNanosNow) - start
+  ping.close
+  let _ ← IO.wait echo
+  return elapsed / rounds
+
+test "unbuffered ping-pong round trip stays well under a poll interval" := do
+  let avg ← pingPongNanos (← Channel.new Nat) (← Channel.new Nat) 2000
+  -- A 10ms poll would put misses in the milliseconds; signalled handoff is microseconds
+  ensure (avg < 1000000) s!"average round trip {avg}ns"
+
+test "buffered ping-pong round trip stays well under a poll interval" := do
+  let avg ← pingPongNanos (← Channel.newBuffered Nat 1) (← Channel.newBuffered Nat 1) 2000
+  ensure (avg < 1000000) s!"average round trip {avg}ns"
+
+testSuite "Idle Waiters"
+
+test "blocked receivers do not wake while idle" := do
+  let ch ← Channel.newBuffered Nat 4
+  let receivers ← (List.range 8).mapM fun _ =>
+    IO.asTask (prio := .dedicated) ch.recv
+  -- Let every receiver block
+  IO.sleep 50
+  let before ← Channel.Debug.getWakeupCount
+  IO.sleep 200
+  let after ← Channel.Debug.getWakeupCount
+  ch.close
+  for r in receivers do
+    let v ← IO.ofExcept (← IO.wait r)
+    v ≡ none
+  -- Polling every 10ms would add ~160 wakeups here
+  ensure (after - before < 8) s!"{after - before} wakeups from idle receivers"
+
+test "blocked unbuffered senders and selects do not wake while idle" := do
+  let ch ← Channel.new Nat
+  let senders ← (List.range 4).mapM fun i =>
+    IO.asTask (prio := .dedicated) (ch.send i)
+  let other ← Channel.new Nat
+  let selects ← (List.range 4).mapM fun _ =>
+    IO.asTask (prio := .dedicated) (selectWait (recvCase other))
+  IO.sleep 50
+  let before ← Channel.Debug.getWakeupCount
+  IO.sleep 200
+  let after ← Channel.Debug.getWakeupCount
+  ch.close
+  other.close
+  for s in senders do
+    let _ ← IO.wait s
+  for s in selects do
+    let _ ← IO.wait s
+  ensure (after - before < 8) s!"{after - before} wakeups from idle waiters"
+
+test "each handoff costs a bounded number of wakeups" := do
+  let ch ← Channel.newBuffered Nat 1
+  let receiver ← IO.asTask (prio := .dedicated) do
+    let mut n := 0
+    for _ in ch do
+      n := n + 1
+    return n
+  IO.sleep 20
+  let before ← Channel.Debug.getWakeupCount
+  for i in [:1000] do
+    let _ ← ch.send i
+  ch.close
+  let n ← IO.ofExcept (← IO.wait receiver)
+  let after ← Channel.Debug.getWakeupCount
+  n ≡ 1000
+  -- At most one wakeup per side per value
+  ensure (after - before ≤ 2 * 1000 + 2) s!"{after - before} wakeups for 1000 values"
+
 
 
 end ConduitTests.StressTests
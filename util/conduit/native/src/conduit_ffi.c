@@ -12,6 +12,7 @@
 #include <time.h>
 #include <errno.h>
 #include <stdatomic.h>
+#include <sched.h>
 
 /* ============================================================================
  * Allocation Tracking (for testing finalizers and memory leaks)
@@ -31,6 +32,42 @@ typedef struct conduit_select_waiter {
     struct conduit_select_waiter *next;  /* Linked list for channel's waiter list */
 } conduit_select_waiter_t;
 
+/* ============================================================================
+ * Lock-free Ring Structure
+ *
+ * SPSC and MPMC channels keep their values in a bounded ring instead of the
+ * mutex-protected buffer. Head and tail live on separate cache lines so the
+ * producer and consumer do not share one. The MPMC ring is Vyukov's bounded
+ * queue: each cell carries a sequence number saying whose turn it is.
+ * ============================================================================ */
+
+#define CONDUIT_KIND_MUTEX 0
+#define CONDUIT_KIND_SPSC  1
+#define CONDUIT_KIND_MPMC  2
+
+#define CACHE_LINE 64
+
+typedef struct {
+    _Atomic size_t seq;           /* pos when free to write, pos + 1 when full */
+    lean_object *value;
+} conduit_cell_t;
+
+typedef struct conduit_ring {
+    /* Consumer side */
+    _Alignas(CACHE_LINE) _Atomic size_t head;   /* Next position to read */
+    size_t tail_cache;                           /* SPSC: consumer's last view of tail */
+
+    /* Producer side */
+    _Alignas(CACHE_LINE) _Atomic size_t tail;   /* Next position to write */
+    size_t head_cache;                           /* SPSC: producer's last view of head */
+
+    /* Immutable after creation */
+    _Alignas(CACHE_LINE) int kind;
+    size_t mask;                  /* capacity - 1; capacity is a power of two */
+    lean_object **slots;          /* SPSC storage */
+    conduit_cell_t *cells;        /* MPMC storage */
+} conduit_ring_t;
+
 /* ============================================================================
  * Channel Structure
  * ============================================================================ */
@@ -58,7 +95,15 @@ typedef struct {
     /* Select waiter list (protected by channel mutex) */
     conduit_select_waiter_t *select_waiters;  /* Head of linked list */
 
-    bool closed;
+    /* Lock-free ring for SPSC/MPMC channels (NULL for mutex channels). Values
+     * bypass the mutex; it is only taken to park and wake blocked threads. */
+    conduit_ring_t *ring;
+    _Atomic size_t send_sleepers;  /* Ring senders parked on not_full */
+    _Atomic size_t recv_sleepers;  /* Ring receivers parked on not_empty */
+    _Atomic size_t select_count;   /* Select waiters registered */
+
+    /* Written under the mutex; atomic so ring fast paths can read it */
+    _Atomic bool closed;
 } conduit_channel_t;
 
 /* Forward declarations for select waiter helpers */
@@ -67,24 +112,360 @@ static void select_unregister_waiter(conduit_channel_t *ch, conduit_select_waite
 static void select_notify_waiters(conduit_channel_t *ch);
 
 /* ============================================================================
- * Interruptible Wait Helper
+ * Blocking Wait Helpers
  *
- * Uses a short timeout (10ms) instead of blocking forever, allowing
- * the loop to re-check conditions periodically. This makes operations
- * interruptible by Lean's IO.cancel mechanism.
+ * Waiters block on the channel's condition variables with no deadline, so an
+ * idle sender or receiver costs nothing until it is signalled. Lean's
+ * IO.cancel only sets a flag on the task, so cancellation is delivered by an
+ * explicit wake (conduit_channel_interrupt): every waiter re-checks its own
+ * task's cancellation flag whenever it wakes and backs out if it is set.
  * ============================================================================ */
 
-#define POLL_INTERVAL_NS 10000000  /* 10ms in nanoseconds */
+/* Wakeups of blocked waiters, for measuring idle cost in tests */
+static _Atomic int64_t g_wakeup_count = 0;
+
+/*
+ * Block on `cond` (channel mutex held) until signalled. Returns false if the
+ * calling task has been cancelled; the caller must then back out. A wakeup
+ * consumed by a cancelled waiter is passed on so it is not lost.
+ */
+static bool channel_wait(conduit_channel_t *ch, pthread_cond_t *cond) {
+    if (lean_io_check_canceled_core()) {
+        return false;
+    }
+    pthread_cond_wait(cond, &ch->mutex);
+    atomic_fetch_add(&g_wakeup_count, 1);
+    if (lean_io_check_canceled_core()) {
+        pthread_cond_signal(cond);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Like channel_wait with an absolute CLOCK_REALTIME deadline.
+ * Returns 0, ETIMEDOUT, or ECANCELED if the calling task has been cancelled.
+ */
+static int channel_timedwait(conduit_channel_t *ch, pthread_cond_t *cond,
+                             const struct timespec *deadline) {
+    if (lean_io_check_canceled_core()) {
+        return ECANCELED;
+    }
+    int rc = pthread_cond_timedwait(cond, &ch->mutex, deadline);
+    atomic_fetch_add(&g_wakeup_count, 1);
+    if (rc != ETIMEDOUT && lean_io_check_canceled_core()) {
+        pthread_cond_signal(cond);
+        return ECANCELED;
+    }
+    return rc;
+}
 
-static int cond_wait_interruptible(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+/*
+ * An unbuffered handoff is in progress from the moment a sender publishes its
+ * value until that sender has seen it taken (or given up) and cleared the slot.
+ */
+static inline bool handoff_busy(conduit_channel_t *ch) {
+    return ch->pending_ready || ch->pending_taken;
+}
+
+/* Clear the handoff slot and let queued senders (and select) try again */
+static void handoff_finish(conduit_channel_t *ch) {
+    ch->pending_value = NULL;
+    ch->pending_ready = false;
+    ch->pending_taken = false;
+    pthread_cond_broadcast(&ch->not_full);
+    select_notify_waiters(ch);
+}
+
+/* ============================================================================
+ * Lock-free Ring Operations
+ * ============================================================================ */
+
+static conduit_ring_t *ring_new(int kind, size_t capacity) {
+    size_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    /* Vyukov's sequence scheme needs at least two cells */
+    if (kind == CONDUIT_KIND_MPMC && cap < 2) cap = 2;
+
+    conduit_ring_t *r = (conduit_ring_t *)aligned_alloc(CACHE_LINE, sizeof(conduit_ring_t));
+    if (!r) return NULL;
+    memset(r, 0, sizeof(conduit_ring_t));
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->kind = kind;
+    r->mask = cap - 1;
+
+    if (kind == CONDUIT_KIND_SPSC) {
+        r->slots = (lean_object **)calloc(cap, sizeof(lean_object *));
+        if (!r->slots) {
+            free(r);
+            return NULL;
+        }
+    } else {
+        r->cells = (conduit_cell_t *)malloc(cap * sizeof(conduit_cell_t));
+        if (!r->cells) {
+            free(r);
+            return NULL;
+        }
+        for (size_t i = 0; i < cap; i++) {
+            atomic_init(&r->cells[i].seq, i);
+            r->cells[i].value = NULL;
+        }
+    }
+    return r;
+}
+
+static inline size_t ring_capacity(conduit_ring_t *r) {
+    return r->mask + 1;
+}
+
+/* Values in the ring, possibly including ones still being written or read */
+static size_t ring_len(conduit_ring_t *r) {
+    size_t head = atomic_load(&r->head);
+    size_t tail = atomic_load(&r->tail);
+    size_t len = tail - head;
+    return len > ring_capacity(r) ? ring_capacity(r) : len;
+}
+
+/*
+ * Push up to n values, returning how many were pushed (0 when full).
+ * SPSC rings publish the whole batch with one store. The caller owns the
+ * references being pushed.
+ */
+static size_t ring_push(conduit_ring_t *r, lean_object **values, size_t n) {
+    if (r->kind == CONDUIT_KIND_SPSC) {
+        size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        size_t free_slots = ring_capacity(r) - (tail - r->head_cache);
+        if (free_slots < n) {
+            r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+            free_slots = ring_capacity(r) - (tail - r->head_cache);
+        }
+        if (n > free_slots) n = free_slots;
+        for (size_t i = 0; i < n; i++) {
+            r->slots[(tail + i) & r->mask] = values[i];
+        }
+        if (n > 0) {
+            atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+        }
+        return n;
+    }
+
+    size_t pushed = 0;
+    while (pushed < n) {
+        size_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        conduit_cell_t *cell;
+        for (;;) {
+            cell = &r->cells[pos & r->mask];
+            size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (atomic_compare_exchange_weak_explicit(&r->tail, &pos, pos + 1,
+                        memory_order_relaxed, memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return pushed; /* full */
+            } else {
+                pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            }
+        }
+        cell->value = values[pushed++];
+        atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    }
+    return pushed;
+}
+
+/* Pop up to n values into out, returning how many were popped (0 when empty) */
+static size_t ring_pop(conduit_ring_t *r, lean_object **out, size_t n) {
+    if (r->kind == CONDUIT_KIND_SPSC) {
+        size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+        size_t avail = r->tail_cache - head;
+        if (avail < n) {
+            r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+            avail = r->tail_cache - head;
+        }
+        if (n > avail) n = avail;
+        for (size_t i = 0; i < n; i++) {
+            size_t idx = (head + i) & r->mask;
+            out[i] = r->slots[idx];
+            r->slots[idx] = NULL;
+        }
+        if (n > 0) {
+            atomic_store_explicit(&r->head, head + n, memory_order_release);
+        }
+        return n;
+    }
+
+    size_t popped = 0;
+    while (popped < n) {
+        size_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        conduit_cell_t *cell;
+        for (;;) {
+            cell = &r->cells[pos & r->mask];
+            size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + 1,
+                        memory_order_relaxed, memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return popped; /* empty */
+            } else {
+                pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+            }
+        }
+        out[popped++] = cell->value;
+        cell->value = NULL;
+        atomic_store_explicit(&cell->seq, pos + r->mask + 1, memory_order_release);
+    }
+    return popped;
+}
+
+/* Release every value left in a ring and free it (finalizer only) */
+static void ring_free(conduit_ring_t *r) {
+    lean_object *value;
+    while (ring_pop(r, &value, 1) == 1) {
+        lean_dec(value);
+    }
+    free(r->slots);
+    free(r->cells);
+    free(r);
+}
+
+/*
+ * Wake parked threads after a ring operation. Parked threads bump their
+ * sleeper count under the mutex before re-checking the ring, and we publish
+ * before reading the counts, so with the fence one side always sees the other.
+ */
+static void ring_wake(conduit_channel_t *ch, _Atomic size_t *sleepers, pthread_cond_t *cond) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(sleepers, memory_order_relaxed) == 0 &&
+        atomic_load_explicit(&ch->select_count, memory_order_relaxed) == 0) {
+        return;
+    }
+    pthread_mutex_lock(&ch->mutex);
+    pthread_cond_broadcast(cond);
+    select_notify_waiters(ch);
+    pthread_mutex_unlock(&ch->mutex);
+}
+
+/* Values were pushed: wake receivers and selects */
+static inline void ring_wake_receivers(conduit_channel_t *ch) {
+    ring_wake(ch, &ch->recv_sleepers, &ch->not_empty);
+}
+
+/* Values were popped: wake senders and selects */
+static inline void ring_wake_senders(conduit_channel_t *ch) {
+    ring_wake(ch, &ch->send_sleepers, &ch->not_full);
+}
+
+/*
+ * Park until a sender (sending = true) or receiver could make progress.
+ * Returns 0 to retry the ring, EPIPE if the channel is closed (and, for
+ * receivers, drained), ETIMEDOUT, or ECANCELED. deadline may be NULL.
+ */
+static int ring_park(conduit_channel_t *ch, bool sending, const struct timespec *deadline) {
+    _Atomic size_t *sleepers = sending ? &ch->send_sleepers : &ch->recv_sleepers;
+    pthread_cond_t *cond = sending ? &ch->not_full : &ch->not_empty;
+    bool waited = false;
+    int rc = 0;
+
+    pthread_mutex_lock(&ch->mutex);
+    atomic_fetch_add(sleepers, 1);
+    for (;;) {
+        if (sending && ch->closed) {
+            rc = EPIPE;
+            break;
+        }
+        size_t len = ring_len(ch->ring);
+        if (sending ? len < ring_capacity(ch->ring) : len > 0) {
+            break;
+        }
+        if (ch->closed) {
+            rc = EPIPE;
+            break;
+        }
+        if (deadline) {
+            rc = channel_timedwait(ch, cond, deadline);
+        } else {
+            rc = channel_wait(ch, cond) ? 0 : ECANCELED;
+        }
+        if (rc != 0) break;
+        waited = true;
+    }
+    atomic_fetch_sub(sleepers, 1);
+    pthread_mutex_unlock(&ch->mutex);
+
+    /* An MPMC cell can be claimed but not yet written; let its owner finish */
+    if (rc == 0 && !waited) sched_yield();
+    return rc;
+}
+
+/* Absolute CLOCK_REALTIME deadline timeout_ms from now */
+static struct timespec deadline_after_ms(size_t timeout_ms) {
     struct timespec deadline;
     clock_gettime(CLOCK_REALTIME, &deadline);
-    deadline.tv_nsec += POLL_INTERVAL_NS;
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
     if (deadline.tv_nsec >= 1000000000) {
         deadline.tv_sec++;
         deadline.tv_nsec -= 1000000000;
     }
-    return pthread_cond_timedwait(cond, mutex, &deadline);
+    return deadline;
+}
+
+/*
+ * Ring send. Returns 0=ok, 1=timeout (or would block), 2=closed; a cancelled
+ * task gets 2 when waiting forever and 1 with a deadline, like the mutex paths.
+ * Takes ownership of value. block = false makes it a try_send.
+ */
+static int ring_send(conduit_channel_t *ch, lean_object *value, bool block,
+                     const struct timespec *deadline) {
+    for (;;) {
+        if (ch->closed) {
+            lean_dec(value);
+            return 2;
+        }
+        if (ring_push(ch->ring, &value, 1) == 1) {
+            ring_wake_receivers(ch);
+            return 0;
+        }
+        if (!block) {
+            lean_dec(value);
+            return 1;
+        }
+        int rc = ring_park(ch, true, deadline);
+        if (rc != 0) {
+            lean_dec(value);
+            return (rc == EPIPE || (rc == ECANCELED && !deadline)) ? 2 : 1;
+        }
+    }
+}
+
+/*
+ * Ring receive. Returns the value, or NULL with *status set to 1 for timeout
+ * (or empty / cancelled) and 2 for closed and drained.
+ */
+static lean_object *ring_recv(conduit_channel_t *ch, bool block,
+                              const struct timespec *deadline, int *status) {
+    for (;;) {
+        lean_object *value;
+        if (ring_pop(ch->ring, &value, 1) == 1) {
+            ring_wake_senders(ch);
+            return value;
+        }
+        if (!block) {
+            /* Only report closed once nothing is left in flight */
+            *status = (ch->closed && ring_len(ch->ring) == 0) ? 2 : 1;
+            return NULL;
+        }
+        int rc = ring_park(ch, false, deadline);
+        if (rc != 0) {
+            *status = rc == EPIPE ? 2 : 1;
+            return NULL;
+        }
+    }
 }
 
 /* ============================================================================
@@ -114,6 +495,10 @@ static void conduit_channel_finalizer(void *ptr) {
             lean_dec(ch->pending_value);
         }
 
+        if (ch->ring) {
+            ring_free(ch->ring);
+        }
+
         pthread_mutex_unlock(&ch->mutex);
 
         pthread_mutex_destroy(&ch->mutex);
@@ -194,7 +579,11 @@ LEAN_EXPORT lean_obj_res conduit_channel_new(lean_obj_arg world) {
     ch->pending_taken = false;
     ch->waiting_receivers = 0;
     ch->select_waiters = NULL;
-    ch->closed = false;
+    ch->ring = NULL;
+    atomic_init(&ch->send_sleepers, 0);
+    atomic_init(&ch->recv_sleepers, 0);
+    atomic_init(&ch->select_count, 0);
+    atomic_init(&ch->closed, false);
 
     atomic_fetch_add(&g_channel_alloc_count, 1);
     return lean_io_result_mk_ok(conduit_channel_box(ch));
@@ -259,12 +648,52 @@ LEAN_EXPORT lean_obj_res conduit_channel_new_buffered(
     ch->pending_taken = false;
     ch->waiting_receivers = 0;
     ch->select_waiters = NULL;
-    ch->closed = false;
+    ch->ring = NULL;
+    atomic_init(&ch->send_sleepers, 0);
+    atomic_init(&ch->recv_sleepers, 0);
+    atomic_init(&ch->select_count, 0);
+    atomic_init(&ch->closed, false);
 
     atomic_fetch_add(&g_channel_alloc_count, 1);
     return lean_io_result_mk_ok(conduit_channel_box(ch));
 }
 
+/* ============================================================================
+ * conduit_channel_new_kind : Type → ChannelKind → Nat → IO (Channel α)
+ *
+ * Create a bounded channel of the given kind (0=mutex, 1=SPSC, 2=MPMC).
+ * Ring kinds round the capacity up to a power of two. Capacity 0 always
+ * gives an unbuffered mutex channel.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res conduit_channel_new_kind(
+    uint8_t kind,
+    b_lean_obj_arg capacity_obj,
+    lean_obj_arg world
+) {
+    size_t capacity = lean_usize_of_nat(capacity_obj);
+
+    if (capacity == 0 || kind == CONDUIT_KIND_MUTEX) {
+        return conduit_channel_new_buffered(capacity_obj, world);
+    }
+
+    conduit_ring_t *ring = ring_new(kind, capacity);
+    if (!ring) {
+        return mk_io_error("Failed to allocate channel ring");
+    }
+
+    lean_object *result = conduit_channel_new(world);
+    if (lean_io_result_is_error(result)) {
+        ring_free(ring);
+        return result;
+    }
+
+    conduit_channel_t *ch = conduit_channel_unbox(lean_io_result_get_value(result));
+    ch->ring = ring;
+    ch->capacity = ring_capacity(ring);
+    return result;
+}
+
 /* ============================================================================
  * conduit_channel_send : Channel α → α → IO Bool
  *
@@ -279,6 +708,11 @@ LEAN_EXPORT lean_obj_res conduit_channel_send(
     (void)world;
     conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
 
+    if (ch->ring) {
+        int status = ring_send(ch, value, true, NULL);
+        return lean_io_result_mk_ok(lean_box(status == 0 ? 1 : 0));
+    }
+
     pthread_mutex_lock(&ch->mutex);
 
     /* Check if closed */
@@ -289,9 +723,13 @@ LEAN_EXPORT lean_obj_res conduit_channel_send(
     }
 
     if (ch->capacity == 0) {
-        /* Unbuffered channel: wait for receiver */
-        while (ch->pending_ready && !ch->closed) {
-            cond_wait_interruptible(&ch->not_full, &ch->mutex);
+        /* Unbuffered channel: wait for any earlier handoff to finish */
+        while (handoff_busy(ch) && !ch->closed) {
+            if (!channel_wait(ch, &ch->not_full)) {
+                pthread_mutex_unlock(&ch->mutex);
+                lean_dec(value);
+                return lean_io_result_mk_ok(lean_box(0)); /* false */
+            }
         }
 
         if (ch->closed) {
@@ -308,20 +746,18 @@ LEAN_EXPORT lean_obj_res conduit_channel_send(
         pthread_cond_signal(&ch->not_empty);
         select_notify_waiters(ch);
 
-        /* Wait for receiver to take it or channel to close */
+        /* Wait for receiver to take it, channel to close, or cancellation */
         while (!ch->pending_taken && !ch->closed) {
-            cond_wait_interruptible(&ch->not_full, &ch->mutex);
+            if (!channel_wait(ch, &ch->not_full)) break;
         }
 
         bool success = ch->pending_taken;
-        ch->pending_value = NULL;
-        ch->pending_ready = false;
-        ch->pending_taken = false;
+        handoff_finish(ch);
 
         pthread_mutex_unlock(&ch->mutex);
 
         if (!success) {
-            /* Channel closed before receiver took value */
+            /* Channel closed (or task cancelled) before receiver took value */
             lean_dec(value);
         }
 
@@ -329,7 +765,11 @@ LEAN_EXPORT lean_obj_res conduit_channel_send(
     } else {
         /* Buffered channel: wait for space */
         while (ch->count >= ch->capacity && !ch->closed) {
-            cond_wait_interruptible(&ch->not_full, &ch->mutex);
+            if (!channel_wait(ch, &ch->not_full)) {
+                pthread_mutex_unlock(&ch->mutex);
+                lean_dec(value);
+                return lean_io_result_mk_ok(lean_box(0)); /* false */
+            }
         }
 
         if (ch->closed) {
@@ -365,14 +805,32 @@ LEAN_EXPORT lean_obj_res conduit_channel_recv(
     (void)world;
     conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
 
+    if (ch->ring) {
+        int status;
+        lean_object *value = ring_recv(ch, true, NULL, &status);
+        if (!value) {
+            return lean_io_result_mk_ok(lean_box(0)); /* none */
+        }
+        lean_object *some = lean_alloc_ctor(1, 1, 0);
+        lean_ctor_set(some, 0, value);
+        return lean_io_result_mk_ok(some);
+    }
+
     pthread_mutex_lock(&ch->mutex);
 
     if (ch->capacity == 0) {
         /* Unbuffered channel: wait for sender */
         while (!ch->pending_ready && !ch->closed) {
-            ch->waiting_receivers++;
-            cond_wait_interruptible(&ch->not_empty, &ch->mutex);
+            /* A waiting receiver makes select send cases ready */
+            if (ch->waiting_receivers++ == 0) select_notify_waiters(ch);
+            bool woken = channel_wait(ch, &ch->not_empty);
             ch->waiting_receivers--;
+            if (!woken) {
+                /* A try_send may be waiting on us to take its value */
+                pthread_cond_broadcast(&ch->not_full);
+                pthread_mutex_unlock(&ch->mutex);
+                return lean_io_result_mk_ok(lean_box(0)); /* none */
+            }
         }
 
         if (ch->pending_ready && !ch->pending_taken) {
@@ -381,8 +839,8 @@ LEAN_EXPORT lean_obj_res conduit_channel_recv(
             ch->pending_taken = true;
             ch->pending_ready = false;  /* Clear to prevent duplicate reads */
 
-            /* Signal sender that we took it */
-            pthread_cond_signal(&ch->not_full);
+            /* Wake the sender; queued senders share the condition variable */
+            pthread_cond_broadcast(&ch->not_full);
             select_notify_waiters(ch);
 
             pthread_mutex_unlock(&ch->mutex);
@@ -399,7 +857,10 @@ LEAN_EXPORT lean_obj_res conduit_channel_recv(
     } else {
         /* Buffered channel: wait for data */
         while (ch->count == 0 && !ch->closed) {
-            cond_wait_interruptible(&ch->not_empty, &ch->mutex);
+            if (!channel_wait(ch, &ch->not_empty)) {
+                pthread_mutex_unlock(&ch->mutex);
+                return lean_io_result_mk_ok(lean_box(0)); /* none */
+            }
         }
 
         if (ch->count == 0) {
@@ -441,6 +902,10 @@ LEAN_EXPORT lean_obj_res conduit_channel_try_send(
     (void)world;
     conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
 
+    if (ch->ring) {
+        return lean_io_result_mk_ok(lean_box(ring_send(ch, value, false, NULL)));
+    }
+
     pthread_mutex_lock(&ch->mutex);
 
     if (ch->closed) {
@@ -451,7 +916,7 @@ LEAN_EXPORT lean_obj_res conduit_channel_try_send(
 
     if (ch->capacity == 0) {
         /* Unbuffered: can send if receiver is waiting and no sender in progress */
-        if (ch->waiting_receivers > 0 && !ch->pending_ready) {
+        if (ch->waiting_receivers > 0 && !handoff_busy(ch)) {
             /* Perform the handoff */
             ch->pending_value = value;
             ch->pending_ready = true;
@@ -461,19 +926,20 @@ LEAN_EXPORT lean_obj_res conduit_channel_try_send(
             pthread_cond_signal(&ch->not_empty);
             select_notify_waiters(ch);
 
-            /* Wait for receiver to take it (they should be immediate) */
-            while (!ch->pending_taken && !ch->closed) {
-                cond_wait_interruptible(&ch->not_full, &ch->mutex);
+            /* Wait for receiver to take it (they should be immediate),
+             * giving up if every waiting receiver was cancelled */
+            while (!ch->pending_taken && !ch->closed && ch->waiting_receivers > 0) {
+                if (!channel_wait(ch, &ch->not_full)) break;
             }
 
             bool success = ch->pending_taken;
-            ch->pending_value = NULL;
-            ch->pending_ready = false;
-            ch->pending_taken = false;
+            bool closed = ch->closed;
+            handoff_finish(ch);
 
             pthread_mutex_unlock(&ch->mutex);
-            if (!success) lean_dec(value);
-            return lean_io_result_mk_ok(lean_box(success ? 0 : 2)); /* ok or closed */
+            if (success) return lean_io_result_mk_ok(lean_box(0)); /* ok */
+            lean_dec(value);
+            return lean_io_result_mk_ok(lean_box(closed ? 2 : 1)); /* closed or would block */
         }
         /* No receiver waiting - would block */
         pthread_mutex_unlock(&ch->mutex);
@@ -515,6 +981,18 @@ LEAN_EXPORT lean_obj_res conduit_channel_try_recv(
     (void)world;
     conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
 
+    if (ch->ring) {
+        int status;
+        lean_object *value = ring_recv(ch, false, NULL, &status);
+        if (value) {
+            lean_object *result = lean_alloc_ctor(0, 1, 0);
+            lean_ctor_set(result, 0, value);
+            return lean_io_result_mk_ok(result);
+        }
+        /* .closed (constructor 2) or .empty (constructor 1) */
+        return lean_io_result_mk_ok(lean_alloc_ctor(status == 2 ? 2 : 1, 0, 0));
+    }
+
     pthread_mutex_lock(&ch->mutex);
 
     if (ch->capacity == 0) {
@@ -523,7 +1001,7 @@ LEAN_EXPORT lean_obj_res conduit_channel_try_recv(
             lean_object *value = ch->pending_value;
             ch->pending_taken = true;
             ch->pending_ready = false;  /* Clear to prevent duplicate reads */
-            pthread_cond_signal(&ch->not_full);
+            pthread_cond_broadcast(&ch->not_full);
             select_notify_waiters(ch);
             pthread_mutex_unlock(&ch->mutex);
 
@@ -588,6 +1066,11 @@ LEAN_EXPORT lean_obj_res conduit_channel_send_timeout(
     (void)world;
     conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
 
+    if (ch->ring) {
+        struct timespec deadline = deadline_after_ms(timeout_ms);
+        return lean_io_result_mk_ok(lean_box(ring_send(ch, value, true, &deadline)));
+    }
+
     pthread_mutex_lock(&ch->mutex);
 
     /* Check if closed */
@@ -597,21 +1080,13 @@ LEAN_EXPORT lean_obj_res conduit_channel_send_timeout(
         return lean_io_result_mk_ok(lean_box(2)); /* closed */
     }
 
-    /* Calculate deadline */
-    struct timespec deadline;
-    clock_gettime(CLOCK_REALTIME, &deadline);
-    deadline.tv_sec += timeout_ms / 1000;
-    deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
-    if (deadline.tv_nsec >= 1000000000) {
-        deadline.tv_sec++;
-        deadline.tv_nsec -= 1000000000;
-    }
+    struct timespec deadline = deadline_after_ms(timeout_ms);
 
     if (ch->capacity == 0) {
-        /* Unbuffered channel: wait for receiver with timeout */
-        while (ch->pending_ready && !ch->closed) {
-            int rc = pthread_cond_timedwait(&ch->not_full, &ch->mutex, &deadline);
-            if (rc == ETIMEDOUT) {
+        /* Unbuffered channel: wait for any earlier handoff with timeout */
+        while (handoff_busy(ch) && !ch->closed) {
+            int rc = channel_timedwait(ch, &ch->not_full, &deadline);
+            if (rc != 0) {
                 pthread_mutex_unlock(&ch->mutex);
                 lean_dec(value);
                 return lean_io_result_mk_ok(lean_box(1)); /* timeout */
@@ -634,12 +1109,10 @@ LEAN_EXPORT lean_obj_res conduit_channel_send_timeout(
 
         /* Wait for receiver to take it or channel to close or timeout */
         while (!ch->pending_taken && !ch->closed) {
-            int rc = pthread_cond_timedwait(&ch->not_full, &ch->mutex, &deadline);
-            if (rc == ETIMEDOUT) {
-                /* Timeout - clean up pending state */
-                ch->pending_value = NULL;
-                ch->pending_ready = false;
-                ch->pending_taken = false;
+            int rc = channel_timedwait(ch, &ch->not_full, &deadline);
+            if (rc != 0) {
+                /* Timeout (or cancelled) - clean up pending state */
+                handoff_finish(ch);
                 pthread_mutex_unlock(&ch->mutex);
                 lean_dec(value);
                 return lean_io_result_mk_ok(lean_box(1)); /* timeout */
@@ -647,9 +1120,7 @@ LEAN_EXPORT lean_obj_res conduit_channel_send_timeout(
         }
 
         bool success = ch->pending_taken;
-        ch->pending_value = NULL;
-        ch->pending_ready = false;
-        ch->pending_taken = false;
+        handoff_finish(ch);
 
         pthread_mutex_unlock(&ch->mutex);
 
@@ -663,8 +1134,8 @@ LEAN_EXPORT lean_obj_res conduit_channel_send_timeout(
     } else {
         /* Buffered channel: wait for space with timeout */
         while (ch->count >= ch->capacity && !ch->closed) {
-            int rc = pthread_cond_timedwait(&ch->not_full, &ch->mutex, &deadline);
-            if (rc == ETIMEDOUT) {
+            int rc = channel_timedwait(ch, &ch->not_full, &deadline);
+            if (rc != 0) {
                 pthread_mutex_unlock(&ch->mutex);
                 lean_dec(value);
                 return lean_io_result_mk_ok(lean_box(1)); /* timeout */
@@ -706,25 +1177,36 @@ LEAN_EXPORT lean_obj_res conduit_channel_recv_timeout(
     (void)world;
     conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
 
+    if (ch->ring) {
+        struct timespec deadline = deadline_after_ms(timeout_ms);
+        int status;
+        lean_object *value = ring_recv(ch, true, &deadline, &status);
+        if (!value) {
+            if (status == 1) {
+                return lean_io_result_mk_ok(lean_box(0)); /* none (timeout) */
+            }
+            lean_object *outer = lean_alloc_ctor(1, 1, 0); /* some none (closed) */
+            lean_ctor_set(outer, 0, lean_box(0));
+            return lean_io_result_mk_ok(outer);
+        }
+        lean_object *inner = lean_alloc_ctor(1, 1, 0);
+        lean_ctor_set(inner, 0, value);
+        lean_object *outer = lean_alloc_ctor(1, 1, 0);
+        lean_ctor_set(outer, 0, inner);
+        return lean_io_result_mk_ok(outer);
+    }
+
     pthread_mutex_lock(&ch->mutex);
 
-    /* Calculate deadline */
-    struct timespec deadline;
-    clock_gettime(CLOCK_REALTIME, &deadline);
-    deadline.tv_sec += timeout_ms / 1000;
-    deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
-    if (deadline.tv_nsec >= 1000000000) {
-        deadline.tv_sec++;
-        deadline.tv_nsec -= 1000000000;
-    }
+    struct timespec deadline = deadline_after_ms(timeout_ms);
 
     if (ch->capacity == 0) {
         /* Unbuffered channel: wait for sender with timeout */
         while (!ch->pending_ready && !ch->closed) {
-            ch->waiting_receivers++;
-            int rc = pthread_cond_timedwait(&ch->not_empty, &ch->mutex, &deadline);
+            if (ch->waiting_receivers++ == 0) select_notify_waiters(ch);
+            int rc = channel_timedwait(ch, &ch->not_empty, &deadline);
             ch->waiting_receivers--;
-            if (rc == ETIMEDOUT) {
+            if (rc != 0) {
                 pthread_mutex_unlock(&ch->mutex);
                 /* Return none (timeout) */
                 return lean_io_result_mk_ok(lean_box(0));
@@ -737,8 +1219,8 @@ LEAN_EXPORT lean_obj_res conduit_channel_recv_timeout(
             ch->pending_taken = true;
             ch->pending_ready = false;
 
-            /* Signal sender that we took it */
-            pthread_cond_signal(&ch->not_full);
+            /* Wake the sender; queued senders share the condition variable */
+            pthread_cond_broadcast(&ch->not_full);
             select_notify_waiters(ch);
 
             pthread_mutex_unlock(&ch->mutex);
@@ -760,8 +1242,8 @@ LEAN_EXPORT lean_obj_res conduit_channel_recv_timeout(
     } else {
         /* Buffered channel: wait for data with timeout */
         while (ch->count == 0 && !ch->closed) {
-            int rc = pthread_cond_timedwait(&ch->not_empty, &ch->mutex, &deadline);
-            if (rc == ETIMEDOUT) {
+            int rc = channel_timedwait(ch, &ch->not_empty, &deadline);
+            if (rc != 0) {
                 pthread_mutex_unlock(&ch->mutex);
                 /* Return none (timeout) */
                 return lean_io_result_mk_ok(lean_box(0));
@@ -798,6 +1280,214 @@ LEAN_EXPORT lean_obj_res conduit_channel_recv_timeout(
     }
 }
 
+/* ============================================================================
+ * Batched Send/Receive
+ * ============================================================================ */
+
+/*
+ * Send values[start..] in order, returning how many were sent. Blocking sends
+ * wait for space, moving as many values per wakeup as the buffer allows, and
+ * stop early only if the channel closes (or the task is cancelled).
+ * Non-blocking sends stop at the first value that does not fit.
+ */
+static size_t put_many(b_lean_obj_arg ch_obj, b_lean_obj_arg values_obj, size_t start,
+                       bool block, lean_obj_arg world) {
+    conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
+    size_t n = lean_array_size(values_obj);
+    lean_object **values = lean_array_cptr(values_obj);
+    if (start >= n) return 0;
+    size_t sent = start;
+
+    if (ch->ring == NULL && ch->capacity == 0) {
+        /* Unbuffered: every value is its own handoff */
+        while (sent < n) {
+            lean_inc(values[sent]);
+            lean_object *result = block
+                ? conduit_channel_send(ch_obj, values[sent], world)
+                : conduit_channel_try_send(ch_obj, values[sent], world);
+            size_t status = lean_unbox(lean_io_result_get_value(result));
+            lean_dec(result);
+            if (block ? status == 0 : status != 0) break;
+            sent++;
+        }
+        return sent - start;
+    }
+
+    /* The channel takes its own reference to each value */
+    for (size_t i = sent; i < n; i++) {
+        lean_inc(values[i]);
+    }
+
+    if (ch->ring) {
+        while (sent < n && !ch->closed) {
+            size_t pushed = ring_push(ch->ring, values + sent, n - sent);
+            if (pushed > 0) {
+                sent += pushed;
+                ring_wake_receivers(ch);
+            } else if (!block || ring_park(ch, true, NULL) != 0) {
+                break;
+            }
+        }
+    } else {
+        pthread_mutex_lock(&ch->mutex);
+        while (sent < n) {
+            bool stop = false;
+            while (ch->count >= ch->capacity && !ch->closed) {
+                if (!block || !channel_wait(ch, &ch->not_full)) {
+                    stop = true;
+                    break;
+                }
+            }
+            if (stop || ch->closed) break;
+
+            while (sent < n && ch->count < ch->capacity) {
+                ch->buffer[ch->tail] = values[sent++];
+                ch->tail = (ch->tail + 1) % ch->capacity;
+                ch->count++;
+            }
+            pthread_cond_broadcast(&ch->not_empty);
+            select_notify_waiters(ch);
+        }
+        pthread_mutex_unlock(&ch->mutex);
+    }
+
+    for (size_t i = sent; i < n; i++) {
+        lean_dec(values[i]);
+    }
+    return sent - start;
+}
+
+/*
+ * Take up to max values (never more than the buffer holds). Blocking
+ * receives first wait for at least one value; the result is empty only once
+ * the channel is closed and drained (or the task is cancelled). Non-blocking
+ * receives return whatever is available now.
+ */
+static lean_obj_res take_many(b_lean_obj_arg ch_obj, size_t max, bool block,
+                              lean_obj_arg world) {
+    conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
+
+    if (ch->ring == NULL && ch->capacity == 0) {
+        /* Unbuffered: one handoff at a time */
+        lean_object *arr = lean_alloc_array(0, 1);
+        if (max == 0) return arr;
+        lean_object *result = block
+            ? conduit_channel_recv(ch_obj, world)
+            : conduit_channel_try_recv(ch_obj, world);
+        lean_object *got = lean_io_result_get_value(result);
+        /* recv gives Option (some = tag 1), try_recv gives TryResult (ok = tag 0) */
+        if (!lean_is_scalar(got) && lean_ptr_tag(got) == (block ? 1 : 0)) {
+            lean_object *value = lean_ctor_get(got, 0);
+            lean_inc(value);
+            lean_array_cptr(arr)[0] = value;
+            lean_to_array(arr)->m_size = 1;
+        }
+        lean_dec(result);
+        return arr;
+    }
+
+    if (max > ch->capacity) max = ch->capacity;
+    lean_object *arr = lean_alloc_array(0, max);
+    lean_object **out = lean_array_cptr(arr);
+    size_t taken = 0;
+    if (max == 0) return arr;
+
+    if (ch->ring) {
+        for (;;) {
+            taken = ring_pop(ch->ring, out, max);
+            if (taken > 0) {
+                ring_wake_senders(ch);
+                break;
+            }
+            if (!block || ring_park(ch, false, NULL) != 0) break;
+        }
+    } else {
+        pthread_mutex_lock(&ch->mutex);
+        bool stop = false;
+        while (ch->count == 0 && !ch->closed) {
+            if (!block || !channel_wait(ch, &ch->not_empty)) {
+                stop = true;
+                break;
+            }
+        }
+        if (!stop) {
+            while (taken < max && ch->count > 0) {
+                out[taken++] = ch->buffer[ch->head];
+                ch->buffer[ch->head] = NULL;
+                ch->head = (ch->head + 1) % ch->capacity;
+                ch->count--;
+            }
+            if (taken > 0) {
+                pthread_cond_broadcast(&ch->not_full);
+                select_notify_waiters(ch);
+            }
+        }
+        pthread_mutex_unlock(&ch->mutex);
+    }
+
+    lean_to_array(arr)->m_size = taken;
+    return arr;
+}
+
+/*
+ * conduit_channel_send_many : Channel α → Array α → IO Nat
+ *
+ * Blocking send of every value. Returns how many were sent; fewer than the
+ * array size only if the channel closed (or the task was cancelled) part way.
+ */
+LEAN_EXPORT lean_obj_res conduit_channel_send_many(
+    b_lean_obj_arg ch_obj,
+    b_lean_obj_arg values_obj,
+    lean_obj_arg world
+) {
+    size_t sent = put_many(ch_obj, values_obj, 0, true, world);
+    return lean_io_result_mk_ok(lean_usize_to_nat(sent));
+}
+
+/*
+ * conduit_channel_try_send_many : Channel α → Array α → Nat → IO Nat
+ *
+ * Non-blocking send of values[start..] in order. Returns how many were sent
+ * (0 if the channel is full or closed).
+ */
+LEAN_EXPORT lean_obj_res conduit_channel_try_send_many(
+    b_lean_obj_arg ch_obj,
+    b_lean_obj_arg values_obj,
+    b_lean_obj_arg start_obj,
+    lean_obj_arg world
+) {
+    size_t sent = put_many(ch_obj, values_obj, lean_usize_of_nat(start_obj), false, world);
+    return lean_io_result_mk_ok(lean_usize_to_nat(sent));
+}
+
+/*
+ * conduit_channel_recv_many : Channel α → Nat → IO (Array α)
+ *
+ * Block until at least one value is available, then take up to max values
+ * without blocking further. Returns an empty array once the channel is
+ * closed and drained (or if the task was cancelled).
+ */
+LEAN_EXPORT lean_obj_res conduit_channel_recv_many(
+    b_lean_obj_arg ch_obj,
+    b_lean_obj_arg max_obj,
+    lean_obj_arg world
+) {
+    return lean_io_result_mk_ok(take_many(ch_obj, lean_usize_of_nat(max_obj), true, world));
+}
+
+/*
+ * conduit_channel_try_recv_many : Channel α → Nat → IO (Array α)
+ *
+ * Take up to max values that are available now, without blocking.
+ */
+LEAN_EXPORT lean_obj_res conduit_channel_try_recv_many(
+    b_lean_obj_arg ch_obj,
+    b_lean_obj_arg max_obj,
+    lean_obj_arg world
+) {
+    return lean_io_result_mk_ok(take_many(ch_obj, lean_usize_of_nat(max_obj), false, world));
+}
+
 /* ============================================================================
  * conduit_channel_close : Channel α → IO Unit
  *
@@ -827,6 +1517,29 @@ LEAN_EXPORT lean_obj_res conduit_channel_close(
     return lean_io_result_mk_ok(lean_box(0));
 }
 
+/* ============================================================================
+ * conduit_channel_interrupt : Channel α → IO Unit
+ *
+ * Wake every thread blocked on the channel (including selects). Waiters whose
+ * task has been cancelled back out; the rest go back to sleep.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res conduit_channel_interrupt(
+    b_lean_obj_arg ch_obj,
+    lean_obj_arg world
+) {
+    (void)world;
+    conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
+
+    pthread_mutex_lock(&ch->mutex);
+    pthread_cond_broadcast(&ch->not_empty);
+    pthread_cond_broadcast(&ch->not_full);
+    select_notify_waiters(ch);
+    pthread_mutex_unlock(&ch->mutex);
+
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
 /* ============================================================================
  * conduit_channel_is_closed : Channel α → IO Bool
  * ============================================================================ */
@@ -858,6 +1571,10 @@ LEAN_EXPORT lean_obj_res conduit_channel_len(
     (void)world;
     conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
 
+    if (ch->ring) {
+        return lean_io_result_mk_ok(lean_usize_to_nat(ring_len(ch->ring)));
+    }
+
     pthread_mutex_lock(&ch->mutex);
     size_t len = ch->count;
     pthread_mutex_unlock(&ch->mutex);
@@ -882,6 +1599,24 @@ LEAN_EXPORT lean_obj_res conduit_channel_capacity(
     return lean_io_result_mk_ok(lean_usize_to_nat(ch->capacity));
 }
 
+/* ============================================================================
+ * conduit_channel_kind : Channel α → IO ChannelKind
+ *
+ * 0 = mutex, 1 = SPSC, 2 = MPMC.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res conduit_channel_kind(
+    b_lean_obj_arg ch_obj,
+    lean_obj_arg world
+) {
+    (void)world;
+    conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
+
+    /* Kind is immutable, no lock needed */
+    int kind = ch->ring ? ch->ring->kind : CONDUIT_KIND_MUTEX;
+    return lean_io_result_mk_ok(lean_box(kind));
+}
+
 /* ============================================================================
  * Select Waiter Helpers
  * ============================================================================ */
@@ -890,6 +1625,7 @@ LEAN_EXPORT lean_obj_res conduit_channel_capacity(
 static void select_register_waiter(conduit_channel_t *ch, conduit_select_waiter_t *w) {
     w->next = ch->select_waiters;
     ch->select_waiters = w;
+    atomic_fetch_add(&ch->select_count, 1);
 }
 
 /* Unregister a select waiter from a channel (called with channel mutex held) */
@@ -898,6 +1634,7 @@ static void select_unregister_waiter(conduit_channel_t *ch, conduit_select_waite
     while (*pp != NULL) {
         if (*pp == w) {
             *pp = w->next;
+            atomic_fetch_sub(&ch->select_count, 1);
             return;
         }
         pp = &(*pp)->next;
@@ -920,6 +1657,21 @@ static void select_notify_waiters(conduit_channel_t *ch) {
  * Select Implementation
  * ============================================================================ */
 
+/* Can a send proceed without blocking? (channel mutex held) */
+static bool channel_can_send(conduit_channel_t *ch) {
+    if (ch->closed) return false;
+    if (ch->ring) return ring_len(ch->ring) < ring_capacity(ch->ring);
+    if (ch->capacity > 0) return ch->count < ch->capacity;
+    /* Unbuffered with waiting receiver and no send in progress */
+    return ch->waiting_receivers > 0 && !handoff_busy(ch);
+}
+
+/* Can a receive proceed without blocking? Closed counts as ready. (channel mutex held) */
+static bool channel_can_recv(conduit_channel_t *ch) {
+    if (ch->ring) return ring_len(ch->ring) > 0 || ch->closed;
+    return ch->count > 0 || (ch->pending_ready && !ch->pending_taken) || ch->closed;
+}
+
 /*
  * conduit_select_poll : Array (Channel × Bool) → IO (Option Nat)
  *
@@ -945,24 +1697,7 @@ LEAN_EXPORT lean_obj_res conduit_select_poll(
 
         pthread_mutex_lock(&ch->mutex);
 
-        bool ready = false;
-
-        if (is_send) {
-            /* Can send if: not closed AND (buffered with space OR unbuffered with waiting receiver) */
-            if (!ch->closed) {
-                if (ch->capacity > 0 && ch->count < ch->capacity) {
-                    ready = true;
-                } else if (ch->capacity == 0 && ch->waiting_receivers > 0 && !ch->pending_ready) {
-                    /* Unbuffered with waiting receiver and no send in progress */
-                    ready = true;
-                }
-            }
-        } else {
-            /* Can recv if: has data OR (unbuffered with pending and not yet taken) OR closed */
-            if (ch->count > 0 || (ch->pending_ready && !ch->pending_taken) || ch->closed) {
-                ready = true;
-            }
-        }
+        bool ready = is_send ? channel_can_send(ch) : channel_can_recv(ch);
 
         pthread_mutex_unlock(&ch->mutex);
 
@@ -987,12 +1722,34 @@ static int compare_channels(const void *a, const void *b) {
     return 0;
 }
 
+/*
+ * Is the channel of any send case closed? Such a send can never proceed, so
+ * a wait gives up with none rather than sleeping on it; the caller sees the
+ * close when it next tries the send.
+ */
+static bool select_send_closed(b_lean_obj_arg cases_obj) {
+    size_t n = lean_array_size(cases_obj);
+    for (size_t i = 0; i < n; i++) {
+        lean_object *pair = lean_array_get_core(cases_obj, i);
+        if (lean_unbox(lean_ctor_get(pair, 1)) == 0) continue;
+
+        conduit_channel_t *ch = conduit_channel_unbox(lean_ctor_get(pair, 0));
+        pthread_mutex_lock(&ch->mutex);
+        bool closed = ch->closed;
+        pthread_mutex_unlock(&ch->mutex);
+        if (closed) return true;
+    }
+    return false;
+}
+
 /*
  * conduit_select_wait : Array (Channel × Bool) → Nat → IO (Option Nat)
  *
  * Wait for any channel to become ready, with timeout in milliseconds.
  * timeout = 0 means wait forever.
- * Returns index of ready channel, or none on timeout.
+ * Returns index of ready channel, or none on timeout, once a send case's
+ * channel is closed, or if the calling task has been cancelled (and woken
+ * with conduit_channel_interrupt).
  *
  * Uses proper condition variable signaling for immediate wake-up.
  */
@@ -1018,6 +1775,9 @@ retry:
         return result; /* Already ready */
     }
     lean_dec(result);
+    if (select_send_closed(cases_obj)) {
+        return lean_io_result_mk_ok(lean_box(0)); /* none */
+    }
 
     /* 2. Collect unique channels and sort by address (for deadlock prevention) */
     conduit_channel_t **channels = (conduit_channel_t **)malloc(n * sizeof(conduit_channel_t *));
@@ -1070,19 +1830,7 @@ retry:
         conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
 
         /* Note: we already hold the lock on this channel */
-        if (is_send) {
-            if (!ch->closed) {
-                if (ch->capacity > 0 && ch->count < ch->capacity) {
-                    found_ready = true;
-                } else if (ch->capacity == 0 && ch->waiting_receivers > 0 && !ch->pending_ready) {
-                    found_ready = true;
-                }
-            }
-        } else {
-            if (ch->count > 0 || (ch->pending_ready && !ch->pending_taken) || ch->closed) {
-                found_ready = true;
-            }
-        }
+        found_ready = is_send ? channel_can_send(ch) : channel_can_recv(ch);
     }
 
     if (found_ready) {
@@ -1106,23 +1854,19 @@ retry:
     /* 7. Wait loop with timeout */
     struct timespec deadline;
     if (timeout_ms > 0) {
-        clock_gettime(CLOCK_REALTIME, &deadline);
-        deadline.tv_sec += timeout_ms / 1000;
-        deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
-        if (deadline.tv_nsec >= 1000000000) {
-            deadline.tv_sec++;
-            deadline.tv_nsec -= 1000000000;
-        }
+        deadline = deadline_after_ms(timeout_ms);
     }
 
-    while (!waiter.notified) {
+    while (!waiter.notified && !lean_io_check_canceled_core()) {
+        int rc;
         if (timeout_ms == 0) {
-            cond_wait_interruptible(&wait_cond, &wait_mutex);
+            rc = pthread_cond_wait(&wait_cond, &wait_mutex);
         } else {
-            int rc = pthread_cond_timedwait(&wait_cond, &wait_mutex, &deadline);
-            if (rc == ETIMEDOUT) {
-                break;
-            }
+            rc = pthread_cond_timedwait(&wait_cond, &wait_mutex, &deadline);
+        }
+        atomic_fetch_add(&g_wakeup_count, 1);
+        if (rc == ETIMEDOUT) {
+            break;
         }
     }
     pthread_mutex_unlock(&wait_mutex);
@@ -1142,32 +1886,11 @@ retry:
     pthread_mutex_destroy(&wait_mutex);
     free(channels);
 
-    if (timeout_ms == 0) {
+    /* A cancelled task gets none, as on timeout */
+    if (timeout_ms == 0 && !lean_io_check_canceled_core()) {
         lean_object *final_inner = lean_ctor_get(result, 0);
         if (lean_is_scalar(final_inner)) {
-            bool all_send_closed = true;
-            for (size_t i = 0; i < n; i++) {
-                lean_object *pair = lean_array_get_core(cases_obj, i);
-                lean_object *ch_obj = lean_ctor_get(pair, 0);
-                bool is_send = lean_unbox(lean_ctor_get(pair, 1)) != 0;
-
-                if (!is_send) {
-                    all_send_closed = false;
-                    break;
-                }
-
-                conduit_channel_t *ch = conduit_channel_unbox(ch_obj);
-                pthread_mutex_lock(&ch->mutex);
-                bool closed = ch->closed;
-                pthread_mutex_unlock(&ch->mutex);
-
-                if (!closed) {
-                    all_send_closed = false;
-                    break;
-                }
-            }
-
-            if (!all_send_closed) {
+            if (!select_send_closed(cases_obj)) {
                 lean_dec(result);
                 goto retry;
             }
@@ -1208,3 +1931,15 @@ LEAN_EXPORT lean_obj_res conduit_reset_alloc_stats(lean_obj_arg world) {
     atomic_store(&g_channel_free_count, 0);
     return lean_io_result_mk_ok(lean_box(0));
 }
+
+/*
+ * conduit_get_wakeup_count : IO Nat
+ *
+ * Number of times a blocked channel operation or select has woken up.
+ * Idle waiters should not add to it.
+ */
+LEAN_EXPORT lean_obj_res conduit_get_wakeup_count(lean_obj_arg world) {
+    (void)world;
+    int64_t wakeups = atomic_load(&g_wakeup_count);
+    return lean_io_result_mk_ok(lean_uint64_to_nat((uint64_t)wakeups));
+}
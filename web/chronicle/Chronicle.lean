@@ -44,5 +44,6 @@
 import Chronicle.Level
 import Chronicle.Format
 import Chronicle.Config
+import Chronicle.Pipeline
 import Chronicle.Logger
 import Chronicle.MultiLogger
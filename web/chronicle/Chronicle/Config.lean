@@ -6,6 +6,7 @@
 
 import Chronicle.Level
 import Chronicle.Format
+import Chronicle.Pipeline
 
 namespace Chronicle
 
@@ -19,6 +20,8 @@ structure Config where
   format : Format := Format.text
   /-- Whether to also print to stderr -/
   alsoStderr : Bool := false
+  /-- Write through a background pipeline instead of on the calling thread -/
+  async : Option PipelineConfig := none
 deriving Repr
 
 namespace Config
@@ -43,6 +46,10 @@ def withFormat (c : Config) (fmt : Format) : Config :=
 def withStderr (c : Config) (enabled : Bool) : Config :=
   { c with alsoStderr := enabled }
 
+/-- Queue lines for a background writer (see `LogPipeline`) -/
+def withAsync (c : Config) (pipeline : PipelineConfig := {}) : Config :=
+  { c with async := some pipeline }
+
 /-- Set the file path -/
 def withPath (c : Config) (path : System.FilePath) : Config :=
   { c with filePath := path }
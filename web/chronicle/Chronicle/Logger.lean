@@ -15,6 +15,8 @@ structure Logger where
   config : Config
   /-- File handle for writing -/
   handle : IO.FS.Handle
+  /-- Background writer, when `config.async` is set -/
+  pipeline : Option LogPipeline := none
 
 namespace Logger
 
@@ -24,12 +26,31 @@ def create (config : Config) : IO Logger := do
   if let some parent := config.filePath.parent then
     IO.FS.createDirAll parent
   let handle ← IO.FS.Handle.mk config.filePath .append
-  pure { config, handle }
+  let pipeline ← config.async.mapM (LogPipeline.forHandle handle)
+  pure { config, handle, pipeline }
 
 /-- Close the logger's file handle -/
 def close (logger : Logger) : IO Unit := do
+  if let some p := logger.pipeline then p.close
   logger.handle.flush
 
+/-- Wait until every line logged so far has been written -/
+def flush (logger : Logger) : IO Unit := do
+  match logger.pipeline with
+  | some p => p.flush
+  | none => logger.handle.flush
+
+/-- Write a formatted line to the file (queued when async) and optionally stderr -/
+private def emit (logger : Logger) (line : String) : IO Unit := do
+  match logger.pipeline with
+  | some p => discard <| p.push line
+  | none =>
+    logger.handle.putStrLn line
+    logger.handle.flush
+
+  if logger.config.alsoStderr then
+    IO.eprintln line
+
 /-- Check if a level should be logged based on the threshold -/
 def shouldLog (logger : Logger) (level : Level) : Bool :=
   level.meetsThreshold logger.config.minLevel
@@ -46,22 +67,12 @@ def log (logger : Logger) (level : Level) (message : String)
     message := message
     context := context
   }
-  let line := entry.format logger.config.format
-  logger.handle.putStrLn line
-  logger.handle.flush
-
-  if logger.config.alsoStderr then
-    IO.eprintln line
+  logger.emit (entry.format logger.config.format)
 
 /-- Log a structured log entry (for HTTP requests) -/
 def logRequest (logger : Logger) (entry : LogEntry) : IO Unit := do
   if !logger.shouldLog entry.level then return ()
-  let line := entry.format logger.config.format
-  logger.handle.putStrLn line
-  logger.handle.flush
-
-  if logger.config.alsoStderr then
-    IO.eprintln line
+  logger.emit (entry.format logger.config.format)
 
 /-- Log at TRACE level -/
 def trace (logger : Logger) (msg : String) : IO Unit :=
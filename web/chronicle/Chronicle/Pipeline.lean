@@ -0,0 +1,232 @@
+/-
+  Chronicle.Pipeline - Asynchronous batched log writer
+
+  Producers push preformatted lines into a bounded ring buffer and return
+  immediately. A single background writer drains the ring and coalesces the
+  lines into one large write per batch, flushing the output when enough bytes
+  are pending or the flush interval elapses. When the ring is full the
+  configured overflow policy decides whether producers wait or lines are
+  dropped; dropped lines are counted in `PipelineStats`.
+-/
+
+import Std.Sync.Mutex
+
+namespace Chronicle
+
+/-- What a producer does when the ring buffer is full -/
+inductive Overflow where
+  | block       -- Wait for the writer to make room
+  | dropNewest  -- Discard the line being pushed
+  | dropOldest  -- Discard the oldest queued line
+deriving Repr, BEq, Inhabited
+
+/-- Pipeline tuning -/
+structure PipelineConfig where
+  /-- Ring buffer capacity in lines -/
+  capacity : Nat := 8192
+  /-- Maximum delay before queued lines are written, in milliseconds -/
+  flushIntervalMs : Nat := 100
+  /-- Write as soon as this many bytes are queued -/
+  flushBytes : Nat := 64 * 1024
+  /-- Behaviour when the ring is full -/
+  overflow : Overflow := .dropNewest
+deriving Repr, Inhabited
+
+/-- Pipeline counters -/
+structure PipelineStats where
+  /-- Lines accepted into the ring -/
+  accepted : Nat := 0
+  /-- Lines written to the output -/
+  written : Nat := 0
+  /-- Lines discarded by the overflow policy -/
+  dropped : Nat := 0
+  /-- Coalesced writes issued -/
+  batches : Nat := 0
+deriving Repr, Inhabited
+
+/-- Writer state shared under the pipeline mutex -/
+structure PipelineState where
+  /-- Ring slots; empty slots hold "" -/
+  slots : Array String
+  head : Nat := 0
+  count : Nat := 0
+  /-- Bytes (including newlines) currently queued -/
+  pendingBytes : Nat := 0
+  /-- Monotonic time of the last write, in milliseconds -/
+  lastWriteMs : Nat := 0
+  /-- Set by `flush` to write without waiting for the interval -/
+  urgent : Bool := false
+  stopping : Bool := false
+  /-- Lines evicted by `dropOldest` (accepted but never written) -/
+  evicted : Nat := 0
+  stats : PipelineStats := {}
+
+/-- A running log pipeline -/
+structure LogPipeline where
+  config : PipelineConfig
+  state : Std.Mutex PipelineState
+  /-- Signalled when enough bytes are queued, a flush is requested, or on each tick -/
+  wakeWriter : Std.Condvar
+  /-- Signalled after each batch is taken and after each write -/
+  progress : Std.Condvar
+  writer : Task (Except IO.Error Unit)
+
+namespace PipelineState
+
+-- The slots array is detached from the state before it is updated so that
+-- `set!` mutates it in place instead of copying the whole ring.
+
+/-- Append a line at the tail; the ring must have room -/
+def enqueue (st : PipelineState) (line : String) : PipelineState :=
+  let i := (st.head + st.count) % st.slots.size
+  let slots := st.slots
+  let st := { st with slots := #[] }
+  { st with
+    slots := slots.set! i line
+    count := st.count + 1
+    pendingBytes := st.pendingBytes + line.utf8ByteSize + 1
+    stats := { st.stats with accepted := st.stats.accepted + 1 } }
+
+/-- Discard the oldest queued line -/
+def evictOldest (st : PipelineState) : PipelineState :=
+  let oldest := st.slots[st.head]!
+  let slots := st.slots
+  let st := { st with slots := #[] }
+  { st with
+    slots := slots.set! st.head ""
+    head := (st.head + 1) % slots.size
+    count := st.count - 1
+    pendingBytes := st.pendingBytes - (oldest.utf8ByteSize + 1)
+    evicted := st.evicted + 1
+    stats := { st.stats with dropped := st.stats.dropped + 1 } }
+
+/-- Remove every queued line, oldest first -/
+def takeAll (st : PipelineState) : Array String × PipelineState := Id.run do
+  let cap := st.slots.size
+  let mut slots := st.slots
+  let st := { st with slots := #[] }
+  let mut batch : Array String := #[]
+  for k in [:st.count] do
+    let i := (st.head + k) % cap
+    batch := batch.push slots[i]!
+    slots := slots.set! i ""
+  return (batch, { st with slots, head := 0, count := 0, pendingBytes := 0, urgent := false })
+
+end PipelineState
+
+namespace LogPipeline
+
+/-- Whether the writer should take a batch now -/
+private def writerReady (config : PipelineConfig) : Std.AtomicT PipelineState IO Bool := do
+  let st ← get
+  if st.stopping || st.urgent then return true
+  if st.count == 0 then return false
+  if st.pendingBytes >= config.flushBytes || st.count >= config.capacity then return true
+  let now ← IO.monoMsNow
+  return now - st.lastWriteMs >= config.flushIntervalMs
+
+private partial def writerLoop (config : PipelineConfig) (state : Std.Mutex PipelineState)
+    (wakeWriter progress : Std.Condvar) (out : IO.FS.Stream) : IO Unit := do
+  let (batch, stopping) ← state.atomicallyOnce wakeWriter (writerReady config) do
+    let batch ← modifyGet PipelineState.takeAll
+    return (batch, (← get).stopping)
+  -- Producers blocked on a full ring can continue while the batch is written
+  progress.notifyAll
+  if !batch.isEmpty then
+    let text := batch.foldl (init := "") fun acc line => acc ++ line ++ "\n"
+    try
+      out.putStr text
+      out.flush
+    catch _ => pure ()
+  let now ← IO.monoMsNow
+  state.atomically do
+    modify fun st => { st with
+      lastWriteMs := now
+      stats := { st.stats with
+        written := st.stats.written + batch.size
+        batches := st.stats.batches + (if batch.isEmpty then 0 else 1) } }
+  progress.notifyAll
+  if !stopping then
+    writerLoop config state wakeWriter progress out
+
+/-- Start a pipeline writing to a stream -/
+def create (out : IO.FS.Stream) (config : PipelineConfig := {}) : IO LogPipeline := do
+  let config := { config with capacity := max config.capacity 1 }
+  let state ← Std.Mutex.new ({ slots := Array.replicate config.capacity "", lastWriteMs := ← IO.monoMsNow } : PipelineState)
+  let wakeWriter ← Std.Condvar.new
+  let progress ← Std.Condvar.new
+  let writer ← IO.asTask (prio := .dedicated) (writerLoop config state wakeWriter progress out)
+  -- Wake the writer periodically so the flush interval is honoured when producers go quiet
+  let _ ← IO.asTask (prio := .dedicated) do
+    let mut running := true
+    while running do
+      IO.sleep (max config.flushIntervalMs 1).toUInt32
+      running := !(← state.atomically do return (← get).stopping)
+      wakeWriter.notifyOne
+  pure { config, state, wakeWriter, progress, writer }
+
+/-- Start a pipeline writing to a file handle -/
+def forHandle (handle : IO.FS.Handle) (config : PipelineConfig := {}) : IO LogPipeline :=
+  create (IO.FS.Stream.ofHandle handle) config
+
+/-- Start a pipeline writing to stdout -/
+def stdout (config : PipelineConfig := {}) : IO LogPipeline := do
+  create (← IO.getStdout) config
+
+/-- Queue a line (without trailing newline). Returns false if it was dropped. -/
+def push (p : LogPipeline) (line : String) : IO Bool := do
+  let cap := p.config.capacity
+  let (accepted, wake) ← match p.config.overflow with
+    | .block => do
+      -- A full ring is written straight away rather than at the next tick
+      if (← p.state.atomically do return (← get).count >= cap) then
+        p.wakeWriter.notifyOne
+      p.state.atomicallyOnce p.progress (do let st ← get; return st.count < cap || st.stopping) <|
+        modifyGet fun st =>
+          if st.stopping then ((false, false), st)
+          else
+            let st := st.enqueue line
+            ((true, st.pendingBytes >= p.config.flushBytes), st)
+    | .dropNewest =>
+      p.state.atomically <| modifyGet fun st =>
+        if st.stopping || st.count >= cap then
+          ((false, false), { st with stats := { st.stats with dropped := st.stats.dropped + 1 } })
+        else
+          let st := st.enqueue line
+          ((true, st.pendingBytes >= p.config.flushBytes), st)
+    | .dropOldest =>
+      p.state.atomically <| modifyGet fun st =>
+        if st.stopping then ((false, false), st)
+        else
+          let st := if st.count >= cap then st.evictOldest else st
+          let st := st.enqueue line
+          ((true, st.pendingBytes >= p.config.flushBytes), st)
+  if wake then p.wakeWriter.notifyOne
+  pure accepted
+
+/-- Current counters -/
+def stats (p : LogPipeline) : IO PipelineStats :=
+  p.state.atomically do return (← get).stats
+
+/-- Write everything queued so far and wait until it has reached the output -/
+def flush (p : LogPipeline) : IO Unit := do
+  let target ← p.state.atomically do
+    modify fun st => { st with urgent := st.count > 0 }
+    return (← get).stats.accepted
+  p.wakeWriter.notifyOne
+  -- Lines leave the ring oldest first, so once this many are written or evicted
+  -- every line accepted before the call has been handled
+  p.state.atomicallyOnce p.progress
+    (do let st ← get; return st.stopping || st.stats.written + st.evicted >= target)
+    (pure ())
+
+/-- Stop accepting lines, write what is queued, and wait for the writer to finish.
+    The output stream itself is left open. -/
+def close (p : LogPipeline) : IO Unit := do
+  p.state.atomically (modify fun st => { st with stopping := true })
+  p.wakeWriter.notifyAll
+  p.progress.notifyAll
+  let _ ← IO.wait p.writer
+
+end LogPipeline
+end Chronicle
@@ -284,6 +284,102 @@ test "creates parent directories" := do
 
 end ChronicleTests.Logger
 
+namespace ChronicleTests.Pipeline
+
+open Crucible
+open Chronicle
+
+testSuite "Chronicle.Pipeline"
+
+/-- In-memory stream whose writes wait while `gate` is closed -/
+def gatedStream (buffer : IO.Ref String) (gate : IO.Ref Bool) : IO.FS.Stream := {
+  flush := pure ()
+  read := fun _ => pure .empty
+  write := fun _ => pure ()
+  getLine := pure ""
+  putStr := fun s => do
+    while !(← gate.get) do
+      IO.sleep 1
+    buffer.modify (· ++ s)
+  isTty := pure false
+}
+
+test "async logger writes queued lines on flush" := do
+  let tempPath : System.FilePath := "/tmp/chronicle_test_async.log"
+  let cfg := Config.default tempPath |>.withAsync { flushIntervalMs := 10 }
+  let logger ← Logger.create cfg
+  for i in [:100] do
+    logger.info s!"async line {i}"
+  logger.flush
+  let content ← IO.FS.readFile tempPath
+  shouldSatisfy (content.containsSubstr "async line 99") "should contain the last line after flush"
+  logger.close
+  IO.FS.removeFile tempPath
+
+test "coalesces lines into few writes" := do
+  let buffer ← IO.mkRef ""
+  let gate ← IO.mkRef true
+  let p ← LogPipeline.create (gatedStream buffer gate) { flushIntervalMs := 10 }
+  for i in [:1000] do
+    discard <| p.push s!"line {i}"
+  p.flush
+  let stats ← p.stats
+  stats.written ≡ 1000
+  stats.dropped ≡ 0
+  shouldSatisfy (stats.batches < 100) "lines should be batched"
+  ((← buffer.get).splitOn "\n").length ≡ 1001
+  p.close
+
+test "dropNewest counts discarded lines" := do
+  let buffer ← IO.mkRef ""
+  let gate ← IO.mkRef false
+  let p ← LogPipeline.create (gatedStream buffer gate) { capacity := 4, flushIntervalMs := 10 }
+  let mut accepted := 0
+  for i in [:20] do
+    if ← p.push s!"line {i}" then accepted := accepted + 1
+  gate.set true
+  p.flush
+  let stats ← p.stats
+  shouldSatisfy (stats.dropped > 0) "a full ring should drop lines"
+  (stats.written + stats.dropped) ≡ 20
+  stats.written ≡ accepted
+  shouldSatisfy ((← buffer.get).containsSubstr "line 0\n") "the oldest line should be kept"
+  p.close
+
+test "dropOldest keeps the newest lines" := do
+  let buffer ← IO.mkRef ""
+  let gate ← IO.mkRef false
+  let p ← LogPipeline.create (gatedStream buffer gate) { capacity := 4, flushIntervalMs := 10, overflow := .dropOldest }
+  for i in [:20] do
+    discard <| p.push s!"line {i}"
+  gate.set true
+  p.flush
+  let stats ← p.stats
+  shouldSatisfy (stats.dropped > 0) "a full ring should evict lines"
+  (stats.written + stats.dropped) ≡ 20
+  shouldSatisfy ((← buffer.get).containsSubstr "line 19\n") "the newest line should be kept"
+  p.close
+
+test "block waits for room instead of dropping" := do
+  let buffer ← IO.mkRef ""
+  let gate ← IO.mkRef true
+  let p ← LogPipeline.create (gatedStream buffer gate) { capacity := 2, flushIntervalMs := 1, overflow := .block }
+  for i in [:200] do
+    discard <| p.push s!"line {i}"
+  p.close
+  let stats ← p.stats
+  stats.written ≡ 200
+  stats.dropped ≡ 0
+
+test "push after close is rejected" := do
+  let buffer ← IO.mkRef ""
+  let gate ← IO.mkRef true
+  let p ← LogPipeline.create (gatedStream buffer gate) { flushIntervalMs := 10 }
+  p.close
+  (← p.push "late") ≡ false
+
+end ChronicleTests.Pipeline
+
 -- Main entry point
 open Crucible
 
@@ -4,6 +4,8 @@
   Core types for the HTTP server.
 -/
 import Herald
+import Citadel.RouteTrie
+import Chronicle.Pipeline
 
 namespace Citadel
 
@@ -17,6 +19,38 @@ structure TlsConfig where
   keyFile : String
   deriving Repr, Inhabited, BEq
 
+/-- Connection engine used for plain HTTP -/
+inductive ConnectionMode where
+  /-- One dedicated thread per connection running blocking reads -/
+  | threadPerConnection
+  /-- Non-blocking sockets multiplexed on readiness reactors, handlers on a bounded worker pool -/
+  | eventLoop
+  deriving Repr, BEq, Inhabited
+
+/-- Tuning for `ConnectionMode.eventLoop` -/
+structure EventLoopConfig where
+  /-- Number of reactor threads; accepted connections are sharded round-robin -/
+  reactors : Nat := 1
+  /-- Number of handler worker threads -/
+  workers : Nat := 8
+  /-- Maximum requests queued or running on workers before new ones get 503 -/
+  maxPending : Nat := 4096
+  /-- Maximum readiness notifications processed per reactor wakeup -/
+  maxEvents : Nat := 512
+  /-- Listen backlog for the accept queue -/
+  backlog : Nat := 4096
+  deriving Repr, Inhabited, BEq
+
+/-- Per-request access logging -/
+inductive RequestLogMode where
+  /-- No request or connection lines -/
+  | off
+  /-- One line per finished request with its status and duration -/
+  | completed
+  /-- Also a line when each request arrives -/
+  | verbose
+  deriving Repr, BEq, Inhabited
+
 /-- Server configuration -/
 structure ServerConfig where
   /-- Port to listen on -/
@@ -39,6 +73,14 @@ structure ServerConfig where
   maxHeaderSize : Nat := 8192  -- 8KB
   /-- Maximum total size of all headers in bytes -/
   maxTotalHeaderSize : Nat := 65536  -- 64KB
+  /-- Connection engine for plain HTTP (TLS always uses a thread per connection) -/
+  connectionMode : ConnectionMode := .threadPerConnection
+  /-- Event loop tuning (used when `connectionMode` is `.eventLoop`) -/
+  eventLoop : EventLoopConfig := {}
+  /-- Request and connection log lines written to stdout -/
+  requestLog : RequestLogMode := .completed
+  /-- Queueing for request log lines (written by a background thread) -/
+  requestLogPipeline : Chronicle.PipelineConfig := {}
   deriving Repr, Inhabited
 
 -- ============================================================================
@@ -389,6 +431,8 @@ structure ResponseBuilder where
   headers : Headers := Headers.empty
   /-- Response body -/
   body : ByteArray := ByteArray.empty
+  /-- File-backed body, sent with sendfile after the headers -/
+  file : Option FileRange := none
   deriving Inhabited
 
 namespace ResponseBuilder
@@ -405,6 +449,10 @@ def withBody (b : ResponseBuilder) (data : ByteArray) : ResponseBuilder :=
 def withText (b : ResponseBuilder) (text : String) : ResponseBuilder :=
   { b with body := text.toUTF8 }
 
+/-- Set the response body to a byte range of a file on disk -/
+def withFile (b : ResponseBuilder) (range : FileRange) : ResponseBuilder :=
+  { b with body := ByteArray.empty, file := some range }
+
 /-- Add a header -/
 def withHeader (b : ResponseBuilder) (name value : String) : ResponseBuilder :=
   { b with headers := b.headers.add name value }
@@ -415,12 +463,14 @@ def withContentType (b : ResponseBuilder) (ct : String) : ResponseBuilder :=
 
 /-- Build the final response -/
 def build (b : ResponseBuilder) : Response :=
-  let headers := b.headers.add "Content-Length" (toString b.body.size)
+  let length := b.body.size + (b.file.map (·.length)).getD 0
+  let headers := b.headers.add "Content-Length" (toString length)
   { status := b.status
     reason := b.status.defaultReason
     version := Version.http11
     headers := headers
-    body := b.body }
+    body := b.body
+    file := b.file }
 
 end ResponseBuilder
 
@@ -724,17 +774,20 @@ structure Route where
 
 /-- Router that matches requests to handlers -/
 structure Router where
-  /-- Registered routes -/
+  /-- Registered routes, in registration order -/
   routes : List Route := []
+  /-- Compiled route table, updated as routes are added -/
+  trie : RouteTrie Route := {}
 
 namespace Router
 
 /-- Create an empty router -/
-def empty : Router := { routes := [] }
+def empty : Router := {}
 
 /-- Add a route -/
 def add (r : Router) (method : Method) (pattern : String) (handler : Handler) : Router :=
-  { routes := r.routes ++ [{ method, pattern := RoutePattern.parse pattern, handler }] }
+  let route : Route := { method, pattern := RoutePattern.parse pattern, handler }
+  { routes := r.routes ++ [route], trie := r.trie.insert method pattern route }
 
 /-- Add a GET route -/
 def get (r : Router) (pattern : String) (handler : Handler) : Router :=
@@ -766,20 +819,11 @@ def options (r : Router) (pattern : String) (handler : Handler) : Router :=
 
 /-- Find a matching route for a request -/
 def findRoute (r : Router) (req : Request) : Option (Route × Params) :=
-  r.routes.findSome? fun route =>
-    if route.method == req.method then
-      match route.pattern.match_ req.path with
-      | some params => some (route, params)
-      | none => none
-    else
-      none
+  r.trie.match? req.method req.path
 
 /-- Find all routes that match a path (ignoring method) and return their methods -/
 def findMethodsForPath (r : Router) (path : String) : List Method :=
-  r.routes.filterMap fun route =>
-    match route.pattern.match_ path with
-    | some _ => some route.method
-    | none => none
+  r.trie.methodsFor path
 
 /-- Handle a request, returning a response -/
 def handle (r : Router) (req : Request) : IO Response := do
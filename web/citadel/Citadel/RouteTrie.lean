@@ -0,0 +1,151 @@
+/-
+  Citadel Route Trie
+
+  Compiled route table: patterns are inserted once into a tree of path
+  segments (literals, `:param`, and a trailing `*`), with a method table at
+  each node. Matching walks the request path by byte offsets, so lookup is
+  proportional to the path length rather than the number of routes, and
+  parameter values are only sliced out once a route has matched.
+
+  When several patterns match, literal segments win over `:param`, which
+  wins over `*`; among routes with the same pattern and method the first
+  registered wins.
+-/
+import Herald
+
+namespace Citadel
+
+open Herald.Core
+
+/-- A route stored at a trie node -/
+structure RouteEntry (α : Type) where
+  /-- HTTP method to match -/
+  method : Method
+  /-- Names of the pattern's `:param` segments, in path order -/
+  params : Array String
+  /-- Route payload (handler, named route, ...) -/
+  value : α
+
+/-- Segment tree of route patterns -/
+structure RouteTrie (α : Type) where
+  /-- Routes whose pattern ends at this node -/
+  entries : Array (RouteEntry α) := #[]
+  /-- Literal child segments -/
+  statics : Array (String × RouteTrie α) := #[]
+  /-- Child for a `:param` segment (shared by all parameter names) -/
+  param : Option (RouteTrie α) := none
+  /-- Routes whose pattern ends in `*` here, matching any remainder -/
+  wildcard : Array (RouteEntry α) := #[]
+
+instance : Inhabited (RouteTrie α) := ⟨{}⟩
+
+namespace RouteTrie
+
+/-- Create an empty trie -/
+def empty : RouteTrie α := {}
+
+/-- Add an entry unless one already exists for its method -/
+private def addEntry (entries : Array (RouteEntry α)) (entry : RouteEntry α) : Array (RouteEntry α) :=
+  if entries.any (·.method == entry.method) then entries else entries.push entry
+
+private partial def insertAt (node : RouteTrie α) (segs : List String) (entry : RouteEntry α) : RouteTrie α :=
+  match segs with
+  | [] => { node with entries := addEntry node.entries entry }
+  | "*" :: _ => { node with wildcard := addEntry node.wildcard entry }
+  | seg :: rest =>
+    if seg.startsWith ":" then
+      { node with param := some (insertAt (node.param.getD {}) rest entry) }
+    else
+      match node.statics.findIdx? (·.1 == seg) with
+      | some i => { node with statics := node.statics.modify i fun (s, child) => (s, insertAt child rest entry) }
+      | none => { node with statics := node.statics.push (seg, insertAt {} rest entry) }
+
+/-- Insert a route pattern like "/users/:id/posts" or "/files/*" -/
+def insert (t : RouteTrie α) (method : Method) (pattern : String) (value : α) : RouteTrie α :=
+  let segs := pattern.splitOn "/" |>.filter (· ≠ "")
+  let params := segs.takeWhile (· != "*") |>.filterMap fun s =>
+    if s.startsWith ":" then some (s.drop 1) else none
+  insertAt t segs { method, params := params.toArray, value }
+
+/-! ## Path scanning -/
+
+/-- Byte offset where the path ends and the query string begins -/
+private partial def pathStop (path : String) (i : Nat := 0) : Nat :=
+  if i >= path.utf8ByteSize then i
+  else
+    let c := String.Pos.Raw.get path ⟨i⟩
+    if c == '?' then i else pathStop path (i + c.utf8Size)
+
+/-- Skip `/` separators starting at byte offset i -/
+private partial def skipSlashes (path : String) (stop i : Nat) : Nat :=
+  if i < stop && String.Pos.Raw.get path ⟨i⟩ == '/' then skipSlashes path stop (i + 1) else i
+
+/-- End of the segment starting at byte offset i -/
+private partial def segmentEnd (path : String) (stop i : Nat) : Nat :=
+  if i >= stop then stop
+  else
+    let c := String.Pos.Raw.get path ⟨i⟩
+    if c == '/' then i else segmentEnd path stop (i + c.utf8Size)
+
+/-- Whether lit matches path from byte offset start, comparing from offset i of lit -/
+private partial def segmentEqFrom (lit path : String) (start i : Nat) : Bool :=
+  if i >= lit.utf8ByteSize then true
+  else
+    let c := String.Pos.Raw.get lit ⟨i⟩
+    c == String.Pos.Raw.get path ⟨start + i⟩ && segmentEqFrom lit path start (i + c.utf8Size)
+
+/-- Whether lit equals the bytes [start, stop) of path -/
+private def segmentEq (lit path : String) (start stop : Nat) : Bool :=
+  lit.utf8ByteSize == stop - start && segmentEqFrom lit path start 0
+
+/-! ## Matching -/
+
+/-- Walk from byte offset i, returning the first entry `pick` accepts on the
+    highest-priority branch together with the parameter byte ranges. -/
+private partial def findFrom (node : RouteTrie α) (path : String) (stop i : Nat)
+    (caps : Array (Nat × Nat)) (pick : Array (RouteEntry α) → Option (RouteEntry α))
+    : Option (RouteEntry α × Array (Nat × Nat)) :=
+  let start := skipSlashes path stop i
+  if start >= stop then
+    -- "/files/*" also matches "/files"
+    (pick node.entries <|> pick node.wildcard).map (·, caps)
+  else
+    let next := segmentEnd path stop start
+    let viaStatic := match node.statics.find? (fun (lit, _) => segmentEq lit path start next) with
+      | some (_, child) => findFrom child path stop next caps pick
+      | none => none
+    viaStatic
+      <|> (node.param.bind fun child => findFrom child path stop next (caps.push (start, next)) pick)
+      <|> (pick node.wildcard).map (·, caps)
+
+/-- Find the route for a method and path (query string ignored), with its parameters -/
+def match? (t : RouteTrie α) (method : Method) (path : String) : Option (α × List (String × String)) :=
+  let pick := fun (entries : Array (RouteEntry α)) => entries.find? (·.method == method)
+  (findFrom t path (pathStop path) 0 #[] pick).map fun (entry, caps) =>
+    let values := caps.toList.map fun (a, b) => String.Pos.Raw.extract path ⟨a⟩ ⟨b⟩
+    (entry.value, entry.params.toList.zip values)
+
+private def pushMethods (acc : Array Method) (entries : Array (RouteEntry α)) : Array Method :=
+  entries.foldl (init := acc) fun acc e => if acc.contains e.method then acc else acc.push e.method
+
+private partial def methodsFrom (node : RouteTrie α) (path : String) (stop i : Nat) (acc : Array Method) : Array Method :=
+  let acc := pushMethods acc node.wildcard
+  let start := skipSlashes path stop i
+  if start >= stop then
+    pushMethods acc node.entries
+  else
+    let next := segmentEnd path stop start
+    let acc := match node.statics.find? (fun (lit, _) => segmentEq lit path start next) with
+      | some (_, child) => methodsFrom child path stop next acc
+      | none => acc
+    match node.param with
+    | some child => methodsFrom child path stop next acc
+    | none => acc
+
+/-- Methods of every route whose pattern matches the path (for 405 responses) -/
+def methodsFor (t : RouteTrie α) (path : String) : List Method :=
+  (methodsFrom t path (pathStop path) 0 #[]).toList
+
+end RouteTrie
+
+end Citadel
@@ -7,7 +7,9 @@ import Citadel.Core
 import Citadel.Socket
 import Citadel.SSE
 import Citadel.Server.Stats
+import Citadel.Server.RequestLog
 import Citadel.Server.Connection
+import Citadel.Server.EventLoop
 
 namespace Citadel
 
@@ -123,7 +125,8 @@ private def handleSSEConnection (s : Server) (client : Socket) (topic : String)
 /-- Handle a single request -/
 private def handleRequest (s : Server) (req : Request) : IO Response := do
   let startTime ← IO.monoMsNow
-  IO.println s!"[REQ] {req.method} {req.path}"
+  if s.config.requestLog == .verbose then
+    logRequestLine s.config s!"[REQ] {req.method} {req.path}"
   match s.router.findRoute req with
   | some (route, params) =>
     let serverReq : ServerRequest := { request := req, params }
@@ -132,7 +135,7 @@ private def handleRequest (s : Server) (req : Request) : IO Response := do
       let wrappedHandler := Middleware.chain s.middleware route.handler
       let resp ← wrappedHandler serverReq
       let elapsed := (← IO.monoMsNow) - startTime
-      IO.println s!"[REQ] {req.method} {req.path} -> {resp.status.code} ({elapsed}ms)"
+      logRequestLine s.config s!"[REQ] {req.method} {req.path} -> {resp.status.code} ({elapsed}ms)"
       pure resp
     catch e =>
       IO.eprintln s!"[REQ] Handler error: {e}"
@@ -141,24 +144,28 @@ private def handleRequest (s : Server) (req : Request) : IO Response := do
     -- Check if path matches but method doesn't
     let allowedMethods := s.router.findMethodsForPath req.path
     if allowedMethods.isEmpty then
-      IO.println s!"[REQ] {req.method} {req.path} -> 404"
+      logRequestLine s.config s!"[REQ] {req.method} {req.path} -> 404"
       pure (Response.notFound)
     else
       let methodStrs := allowedMethods.map fun m => m.toString
-      IO.println s!"[REQ] {req.method} {req.path} -> 405 (allowed: {String.intercalate ", " methodStrs})"
+      logRequestLine s.config s!"[REQ] {req.method} {req.path} -> 405 (allowed: {String.intercalate ", " methodStrs})"
       pure (Response.methodNotAllowed methodStrs)
 
 /-- Handle a client connection -/
 private def handleConnection (s : Server) (client : Socket) : IO Unit := do
   let mut keepAlive := true
   let mut firstRequest := true
+  -- Kept across requests so pipelined bytes read with one request serve the next
+  let mut parser := newParser s.config
 
   while keepAlive do
     -- For subsequent requests, use keepAliveTimeout while waiting
     if !firstRequest then
       client.setTimeout s.config.keepAliveTimeout.toUInt32
 
-    match ← readRequest client s.config with
+    let (result, next) ← readNextRequest client s.config parser
+    parser := next
+    match result with
     | .success req =>
       -- Check if this is an SSE endpoint
       match s.matchSSERoute req.path with
@@ -223,13 +230,16 @@ private def handleTlsConnection (s : Server) (client : TlsSocket) : IO Unit := d
   let anyClient := AnySocket.tls client
   let mut keepAlive := true
   let mut firstRequest := true
+  let mut parser := newParser s.config
 
   while keepAlive do
     -- For subsequent requests, use keepAliveTimeout while waiting
     if !firstRequest then
       anyClient.setTimeout s.config.keepAliveTimeout.toUInt32
 
-    match ← readRequestAny anyClient s.config with
+    let (result, next) ← readNextRequestAny anyClient s.config parser
+    parser := next
+    match result with
     | .success req =>
       -- Regular HTTP request (SSE not supported over TLS for now)
       -- Check Connection header
@@ -309,7 +319,7 @@ private def runPlain (s : Server) : IO Unit := do
     let total ← stats.incrementTotal
     let active ← stats.incrementActive
     let threads ← stats.incrementDedicated
-    IO.println s!"[CONN] Accepted #{total} (active={active} threads={threads})"
+    logRequestLine s.config s!"[CONN] Accepted #{total} (active={active} threads={threads})"
     -- Use Task.Priority.dedicated so blocking I/O doesn't starve the thread pool
     let _ ← IO.asTask (prio := .dedicated) do
       try
@@ -319,9 +329,32 @@ private def runPlain (s : Server) : IO Unit := do
       finally
         let active ← stats.decrementActive
         let threads ← stats.decrementDedicated
-        IO.println s!"[CONN] Closed (active={active} threads={threads})"
+        logRequestLine s.config s!"[CONN] Closed (active={active} threads={threads})"
         try clientSocket.close catch _ => pure ()
 
+/-- Run plain HTTP server on readiness reactors with a bounded handler pool (internal) -/
+private def runEventLoop (s : Server) : IO Unit := do
+  let loopConfig := s.config.eventLoop
+  let serverSocket ← Jack.Socket.new
+  serverSocket.bind s.config.host s.config.port
+  serverSocket.listen loopConfig.backlog.toUInt32
+
+  let stats ← getOrCreateStats
+
+  IO.println s!"Citadel HTTP server listening on {s.config.host}:{s.config.port} (event loop: {loopConfig.reactors} reactors, {loopConfig.workers} workers)"
+
+  -- Stats printer task (every 10 seconds)
+  let _ ← IO.asTask do
+    while true do
+      IO.sleep 10000
+      stats.print
+
+  -- SSE streams keep their connection, so they leave the reactor for a dedicated thread
+  let upgrade : Request → Option (Socket → IO Unit) := fun req =>
+    (s.matchSSERoute req.path).map fun topic client => s.handleSSEConnection client topic
+
+  EventLoop.serve s.config serverSocket s.handleRequest upgrade
+
 /-- Run HTTPS server with TLS (internal) -/
 private def runTls (s : Server) (tlsConfig : TlsConfig) : IO Unit := do
   -- Create TLS server socket
@@ -359,7 +392,7 @@ private def runTls (s : Server) (tlsConfig : TlsConfig) : IO Unit := do
       let total ← stats.incrementTotal
       let active ← stats.incrementActive
       let threads ← stats.incrementDedicated
-      IO.println s!"[TLS] Accepted #{total} (active={active} threads={threads})"
+      logRequestLine s.config s!"[TLS] Accepted #{total} (active={active} threads={threads})"
       -- Use Task.Priority.dedicated so blocking I/O doesn't starve the thread pool
       let _ ← IO.asTask (prio := .dedicated) do
         try
@@ -369,13 +402,17 @@ private def runTls (s : Server) (tlsConfig : TlsConfig) : IO Unit := do
         finally
           let active ← stats.decrementActive
           let threads ← stats.decrementDedicated
-          IO.println s!"[TLS] Closed (active={active} threads={threads})"
+          logRequestLine s.config s!"[TLS] Closed (active={active} threads={threads})"
           try clientSocket.close catch _ => pure ()
 
-/-- Run the server (blocking). Uses TLS if configured, otherwise plain HTTP. -/
+/-- Run the server (blocking). Uses TLS if configured, otherwise plain HTTP
+    with the configured connection mode. -/
 def run (s : Server) : IO Unit := do
   match s.config.tls with
-  | none => s.runPlain
+  | none =>
+    match s.config.connectionMode with
+    | .threadPerConnection => s.runPlain
+    | .eventLoop => s.runEventLoop
   | some tlsConfig => s.runTls tlsConfig
 
 end Server
@@ -11,8 +11,10 @@ import Citadel.Server.Stats
 namespace Citadel
 
 open Herald.Core
+open Herald.Parser.Incremental (RequestParser)
 
-/-- Serialize a response to bytes for sending over the wire -/
+/-- Serialize a response to bytes for sending over the wire.
+    A file-backed body (`resp.file`) is not included; send it with `sendFileBody`. -/
 def serializeResponse (resp : Response) : ByteArray :=
   let statusLine := s!"{resp.version} {resp.status.code} {resp.reason}\r\n"
   let headerLines := resp.headers.foldl (init := "") fun acc h =>
@@ -32,91 +34,120 @@ inductive ReadResult where
 
 namespace Connection
 
+/-- Validate a parsed request, mapping limit violations onto read results -/
+def checkRequest (req : Request) (config : ServerConfig) : ReadResult :=
+  match validateRequest req config with
+  | some (.uriTooLong _ _) => .uriTooLong
+  | some (.tooManyHeaders count limit) =>
+    .headerValidationFailed s!"Too many headers: {count} (limit: {limit})"
+  | some (.headerTooLarge name size limit) =>
+    .headerValidationFailed s!"Header '{name}' too large: {size} bytes (limit: {limit})"
+  | some (.totalHeadersTooLarge size limit) =>
+    .headerValidationFailed s!"Total headers too large: {size} bytes (limit: {limit})"
+  | some (.invalidUriCharacter c) =>
+    .headerValidationFailed s!"Invalid character in URI: {repr c}"
+  | none => .success req
+
+/-- Whether the connection should stay open after responding to this request -/
+def wantsKeepAlive (req : Request) : Bool :=
+  let connHeader := req.headers.get "Connection"
+  if req.version.minor == 0 then
+    connHeader == some "keep-alive"
+  else
+    connHeader != some "close"
+
+/-- Send a file-backed body with sendfile (no user-space copy) -/
+def sendFileBody (client : Socket) (range : FileRange) : IO Unit := do
+  if range.length == 0 then return
+  let sent ← client.sendFile range.path range.offset.toUInt64 range.length.toUInt64
+  if sent.toNat < range.length then
+    throw (IO.userError s!"File body truncated: sent {sent} of {range.length} bytes from {range.path}")
+
+/-- Read a file range into memory (for transports without sendfile, e.g. TLS) -/
+def readFileRange (range : FileRange) : IO ByteArray := do
+  let handle ← IO.FS.Handle.mk range.path .read
+  let mut skip := range.offset
+  while skip > 0 do
+    let chunk ← handle.read (min skip 65536).toUSize
+    if chunk.isEmpty then skip := 0 else skip := skip - chunk.size
+  let mut out := ByteArray.empty
+  while out.size < range.length do
+    let chunk ← handle.read (min (range.length - out.size) 65536).toUSize
+    if chunk.isEmpty then
+      throw (IO.userError s!"File body truncated: read {out.size} of {range.length} bytes from {range.path}")
+    out := out ++ chunk
+  return out
+
 /-- Send HTTP response to client socket -/
 def sendResponse (client : Socket) (resp : Response) : IO Unit := do
   let data := serializeResponse resp
   client.send data
+  if let some range := resp.file then
+    sendFileBody client range
 
 /-- Send HTTP response to any socket type -/
 def sendResponseAny (client : AnySocket) (resp : Response) : IO Unit := do
-  let data := serializeResponse resp
-  client.send data
-
-/-- Read HTTP request from client socket -/
-def readRequest (client : Socket) (config : ServerConfig) : IO ReadResult := do
-  -- Apply requestTimeout from config
-  client.setTimeout config.requestTimeout.toUInt32
-
-  let mut buffer := ByteArray.empty
+  match client, resp.file with
+  | .plain sock, _ => sendResponse sock resp
+  | _, some range =>
+    client.send (serializeResponse resp ++ (← readFileRange range))
+  | _, none =>
+    client.send (serializeResponse resp)
+
+/-- Request parser for a new connection, with limits taken from the server config -/
+def newParser (config : ServerConfig) : RequestParser :=
+  -- The head limit leaves room for the request line around the URI and header limits,
+  -- which `checkRequest` enforces precisely once the head is decoded
+  RequestParser.new (maxHeadBytes := config.maxUriLength + config.maxTotalHeaderSize + 1024)
+    (maxBodyBytes := config.maxBodySize)
+
+/-- Read the next request, starting with any pipelined bytes the parser already holds.
+    Returns the parser to use for the following request on the connection. -/
+def readRequestWith (recv : IO ByteArray) (parser : RequestParser) (config : ServerConfig)
+    : IO (ReadResult × RequestParser) := do
+  let mut parser := parser
   let mut attempts := 0
   let maxAttempts := 1000  -- Allow up to ~16MB uploads (1000 * 16KB)
 
   while attempts < maxAttempts do
-    let chunk ← client.recv 16384  -- 16KB chunks for better performance
-    if chunk.isEmpty then
-      return .connectionClosed  -- Client closed connection (recv returned 0)
-    else
-      buffer := buffer ++ chunk
-      -- Check body size limit
-      if buffer.size > config.maxBodySize then
-        return .payloadTooLarge
-      -- Try to parse
-      match Herald.parseRequest buffer with
-      | .ok result =>
-        -- Validate the parsed request
-        match validateRequest result.request config with
-        | some (.uriTooLong _ _) => return .uriTooLong
-        | some (.tooManyHeaders count limit) =>
-          return .headerValidationFailed s!"Too many headers: {count} (limit: {limit})"
-        | some (.headerTooLarge name size limit) =>
-          return .headerValidationFailed s!"Header '{name}' too large: {size} bytes (limit: {limit})"
-        | some (.totalHeadersTooLarge size limit) =>
-          return .headerValidationFailed s!"Total headers too large: {size} bytes (limit: {limit})"
-        | some (.invalidUriCharacter c) =>
-          return .headerValidationFailed s!"Invalid character in URI: {repr c}"
-        | none => return .success result.request
-      | .error .incomplete => attempts := attempts + 1  -- Wait for more data
-      | .error _ => return .parseError
-
-  return .timeout  -- Exceeded max attempts
+    match parser.next with
+    | .ok (some parsed, p) =>
+      -- Validate the parsed request
+      return (checkRequest parsed.request config, p)
+    | .ok (none, p) =>
+      -- Wait for more data
+      let chunk ← recv
+      if chunk.isEmpty then
+        return (.connectionClosed, p)  -- Client closed connection (recv returned 0)
+      parser := p.feed chunk
+      attempts := attempts + 1
+    | .error .messageTooLarge => return (.payloadTooLarge, parser)
+    | .error _ => return (.parseError, parser)
+
+  return (.timeout, parser)  -- Exceeded max attempts
+
+/-- Read the next request on a keep-alive connection from client socket -/
+def readNextRequest (client : Socket) (config : ServerConfig) (parser : RequestParser)
+    : IO (ReadResult × RequestParser) := do
+  -- Apply requestTimeout from config
+  client.setTimeout config.requestTimeout.toUInt32
+  readRequestWith (client.recv 16384) parser config
 
-/-- Read HTTP request from any socket type -/
-def readRequestAny (client : AnySocket) (config : ServerConfig) : IO ReadResult := do
+/-- Read the next request on a keep-alive connection from any socket type -/
+def readNextRequestAny (client : AnySocket) (config : ServerConfig) (parser : RequestParser)
+    : IO (ReadResult × RequestParser) := do
   -- Apply requestTimeout from config
   client.setTimeout config.requestTimeout.toUInt32
+  readRequestWith (client.recv 16384) parser config
 
-  let mut buffer := ByteArray.empty
-  let mut attempts := 0
-  let maxAttempts := 1000  -- Allow up to ~16MB uploads (1000 * 16KB)
+/-- Read HTTP request from client socket. Bytes pipelined after it are discarded;
+    use `readNextRequest` to keep them for the following request. -/
+def readRequest (client : Socket) (config : ServerConfig) : IO ReadResult :=
+  (·.1) <$> readNextRequest client config (newParser config)
 
-  while attempts < maxAttempts do
-    let chunk ← client.recv 16384  -- 16KB chunks for better performance
-    if chunk.isEmpty then
-      return .connectionClosed  -- Client closed connection (recv returned 0)
-    else
-      buffer := buffer ++ chunk
-      -- Check body size limit
-      if buffer.size > config.maxBodySize then
-        return .payloadTooLarge
-      -- Try to parse
-      match Herald.parseRequest buffer with
-      | .ok result =>
-        -- Validate the parsed request
-        match validateRequest result.request config with
-        | some (.uriTooLong _ _) => return .uriTooLong
-        | some (.tooManyHeaders count limit) =>
-          return .headerValidationFailed s!"Too many headers: {count} (limit: {limit})"
-        | some (.headerTooLarge name size limit) =>
-          return .headerValidationFailed s!"Header '{name}' too large: {size} bytes (limit: {limit})"
-        | some (.totalHeadersTooLarge size limit) =>
-          return .headerValidationFailed s!"Total headers too large: {size} bytes (limit: {limit})"
-        | some (.invalidUriCharacter c) =>
-          return .headerValidationFailed s!"Invalid character in URI: {repr c}"
-        | none => return .success result.request
-      | .error .incomplete => attempts := attempts + 1  -- Wait for more data
-      | .error _ => return .parseError
-
-  return .timeout  -- Exceeded max attempts
+/-- Read HTTP request from any socket type -/
+def readRequestAny (client : AnySocket) (config : ServerConfig) : IO ReadResult :=
+  (·.1) <$> readNextRequestAny client config (newParser config)
 
 /-- SSE keep-alive loop: sends pings and detects disconnection -/
 partial def sseKeepAliveLoop (client : Socket) (manager : SSE.ConnectionManager) (clientId : Nat) : IO Unit := do
@@ -0,0 +1,458 @@
+/-
+  Citadel Event Loop
+
+  Readiness-driven connection engine. Non-blocking sockets are multiplexed on
+  one or more Jack pollers (reactors) and parsed requests are handed to a
+  bounded pool of handler workers, so an idle keep-alive connection costs a
+  table entry rather than a thread.
+-/
+import Citadel.Core
+import Citadel.Socket
+import Citadel.Server.Stats
+import Citadel.Server.Connection
+import Std.Data.HashMap
+import Std.Sync.Channel
+import Std.Sync.Mutex
+
+namespace Citadel
+
+open Herald.Core
+open Herald.Parser.Incremental (RequestParser)
+
+namespace EventLoop
+
+/-- Poller token of the listening socket -/
+private def listenerToken : UInt64 := 0
+
+/-- Poller token of a reactor's wakeup socket -/
+private def wakeToken : UInt64 := 1
+
+/-- Bytes requested per non-blocking recv -/
+private def recvChunk : Nat := 16384
+
+private def readMask : UInt16 := Jack.PollEvent.readable.toBit
+private def writeMask : UInt16 := Jack.PollEvent.writable.toBit
+
+/-- File-backed response body being streamed with sendfile -/
+private structure FileOut where
+  fd : UInt32
+  offset : Nat
+  remaining : Nat
+
+/-- Per-connection state, owned by the reactor the connection is registered on -/
+private structure Conn where
+  socket : Socket
+  /-- Incremental parser holding bytes received but not yet consumed -/
+  parser : RequestParser := {}
+  /-- Serialized response being written -/
+  outbox : ByteArray := .empty
+  /-- Bytes of `outbox` already accepted by the kernel -/
+  sent : Nat := 0
+  /-- File body to stream once the outbox drains -/
+  fileOut : Option FileOut := none
+  /-- A request from this connection is on the worker pool -/
+  busy : Bool := false
+  /-- Close once the outbox drains -/
+  closeAfterWrite : Bool := false
+  /-- Peer has shut down its sending side -/
+  eof : Bool := false
+  /-- Interest mask currently registered with the poller -/
+  interest : UInt16 := readMask
+  /-- Monotonic milliseconds of the last activity, for idle timeouts -/
+  lastActive : Nat
+
+/-- A parsed request travelling from a reactor to the worker pool -/
+private structure Job where
+  shard : Nat
+  token : UInt64
+  request : Request
+  keepAlive : Bool
+
+/-- A serialized response travelling from a worker back to its reactor -/
+private structure Completion where
+  token : UInt64
+  data : ByteArray
+  file : Option FileOut := none
+  close : Bool
+
+/-- One reactor: a poller plus the connections registered on it -/
+private structure Shard where
+  poller : Jack.Poller
+  conns : IO.Ref (Std.HashMap UInt64 Conn)
+  nextToken : IO.Ref UInt64
+  /-- Sockets accepted by another reactor, waiting to be registered here -/
+  inbox : Std.Mutex (Array Socket)
+  /-- Responses finished by workers for connections on this reactor -/
+  completions : Std.Mutex (Array Completion)
+  /-- Read end of the wakeup pair (registered on the poller) -/
+  wakeRx : Socket
+  /-- Write end of the wakeup pair (poked from other threads) -/
+  wakeTx : Socket
+
+/-- State shared by all reactors and workers -/
+private structure Engine where
+  config : ServerConfig
+  listener : Socket
+  shards : Array Shard
+  jobs : Std.CloseableChannel.Sync Job
+  /-- Requests queued on or running in the worker pool -/
+  pending : IO.Ref Nat
+  /-- Round-robin cursor for distributing accepted connections -/
+  nextShard : IO.Ref Nat
+  stats : ServerStats
+  handle : Request → IO Response
+  upgrade : Request → Option (Socket → IO Unit)
+
+private def newShard : IO Shard := do
+  let poller ← Jack.Poller.new
+  let (wakeRx, wakeTx) ← Jack.Socket.pair .unix .stream .default
+  wakeRx.setNonBlocking true
+  wakeTx.setNonBlocking true
+  poller.add wakeRx #[.readable] wakeToken
+  let conns ← IO.mkRef ({} : Std.HashMap UInt64 Conn)
+  let nextToken ← IO.mkRef (2 : UInt64)
+  let inbox ← Std.Mutex.new (#[] : Array Socket)
+  let completions ← Std.Mutex.new (#[] : Array Completion)
+  return { poller, conns, nextToken, inbox, completions, wakeRx, wakeTx }
+
+/-- Interrupt a reactor blocked in `Poller.wait` -/
+private def wake (shard : Shard) : IO Unit := do
+  -- A full pipe already guarantees a pending wakeup, so the result is irrelevant
+  let _ ← shard.wakeTx.sendTry (ByteArray.mk #[1])
+  pure ()
+
+private partial def drainWake (shard : Shard) : IO Unit := do
+  match ← shard.wakeRx.recvTry 512 with
+  | .ok data => if data.size > 0 then drainWake shard
+  | _ => pure ()
+
+private def closeFile (out : FileOut) : IO Unit :=
+  try Jack.Ring.closeFile out.fd catch _ => pure ()
+
+private def closeConn (engine : Engine) (shard : Shard) (token : UInt64) (conn : Conn) : IO Unit := do
+  if let some out := conn.fileOut then closeFile out
+  shard.conns.modify (·.erase token)
+  try shard.poller.remove conn.socket catch _ => pure ()
+  try conn.socket.close catch _ => pure ()
+  let _ ← engine.stats.decrementActive
+  pure ()
+
+/-- Response bytes (or file body) still waiting to be written -/
+private def writing (conn : Conn) : Bool :=
+  conn.sent < conn.outbox.size || conn.fileOut.isSome
+
+/-- Interest implied by the connection state -/
+private def interestOf (conn : Conn) : UInt16 :=
+  let r := if conn.eof then 0 else readMask
+  let w := if writing conn then writeMask else 0
+  r ||| w
+
+/-- Save connection state, updating the poller registration if the interest changed -/
+private def store (engine : Engine) (shard : Shard) (token : UInt64) (conn : Conn) : IO Unit := do
+  let mask := interestOf conn
+  if mask == conn.interest then
+    shard.conns.modify (·.insert token conn)
+  else
+    try
+      shard.poller.modifyFd conn.socket.fd mask token
+      shard.conns.modify (·.insert token { conn with interest := mask })
+    catch _ =>
+      closeConn engine shard token conn
+
+/-- Hand a connection to a dedicated thread (long-lived streams such as SSE) -/
+private def detach (engine : Engine) (shard : Shard) (token : UInt64) (conn : Conn)
+    (run : Socket → IO Unit) : IO Unit := do
+  shard.conns.modify (·.erase token)
+  try shard.poller.remove conn.socket catch _ => pure ()
+  let client := conn.socket
+  let _ ← IO.asTask (prio := .dedicated) do
+    try
+      client.setNonBlocking false
+      run client
+    catch e =>
+      IO.eprintln s!"[LOOP] Detached connection error: {e}"
+    finally
+      let _ ← engine.stats.decrementActive
+      try client.close catch _ => pure ()
+  pure ()
+
+/-- Queue a reactor-generated response and close once it is written -/
+private def respondAndClose (conn : Conn) (resp : Response) : Conn :=
+  { conn with outbox := serializeResponse resp, sent := 0, closeAfterWrite := true, parser := {} }
+
+private inductive Flush where
+  | drained (conn : Conn)
+  | blocked (conn : Conn)
+  | failed
+
+/-- Stream the file body with sendfile until done or the socket is full -/
+private partial def flushFile (conn : Conn) (out : FileOut) : IO Flush := do
+  if out.remaining == 0 then
+    closeFile out
+    return .drained { conn with fileOut := none }
+  match ← conn.socket.sendFileFdTry out.fd out.offset.toUInt64 out.remaining.toUInt64 with
+  | .ok n =>
+    if n == 0 then
+      -- File shrank under us; the promised Content-Length can no longer be met
+      closeFile out
+      return .failed
+    flushFile conn { out with offset := out.offset + n.toNat, remaining := out.remaining - n.toNat }
+  | .wouldBlock => return .blocked { conn with fileOut := some out }
+  | .error _ =>
+    closeFile out
+    return .failed
+
+/-- Push as much of the outbox as the kernel will take -/
+private partial def flush (conn : Conn) : IO Flush := do
+  if conn.sent >= conn.outbox.size then
+    let conn := { conn with outbox := .empty, sent := 0 }
+    match conn.fileOut with
+    | some out => return ← flushFile conn out
+    | none => return .drained conn
+  let chunk := if conn.sent == 0 then conn.outbox else conn.outbox.extract conn.sent conn.outbox.size
+  match ← conn.socket.sendTry chunk with
+  | .ok n =>
+    if n == 0 then return .blocked conn
+    flush { conn with sent := conn.sent + n.toNat }
+  | .wouldBlock => return .blocked conn
+  | .error _ => return .failed
+
+/-- Read what the kernel has buffered. `none` means the connection failed. -/
+private partial def readAvailable (conn : Conn) : IO (Option Conn) := do
+  match ← conn.socket.recvTry recvChunk.toUInt32 with
+  | .ok data =>
+    if data.isEmpty then
+      return some { conn with eof := true }
+    -- Detach the parser so its buffer is appended to in place
+    let parser := conn.parser
+    let conn := { conn with parser := {} }
+    let conn := { conn with parser := parser.feed data }
+    -- A short read means the socket buffer is drained; skip the extra syscall
+    if data.size < recvChunk then return some conn
+    readAvailable conn
+  | .wouldBlock => return some conn
+  | .error _ => return none
+
+/-- Advance a connection: finish pending output, then parse and dispatch the next request.
+    Requests pipelined behind a busy one stay buffered and are parsed once it completes. -/
+private partial def step (engine : Engine) (idx : Nat) (shard : Shard) (token : UInt64) (conn : Conn) : IO Unit := do
+  if writing conn then
+    match ← flush conn with
+    | .failed => closeConn engine shard token conn
+    | .blocked conn => store engine shard token conn
+    | .drained conn =>
+      if conn.closeAfterWrite then
+        closeConn engine shard token conn
+      else
+        step engine idx shard token conn
+  else if conn.closeAfterWrite then
+    closeConn engine shard token conn
+  else if conn.busy then
+    store engine shard token conn
+  else
+    match conn.parser.next with
+    | .ok (none, parser) =>
+      let conn := { conn with parser }
+      if conn.eof then
+        closeConn engine shard token conn
+      else
+        store engine shard token conn
+    | .error .messageTooLarge =>
+      step engine idx shard token (respondAndClose conn Response.payloadTooLarge)
+    | .error _ =>
+      step engine idx shard token (respondAndClose conn (Response.badRequest "Malformed HTTP request"))
+    | .ok (some parsed, parser) =>
+      let conn := { conn with parser }
+      match Connection.checkRequest parsed.request engine.config with
+      | .success req =>
+        match engine.upgrade req with
+        | some run => detach engine shard token conn run
+        | none =>
+          let admitted ← engine.pending.modifyGet fun n =>
+            if n < engine.config.eventLoop.maxPending then (true, n + 1) else (false, n)
+          if admitted then
+            let keepAlive := Connection.wantsKeepAlive req && !conn.eof
+            let job : Job := { shard := idx, token, request := req, keepAlive }
+            let _ ← Std.CloseableChannel.Sync.send engine.jobs job
+            store engine shard token { conn with busy := true }
+          else
+            step engine idx shard token (respondAndClose conn (Response.serviceUnavailable (some 1)))
+      | .uriTooLong =>
+        step engine idx shard token (respondAndClose conn Response.uriTooLong)
+      | .headerValidationFailed msg =>
+        step engine idx shard token (respondAndClose conn (Response.headerFieldsTooLarge msg))
+      | _ =>
+        step engine idx shard token (respondAndClose conn (Response.badRequest "Malformed HTTP request"))
+
+/-- Register a freshly accepted socket on this reactor -/
+private def adopt (engine : Engine) (shard : Shard) (sock : Socket) : IO Unit := do
+  let token ← shard.nextToken.modifyGet fun t => (t, t + 1)
+  try
+    shard.poller.add sock #[.readable] token
+    let now ← IO.monoMsNow
+    shard.conns.modify (·.insert token { socket := sock, parser := Connection.newParser engine.config, lastActive := now })
+  catch e =>
+    IO.eprintln s!"[LOOP] Failed to register connection: {e}"
+    try sock.close catch _ => pure ()
+    let _ ← engine.stats.decrementActive
+    pure ()
+
+/-- Accept every pending connection, spreading them across reactors -/
+private partial def acceptAll (engine : Engine) (idx : Nat) (shard : Shard) : IO Unit := do
+  match ← engine.listener.acceptTry with
+  | .ok client =>
+    client.setNonBlocking true
+    let _ ← engine.stats.incrementTotal
+    let _ ← engine.stats.incrementActive
+    let target ← engine.nextShard.modifyGet fun n => (n % engine.shards.size, n + 1)
+    match engine.shards[target]? with
+    | some other =>
+      if target == idx then
+        adopt engine shard client
+      else
+        other.inbox.atomically (modify (·.push client))
+        wake other
+    | none => adopt engine shard client
+    acceptAll engine idx shard
+  | .wouldBlock => pure ()
+  | .error err =>
+    -- Usually descriptor exhaustion; back off instead of spinning on the ready listener
+    IO.eprintln s!"[LOOP] Accept error: {err}"
+    IO.sleep 10
+
+private def drainInbox (engine : Engine) (shard : Shard) : IO Unit := do
+  let arrivals ← shard.inbox.atomically do
+    let xs ← get
+    set (#[] : Array Socket)
+    return xs
+  for sock in arrivals do
+    adopt engine shard sock
+
+private def drainCompletions (engine : Engine) (idx : Nat) (shard : Shard) : IO Unit := do
+  let finished ← shard.completions.atomically do
+    let xs ← get
+    set (#[] : Array Completion)
+    return xs
+  if finished.isEmpty then return
+  let now ← IO.monoMsNow
+  for c in finished do
+    -- The connection may have gone away while its handler ran
+    if let some conn := (← shard.conns.get).get? c.token then
+      let conn := { conn with
+        busy := false, outbox := c.data, sent := 0, fileOut := c.file, closeAfterWrite := c.close,
+        lastActive := now }
+      step engine idx shard c.token conn
+    else if let some out := c.file then
+      closeFile out
+
+/-- Handle readiness on a client connection -/
+private def onReady (engine : Engine) (idx : Nat) (shard : Shard) (ev : Jack.PollerEvent) : IO Unit := do
+  match (← shard.conns.get).get? ev.token with
+  | none => pure ()
+  | some conn =>
+    if ev.isReadable || ev.isHangup || ev.isError then
+      match ← readAvailable conn with
+      | none => closeConn engine shard ev.token conn
+      | some conn =>
+        let conn := { conn with lastActive := ← IO.monoMsNow }
+        if conn.busy && conn.parser.buffered > engine.config.maxBodySize then
+          closeConn engine shard ev.token conn
+        else
+          step engine idx shard ev.token conn
+    else
+      step engine idx shard ev.token conn
+
+/-- Close connections idle past keepAliveTimeout, or stalled mid-request past requestTimeout -/
+private def sweepIdle (engine : Engine) (shard : Shard) : IO Unit := do
+  let now ← IO.monoMsNow
+  let keepAliveMs := engine.config.keepAliveTimeout * 1000
+  let requestMs := engine.config.requestTimeout * 1000
+  for (token, conn) in (← shard.conns.get).toList do
+    if !conn.busy then
+      let idle := conn.parser.isIdle && !writing conn
+      let limit := if idle then keepAliveMs else requestMs
+      if now - conn.lastActive > limit then
+        if !conn.parser.isIdle then
+          let _ ← conn.socket.sendTry (serializeResponse Response.requestTimeout)
+        closeConn engine shard token conn
+
+private def runShard (engine : Engine) (idx : Nat) (shard : Shard) : IO Unit := do
+  let maxEvents := (max 1 engine.config.eventLoop.maxEvents).toUInt32
+  let mut lastSweep ← IO.monoMsNow
+  while true do
+    let events ← shard.poller.wait maxEvents 1000
+    for ev in events do
+      try
+        if ev.token == listenerToken then
+          acceptAll engine idx shard
+        else if ev.token == wakeToken then
+          drainWake shard
+        else
+          onReady engine idx shard ev
+      catch e =>
+        IO.eprintln s!"[LOOP] Reactor {idx} error: {e}"
+    -- Wakeups coalesce, so check the mailboxes on every pass
+    drainInbox engine shard
+    drainCompletions engine idx shard
+    let now ← IO.monoMsNow
+    if now - lastSweep >= 1000 then
+      sweepIdle engine shard
+      lastSweep := now
+
+private partial def workerLoop (engine : Engine) : IO Unit := do
+  match ← engine.jobs.recv with
+  | none => pure ()
+  | some job =>
+    let resp ← try engine.handle job.request catch e => do
+      IO.eprintln s!"[LOOP] Handler error: {e}"
+      pure Response.internalError
+    let resp := if job.keepAlive then resp
+      else { resp with headers := resp.headers.add "Connection" "close" }
+    -- Open file bodies here so the reactor only issues non-blocking sendfile steps
+    let (resp, file) ← match resp.file with
+      | none => pure (resp, none)
+      | some range =>
+        try
+          let fd ← Jack.Ring.openFile range.path
+          pure (resp, some { fd, offset := range.offset, remaining := range.length : FileOut })
+        catch e =>
+          IO.eprintln s!"[LOOP] Cannot open file body {range.path}: {e}"
+          pure (Response.internalError, none)
+    let completion : Completion :=
+      { token := job.token, data := serializeResponse resp, file, close := !job.keepAlive }
+    engine.pending.modify (· - 1)
+    if let some shard := engine.shards[job.shard]? then
+      shard.completions.atomically (modify (·.push completion))
+      wake shard
+    workerLoop engine
+
+/-- Serve HTTP on a bound, listening socket until the process exits.
+    `handle` runs on the worker pool. `upgrade` claims requests that take over their
+    connection; the socket is switched back to blocking mode and run on a dedicated thread. -/
+def serve (config : ServerConfig) (listener : Socket)
+    (handle : Request → IO Response)
+    (upgrade : Request → Option (Socket → IO Unit) := fun _ => none) : IO Unit := do
+  let loopConfig := config.eventLoop
+  listener.setNonBlocking true
+  let mut shards : Array Shard := #[]
+  for _ in [:max 1 loopConfig.reactors] do
+    shards := shards.push (← newShard)
+  let jobs ← Std.CloseableChannel.Sync.new (α := Job)
+  let pending ← IO.mkRef 0
+  let nextShard ← IO.mkRef 0
+  let stats ← getOrCreateStats
+  let engine : Engine := { config, listener, shards, jobs, pending, nextShard, stats, handle, upgrade }
+  for _ in [:max 1 loopConfig.workers] do
+    let _ ← IO.asTask (prio := .dedicated) (workerLoop engine)
+  match shards[0]? with
+  | none => pure ()
+  | some first =>
+    first.poller.add listener #[.readable] listenerToken
+    for i in [1:shards.size] do
+      if let some shard := shards[i]? then
+        let _ ← IO.asTask (prio := .dedicated) (runShard engine i shard)
+    runShard engine 0 first
+
+end EventLoop
+
+end Citadel
@@ -0,0 +1,34 @@
+/-
+  Citadel Request Log
+
+  Request log lines are queued on a process-wide Chronicle pipeline that
+  writes to stdout from a background thread, so handlers never wait on
+  terminal or pipe output.
+-/
+import Std.Sync.Mutex
+import Chronicle.Pipeline
+import Citadel.Core
+
+namespace Citadel
+
+/-- Global request log pipeline (started on first use) -/
+initialize globalRequestLog : Std.Mutex (Option Chronicle.LogPipeline) ← Std.Mutex.new none
+
+/-- The global pipeline, starting it if needed. The check and the start
+    happen under one lock, so concurrent first requests share one pipeline. -/
+def getOrCreateRequestLog (config : ServerConfig) : IO Chronicle.LogPipeline :=
+  globalRequestLog.atomically do
+    match ← get with
+    | some p => pure p
+    | none =>
+      let p ← Chronicle.LogPipeline.stdout config.requestLogPipeline
+      set (some p)
+      pure p
+
+/-- Queue a request log line unless request logging is off -/
+def logRequestLine (config : ServerConfig) (line : String) : IO Unit := do
+  if config.requestLog != .off then
+    let log ← getOrCreateRequestLog config
+    discard <| log.push line
+
+end Citadel
@@ -406,6 +406,72 @@ test "router matches OPTIONS route" := do
   resp.status.code ≡ 204
   resp.headers.get "Allow" ≡ some "GET, POST, OPTIONS"
 
+-- ============================================================================
+-- RouteTrie Tests
+-- ============================================================================
+
+testSuite "RouteTrie"
+
+test "literal segments win over params regardless of order" := do
+  let trie := RouteTrie.empty
+    |>.insert .GET "/users/:id" "show"
+    |>.insert .GET "/users/new" "new"
+  (trie.match? .GET "/users/new").map (·.1) ≡ some "new"
+  (trie.match? .GET "/users/7").map (·.1) ≡ some "show"
+
+test "backtracks from a literal branch to a param branch" := do
+  let trie := RouteTrie.empty
+    |>.insert .GET "/users/new/form" "form"
+    |>.insert .GET "/users/:id/edit" "edit"
+  match trie.match? .GET "/users/new/edit" with
+  | some (name, params) =>
+    name ≡ "edit"
+    params ≡ [("id", "new")]
+  | none => throw (IO.userError "Expected match")
+
+test "routes sharing a param node keep their own names" := do
+  let trie := RouteTrie.empty
+    |>.insert .GET "/posts/:id" "post"
+    |>.insert .GET "/posts/:postId/comments/:commentId" "comment"
+  (trie.match? .GET "/posts/3").map (·.2) ≡ some [("id", "3")]
+  (trie.match? .GET "/posts/3/comments/9").map (·.2) ≡ some [("postId", "3"), ("commentId", "9")]
+
+test "wildcard matches the remainder and the bare prefix" := do
+  let trie := RouteTrie.empty
+    |>.insert .GET "/static/*" "static"
+    |>.insert .GET "/static/app.js" "app"
+  (trie.match? .GET "/static/css/site.css").map (·.1) ≡ some "static"
+  (trie.match? .GET "/static").map (·.1) ≡ some "static"
+  (trie.match? .GET "/static/app.js").map (·.1) ≡ some "app"
+
+test "ignores query strings and repeated slashes" := do
+  let trie := RouteTrie.empty |>.insert .GET "/search/:term" "search"
+  (trie.match? .GET "/search/lean?page=2").map (·.2) ≡ some [("term", "lean")]
+  (trie.match? .GET "//search//lean/").map (·.2) ≡ some [("term", "lean")]
+  (trie.match? .GET "/search?q=/x").isSome ≡ false
+
+test "matches non-ASCII segments" := do
+  let trie := RouteTrie.empty |>.insert .GET "/café/:name" "cafe"
+  (trie.match? .GET "/café/crème").map (·.2) ≡ some [("name", "crème")]
+  (trie.match? .GET "/cafe/creme").isSome ≡ false
+
+test "first registration wins for the same method and pattern" := do
+  let trie := RouteTrie.empty
+    |>.insert .GET "/dup" "first"
+    |>.insert .GET "/dup" "second"
+  (trie.match? .GET "/dup").map (·.1) ≡ some "first"
+
+test "methodsFor collects methods across matching branches" := do
+  let trie := RouteTrie.empty
+    |>.insert .GET "/users/new" ()
+    |>.insert .POST "/users/:id" ()
+    |>.insert .GET "/users/:id" ()
+    |>.insert .DELETE "/*" ()
+  let methods := trie.methodsFor "/users/new"
+  methods.length ≡ 3
+  shouldSatisfy (methods.contains .POST) "should contain POST"
+  shouldSatisfy (methods.contains .DELETE) "should contain DELETE"
+
 -- ============================================================================
 -- ServerRequest Tests
 -- ============================================================================
@@ -1170,6 +1236,159 @@ test "ServerConfig with TLS and custom port" := do
   shouldSatisfy (config.tls.isSome) "should have TLS config"
 
 
+-- ============================================================================
+-- Event Loop Tests
+-- ============================================================================
+
+testSuite "EventLoop"
+
+test "event loop config defaults" := do
+  let config : ServerConfig := {}
+  shouldSatisfy (config.connectionMode == .threadPerConnection) "thread-per-connection by default"
+  config.eventLoop.reactors ≡ 1
+  config.eventLoop.workers ≡ 8
+  config.eventLoop.maxPending ≡ 4096
+
+/-- Read until `count` responses have been parsed or the peer closes -/
+partial def readResponses (client : Jack.Socket) (count : Nat)
+    (buf : ByteArray := .empty) (acc : Array Response := #[]) : IO (Array Response) := do
+  if acc.size >= count then return acc
+  match Herald.parseResponse buf with
+  | .ok parsed =>
+    readResponses client count (buf.extract parsed.bytesConsumed buf.size) (acc.push parsed.response)
+  | .error _ =>
+    let chunk ← client.recv 4096
+    if chunk.isEmpty then return acc
+    readResponses client count (buf ++ chunk) acc
+
+test "event loop answers pipelined keep-alive requests in order" := do
+  let listener ← Jack.Socket.new
+  listener.bind "127.0.0.1" 0
+  listener.listen 16
+  let addr ← listener.getLocalAddr
+  let router := Router.empty
+    |>.get "/a" (fun _ => pure (Response.ok "first"))
+    |>.get "/b" (fun _ => pure (Response.ok "second"))
+  let _ ← IO.asTask (prio := .dedicated) (EventLoop.serve {} listener router.handle)
+
+  let client ← Jack.Socket.new
+  client.connectAddr addr
+  client.setTimeout 5
+  client.sendAll "GET /a HTTP/1.1\r\nHost: test\r\n\r\nGET /b HTTP/1.1\r\nHost: test\r\n\r\n".toUTF8
+  let responses ← readResponses client 2
+  responses.size ≡ 2
+  String.fromUTF8! responses[0]!.body ≡ "first"
+  String.fromUTF8! responses[1]!.body ≡ "second"
+
+  -- The connection stays open for another request
+  client.sendAll "GET /missing HTTP/1.1\r\nHost: test\r\nConnection: close\r\n\r\n".toUTF8
+  let more ← readResponses client 1
+  more.size ≡ 1
+  more[0]!.status.code ≡ 404
+  client.close
+
+test "connection reader keeps pipelined requests for the next read" := do
+  let config : ServerConfig := {}
+  -- Two requests arrive in one read; the second one's body straddles the next read
+  let reads ← IO.mkRef [
+    "GET /a HTTP/1.1\r\nHost: test\r\n\r\nPOST /b HTTP/1.1\r\nContent-Length: 6\r\n\r\nab".toUTF8,
+    "cdef".toUTF8]
+  let recv : IO ByteArray := reads.modifyGet fun
+    | chunk :: rest => (chunk, rest)
+    | [] => (.empty, [])
+  let (first, parser) ← Connection.readRequestWith recv (Connection.newParser config) config
+  let (second, parser) ← Connection.readRequestWith recv parser config
+  let (third, _) ← Connection.readRequestWith recv parser config
+  match first, second, third with
+  | .success a, .success b, .connectionClosed =>
+    a.path ≡ "/a"
+    b.path ≡ "/b"
+    String.fromUTF8! b.body ≡ "abcdef"
+  | _, _, _ => throw (IO.userError "Expected two requests, then a closed connection")
+
+test "file-backed bodies are streamed by both connection modes" := do
+  let dir : System.FilePath := "/tmp/citadel-file-body-test"
+  IO.FS.createDirAll dir
+  let path := dir / "asset.bin"
+  let contents := String.mk (List.replicate 200000 'x')
+  IO.FS.writeFile path contents
+  let range : FileRange := { path := path.toString, offset := 10, length := 150000 }
+  let resp := ResponseBuilder.withStatus StatusCode.ok |>.withFile range |>.build
+  resp.headers.get "Content-Length" ≡ some "150000"
+
+  -- Thread-per-connection path: headers, then sendfile
+  let (a, b) ← Jack.Socket.pair .unix .stream .default
+  let writer ← IO.asTask (do Connection.sendResponse a resp; a.close)
+  let direct ← readResponses b 1
+  let _ ← IO.ofExcept writer.get
+  b.close
+  direct.size ≡ 1
+  direct[0]!.body.size ≡ 150000
+
+  -- Event loop path: non-blocking sendfile steps driven by writability
+  let listener ← Jack.Socket.new
+  listener.bind "127.0.0.1" 0
+  listener.listen 16
+  let addr ← listener.getLocalAddr
+  let router := Router.empty |>.get "/asset" (fun _ => pure resp)
+  let _ ← IO.asTask (prio := .dedicated) (EventLoop.serve {} listener router.handle)
+  let client ← Jack.Socket.new
+  client.connectAddr addr
+  client.setTimeout 5
+  client.sendAll "GET /asset HTTP/1.1\r\nHost: test\r\n\r\n".toUTF8
+  let looped ← readResponses client 1
+  looped.size ≡ 1
+  looped[0]!.body.size ≡ 150000
+  client.close
+  try IO.FS.removeFile path catch _ => pure ()
+
+
+-- ============================================================================
+-- Routing Benchmark
+-- ============================================================================
+
+testSuite "Router.Bench"
+
+/-- Route patterns and request paths shaped like a CRUD app with many resources -/
+def benchRoutes (resources : Nat) : Array (Method × String) × Array String := Id.run do
+  let mut routes : Array (Method × String) := #[]
+  let mut paths : Array String := #[]
+  for i in [:resources] do
+    let base := s!"/api/resource{i}"
+    routes := routes ++ #[(.GET, base), (.POST, base), (.GET, s!"{base}/new"), (.GET, s!"{base}/:id"),
+      (.PUT, s!"{base}/:id"), (.GET, s!"{base}/:id/edit"), (.GET, s!"{base}/:id/items/:itemId")]
+    paths := paths ++ #[base, s!"{base}/new", s!"{base}/{i}", s!"{base}/{i}/items/{i + 1}?page=2"]
+  return (routes, paths)
+
+test "compiled trie vs linear route scan" := do
+  let (routes, paths) := benchRoutes 60
+  let router := routes.foldl (init := Router.empty) fun r (method, pattern) =>
+    r.add method pattern (fun _ => pure (Response.ok pattern))
+  let lookups := 200000
+  let linearFind (path : String) : Option Params :=
+    router.routes.findSome? fun route =>
+      if route.method == .GET then route.pattern.match_ path else none
+
+  -- Both strategies must agree on which paths match and what they capture
+  for path in paths do
+    let trieParams := (router.trie.match? .GET path).map (·.2)
+    shouldSatisfy (trieParams == linearFind path) s!"agreement on {path}"
+
+  let start ← IO.monoNanosNow
+  let mut hits := 0
+  for k in [:lookups] do
+    if (linearFind paths[k % paths.size]!).isSome then hits := hits + 1
+  let linearNs := (← IO.monoNanosNow) - start
+
+  let start ← IO.monoNanosNow
+  let mut trieHits := 0
+  for k in [:lookups] do
+    if (router.trie.match? .GET paths[k % paths.size]!).isSome then trieHits := trieHits + 1
+  let trieNs := (← IO.monoNanosNow) - start
+
+  trieHits ≡ hits
+  -- Timings are reported, not asserted: wall-clock comparisons flake on loaded machines
+  IO.println s!"  {routes.size} routes, {lookups} lookups: linear {linearNs / lookups} ns/lookup, trie {trieNs / lookups} ns/lookup"
 
 -- Main entry point
 def main : IO UInt32 := do
@@ -0,0 +1,136 @@
+/-
+  Citadel Load Benchmark
+  Drives many concurrent keep-alive clients against each connection mode and
+  reports throughput and latency percentiles.
+
+  Usage: citadel_load_bench [connections] [seconds]
+  Each connection uses two descriptors in this process, so raise the limit
+  first for large runs (e.g. `ulimit -n 65536` for 10k connections).
+-/
+import Citadel
+import Std.Data.HashMap
+
+open Citadel
+
+structure BenchClient where
+  socket : Jack.Socket
+  buffer : ByteArray := .empty
+  sentAt : Nat := 0
+
+structure BenchResult where
+  mode : String
+  connected : Nat
+  requests : Nat
+  errors : Nat
+  elapsedNs : Nat
+  latencies : Array Nat
+
+def requestBytes : ByteArray :=
+  "GET /hello HTTP/1.1\r\nHost: bench\r\n\r\n".toUTF8
+
+def nsToMs (ns : Nat) : Float := ns.toFloat / 1000000.0
+
+def percentile (sorted : Array Nat) (p : Nat) : Nat :=
+  if sorted.isEmpty then 0
+  else sorted[min (sorted.size - 1) (sorted.size * p / 100)]!
+
+/-- Find a free loopback port by binding to port 0 -/
+def freePort : IO UInt16 := do
+  let probe ← Jack.Socket.new
+  probe.bind "127.0.0.1" 0
+  let addr ← probe.getLocalAddr
+  probe.close
+  match addr with
+  | .ipv4 _ port => pure port
+  | .ipv6 _ port => pure port
+  | _ => throw (IO.userError "Unexpected local address")
+
+/-- Start a server in the background and return its port -/
+def startServer (mode : ConnectionMode) : IO UInt16 := do
+  let port ← freePort
+  let server := Server.create { port, connectionMode := mode }
+    |>.get "/hello" (fun _ => pure (Response.ok "hello"))
+  let _ ← IO.asTask (prio := .dedicated) server.run
+  IO.sleep 300
+  pure port
+
+/-- Open connections and keep one request in flight on each until the deadline -/
+def drive (mode : String) (port : UInt16) (connections seconds : Nat) : IO BenchResult := do
+  let poller ← Jack.Poller.new
+  let mut clients : Std.HashMap UInt64 BenchClient := {}
+  let mut errors := 0
+  for i in [:connections] do
+    try
+      let sock ← Jack.Socket.new
+      sock.connect "127.0.0.1" port
+      sock.setNonBlocking true
+      poller.add sock #[.readable] i.toUInt64
+      clients := clients.insert i.toUInt64 { socket := sock }
+    catch _ =>
+      errors := errors + 1
+  let connected := clients.size
+
+  let start ← IO.monoNanosNow
+  for (token, client) in clients.toList do
+    match ← client.socket.sendTry requestBytes with
+    | .ok _ => clients := clients.insert token { client with sentAt := start }
+    | _ =>
+      errors := errors + 1
+      try poller.remove client.socket catch _ => pure ()
+      client.socket.close
+      clients := clients.erase token
+
+  let deadline := start + seconds * 1000000000
+  let mut latencies : Array Nat := #[]
+  let mut now := start
+  while now < deadline && !clients.isEmpty do
+    let events ← poller.wait 1024 100
+    for ev in events do
+      if let some client := clients.get? ev.token then
+        match ← client.socket.recvTry 65536 with
+        | .ok data =>
+          if data.isEmpty then
+            errors := errors + 1
+            try poller.remove client.socket catch _ => pure ()
+            client.socket.close
+            clients := clients.erase ev.token
+          else
+            let buffer := client.buffer ++ data
+            match Herald.parseResponse buffer with
+            | .ok parsed =>
+              let t ← IO.monoNanosNow
+              latencies := latencies.push (t - client.sentAt)
+              let _ ← client.socket.sendTry requestBytes
+              clients := clients.insert ev.token
+                { client with buffer := buffer.extract parsed.bytesConsumed buffer.size, sentAt := t }
+            | .error _ =>
+              clients := clients.insert ev.token { client with buffer := buffer }
+        | .wouldBlock => pure ()
+        | .error _ =>
+          errors := errors + 1
+          try poller.remove client.socket catch _ => pure ()
+          client.socket.close
+          clients := clients.erase ev.token
+    now ← IO.monoNanosNow
+
+  for (_, client) in clients.toList do
+    client.socket.close
+  poller.close
+  return { mode, connected, requests := latencies.size, errors, elapsedNs := now - start, latencies }
+
+def report (r : BenchResult) : IO Unit := do
+  let sorted := r.latencies.qsort (· < ·)
+  let secs := r.elapsedNs.toFloat / 1000000000.0
+  let rps := if secs > 0 then r.requests.toFloat / secs else 0
+  IO.println s!"{r.mode}: connected {r.connected}, {r.requests} requests, {rps} req/s, p50 {nsToMs (percentile sorted 50)} ms, p99 {nsToMs (percentile sorted 99)} ms, errors {r.errors}"
+
+def main (args : List String) : IO Unit := do
+  let connections := (args[0]? >>= String.toNat?).getD 10000
+  let seconds := (args[1]? >>= String.toNat?).getD 10
+  IO.println s!"Citadel load benchmark: {connections} keep-alive connections, {seconds}s per mode (poller: {← Jack.Poller.backend})"
+  let modes : List (String × ConnectionMode) :=
+    [("thread-per-connection", .threadPerConnection), ("event-loop", .eventLoop)]
+  for (name, mode) in modes do
+    let port ← startServer mode
+    let result ← drive name port connections seconds
+    report result
@@ -66,6 +66,7 @@ def ok : StatusCode := ⟨200⟩
 def created : StatusCode := ⟨201⟩
 def accepted : StatusCode := ⟨202⟩
 def noContent : StatusCode := ⟨204⟩
+def partialContent : StatusCode := ⟨206⟩
 
 -- Redirection 3xx
 def movedPermanently : StatusCode := ⟨301⟩
@@ -84,6 +85,7 @@ def methodNotAllowed : StatusCode := ⟨405⟩
 def conflict : StatusCode := ⟨409⟩
 def gone : StatusCode := ⟨410⟩
 def unprocessableEntity : StatusCode := ⟨422⟩
+def rangeNotSatisfiable : StatusCode := ⟨416⟩
 def tooManyRequests : StatusCode := ⟨429⟩
 
 -- Server Error 5xx
@@ -109,6 +111,7 @@ def defaultReason (s : StatusCode) : String :=
   | 201 => "Created"
   | 202 => "Accepted"
   | 204 => "No Content"
+  | 206 => "Partial Content"
   | 301 => "Moved Permanently"
   | 302 => "Found"
   | 303 => "See Other"
@@ -122,6 +125,7 @@ def defaultReason (s : StatusCode) : String :=
   | 405 => "Method Not Allowed"
   | 409 => "Conflict"
   | 410 => "Gone"
+  | 416 => "Range Not Satisfiable"
   | 422 => "Unprocessable Entity"
   | 429 => "Too Many Requests"
   | 500 => "Internal Server Error"
@@ -222,6 +226,14 @@ structure Request where
   body : ByteArray
   deriving Inhabited
 
+/-- A byte range of a file on disk, used as a response body that servers
+    send with sendfile(2) instead of copying it through `Response.body` -/
+structure FileRange where
+  path : String
+  offset : Nat
+  length : Nat
+  deriving Repr, BEq, Inhabited
+
 /-- HTTP response -/
 structure Response where
   version : Version
@@ -229,6 +241,8 @@ structure Response where
   reason : String
   headers : Headers
   body : ByteArray
+  /-- File-backed body sent after `body` (which is then normally empty) -/
+  file : Option FileRange := none
   deriving Inhabited
 
 end Herald.Core
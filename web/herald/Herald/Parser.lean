@@ -11,6 +11,7 @@ import Herald.Parser.Headers
 import Herald.Parser.Body
 import Herald.Parser.Chunked
 import Herald.Parser.Message
+import Herald.Parser.Incremental
 
 namespace Herald
 
@@ -39,6 +39,13 @@ def executeFrom (dec : Decoder α) (input : ByteArray) (startPos : Nat) : ParseR
   let (result, _) := ExceptT.run dec { input, position := startPos, limit := none }
   result
 
+/-- Run decoder starting at a specific position, returning the final position -/
+def executeFromWithPos (dec : Decoder α) (input : ByteArray) (startPos : Nat) : Except ParseError (α × Nat) :=
+  let (result, state) := ExceptT.run dec { input, position := startPos, limit := none }
+  match result with
+  | .ok a => .ok (a, state.position)
+  | .error e => .error e
+
 /-- Get the effective end position (limit or input size) -/
 def getEndPos : Decoder Nat := do
   let s ← get
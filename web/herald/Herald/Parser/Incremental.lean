@@ -0,0 +1,390 @@
+/-
+  Herald Incremental Request Parser
+
+  Resumable request parsing for connections that deliver bytes in arbitrary
+  pieces. Received bytes are appended with `feed`; `next` returns a request as
+  soon as it is complete and leaves whatever follows it (a pipelined request)
+  buffered for the next call.
+
+  Work already done is never repeated: the search for the end of the head
+  resumes where the previous call stopped, and chunked bodies advance one
+  complete chunk at a time. A parsed head refers to the receive buffer by
+  byte ranges (`RequestHead`); names and values are only decoded into
+  `String`s once the whole message, body included, has arrived.
+-/
+import Herald.Parser.Headers
+import Herald.Parser.Body
+import Herald.Parser.Chunked
+import Herald.Parser.Message
+
+namespace Herald.Parser.Incremental
+
+open Herald.Core
+open Primitives
+open Message (ParsedRequest)
+
+/-- Byte at offset i, or 0 past the end -/
+@[inline] private def byteAt (buf : ByteArray) (i : Nat) : UInt8 :=
+  if h : i < buf.size then buf[i] else 0
+
+private def toLowerByte (b : UInt8) : UInt8 :=
+  if b >= 65 && b <= 90 then b + 32 else b
+
+/-- First offset in [i, stop) whose byte fails pred (stop if none) -/
+private partial def skipWhile (buf : ByteArray) (pred : UInt8 → Bool) (i stop : Nat) : Nat :=
+  if i < stop && pred (byteAt buf i) then skipWhile buf pred (i + 1) stop else i
+
+/-- Offset of the CR or LF ending the line that contains offset i -/
+private partial def lineEnd (buf : ByteArray) (i : Nat) : Nat :=
+  if i >= buf.size then i
+  else
+    let b := byteAt buf i
+    if b == Ascii.CR || b == Ascii.LF then i else lineEnd buf (i + 1)
+
+/-- Whether a blank line (CRLF or LF) starts at offset i -/
+private def atBlank (buf : ByteArray) (i : Nat) : Bool :=
+  byteAt buf i == Ascii.LF || (byteAt buf i == Ascii.CR && byteAt buf (i + 1) == Ascii.LF)
+
+/-- Offset past the line terminator at i -/
+private def afterEol (buf : ByteArray) (i : Nat) : Except ParseError Nat :=
+  if byteAt buf i == Ascii.LF then .ok (i + 1)
+  else if byteAt buf i == Ascii.CR && byteAt buf (i + 1) == Ascii.LF then .ok (i + 2)
+  else .error (.other s!"expected CRLF or LF, got {byteAt buf i}")
+
+/-- Whether the line terminator at i is followed by an obs-fold continuation -/
+private def isFold (buf : ByteArray) (i : Nat) : Bool :=
+  match afterEol buf i with
+  | .ok j => j < buf.size && Ascii.isWS (byteAt buf j)
+  | .error _ => false
+
+/-- Search from offset i for the blank line that ends a head, returning the offset just past it -/
+private partial def findHeadEnd (buf : ByteArray) (i : Nat) : Option Nat :=
+  if i >= buf.size then none
+  else if byteAt buf i == Ascii.LF then
+    let b := byteAt buf (i + 1)
+    if b == Ascii.LF then some (i + 2)
+    else if b == Ascii.CR && byteAt buf (i + 2) == Ascii.LF then some (i + 3)
+    else findHeadEnd buf (i + 1)
+  else findHeadEnd buf (i + 1)
+
+/-- Byte range [start, stop) of a buffer -/
+structure Slice where
+  start : Nat
+  stop : Nat
+  deriving Repr, Inhabited, BEq
+
+namespace Slice
+
+def size (s : Slice) : Nat := s.stop - s.start
+
+/-- Copy the bytes out of the buffer -/
+def bytes (s : Slice) (buf : ByteArray) : ByteArray := buf.extract s.start s.stop
+
+/-- Case-insensitive comparison with an ASCII string, without copying -/
+def eqIgnoreCase (s : Slice) (buf : ByteArray) (lit : String) : Bool := Id.run do
+  let lit := lit.toUTF8
+  if s.size != lit.size then return false
+  for k in [:lit.size] do
+    if toLowerByte (byteAt buf (s.start + k)) != toLowerByte (byteAt lit k) then return false
+  return true
+
+/-- Drop leading and trailing SP/HT -/
+def trim (s : Slice) (buf : ByteArray) : Slice := Id.run do
+  let start := skipWhile buf Ascii.isWS s.start s.stop
+  let mut stop := s.stop
+  while stop > start && Ascii.isWS (byteAt buf (stop - 1)) do
+    stop := stop - 1
+  return ⟨start, stop⟩
+
+/-- Decimal value, if the slice is all digits -/
+def toNat? (s : Slice) (buf : ByteArray) : Option Nat := Id.run do
+  if s.size == 0 then return none
+  let mut n := 0
+  for i in [s.start:s.stop] do
+    let b := byteAt buf i
+    if !Ascii.isDigit b then return none
+    n := n * 10 + (b - 48).toNat
+  return some n
+
+/-- Decode as UTF-8 -/
+def decode (s : Slice) (buf : ByteArray) : Except ParseError String :=
+  match String.fromUTF8? (s.bytes buf) with
+  | some str => .ok str
+  | none => .error (.other "invalid UTF-8")
+
+end Slice
+
+/-- Replace each line break and the indentation after it with one space -/
+private partial def unfold (buf : ByteArray) (i stop : Nat) (acc : ByteArray) : ByteArray :=
+  if i >= stop then acc
+  else
+    let b := byteAt buf i
+    if b == Ascii.CR || b == Ascii.LF then
+      let j := skipWhile buf (fun b => b == Ascii.CR || b == Ascii.LF) i stop
+      unfold buf (skipWhile buf Ascii.isWS j stop) stop (acc.push Ascii.SP)
+    else
+      unfold buf (i + 1) stop (acc.push b)
+
+/-- A header field located in the receive buffer -/
+structure RawHeader where
+  name : Slice
+  /-- Value without surrounding whitespace; a folded value spans its continuation lines -/
+  value : Slice
+  /-- Value continues on obs-fold lines and is unfolded when decoded -/
+  folded : Bool := false
+  deriving Repr, Inhabited
+
+namespace RawHeader
+
+/-- Value bytes with any folding removed, and the range they occupy -/
+def valueBytes (h : RawHeader) (buf : ByteArray) : ByteArray × Slice :=
+  if h.folded then
+    let bytes := unfold buf h.value.start h.value.stop .empty
+    (bytes, (Slice.mk 0 bytes.size).trim bytes)
+  else
+    (buf, h.value)
+
+/-- Decode to a `Header`, matching the semantics of `Headers.header` -/
+def decode (h : RawHeader) (buf : ByteArray) : Except ParseError Header := do
+  let name ← h.name.decode buf
+  let (bytes, range) := h.valueBytes buf
+  let value ← range.decode bytes
+  pure { name, value }
+
+end RawHeader
+
+/-- A parsed request head whose fields are ranges of the receive buffer -/
+structure RequestHead where
+  /-- Offset of the request line -/
+  start : Nat
+  method : Slice
+  target : Slice
+  version : Version
+  headers : Array RawHeader
+  /-- Offset just past the blank line ending the head -/
+  stop : Nat
+  deriving Repr, Inhabited
+
+/-- Parse "HTTP/" DIGIT "." DIGIT at offset i -/
+private def parseVersion (buf : ByteArray) (i : Nat) : Except ParseError Version := do
+  let tag := "HTTP/".toUTF8
+  for k in [:tag.size] do
+    if byteAt buf (i + k) != byteAt tag k then
+      throw (.invalidVersion "expected HTTP/")
+  let major := byteAt buf (i + 5)
+  let minor := byteAt buf (i + 7)
+  if !Ascii.isDigit major then
+    throw (.invalidVersion "expected major version digit")
+  if byteAt buf (i + 6) != 46 then
+    throw (.invalidVersion "expected '.'")
+  if !Ascii.isDigit minor then
+    throw (.invalidVersion "expected minor version digit")
+  pure { major := major - 48, minor := minor - 48 }
+
+/-- Parse a head occupying [start, stop) of the buffer; stop is just past its blank line -/
+def parseHead (buf : ByteArray) (start stop : Nat) : Except ParseError RequestHead := do
+  -- Request line
+  let methodEnd := skipWhile buf Ascii.isTokenChar start stop
+  if methodEnd == start then
+    throw (.invalidMethod "empty or invalid method")
+  if byteAt buf methodEnd != Ascii.SP then
+    throw (.other s!"expected SP, got {byteAt buf methodEnd}")
+  let targetStart := methodEnd + 1
+  let targetEnd := skipWhile buf (fun b => b != Ascii.SP && b != Ascii.CR && b != Ascii.LF) targetStart stop
+  if targetEnd == targetStart then
+    throw .invalidPath
+  -- The version is optional (HTTP/0.9 style requests default to 1.0)
+  let (version, lineStop) ← if byteAt buf targetEnd == Ascii.SP then do
+      let version ← parseVersion buf (targetEnd + 1)
+      pure (version, targetEnd + 9)
+    else
+      pure (Version.http10, targetEnd)
+  let mut i ← afterEol buf lineStop
+  -- Header fields
+  let mut headers : Array RawHeader := #[]
+  while i < stop && !atBlank buf i do
+    let nameEnd := skipWhile buf Ascii.isTokenChar i stop
+    if nameEnd == i then
+      throw (.invalidHeader "empty header name")
+    if byteAt buf nameEnd != Ascii.COLON then
+      throw (.other s!"expected ':', got {byteAt buf nameEnd}")
+    let valueStart := skipWhile buf Ascii.isWS (nameEnd + 1) stop
+    let mut eol := lineEnd buf valueStart
+    let mut folded := false
+    while isFold buf eol do
+      folded := true
+      eol := lineEnd buf (← afterEol buf eol)
+    let value := (Slice.mk valueStart eol).trim buf
+    headers := headers.push { name := ⟨i, nameEnd⟩, value, folded }
+    i ← afterEol buf eol
+  pure { start, method := ⟨start, methodEnd⟩, target := ⟨targetStart, targetEnd⟩, version, headers, stop }
+
+/-- Last comma-separated element of a list value, trimmed -/
+private def lastCoding (buf : ByteArray) (s : Slice) : Slice := Id.run do
+  let mut first := s.start
+  for i in [s.start:s.stop] do
+    if byteAt buf i == 44 then first := i + 1  -- ','
+  return (Slice.mk first s.stop).trim buf
+
+namespace RequestHead
+
+/-- First header with the given name (case-insensitive) -/
+def find? (h : RequestHead) (buf : ByteArray) (name : String) : Option RawHeader :=
+  h.headers.find? (·.name.eqIgnoreCase buf name)
+
+/-- How the body is delimited, matching `Body.requestBodyStrategy` -/
+def bodyStrategy (h : RequestHead) (buf : ByteArray) : Body.BodyStrategy :=
+  let chunked := match h.find? buf "Transfer-Encoding" with
+    | some te =>
+      -- Only the last transfer coding decides the framing
+      let (bytes, range) := te.valueBytes buf
+      (lastCoding bytes range).eqIgnoreCase bytes "chunked"
+    | none => false
+  if chunked then .chunked
+  else
+    match h.find? buf "Content-Length" with
+    | some cl =>
+      let (bytes, range) := cl.valueBytes buf
+      match range.toNat? bytes with
+      | some 0 | none => .none
+      | some n => .fixedLength n
+    | none => .none
+
+/-- Decode the head into a `Request` carrying the given body -/
+def toRequest (h : RequestHead) (buf : ByteArray) (body : ByteArray) : Except ParseError Request := do
+  let method := Method.fromString (← h.method.decode buf)
+  let path ← h.target.decode buf
+  let headers ← h.headers.mapM (·.decode buf)
+  pure { method, path, version := h.version, headers, body }
+
+end RequestHead
+
+/-- Progress through the current message -/
+inductive Phase where
+  /-- Looking for the end of the next head -/
+  | head
+  /-- Waiting until `length` body bytes follow the head -/
+  | fixed (head : RequestHead) (length : Nat)
+  /-- `cursor` is the next chunk-size line; `body` holds the chunk data decoded so far -/
+  | chunked (head : RequestHead) (cursor : Nat) (body : ByteArray)
+  deriving Inhabited
+
+/-- Resumable request parser for one connection -/
+structure RequestParser where
+  /-- Received bytes; everything before `start` has been consumed -/
+  buffer : ByteArray := .empty
+  /-- Offset of the message being parsed -/
+  start : Nat := 0
+  /-- Where the search for the end of the head resumes -/
+  scan : Nat := 0
+  phase : Phase := .head
+  /-- Largest head accepted, in bytes -/
+  maxHeadBytes : Nat := 64 * 1024
+  /-- Largest body accepted, in bytes -/
+  maxBodyBytes : Nat := 16 * 1024 * 1024
+  deriving Inhabited
+
+namespace RequestParser
+
+/-- Create a parser with the given limits -/
+def new (maxHeadBytes : Nat := 64 * 1024) (maxBodyBytes : Nat := 16 * 1024 * 1024) : RequestParser :=
+  { maxHeadBytes, maxBodyBytes }
+
+/-- Bytes received but not yet returned as part of a request -/
+def buffered (p : RequestParser) : Nat := p.buffer.size - p.start
+
+/-- Whether no partial request is buffered -/
+def isIdle (p : RequestParser) : Bool :=
+  match p.phase with
+  | .head => p.buffered == 0
+  | _ => false
+
+/-- Append received bytes -/
+def feed (p : RequestParser) (data : ByteArray) : RequestParser :=
+  -- The buffer is detached from the parser first so that appending happens in place
+  let buf := p.buffer
+  let p := { p with buffer := .empty }
+  match p.phase with
+  | .head =>
+    if p.start == 0 then
+      { p with buffer := buf ++ data }
+    else if p.start >= buf.size then
+      { p with buffer := data, start := 0, scan := 0 }
+    else
+      -- Between heads nothing refers into the buffer, so the consumed prefix can go
+      { p with buffer := buf.extract p.start buf.size ++ data, scan := p.scan - p.start, start := 0 }
+  | _ => { p with buffer := buf ++ data }
+
+/-- Hand out a finished message and move to the next one -/
+private def emit (p : RequestParser) (head : RequestHead) (body : ByteArray) (stop : Nat)
+    : Except ParseError (Option ParsedRequest × RequestParser) := do
+  let request ← head.toRequest p.buffer body
+  let hdrs := request.headers
+  let parsed : ParsedRequest := {
+    request
+    upgrade := if Headers.isUpgrade hdrs then Headers.getUpgrade hdrs else none
+    bytesConsumed := stop - p.start
+    connectionClose := Headers.isConnectionClose hdrs
+  }
+  pure (some parsed, { p with start := stop, scan := stop, phase := .head })
+
+/-- Parse as far as the buffered bytes allow. Returns the next complete request,
+    or `none` when more bytes are needed. -/
+partial def next (p : RequestParser) : Except ParseError (Option ParsedRequest × RequestParser) := do
+  match p.phase with
+  | .head =>
+    -- Empty lines between requests are ignored (RFC 9112 section 2.2)
+    let headStart := skipWhile p.buffer (fun b => b == Ascii.CR || b == Ascii.LF) p.start p.buffer.size
+    match findHeadEnd p.buffer (max p.scan headStart) with
+    | none =>
+      if p.buffer.size - headStart > p.maxHeadBytes then
+        throw .messageTooLarge
+      -- A terminator may straddle the end of the buffer, so rescan the last two bytes
+      pure (none, { p with scan := max headStart (p.buffer.size - 2) })
+    | some stop =>
+      if stop - headStart > p.maxHeadBytes then
+        throw .messageTooLarge
+      let head ← parseHead p.buffer headStart stop
+      match head.bodyStrategy p.buffer with
+      | .chunked => next { p with phase := .chunked head stop .empty }
+      | .fixedLength n =>
+        if n > p.maxBodyBytes then
+          throw .messageTooLarge
+        next { p with phase := .fixed head n }
+      | _ => emit p head .empty stop
+  | .fixed head length =>
+    let stop := head.stop + length
+    if p.buffer.size < stop then
+      pure (none, p)
+    else
+      emit p head (p.buffer.extract head.stop stop) stop
+  | .chunked head cursor body =>
+    match Decoder.executeFromWithPos Chunked.chunkSizeLine p.buffer cursor with
+    | .error .incomplete => pure (none, p)
+    | .error e => throw e
+    | .ok ((0, _), trailerStart) =>
+      match Decoder.executeFromWithPos Chunked.trailerHeaders p.buffer trailerStart with
+      | .error .incomplete => pure (none, p)
+      | .error e => throw e
+      | .ok (_, stop) => emit p head body stop
+    | .ok ((size, _), dataStart) =>
+      if body.size + size > p.maxBodyBytes then
+        throw .messageTooLarge
+      match Decoder.executeFromWithPos (Chunked.chunkData size) p.buffer dataStart with
+      | .error .incomplete => pure (none, p)
+      | .error e => throw e
+      | .ok (data, cursor) =>
+        -- Release the phase's reference so the body is extended in place
+        let p := { p with phase := .head }
+        next { p with phase := .chunked head cursor (body ++ data) }
+
+/-- Parse every complete request buffered, in order -/
+partial def drain (p : RequestParser) (acc : Array ParsedRequest := #[])
+    : Except ParseError (Array ParsedRequest × RequestParser) := do
+  match ← p.next with
+  | (some req, p) => drain p (acc.push req)
+  | (none, p) => pure (acc, p)
+
+end RequestParser
+
+end Herald.Parser.Incremental
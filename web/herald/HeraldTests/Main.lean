@@ -7,6 +7,7 @@ import Herald
 import Crucible
 import HeraldTests.Parser.Requests
 import HeraldTests.Parser.Responses
+import HeraldTests.Parser.Incremental
 
 -- Core type tests are defined in their own namespace
 namespace HeraldTests.Core
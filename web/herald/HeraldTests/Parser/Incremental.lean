@@ -0,0 +1,186 @@
+/-
+  Herald Incremental Parser Tests
+
+  Chunked delivery, pipelining, and agreement with the whole-buffer parser.
+-/
+import Herald
+import Crucible
+
+namespace HeraldTests.Parser.Incremental
+
+open Crucible
+open Herald.Core
+open Herald.Parser.Message (ParsedRequest)
+open Herald.Parser.Incremental
+
+/-- Helper to build HTTP message from lines -/
+def httpMsg (lines : List String) : ByteArray :=
+  (String.intercalate "\r\n" lines ++ "\r\n").toUTF8
+
+/-- A browser-like request with a realistic set of headers -/
+def browserRequest (path : String) : ByteArray := httpMsg [
+  s!"GET {path} HTTP/1.1",
+  "Host: www.example.com",
+  "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0",
+  "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8",
+  "Accept-Language: en-US,en;q=0.5",
+  "Accept-Encoding: gzip, deflate, br, zstd",
+  "Referer: https://www.example.com/products/catalog?page=3&sort=price",
+  "Cookie: session=3f2a9c1e7b5d4a8f9e0c6b1d2a3f4e5d; theme=dark; _ga=GA1.2.1234567890.1700000000",
+  "Connection: keep-alive",
+  "Upgrade-Insecure-Requests: 1",
+  "Sec-Fetch-Dest: document",
+  "Sec-Fetch-Mode: navigate",
+  "Sec-Fetch-Site: same-origin",
+  "Sec-Fetch-User: ?1",
+  "Priority: u=0, i",
+  ""
+]
+
+/-- Feed the input in pieces of the given size, collecting every request -/
+def parseInPieces (input : ByteArray) (piece : Nat) : IO (Array ParsedRequest × RequestParser) := do
+  let mut parser : RequestParser := {}
+  let mut out := #[]
+  let mut pos := 0
+  while pos < input.size do
+    let stop := min input.size (pos + piece)
+    parser := parser.feed (input.extract pos stop)
+    pos := stop
+    match parser.drain with
+    | .ok (reqs, p) =>
+      parser := p
+      out := out ++ reqs
+    | .error e => throw (IO.userError s!"Parse failed: {e}")
+  return (out, parser)
+
+def sameRequest (a b : Request) : Bool :=
+  a.method == b.method && a.path == b.path && a.version == b.version &&
+    a.headers == b.headers && a.body == b.body
+
+testSuite "Incremental Parser"
+
+test "byte-at-a-time matches parseRequest" := do
+  let input := browserRequest "/index.html"
+  let (reqs, parser) ← parseInPieces input 1
+  reqs.size ≡ 1
+  match Herald.parseRequest input with
+  | .ok expected =>
+    shouldSatisfy (sameRequest reqs[0]!.request expected.request) "same request as parseRequest"
+    reqs[0]!.bytesConsumed ≡ expected.bytesConsumed
+  | .error e => throw (IO.userError s!"Parse failed: {e}")
+  shouldSatisfy parser.isIdle "nothing left buffered"
+
+test "returns none until the head is complete" := do
+  let parser := RequestParser.new |>.feed "GET / HTTP/1.1\r\nHost: a\r\n".toUTF8
+  match parser.next with
+  | .ok (none, p) =>
+    match (p.feed "\r\n".toUTF8).next with
+    | .ok (some req, _) => req.request.path ≡ "/"
+    | _ => throw (IO.userError "Expected a request after the blank line")
+  | _ => throw (IO.userError "Expected to wait for more bytes")
+
+test "pipelined requests in one read come out in order" := do
+  let input := httpMsg ["GET /a HTTP/1.1", "Host: x", ""] ++
+    httpMsg ["POST /b HTTP/1.1", "Content-Length: 5", "", "hello"] ++
+    httpMsg ["GET /c HTTP/1.1", "Host: x", ""]
+  match (RequestParser.new |>.feed input).drain with
+  | .ok (reqs, parser) =>
+    (reqs.map (·.request.path)) ≡ #["/a", "/b", "/c"]
+    String.fromUTF8! reqs[1]!.request.body ≡ "hello"
+    shouldSatisfy parser.isIdle "all requests consumed"
+  | .error e => throw (IO.userError s!"Parse failed: {e}")
+
+test "leftover bytes of the next request are kept" := do
+  let first := httpMsg ["GET /first HTTP/1.1", "Host: x", ""]
+  let second := httpMsg ["GET /second HTTP/1.1", "Host: x", ""]
+  let parser := RequestParser.new |>.feed (first ++ second.extract 0 10)
+  match parser.drain with
+  | .ok (reqs, parser) =>
+    reqs.size ≡ 1
+    parser.buffered ≡ 10
+    match (parser.feed (second.extract 10 second.size)).next with
+    | .ok (some req, _) => req.request.path ≡ "/second"
+    | _ => throw (IO.userError "Expected the second request")
+  | .error e => throw (IO.userError s!"Parse failed: {e}")
+
+test "chunked body split across reads" := do
+  let input := httpMsg [
+    "POST /upload HTTP/1.1",
+    "Transfer-Encoding: chunked",
+    "",
+    "5",
+    "hello",
+    "6; ext=1",
+    " world",
+    "0",
+    "Trailer: yes",
+    ""
+  ] ++ httpMsg ["GET /after HTTP/1.1", ""]
+  for piece in [1, 3, 7, 64] do
+    let (reqs, _) ← parseInPieces input piece
+    reqs.size ≡ 2
+    String.fromUTF8! reqs[0]!.request.body ≡ "hello world"
+    reqs[1]!.request.path ≡ "/after"
+
+test "folded headers and bare LF match parseRequest" := do
+  let input := "GET /fold HTTP/1.1\nX-Long: first\r\n   second  \r\n\tthird\nHost: h \n\n".toUTF8
+  let (reqs, _) ← parseInPieces input 2
+  match Herald.parseRequest input with
+  | .ok expected =>
+    reqs.size ≡ 1
+    reqs[0]!.request.headers ≡ expected.request.headers
+    reqs[0]!.request.headers.get "X-Long" ≡ some "first second   third"
+  | .error e => throw (IO.userError s!"Parse failed: {e}")
+
+test "blank lines between requests are skipped" := do
+  let input := "\r\n\r\nGET /a HTTP/1.1\r\n\r\n\r\nGET /b HTTP/1.1\r\n\r\n".toUTF8
+  let (reqs, _) ← parseInPieces input 4
+  (reqs.map (·.request.path)) ≡ #["/a", "/b"]
+
+test "oversized head is rejected" := do
+  let parser := (RequestParser.new (maxHeadBytes := 64)).feed
+    ("GET / HTTP/1.1\r\nX-Fill: " ++ "".pushn 'a' 100).toUTF8
+  match parser.next with
+  | .error .messageTooLarge => pure ()
+  | _ => throw (IO.userError "Expected messageTooLarge")
+
+test "oversized body is rejected before it arrives" := do
+  let parser := (RequestParser.new (maxBodyBytes := 10)).feed
+    (httpMsg ["POST / HTTP/1.1", "Content-Length: 1000", ""])
+  match parser.next with
+  | .error .messageTooLarge => pure ()
+  | _ => throw (IO.userError "Expected messageTooLarge")
+
+test "malformed request line is an error" := do
+  match (RequestParser.new |>.feed "GET\r\n\r\n".toUTF8).next with
+  | .error _ => pure ()
+  | .ok _ => throw (IO.userError "Expected a parse error")
+
+testSuite "Parser.Bench"
+
+test "header-heavy request throughput" := do
+  let count := 20000
+  let requests := (List.range 64).toArray.map fun i => browserRequest s!"/products/{i}/reviews?page={i % 7}"
+  let stream := (List.range count).foldl (init := ByteArray.empty) fun acc i => acc ++ requests[i % requests.size]!
+  let mb := stream.size.toFloat / (1024.0 * 1024.0)
+
+  -- Whole-buffer parser, handed each complete message separately
+  let start ← IO.monoNanosNow
+  let mut parsed := 0
+  for i in [:count] do
+    match Herald.parseRequest requests[i % requests.size]! with
+    | .ok _ => parsed := parsed + 1
+    | .error e => throw (IO.userError s!"Parse failed: {e}")
+  let wholeNs := (← IO.monoNanosNow) - start
+
+  -- Incremental parser fed 16KB reads with requests pipelined across read boundaries
+  let start ← IO.monoNanosNow
+  let (reqs, _) ← parseInPieces stream 16384
+  let incNs := (← IO.monoNanosNow) - start
+
+  parsed ≡ count
+  reqs.size ≡ count
+  let rate (ns : Nat) : Float := mb / (ns.toFloat / 1.0e9)
+  IO.println s!"  {count} requests ({stream.size / count} bytes each): parseRequest {rate wholeNs} MB/s, incremental {rate incNs} MB/s"
+
+end HeraldTests.Parser.Incremental
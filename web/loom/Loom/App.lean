@@ -280,89 +280,45 @@ private def validateCsrf (ctx : Context) : Bool :=
       | some token => Form.validateCsrfToken token ctx.config.secretKey ctx.session
       | none => false
 
-/-- Match a route pattern against a path, extracting parameters -/
-private def matchRoute (pattern : String) (path : String) : Option (List (String × String)) :=
-  let patternParts := pattern.splitOn "/" |>.filter (· != "")
-  let pathParts := path.splitOn "/" |>.filter (· != "")
-
-  if patternParts.length != pathParts.length then none
-  else
-    let pairs := patternParts.zip pathParts
-    let result := pairs.foldl (init := some []) fun acc (pat, actual) =>
-      match acc with
-      | none => none
-      | some params =>
-        if pat.startsWith ":" then
-          -- Parameter segment
-          let paramName := pat.drop 1
-          some ((paramName, actual) :: params)
-        else if pat == actual then
-          -- Literal match
-          some params
-        else
-          none
-    result.map List.reverse
-
-/-- Count parameter segments in a pattern -/
-private def countParams (pattern : String) : Nat :=
-  pattern.splitOn "/" |>.filter (·.startsWith ":") |>.length
-
-/-- Count literal (non-parameter) segments in a pattern -/
-private def countLiterals (pattern : String) : Nat :=
-  pattern.splitOn "/" |>.filter (fun s => s != "" && !s.startsWith ":") |>.length
-
-/-- Find matching route for request (prefers more specific routes) -/
-private def findRoute (routes : Routes) (method : Herald.Core.Method) (path : String) : Option (NamedRoute × List (String × String)) :=
-  -- Remove query string from path
-  let cleanPath := Form.pathWithoutQuery path
-  -- Collect all matching routes with their extracted params
-  let matchingRoutes := routes.routes.filterMap fun route =>
-    if route.method != method then none
-    else matchRoute route.pattern cleanPath |>.map (route, ·)
-  -- Sort by specificity: more literals is better, then fewer params is better
-  let sorted := matchingRoutes.toArray.qsort fun (r1, _) (r2, _) =>
-    let lit1 := countLiterals r1.pattern
-    let lit2 := countLiterals r2.pattern
-    if lit1 != lit2 then lit1 > lit2  -- More literals = more specific
-    else countParams r1.pattern < countParams r2.pattern  -- Fewer params = more specific
-  if h : sorted.size > 0 then some sorted[0] else none
-
 /-- Create the main handler -/
 def toHandler (app : App)
     (cachedPersistentDbRef : Option (IO.Ref Ledger.Persist.PersistentConnection) := none)
-    (stencilManagerRef : Option (IO.Ref Stencil.Manager) := none) : Citadel.Handler := fun req => do
-  -- Build initial context (reads current connection from ref if available)
-  let ctx ← buildContext req app.config cachedPersistentDbRef app.logger stencilManagerRef
-
-  -- Find matching route
-  match findRoute app.routes req.method req.path with
-  | none =>
-    -- Try static file if configured
-    match app.config.staticPath with
-    | some staticPath =>
-      match ← Static.serveFile staticPath req.path app.config.devMode with
-      | some resp => pure resp
+    (stencilManagerRef : Option (IO.Ref Stencil.Manager) := none) : Citadel.Handler :=
+  -- Compile the route table once; the handler closure reuses it for every request
+  let table := app.routes.compile
+  fun req => do
+    -- Build initial context (reads current connection from ref if available)
+    let ctx ← buildContext req app.config cachedPersistentDbRef app.logger stencilManagerRef
+
+    -- Find matching route
+    match table.match? req.method req.path with
+    | none =>
+      -- Try static file if configured
+      match app.config.staticPath with
+      | some staticPath =>
+        match ← Static.serveFile staticPath req.path app.config.devMode (headers := req.headers) with
+        | some resp => pure resp
+        | none => pure Citadel.Response.notFound
       | none => pure Citadel.Response.notFound
-    | none => pure Citadel.Response.notFound
-  | some (route, pathParams) =>
-    -- Add path params to context
-    let ctx := addPathParams ctx pathParams
-
-    -- CSRF validation
-    if !validateCsrf ctx then
-      pure (Citadel.ResponseBuilder.withStatus (Herald.Core.StatusCode.mk 403)
-        |>.withText "CSRF token validation failed"
-        |>.build)
-    else
-      -- Apply route-level middleware chain, then execute action
-      let wrappedAction := RouteMiddleware.chain route.middleware route.action
-      let (resp, ctx') ← wrappedAction ctx
-      -- Write updated connection back to shared ref (if using cached db)
-      match cachedPersistentDbRef, ctx'.persistentDb with
-      | some ref, some updatedPc => ref.set updatedPc
-      | _, _ => pure ()
-      -- Finalize response with session from modified context
-      pure (finalizeResponse ctx' resp)
+    | some (route, pathParams) =>
+      -- Add path params to context
+      let ctx := addPathParams ctx pathParams
+
+      -- CSRF validation
+      if !validateCsrf ctx then
+        pure (Citadel.ResponseBuilder.withStatus (Herald.Core.StatusCode.mk 403)
+          |>.withText "CSRF token validation failed"
+          |>.build)
+      else
+        -- Apply route-level middleware chain, then execute action
+        let wrappedAction := RouteMiddleware.chain route.middleware route.action
+        let (resp, ctx') ← wrappedAction ctx
+        -- Write updated connection back to shared ref (if using cached db)
+        match cachedPersistentDbRef, ctx'.persistentDb with
+        | some ref, some updatedPc => ref.set updatedPc
+        | _, _ => pure ()
+        -- Finalize response with session from modified context
+        pure (finalizeResponse ctx' resp)
 
 /-- Create Citadel server from app (without SSE - use for non-SSE apps) -/
 def toServerBase (app : App)
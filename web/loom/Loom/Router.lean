@@ -81,6 +81,11 @@ def pathFor! (r : Routes) (name : String) (params : List (String × String) := [
 def names (r : Routes) : List String :=
   r.routes.map (·.name)
 
+/-- Compile the routes into a trie for per-request matching -/
+def compile (r : Routes) : Citadel.RouteTrie NamedRoute :=
+  r.routes.foldl (init := Citadel.RouteTrie.empty) fun t route =>
+    t.insert route.method route.pattern route
+
 /-- Convert to Citadel router -/
 def toCitadelRouter (r : Routes) : Citadel.Router :=
   r.routes.foldl (init := Citadel.Router.empty) fun router route =>
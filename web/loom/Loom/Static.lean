@@ -1,8 +1,15 @@
 /-
   Loom.Static - Static file serving
+
+  Files are looked up through an in-process cache of metadata (and of the
+  contents of small files), answer conditional requests with 304 and single
+  byte ranges with 206. Large files become file-backed response bodies that
+  Citadel sends with sendfile, so they never pass through the Lean heap.
 -/
 import Citadel
 import Staple
+import Std.Data.HashMap
+import Std.Sync.Mutex
 
 namespace Loom
 
@@ -60,34 +67,233 @@ structure Config where
   devMode : Bool := false
   /-- Cache max-age in seconds (only used when devMode is false) -/
   maxAge : Nat := 3600
+  /-- Files up to this size are kept in memory; larger ones are sent with sendfile -/
+  inlineMaxBytes : Nat := 64 * 1024
+  /-- Maximum number of files in the open-file cache -/
+  cacheEntries : Nat := 1024
+  /-- Milliseconds cached metadata is trusted before the file is stat'ed again -/
+  revalidateMs : Nat := 2000
   deriving Inhabited
 
-/-- Serve a single file from disk (non-recursive helper) -/
-private def serveFileAt (fullPath : String) (devMode : Bool := false) (maxAge : Nat := 3600) : IO (Option Herald.Core.Response) := do
+private def pad2 (n : Nat) : String :=
+  if n < 10 then s!"0{n}" else toString n
+
+/-- Format Unix seconds as an HTTP date (IMF-fixdate), e.g. `Sun, 06 Nov 1994 08:49:37 GMT` -/
+def httpDate (secs : Int) : String :=
+  let days := secs / 86400
+  let rem := (secs % 86400).toNat
+  let weekday := ((days + 4) % 7).toNat
+  -- Civil date from days since the epoch (proleptic Gregorian calendar)
+  let z := days + 719468
+  let era := (if z >= 0 then z else z - 146096) / 146097
+  let doe := z - era * 146097
+  let yoe := (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365
+  let doy := doe - (365 * yoe + yoe / 4 - yoe / 100)
+  let mp := (5 * doy + 2) / 153
+  let day := (doy - (153 * mp + 2) / 5 + 1).toNat
+  let month := (if mp < 10 then mp + 3 else mp - 9).toNat
+  let year := yoe + era * 400 + (if month <= 2 then 1 else 0)
+  let dayNames := #["Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"]
+  let monthNames := #["Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"]
+  s!"{dayNames[weekday]!}, {pad2 day} {monthNames[month - 1]!} {year} " ++
+    s!"{pad2 (rem / 3600)}:{pad2 (rem % 3600 / 60)}:{pad2 (rem % 60)} GMT"
+
+/-- Outcome of interpreting a `Range` request header against a file size -/
+inductive RangeRequest where
+  /-- No (usable) range: send the whole file -/
+  | full
+  /-- A single satisfiable byte range -/
+  | partial (start length : Nat)
+  /-- The range lies outside the file -/
+  | unsatisfiable
+  deriving Repr, BEq, Inhabited
+
+/-- Parse a `Range` header. Only single `bytes=` ranges are honoured; multi-range
+    and malformed headers fall back to the whole file, as RFC 9110 permits. -/
+def parseRange (header : Option String) (size : Nat) : RangeRequest :=
+  match header with
+  | none => .full
+  | some value =>
+    let value := value.trim
+    if !value.startsWith "bytes=" || value.contains ',' then .full
+    else
+      match (value.drop 6).splitOn "-" with
+      | [first, last] =>
+        let first := first.trim
+        let last := last.trim
+        if first.isEmpty then
+          -- Suffix range: the final N bytes
+          match last.toNat? with
+          | some n =>
+            if n == 0 || size == 0 then .unsatisfiable
+            else
+              let len := min n size
+              .partial (size - len) len
+          | none => .full
+        else
+          match first.toNat? with
+          | none => .full
+          | some start =>
+            if start >= size then .unsatisfiable
+            else if last.isEmpty then .partial start (size - start)
+            else
+              match last.toNat? with
+              | some stop =>
+                if stop < start then .full
+                else .partial start (min stop (size - 1) - start + 1)
+              | none => .full
+      | _ => .full
+
+/-- Cached metadata of a static file, plus its contents when small enough -/
+structure CachedFile where
+  /-- Resolved file path (after directory index lookup) -/
+  path : String
+  size : Nat
+  modified : IO.FS.SystemTime
+  etag : String
+  lastModified : String
+  contentType : String
+  /-- In-memory contents for files up to `Config.inlineMaxBytes` -/
+  contents : Option ByteArray
+  /-- Monotonic milliseconds of the last stat -/
+  checkedAt : Nat
+  /-- Monotonic milliseconds of the last hit, for eviction -/
+  lastUsed : Nat
+
+initialize fileCache : Std.Mutex (Std.HashMap String CachedFile) ← Std.Mutex.new {}
+
+/-- Drop every cached file -/
+def clearCache : IO Unit :=
+  fileCache.atomically (set ({} : Std.HashMap String CachedFile))
+
+/-- Number of files currently cached -/
+def cacheSize : IO Nat :=
+  fileCache.atomically do return (← get).size
+
+/-- Resolve a request to a regular file (directories serve their index.html) -/
+private def resolveFile (fullPath : String) : IO (Option (String × IO.FS.Metadata)) := do
   try
-    let contents ← IO.FS.readBinFile fullPath
-    let contentType := mimeType fullPath
-    -- Get file modification time for ETag
-    let metadata ← System.FilePath.metadata fullPath
-    let mtime := metadata.modified.sec
-    let etag := s!"\"{mtime}\""
-    -- Set cache headers based on mode
-    let cacheControl := if devMode then
-      "no-cache, no-store, must-revalidate"
+    let md ← System.FilePath.metadata fullPath
+    if md.type == .dir then
+      let indexPath := s!"{fullPath}/index.html"
+      let indexMd ← System.FilePath.metadata indexPath
+      if indexMd.type == .dir then return none
+      return some (indexPath, indexMd)
+    return some (fullPath, md)
+  catch _ =>
+    return none
+
+private def loadFile (config : Config) (path : String) (md : IO.FS.Metadata) (now : Nat)
+    (previous : Option CachedFile := none) : IO CachedFile := do
+  let size := md.byteSize.toNat
+  -- Unchanged file: keep the cached contents, only refresh the check time
+  if let some prev := previous then
+    if prev.path == path && prev.size == size && prev.modified == md.modified then
+      return { prev with checkedAt := now, lastUsed := now }
+  let contents ← if size <= config.inlineMaxBytes then some <$> IO.FS.readBinFile path else pure none
+  return {
+    path, size, modified := md.modified
+    etag := s!"\"{size}-{md.modified.sec}.{md.modified.nsec}\""
+    lastModified := httpDate md.modified.sec
+    contentType := mimeType path
+    contents, checkedAt := now, lastUsed := now
+  }
+
+/-- Insert an entry, evicting the least recently used one when the cache is full -/
+private def remember (config : Config) (key : String) (entry : CachedFile) : IO Unit :=
+  fileCache.atomically do
+    let mut cache ← get
+    if !cache.contains key && cache.size >= config.cacheEntries then
+      let victim := cache.fold (init := (none : Option (String × Nat))) fun acc k e =>
+        match acc with
+        | some (_, used) => if e.lastUsed < used then some (k, e.lastUsed) else acc
+        | none => some (k, e.lastUsed)
+      if let some (k, _) := victim then
+        cache := cache.erase k
+    if config.cacheEntries > 0 then
+      set (cache.insert key entry)
     else
-      s!"public, max-age={maxAge}"
-    let resp := Citadel.ResponseBuilder.withStatus Herald.Core.StatusCode.ok
-      |>.withHeader "Content-Type" contentType
+      set cache
+
+/-- Look up a file through the cache. Within `revalidateMs` of the last check a hit
+    costs no syscalls; afterwards the file is stat'ed and reloaded only if it changed. -/
+def lookup (config : Config) (fullPath : String) : IO (Option CachedFile) := do
+  let now ← IO.monoMsNow
+  if config.devMode then
+    match ← resolveFile fullPath with
+    | some (path, md) => return some (← loadFile config path md now)
+    | none => return none
+  let cached ← fileCache.atomically do return (← get).get? fullPath
+  if let some entry := cached then
+    if now - entry.checkedAt < config.revalidateMs then
+      fileCache.atomically (modify (·.insert fullPath { entry with lastUsed := now }))
+      return some entry
+  match ← resolveFile fullPath with
+  | none =>
+    if cached.isSome then fileCache.atomically (modify (·.erase fullPath))
+    return none
+  | some (path, md) =>
+    let entry ← loadFile config path md now cached
+    remember config fullPath entry
+    return some entry
+
+/-- Whether the request's validators match the cached file (answer 304) -/
+def notModified (entry : CachedFile) (headers : Herald.Core.Headers) : Bool :=
+  match headers.get "If-None-Match" with
+  | some tags =>
+    tags.trim == "*" || (tags.splitOn ",").any fun tag =>
+      let tag := tag.trim
+      let tag := if tag.startsWith "W/" then tag.drop 2 else tag
+      tag == entry.etag
+  | none => headers.get "If-Modified-Since" == some entry.lastModified
+
+/-- Build the response for a cached file, honouring conditional and Range headers -/
+def respond (config : Config) (entry : CachedFile) (headers : Herald.Core.Headers) : Herald.Core.Response :=
+  let cacheControl := if config.devMode then
+    "no-cache, no-store, must-revalidate"
+  else
+    s!"public, max-age={config.maxAge}"
+  let base := fun (status : Herald.Core.StatusCode) =>
+    Citadel.ResponseBuilder.withStatus status
+      |>.withHeader "Content-Type" entry.contentType
       |>.withHeader "Cache-Control" cacheControl
-      |>.withHeader "ETag" etag
-      |>.withBody contents
-      |>.build
-    return some resp
+      |>.withHeader "ETag" entry.etag
+      |>.withHeader "Last-Modified" entry.lastModified
+      |>.withHeader "Accept-Ranges" "bytes"
+  let withRange := fun (b : Citadel.ResponseBuilder) (start length : Nat) =>
+    match entry.contents with
+    | some bytes => b.withBody (bytes.extract start (start + length))
+    | none => b.withFile { path := entry.path, offset := start, length }
+  if notModified entry headers then
+    let resp := (base Herald.Core.StatusCode.notModified).build
+    { resp with headers := resp.headers.filter (·.name != "Content-Length") }
+  else
+    -- A stale If-Range validator means the client wants the whole (new) file
+    let rangeHeader := match headers.get "If-Range" with
+      | some v => if v.trim == entry.etag then headers.get "Range" else none
+      | none => headers.get "Range"
+    match parseRange rangeHeader entry.size with
+    | .full => (withRange (base Herald.Core.StatusCode.ok) 0 entry.size).build
+    | .partial start length =>
+      (withRange (base Herald.Core.StatusCode.partialContent) start length
+        |>.withHeader "Content-Range" s!"bytes {start}-{start + length - 1}/{entry.size}").build
+    | .unsatisfiable =>
+      (base Herald.Core.StatusCode.rangeNotSatisfiable
+        |>.withHeader "Content-Range" s!"bytes */{entry.size}").build
+
+/-- Serve a single resolved path through the cache -/
+private def serveFileAt (config : Config) (fullPath : String) (headers : Herald.Core.Headers)
+    : IO (Option Herald.Core.Response) := do
+  try
+    match ← lookup config fullPath with
+    | some entry => return some (respond config entry headers)
+    | none => return none
   catch _ =>
     return none
 
-/-- Serve a file from disk -/
-def serveFile (basePath : String) (requestPath : String) (devMode : Bool := false) (maxAge : Nat := 3600) : IO (Option Herald.Core.Response) := do
+/-- Serve a file using config. `headers` supplies conditional and Range request headers. -/
+def serveFileWithConfig (config : Config) (requestPath : String)
+    (headers : Herald.Core.Headers := Herald.Core.Headers.empty) : IO (Option Herald.Core.Response) := do
   -- Remove leading slash and sanitize
   let relativePath := if requestPath.startsWith "/" then requestPath.drop 1 else requestPath
 
@@ -95,35 +301,22 @@ def serveFile (basePath : String) (requestPath : String) (devMode : Bool := fals
   if !isSafePath relativePath then
     return none
 
-  let fullPath := s!"{basePath}/{relativePath}"
-
-  -- Check if file exists
-  if !(← System.FilePath.pathExists fullPath) then
-    return none
+  serveFileAt config s!"{config.basePath}/{relativePath}" headers
 
-  -- Check if it's a directory
-  if (← System.FilePath.isDir fullPath) then
-    -- Try to serve index.html
-    let indexPath := s!"{fullPath}/index.html"
-    if !(← System.FilePath.pathExists indexPath) then
-      return none
-    serveFileAt indexPath devMode maxAge
-  else
-    serveFileAt fullPath devMode maxAge
-
-/-- Serve a file using config -/
-def serveFileWithConfig (config : Config) (requestPath : String) : IO (Option Herald.Core.Response) :=
-  serveFile config.basePath requestPath config.devMode config.maxAge
+/-- Serve a file from disk -/
+def serveFile (basePath : String) (requestPath : String) (devMode : Bool := false) (maxAge : Nat := 3600)
+    (headers : Herald.Core.Headers := Herald.Core.Headers.empty) : IO (Option Herald.Core.Response) :=
+  serveFileWithConfig { basePath, devMode, maxAge } requestPath headers
 
 /-- Create a static file handler -/
 def handler (basePath : String) (devMode : Bool := false) : Citadel.Handler := fun req => do
-  match ← serveFile basePath req.path devMode with
+  match ← serveFile basePath req.path devMode (headers := req.headers) with
   | some resp => pure resp
   | none => pure Citadel.Response.notFound
 
 /-- Create a static file handler with config -/
 def handlerWithConfig (config : Config) : Citadel.Handler := fun req => do
-  match ← serveFileWithConfig config req.path with
+  match ← serveFileWithConfig config req.path req.headers with
   | some resp => pure resp
   | none => pure Citadel.Response.notFound
 
@@ -133,7 +326,7 @@ def middleware (basePath : String) (devMode : Bool := false) : Citadel.Middlewar
   if req.method != .GET then
     return ← handler req
 
-  match ← serveFile basePath req.path devMode with
+  match ← serveFile basePath req.path devMode (headers := req.headers) with
   | some resp => pure resp
   | none => handler req
 
@@ -143,7 +336,7 @@ def middlewareWithConfig (config : Config) : Citadel.Middleware := fun handler r
   if req.method != .GET then
     return ← handler req
 
-  match ← serveFileWithConfig config req.path with
+  match ← serveFileWithConfig config req.path req.headers with
   | some resp => pure resp
   | none => handler req
 
@@ -61,28 +61,28 @@ def render (name : String) (data : Stencil.Value := .null) : Loom.ActionM Herald
     let manager ← managerRef.get
 
     -- Find template
-    match manager.getTemplate name with
-    | none => throw (IO.userError (toString (RenderError.templateNotFound name)))
-    | some tmpl =>
+    match manager.getTemplate name, manager.getCompiledTemplate name with
+    | some tmpl, some compiled =>
       -- Build Stencil context with merged data
       let stencilCtx := buildStencilContext ctx data manager.getPartials
 
       -- Render template
-      match Stencil.renderString tmpl stencilCtx with
+      match compiled.renderString stencilCtx with
       | .ok htmlStr =>
         -- Check for default layout
         match manager.config.defaultLayout with
         | none => Loom.ActionM.html htmlStr
         | some layoutName =>
-          match manager.getLayout layoutName with
+          match manager.getCompiledLayout layoutName with
           | none => Loom.ActionM.html htmlStr  -- No layout found, just return content
           | some layoutTmpl =>
             -- Render layout with content as "content" block
             let layoutCtx := stencilCtx.addPartial "content" tmpl
-            match Stencil.renderString layoutTmpl layoutCtx with
+            match layoutTmpl.renderString layoutCtx with
             | .ok layoutHtml => Loom.ActionM.html layoutHtml
             | .error e => throw (IO.userError (toString (RenderError.renderError (toString e))))
       | .error e => throw (IO.userError (toString (RenderError.renderError (toString e))))
+    | _, _ => throw (IO.userError (toString (RenderError.templateNotFound name)))
 
 /-- Render a template with an explicit layout.
     The layout template should use `{{> content}}` to include the main content. -/
@@ -96,24 +96,24 @@ def renderWithLayout (layout : String) (name : String) (data : Stencil.Value :=
     let manager ← managerRef.get
 
     -- Find template
-    match manager.getTemplate name with
+    match manager.getCompiledTemplate name with
     | none => throw (IO.userError (toString (RenderError.templateNotFound name)))
     | some tmpl =>
       -- Find layout
-      match manager.getLayout layout with
+      match manager.getCompiledLayout layout with
       | none => throw (IO.userError (toString (RenderError.layoutNotFound layout)))
       | some layoutTmpl =>
         -- Build context
         let stencilCtx := buildStencilContext ctx data manager.getPartials
 
         -- First render the content template
-        match Stencil.renderString tmpl stencilCtx with
+        match tmpl.renderString stencilCtx with
         | .error e => throw (IO.userError (toString (RenderError.renderError (toString e))))
         | .ok contentHtml =>
           -- Pass rendered content as a string value
           -- Layout should use {{{content}}} (triple braces) for raw/unescaped output
           let layoutCtx := stencilCtx.mergeData (.object #[("content", .string contentHtml)])
-          match Stencil.renderString layoutTmpl layoutCtx with
+          match layoutTmpl.renderString layoutCtx with
           | .ok layoutHtml => Loom.ActionM.html layoutHtml
           | .error e => throw (IO.userError (toString (RenderError.renderError (toString e))))
 
@@ -145,11 +145,11 @@ def renderPartial (name : String) (data : Stencil.Value := .null)
     maybeHotReload managerRef
     let manager ← managerRef.get
 
-    match manager.getPartial name with
+    match manager.getCompiledPartial name with
     | none => throw (IO.userError (toString (RenderError.templateNotFound s!"partial:{name}")))
     | some tmpl =>
       let stencilCtx := buildStencilContext ctx data manager.getPartials
-      match Stencil.renderString tmpl stencilCtx with
+      match tmpl.renderString stencilCtx with
       | .ok htmlStr => Loom.ActionM.html htmlStr
       | .error e => throw (IO.userError (toString (RenderError.renderError (toString e))))
 
@@ -8,6 +8,7 @@ import Std.Data.HashMap
 -- Alias to avoid namespace conflicts (Loom.Stencil shadows the Stencil module)
 abbrev StencilEngine := Stencil.Engine
 abbrev StencilTemplate := Stencil.Template
+abbrev StencilCompiledTemplate := Stencil.CompiledTemplate
 
 namespace Loom.Stencil
 
@@ -19,6 +20,8 @@ private def containsSubstr (s sub : String) : Bool :=
 structure TemplateEntry where
   /-- The parsed template -/
   template : StencilTemplate
+  /-- The template compiled against the current partials (see `Manager.compileAll`) -/
+  compiled : Option StencilCompiledTemplate := none
   /-- Original file path -/
   path : System.FilePath
   /-- File modification time (for hot reload) -/
@@ -100,6 +103,23 @@ partial def walkDir (dir : System.FilePath) : IO (List System.FilePath) := do
         files := entry.path :: files
   pure files
 
+/-- Get all partials as a HashMap of templates (for Stencil context) -/
+def getPartials (m : Manager) : Std.HashMap String StencilTemplate :=
+  m.partials.fold (init := {}) fun acc name entry =>
+    acc.insert name entry.template
+
+/-- Compile every template, layout and partial against the current partials.
+    Partials are inlined at compile time, so this reruns after any reload. -/
+def compileAll (m : Manager) : Manager :=
+  let partials := m.getPartials
+  let compile (entries : Std.HashMap String TemplateEntry) : Std.HashMap String TemplateEntry :=
+    entries.fold (init := entries) fun acc name entry =>
+      acc.insert name { entry with compiled := some (Stencil.compileTemplate entry.template partials) }
+  { m with
+    templates := compile m.templates
+    layouts := compile m.layouts
+    partials := compile m.partials }
+
 /-- Discover and load all templates from the template directory -/
 def discover (config : Config) : IO Manager := do
   let templateDir := System.FilePath.mk config.templateDir
@@ -143,7 +163,8 @@ def discover (config : Config) : IO Manager := do
       IO.eprintln s!"Warning: Failed to parse template {path}: {e}"
 
   let now ← IO.monoNanosNow
-  pure { manager with lastReloadCheck := (now / 1000000).toUInt64 }  -- Convert to ms
+  let manager := { manager with lastReloadCheck := (now / 1000000).toUInt64 }  -- Convert to ms
+  pure manager.compileAll
 
 /-- Get a template by name -/
 def getTemplate (m : Manager) (name : String) : Option StencilTemplate :=
@@ -157,10 +178,23 @@ def getLayout (m : Manager) (name : String) : Option StencilTemplate :=
 def getPartial (m : Manager) (name : String) : Option StencilTemplate :=
   m.partials.get? name |>.map (·.template)
 
-/-- Get all partials as a HashMap of templates (for Stencil context) -/
-def getPartials (m : Manager) : Std.HashMap String StencilTemplate :=
-  m.partials.fold (init := {}) fun acc name entry =>
-    acc.insert name entry.template
+/-- Compiled form of an entry, compiling on demand if `compileAll` has not run -/
+private def compiledEntry (m : Manager) (entry : TemplateEntry) : StencilCompiledTemplate :=
+  match entry.compiled with
+  | some compiled => compiled
+  | none => Stencil.compileTemplate entry.template m.getPartials
+
+/-- Get a compiled template by name -/
+def getCompiledTemplate (m : Manager) (name : String) : Option StencilCompiledTemplate :=
+  m.templates.get? name |>.map m.compiledEntry
+
+/-- Get a compiled layout by name -/
+def getCompiledLayout (m : Manager) (name : String) : Option StencilCompiledTemplate :=
+  m.layouts.get? name |>.map m.compiledEntry
+
+/-- Get a compiled partial by name -/
+def getCompiledPartial (m : Manager) (name : String) : Option StencilCompiledTemplate :=
+  m.partials.get? name |>.map m.compiledEntry
 
 /-- Check if hot reload should run (based on interval) -/
 def shouldCheckReload (m : Manager) : IO Bool := do
@@ -250,6 +284,10 @@ def checkAndReload (m : Manager) : IO (Manager × Bool) := do
     manager := newManager
     if changed then anyChanged := true
 
+  -- Recompile so edited partials reach the templates that inline them
+  if anyChanged then
+    manager := manager.compileAll
+
   -- Update last check time
   let now ← IO.monoNanosNow
   pure ({ manager with lastReloadCheck := (now / 1000000).toUInt64 }, anyChanged)
@@ -285,6 +285,64 @@ test "isSafePath blocks absolute paths" := do
 test "isSafePath blocks home directory" := do
   Static.isSafePath "~/.ssh/id_rsa" ≡ false
 
+test "httpDate formats IMF-fixdate" := do
+  Static.httpDate 784111777 ≡ "Sun, 06 Nov 1994 08:49:37 GMT"
+  Static.httpDate 0 ≡ "Thu, 01 Jan 1970 00:00:00 GMT"
+
+test "parseRange handles single byte ranges" := do
+  Static.parseRange none 100 ≡ .full
+  Static.parseRange (some "bytes=0-9") 100 ≡ .partial 0 10
+  Static.parseRange (some "bytes=90-") 100 ≡ .partial 90 10
+  Static.parseRange (some "bytes=-5") 100 ≡ .partial 95 5
+  Static.parseRange (some "bytes=50-500") 100 ≡ .partial 50 50
+  Static.parseRange (some "bytes=100-") 100 ≡ .unsatisfiable
+  Static.parseRange (some "bytes=0-1,5-6") 100 ≡ .full
+  Static.parseRange (some "items=0-1") 100 ≡ .full
+
+test "cached files answer conditional and range requests" := do
+  let dir : System.FilePath := "/tmp/loom-static-test"
+  IO.FS.createDirAll dir
+  IO.FS.writeFile (dir / "app.css") "body { color: red; }"
+  Static.clearCache
+  let config : Static.Config := { basePath := dir.toString }
+  let some first ← Static.serveFileWithConfig config "/app.css"
+    | throw (IO.userError "static file not served")
+  first.status.code ≡ 200
+  String.fromUTF8! first.body ≡ "body { color: red; }"
+  shouldSatisfy (first.headers.get "Last-Modified").isSome "Last-Modified set"
+  let some etag := first.headers.get "ETag" | throw (IO.userError "missing ETag")
+  (← Static.cacheSize) ≡ 1
+
+  let some cached ← Static.serveFileWithConfig config "/app.css" #[{ name := "If-None-Match", value := etag }]
+    | throw (IO.userError "conditional request not served")
+  cached.status.code ≡ 304
+  cached.body.size ≡ 0
+
+  let some part ← Static.serveFileWithConfig config "/app.css" #[{ name := "Range", value := "bytes=0-3" }]
+    | throw (IO.userError "range request not served")
+  part.status.code ≡ 206
+  String.fromUTF8! part.body ≡ "body"
+  part.headers.get "Content-Range" ≡ some "bytes 0-3/20"
+
+  let some bad ← Static.serveFileWithConfig config "/app.css" #[{ name := "Range", value := "bytes=50-" }]
+    | throw (IO.userError "unsatisfiable range not served")
+  bad.status.code ≡ 416
+  try IO.FS.removeFile (dir / "app.css") catch _ => pure ()
+
+test "large files become file-backed bodies" := do
+  let dir : System.FilePath := "/tmp/loom-static-test"
+  IO.FS.createDirAll dir
+  IO.FS.writeFile (dir / "big.bin") "0123456789abcdef"
+  Static.clearCache
+  let config : Static.Config := { basePath := dir.toString, inlineMaxBytes := 8 }
+  let some resp ← Static.serveFileWithConfig config "/big.bin" #[{ name := "Range", value := "bytes=4-7" }]
+    | throw (IO.userError "large file not served")
+  resp.status.code ≡ 206
+  resp.body.size ≡ 0
+  resp.file.map (fun f => (f.offset, f.length)) ≡ some (4, 4)
+  resp.headers.get "Content-Length" ≡ some "4"
+  try IO.FS.removeFile (dir / "big.bin") catch _ => pure ()
+
 -- ============================================================================
 -- Database Tests
 -- ============================================================================
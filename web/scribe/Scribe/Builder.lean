@@ -52,6 +52,10 @@ def build (m : HtmlM Unit) : Html :=
 def render (m : HtmlM Unit) : String :=
   (build m).render
 
+/-- Render content in pieces of at least `chunkBytes` bytes (see `Html.renderChunked`) -/
+def renderChunked (m : HtmlM Unit) (sink : String → IO Unit) (chunkBytes : Nat := 16384) : IO Unit :=
+  (build m).renderChunked sink chunkBytes
+
 /-- Render content with pretty printing -/
 def renderPretty (m : HtmlM Unit) : String :=
   (build m).renderPretty
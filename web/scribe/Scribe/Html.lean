@@ -20,26 +20,46 @@ inductive Html where
 
 namespace Html
 
+/-- Entity for a character that must be escaped (`'` only outside attributes) -/
+@[inline] private def entity? (attr : Bool) : Char → Option String
+  | '<' => some "&lt;"
+  | '>' => some "&gt;"
+  | '&' => some "&amp;"
+  | '"' => some "&quot;"
+  | '\'' => if attr then none else some "&#39;"
+  | _ => none
+
+/-- Append s to out with special characters escaped. Runs of characters that need
+    no escaping are copied in one piece rather than character by character. -/
+private partial def escapeRun (attr : Bool) (s out : String) (runStart i : Nat) : String :=
+  if i >= s.utf8ByteSize then
+    if runStart == 0 then
+      if out.isEmpty then s else out ++ s
+    else if runStart < i then out ++ String.Pos.Raw.extract s ⟨runStart⟩ ⟨i⟩
+    else out
+  else
+    let c := String.Pos.Raw.get s ⟨i⟩
+    match entity? attr c with
+    | some e =>
+      let out := if runStart < i then out ++ String.Pos.Raw.extract s ⟨runStart⟩ ⟨i⟩ else out
+      escapeRun attr s (out ++ e) (i + 1) (i + 1)
+    | none => escapeRun attr s out runStart (i + c.utf8Size)
+
+/-- Append text to a buffer, escaping HTML special characters -/
+def escapeTextInto (out s : String) : String :=
+  escapeRun false s out 0 0
+
+/-- Append an attribute value to a buffer, escaping it -/
+def escapeAttrInto (out s : String) : String :=
+  escapeRun true s out 0 0
+
 /-- Escape HTML special characters in text -/
 def escapeText (s : String) : String :=
-  s.foldl (init := "") fun acc c =>
-    acc ++ match c with
-      | '<' => "&lt;"
-      | '>' => "&gt;"
-      | '&' => "&amp;"
-      | '"' => "&quot;"
-      | '\'' => "&#39;"
-      | c => c.toString
+  escapeTextInto "" s
 
 /-- Escape attribute value -/
 def escapeAttr (s : String) : String :=
-  s.foldl (init := "") fun acc c =>
-    acc ++ match c with
-      | '<' => "&lt;"
-      | '>' => "&gt;"
-      | '&' => "&amp;"
-      | '"' => "&quot;"
-      | c => c.toString
+  escapeAttrInto "" s
 
 /-- Void elements that don't have closing tags -/
 def voidElements : List String :=
@@ -50,24 +70,52 @@ def voidElements : List String :=
 def isVoidElement (tag : String) : Bool :=
   voidElements.contains tag
 
+/-- Append rendered attributes to a buffer -/
+def renderAttrsInto (out : String) (attrs : List Attr) : String :=
+  attrs.foldl (init := out) fun out a =>
+    escapeAttrInto (out ++ " " ++ a.name ++ "=\"") a.value ++ "\""
+
 /-- Render attributes to string -/
 def renderAttrs (attrs : List Attr) : String :=
-  if attrs.isEmpty then ""
-  else " " ++ String.intercalate " " (attrs.map fun a =>
-    s!"{a.name}=\"{escapeAttr a.value}\"")
+  renderAttrsInto "" attrs
 
-/-- Render HTML to string -/
-partial def render : Html → String
-  | .text s => escapeText s
-  | .raw s => s
+/-- Append rendered HTML to a buffer. The buffer is threaded through the whole
+    tree, so it grows in place instead of concatenating per-element strings. -/
+partial def renderInto (out : String) : Html → String
+  | .text s => escapeTextInto out s
+  | .raw s => out ++ s
   | .element tag attrs children =>
-    if isVoidElement tag then
-      s!"<{tag}{renderAttrs attrs}>"
-    else
-      let inner := String.join (children.map render)
-      s!"<{tag}{renderAttrs attrs}>{inner}</{tag}>"
+    let out := renderAttrsInto (out ++ "<" ++ tag) attrs ++ ">"
+    if isVoidElement tag then out
+    else children.foldl renderInto out ++ "</" ++ tag ++ ">"
   | .fragment children =>
-    String.join (children.map render)
+    children.foldl renderInto out
+
+/-- Render HTML to string -/
+def render (h : Html) : String :=
+  renderInto "" h
+
+/-- Render HTML in pieces, handing each to `sink` once it holds at least
+    `chunkBytes` bytes (e.g. to write a large page to a socket while the rest
+    is still being rendered). The pieces concatenate to `render h`. -/
+partial def renderChunked (sink : String → IO Unit) (h : Html) (chunkBytes : Nat := 16384) : IO Unit := do
+  let rest ← go "" h
+  if !rest.isEmpty then sink rest
+where
+  spill (out : String) : IO String := do
+    if out.utf8ByteSize >= chunkBytes then
+      sink out
+      pure ""
+    else
+      pure out
+  go (out : String) : Html → IO String
+    | .element tag attrs children => do
+      if isVoidElement tag then
+        return ← spill (renderAttrsInto (out ++ "<" ++ tag) attrs ++ ">")
+      let out ← children.foldlM go (renderAttrsInto (out ++ "<" ++ tag) attrs ++ ">")
+      spill (out ++ "</" ++ tag ++ ">")
+    | .fragment children => children.foldlM go out
+    | leaf => spill (renderInto out leaf)
 
 /-- Render HTML with indentation for readability -/
 partial def renderPretty (indent : Nat := 0) : Html → String
@@ -4,6 +4,7 @@
 import Crucible
 import ScribeTests.Builder
 import ScribeTests.Components
+import ScribeTests.Render
 
 open Crucible
 
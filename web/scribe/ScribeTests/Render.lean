@@ -0,0 +1,96 @@
+/-
+  Tests for the buffer-passing renderer and its benchmark
+-/
+import Scribe
+import Crucible
+
+namespace ScribeTests.Render
+
+open Crucible
+open Scribe
+
+/-- Reference escaping: one string allocation per character -/
+def naiveEscape (attr : Bool) (s : String) : String :=
+  s.foldl (init := "") fun acc c =>
+    acc ++ match c with
+      | '<' => "&lt;"
+      | '>' => "&gt;"
+      | '&' => "&amp;"
+      | '"' => "&quot;"
+      | '\'' => if attr then "'" else "&#39;"
+      | c => c.toString
+
+/-- Reference renderer: concatenates per-element strings -/
+partial def naiveRender : Html → String
+  | .text s => naiveEscape false s
+  | .raw s => s
+  | .element tag attrs children =>
+    let attrStr := if attrs.isEmpty then "" else
+      " " ++ String.intercalate " " (attrs.map fun a => s!"{a.name}=\"{naiveEscape true a.value}\"")
+    if Html.isVoidElement tag then s!"<{tag}{attrStr}>"
+    else s!"<{tag}{attrStr}>{String.join (children.map naiveRender)}</{tag}>"
+  | .fragment children => String.join (children.map naiveRender)
+
+/-- A table-heavy page with about `rows * 10` nodes -/
+def bigPage (rows : Nat) : Html :=
+  HtmlM.build do
+    raw "<!DOCTYPE html>"
+    html [lang_ "en"] do
+      body [] do
+        table [class_ "data"] do
+          for i in [:rows] do
+            tr [class_ (if i % 2 == 0 then "even" else "odd"), data_ "row" (toString i)] do
+              td [] (text s!"Item #{i}")
+              td [] (text s!"Tom & Jerry's <{i}>")
+              td [] do
+                a [href_ s!"/items/{i}?tab=details&sort=asc"] (text "details")
+              td [] (text "plain cell text without anything special")
+
+testSuite "Scribe Renderer"
+
+test "escaping matches the reference on mixed input" := do
+  let samples := ["", "plain", "<>&\"'", "héllo <wörld> & ✓", "a&&b", "trailing<", "'"]
+  for s in samples do
+    Html.escapeText s ≡ naiveRender (.text s)
+  Html.escapeAttr "it's \"quoted\" & <tagged>" ≡ "it's &quot;quoted&quot; &amp; &lt;tagged&gt;"
+
+test "escapeTextInto appends to the buffer" := do
+  Html.escapeTextInto "<p>" "a<b" ≡ "<p>a&lt;b"
+
+test "render matches the reference renderer" := do
+  let page := bigPage 50
+  page.render ≡ naiveRender page
+
+test "chunked rendering reassembles to the full page" := do
+  let page := bigPage 200
+  let pieces ← IO.mkRef (#[] : Array String)
+  page.renderChunked (fun s => pieces.modify (·.push s)) (chunkBytes := 1024)
+  let parts ← pieces.get
+  shouldSatisfy (parts.size > 1) "large page should be split"
+  shouldSatisfy (parts.pop.all (·.utf8ByteSize >= 1024)) "every piece but the last fills a chunk"
+  String.join parts.toList ≡ page.render
+
+testSuite "Scribe.Bench"
+
+test "render a 10k-node page" := do
+  let page := bigPage 1000
+  let rounds := 20
+
+  let start ← IO.monoNanosNow
+  let mut naiveBytes := 0
+  for _ in [:rounds] do
+    naiveBytes := naiveBytes + (naiveRender page).utf8ByteSize
+  let naiveNs := (← IO.monoNanosNow) - start
+
+  let start ← IO.monoNanosNow
+  let mut bytes := 0
+  for _ in [:rounds] do
+    bytes := bytes + page.render.utf8ByteSize
+  let bufferNs := (← IO.monoNanosNow) - start
+
+  bytes ≡ naiveBytes
+  IO.println s!"  10k nodes, {bytes / rounds} bytes: concatenating {naiveNs / rounds / 1000} us/page, buffer {bufferNs / rounds / 1000} us/page"
+  -- Timings are only reported; wall-clock comparisons are unreliable on shared machines
+  page.render ≡ naiveRender page
+
+end ScribeTests.Render
@@ -12,6 +12,72 @@ def benchRender (tmpl : Template) (ctx : Context) : IO Unit := do
   | .ok s => Bench.forceEval s
   | .error _ => pure ()
 
+/-- Render compiled template and force evaluation of result -/
+def benchCompiled (tmpl : CompiledTemplate) (ctx : Context) : IO Unit := do
+  match tmpl.renderString ctx with
+  | .ok s => Bench.forceEval s
+  | .error _ => pure ()
+
+/-- Docsite's main layout, as served by Loom's `renderWithLayout` -/
+def pageLayout : String :=
+  "<!DOCTYPE html>\n<html lang=\"en\">\n<head>\n  <meta charset=\"utf-8\">\n" ++
+  "  <title>{{title}} - Lean Workspace</title>\n  <link rel=\"stylesheet\" href=\"/css/app.css\">\n" ++
+  "</head>\n<body>\n  <div class=\"app-container\">\n    <aside class=\"sidebar\">\n" ++
+  "      <nav class=\"sidebar-nav\">\n" ++
+  "        {{#each sidebar}}\n        <div class=\"sidebar-category\">\n" ++
+  "          <button class=\"sidebar-toggle\" data-target=\"cat-{{slug}}\">\n" ++
+  "            <span class=\"toggle-icon\">{{#if expanded}}&#9660;{{else}}&#9654;{{/if}}</span>\n" ++
+  "            {{name}}\n          </button>\n" ++
+  "          <div id=\"cat-{{slug}}\" class=\"sidebar-children{{#unless expanded}} collapsed{{/unless}}\">\n" ++
+  "            {{#each projects}}\n            <div class=\"sidebar-project\">\n" ++
+  "              <a href=\"/project/{{slug}}\" class=\"sidebar-link{{#if active}} sidebar-active{{/if}}\">{{name}}</a>\n" ++
+  "            </div>\n            {{/each}}\n          </div>\n        </div>\n        {{/each}}\n" ++
+  "      </nav>\n    </aside>\n    <main class=\"main-content\">\n      {{{content}}}\n    </main>\n" ++
+  "  </div>\n  <script src=\"/js/sidebar.js\"></script>\n</body>\n</html>\n"
+
+/-- Docsite's category page -/
+def categoryPage : String :=
+  "<div class=\"page-header\">\n  <nav class=\"breadcrumb\">\n    <a href=\"/\">Home</a>\n" ++
+  "    <span class=\"breadcrumb-separator\">/</span>\n    <span>{{categoryName}}</span>\n  </nav>\n" ++
+  "  <h1>{{categoryName}}</h1>\n  <p class=\"page-subtitle\">{{projectCount}} projects in this category</p>\n" ++
+  "</div>\n\n<div class=\"projects-list\">\n  {{#each projects}}\n" ++
+  "  <a href=\"/project/{{slug}}\" class=\"project-card\">\n" ++
+  "    <h2 class=\"project-card-title\">{{name}}</h2>\n" ++
+  "    <p class=\"project-card-description\">{{description | truncate \"80\"}}</p>\n" ++
+  "    <span class=\"project-card-link\">View documentation</span>\n  </a>\n  {{/each}}\n</div>\n\n" ++
+  "{{#unless projects}}\n<div class=\"empty-state\">\n  <p>No projects found in this category.</p>\n</div>\n{{/unless}}\n"
+
+/-- Page data shaped like docsite's: 12 sidebar categories of 6 projects, 20 cards -/
+def pageContext : Context :=
+  let project (i : Nat) : Value := .object #[
+    ("slug", .string s!"project-{i}"),
+    ("name", .string s!"Project {i}"),
+    ("description", .string s!"Project {i} does things with <types> & \"proofs\", described at some length for the card."),
+    ("active", .bool (i == 3))
+  ]
+  let category (c : Nat) : Value := .object #[
+    ("slug", .string s!"cat-{c}"),
+    ("name", .string s!"Category {c}"),
+    ("expanded", .bool (c == 0)),
+    ("projects", .array ((List.range 6).map (fun i => project (c * 6 + i))).toArray)
+  ]
+  context [
+    ("title", .string "Web"),
+    ("categoryName", .string "Web & Networking"),
+    ("projectCount", .int 20),
+    ("projects", .array ((List.range 20).map project).toArray),
+    ("sidebar", .array ((List.range 12).map category).toArray)
+  ]
+
+/-- Render the page the way `renderWithLayout` does: content first, then the layout -/
+def renderPage (page layout : Context → RenderResult String) (ctx : Context) : IO Unit := do
+  match page ctx with
+  | .ok content =>
+    match layout (ctx.mergeData (.object #[("content", .string content)])) with
+    | .ok s => Bench.forceEval s
+    | .error _ => pure ()
+  | .error _ => pure ()
+
 /-- Parse and force evaluation -/
 def benchParse (input : String) : IO Unit := do
   let tmpl := parse! input
@@ -149,6 +215,28 @@ def main : IO Unit := do
   IO.println (Bench.formatResult r13)
   IO.println s!"  (uncached was: {297.67}μs, cache hit: ~0μs expected)"
 
+  -- Benchmark 14: Loom page templates, interpreted vs compiled
+  Bench.printHeader "Loom Page (layout + category, 72-link sidebar)"
+  let layoutTmpl := parse! pageLayout
+  let pageTmpl := parse! categoryPage
+  let layoutCompiled := compileTemplate layoutTmpl
+  let pageCompiled := compileTemplate pageTmpl
+  let pageBytes := match renderString pageTmpl pageContext with
+    | .ok content =>
+      match renderString layoutTmpl (pageContext.mergeData (.object #[("content", .string content)])) with
+      | .ok s => s.utf8ByteSize
+      | .error _ => 0
+    | .error _ => 0
+  let r14a ← Bench.benchWithWarmup "page_interpreted" 100 2000 do
+    renderPage (renderString pageTmpl) (renderString layoutTmpl) pageContext
+  IO.println (Bench.formatResult r14a)
+  let r14b ← Bench.benchWithWarmup "page_compiled" 100 2000 do
+    renderPage pageCompiled.renderString layoutCompiled.renderString pageContext
+  IO.println (Bench.formatResult r14b)
+  let pagesPerSec (r : Bench.BenchResult) : Float := 1.0e9 / r.avgNs
+  let mbPerSec (r : Bench.BenchResult) : Float := pageBytes.toFloat * pagesPerSec r / (1024.0 * 1024.0)
+  IO.println s!"  {pageBytes} bytes/page: interpreted {pagesPerSec r14a} pages/s ({mbPerSec r14a} MB/s), compiled {pagesPerSec r14b} pages/s ({mbPerSec r14b} MB/s)"
+
   -- Summary
   Bench.printHeader "Summary"
   IO.println "Benchmark suite complete."
@@ -41,6 +41,10 @@ def render (tmpl : Template) (ctx : Context) : RenderResult Scribe.Html :=
 def renderString (tmpl : Template) (ctx : Context) : RenderResult String :=
   Render.renderString tmpl ctx
 
+/-- Compile a template to closures. Partials in `partials` are inlined. -/
+def compileTemplate (tmpl : Template) (partials : PartialRegistry := {}) : CompiledTemplate :=
+  Render.compileTemplate tmpl partials
+
 /-- Parse and render in one step -/
 def compile (input : String) (ctx : Context) : Except String Scribe.Html :=
   match parse input with
@@ -112,21 +116,39 @@ def withCacheSize (maxSize : Nat) : Engine :=
 
 /-- Parse with caching - returns cached template if available -/
 def parseCached (engine : Engine) (input : String) : ParseResult Template × Engine :=
-  match engine.cache.get? input with
-  | some tmpl => (.ok tmpl, engine)
-  | none =>
+  match engine.cache.lookup (TemplateCache.sourceKey input) with
+  | (some entry, cache) => (.ok entry.template, { engine with cache })
+  | (none, _) =>
     match Parser.parse input with
     | .ok tmpl => (.ok tmpl, { engine with cache := engine.cache.put input tmpl })
     | .error e => (.error e, engine)
 
 /-- Parse with caching, throwing on error -/
 def parseCached! (engine : Engine) (input : String) : Template × Engine :=
-  match engine.cache.get? input with
-  | some tmpl => (tmpl, engine)
-  | none =>
+  match engine.cache.lookup (TemplateCache.sourceKey input) with
+  | (some entry, cache) => (entry.template, { engine with cache })
+  | (none, _) =>
     let tmpl := Stencil.parse! input
     (tmpl, { engine with cache := engine.cache.put input tmpl })
 
+/-- Parse and compile a named template, caching by name and source hash.
+    Partials are bound at first compile; call `clearCache` when they change. -/
+def compileCached (engine : Engine) (name source : String) (partials : PartialRegistry := {})
+    : ParseResult CompiledTemplate × Engine :=
+  let key : CacheKey := ⟨name, source.hash⟩
+  match engine.cache.lookup key with
+  | (some { compiled := some compiled, .. }, cache) => (.ok compiled, { engine with cache })
+  | (some entry, cache) =>
+    let compiled := Render.compileTemplate entry.template partials
+    (.ok compiled, { engine with cache := cache.insert key { entry with compiled := some compiled } })
+  | (none, _) =>
+    match Parser.parse source with
+    | .ok tmpl =>
+      let compiled := Render.compileTemplate tmpl partials
+      let entry : CacheEntry := { template := tmpl, hash := source.hash, compiled := some compiled }
+      (.ok compiled, { engine with cache := engine.cache.insert key entry })
+    | .error e => (.error e, engine)
+
 /-- Get current cache size -/
 def cacheSize (engine : Engine) : Nat := engine.cache.size
 
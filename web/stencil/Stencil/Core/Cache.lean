@@ -4,48 +4,111 @@
 -/
 import Stencil.AST.Types
 import Stencil.Core.Error
+import Stencil.Core.Context
 import Std.Data.HashMap
+import Batteries.Data.RBMap
 
 namespace Stencil
 
+/-- Template compiled to closures (see `Render.compileTemplate`).
+    Appends its output for a context to the given buffer. -/
+structure CompiledTemplate where
+  run : Context → String → RenderResult String
+
+instance : Inhabited CompiledTemplate where
+  default := ⟨fun _ out => .ok out⟩
+
+/-- Cache key: template name plus a hash of its source -/
+structure CacheKey where
+  name : String
+  hash : UInt64
+  deriving BEq, Hashable, Inhabited, Repr
+
 /-- Template cache entry -/
 structure CacheEntry where
   template : Template
   hash : UInt64
+  /-- Compiled form, filled in the first time the entry is compiled -/
+  compiled : Option CompiledTemplate := none
+  /-- Cache clock at the most recent hit -/
+  lastUse : Nat := 0
   deriving Inhabited
 
-/-- Template cache (per-engine instance) -/
+/-- Least-recently-used template cache (per-engine instance) -/
 structure TemplateCache where
-  entries : Std.HashMap UInt64 CacheEntry
+  entries : Std.HashMap CacheKey CacheEntry
   maxSize : Nat := 1000
+  /-- Logical clock, bumped on every insert and hit -/
+  clock : Nat := 0
+  /-- Keys by `lastUse`, oldest first, so eviction is O(log n) -/
+  recency : Batteries.RBMap Nat CacheKey compare := Batteries.RBMap.empty
   deriving Inhabited
 
 namespace TemplateCache
 
 /-- Create empty cache -/
-def empty : TemplateCache := ⟨{}, 1000⟩
+def empty : TemplateCache := { entries := {} }
 
 /-- Create cache with custom max size -/
-def withMaxSize (maxSize : Nat) : TemplateCache := ⟨{}, maxSize⟩
+def withMaxSize (maxSize : Nat) : TemplateCache := { entries := {}, maxSize }
+
+/-- Key for templates cached by source alone -/
+def sourceKey (source : String) : CacheKey := ⟨"", source.hash⟩
+
+/-- Look up an entry without updating its recency -/
+def find? (cache : TemplateCache) (key : CacheKey) : Option CacheEntry :=
+  cache.entries.get? key
+
+/-- Look up an entry and mark it most recently used -/
+def lookup (cache : TemplateCache) (key : CacheKey) : Option CacheEntry × TemplateCache :=
+  match cache.entries.get? key with
+  | some entry =>
+    let recency := (cache.recency.erase entry.lastUse).insert cache.clock key
+    let entry := { entry with lastUse := cache.clock }
+    (some entry, { cache with
+      entries := cache.entries.insert key entry
+      clock := cache.clock + 1
+      recency })
+  | none => (none, cache)
+
+/-- Drop the least recently used entry -/
+def evict (cache : TemplateCache) : TemplateCache :=
+  match cache.recency.min? with
+  | some (lastUse, key) =>
+    { cache with entries := cache.entries.erase key, recency := cache.recency.erase lastUse }
+  | none => cache
+
+/-- Insert or replace an entry, evicting the least recently used one when full -/
+def insert (cache : TemplateCache) (key : CacheKey) (entry : CacheEntry) : TemplateCache :=
+  if cache.maxSize == 0 then cache
+  else
+    let cache := match cache.entries.get? key with
+      | some old => { cache with recency := cache.recency.erase old.lastUse }
+      | none => if cache.entries.size >= cache.maxSize then cache.evict else cache
+    { cache with
+      entries := cache.entries.insert key { entry with lastUse := cache.clock }
+      clock := cache.clock + 1
+      recency := cache.recency.insert cache.clock key }
 
 /-- Get cached template by source string -/
 def get? (cache : TemplateCache) (source : String) : Option Template :=
-  let hash := source.hash
-  cache.entries.get? hash |>.map (·.template)
+  cache.find? (sourceKey source) |>.map (·.template)
 
 /-- Add template to cache -/
 def put (cache : TemplateCache) (source : String) (tmpl : Template) : TemplateCache :=
-  let hash := source.hash
-  -- Simple eviction: if at max size, just don't add
-  -- (could implement LRU later)
-  if cache.entries.size >= cache.maxSize then
-    cache
-  else
-    { cache with entries := cache.entries.insert hash ⟨tmpl, hash⟩ }
+  cache.insert (sourceKey source) { template := tmpl, hash := source.hash }
+
+/-- Get cached template by name and source -/
+def getNamed? (cache : TemplateCache) (name source : String) : Option Template :=
+  cache.find? ⟨name, source.hash⟩ |>.map (·.template)
+
+/-- Add a named template to cache -/
+def putNamed (cache : TemplateCache) (name source : String) (tmpl : Template) : TemplateCache :=
+  cache.insert ⟨name, source.hash⟩ { template := tmpl, hash := source.hash }
 
 /-- Clear the cache -/
 def clear (cache : TemplateCache) : TemplateCache :=
-  { cache with entries := {} }
+  { cache with entries := {}, recency := Batteries.RBMap.empty }
 
 /-- Get cache size -/
 def size (cache : TemplateCache) : Nat :=
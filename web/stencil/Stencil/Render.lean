@@ -5,3 +5,4 @@
 import Stencil.Render.Filters
 import Stencil.Render.Helpers
 import Stencil.Render.Render
+import Stencil.Render.Compile
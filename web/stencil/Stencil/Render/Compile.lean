@@ -0,0 +1,237 @@
+/-
+  Stencil.Render.Compile
+  Template compilation to pre-resolved closures
+
+  The interpreter in `Render.lean` walks the AST and builds a Scribe Html
+  tree on every render. Compiling does that walk once: adjacent text is
+  concatenated, filter chains and lookup strategies are chosen up front,
+  partials known at compile time are inlined, and the resulting closures
+  append straight into one output buffer.
+-/
+import Stencil.Core.Cache
+import Stencil.Render.Render
+
+namespace Stencil.Render
+
+open Scribe
+
+/-- Compiled code for a node sequence: appends its output to the buffer -/
+abbrev Emit := Context → String → RenderResult String
+
+/-- Partials nested deeper than this are looked up at render time
+    (keeps recursive partials finite) -/
+def maxInlineDepth : Nat := 4
+
+/-- Emit nothing -/
+private def emitNone : Emit := fun _ out => .ok out
+
+/-- Emit constant template text (trusted, not escaped) -/
+private def emitText (s : String) : Emit := fun _ out => .ok (out ++ s)
+
+-- Emit needs Inhabited for the partial compile functions
+instance : Inhabited Emit where
+  default := emitNone
+
+/-- Run emitters in order -/
+private def emitSeq (parts : Array Emit) : Emit :=
+  match parts.toList with
+  | [] => emitNone
+  | [part] => part
+  | _ => fun ctx out => parts.foldlM (fun out part => part ctx out) out
+
+/-- Run one node through the interpreter -/
+private def interpret (node : Node) : Emit := fun ctx out =>
+  ((renderNode node).run ctx).map (Html.renderInto out)
+
+/-- Evaluate an expression in a context -/
+private def eval (expr : Expr) (ctx : Context) : RenderResult Value :=
+  (evalExpr expr).run ctx
+
+/-- Loop metadata for iteration `idx` of `size` -/
+private def loopMetaAt (idx size : Nat) (key : Option String := none) : LoopMeta :=
+  { index := idx, first := idx == 0, last := idx == size - 1, length := size, key }
+
+/-- Resolve a filter once. Builtins are looked up at compile time; a custom
+    filter registered on the context still takes precedence. -/
+private def compileFilter (f : Filter) (pos : Position) : Context → Value → RenderResult Value :=
+  match Filters.getFilter f.name with
+  | some fn => fun ctx v =>
+    if ctx.customFilters.isEmpty then fn v f.args (some pos)
+    else Filters.applyFilterWithCustom f v (some pos) ctx.customFilters
+  | none => fun ctx v => Filters.applyFilterWithCustom f v (some pos) ctx.customFilters
+
+/-- Compile a variable: lookup strategy, filter chain and escaping fixed up front -/
+private def compileVariable (ref : VarRef) : Emit :=
+  let lookup : Context → Value :=
+    if ref.parentLevels > 0 then
+      fun ctx => ctx.lookupFromParent ref.path ref.parentLevels |>.getD .null
+    else
+      fun ctx => ctx.lookupParts ref.pathParts ref.path |>.getD .null
+  let filters := ref.filters.map (compileFilter · ref.pos)
+  let write : String → String → String :=
+    if ref.escaped then Html.escapeTextInto else (· ++ ·)
+  fun ctx out => do
+    let v ← filters.foldlM (fun v f => f ctx v) (lookup ctx)
+    return write out v.toString
+
+/-- Try each conditional branch in order, else the fallback -/
+private def emitBranches (inverted : Bool) (otherwise : Emit) : List (Expr × Emit) → Emit
+  | [] => otherwise
+  | (cond, body) :: rest =>
+    let next := emitBranches inverted otherwise rest
+    fun ctx out => do
+      let v ← eval cond ctx
+      if v.isTruthy != inverted then body ctx out else next ctx out
+
+/-- Each loop over an array or object -/
+private def emitEach (config : EachConfig) (body otherwise : Emit) : Emit :=
+  let wrap : Value → Nat → Value := match config.itemVar, config.indexVar with
+    | some itemName, some idxName => fun item idx => .object #[(itemName, item), (idxName, .int idx)]
+    | some itemName, none => fun item _ => .object #[(itemName, item)]
+    | none, _ => fun item _ => item
+  let wrapValue : Value → Value := match config.itemVar with
+    | some itemName => fun value => .object #[(itemName, value)]
+    | none => id
+  fun ctx out => do
+    match ctx.lookup config.source with
+    | some (.array items) =>
+      if items.isEmpty then
+        otherwise ctx out
+      else
+        let mut out := out
+        let mut idx := 0
+        for item in items do
+          out ← body (ctx.pushScope (wrap item idx) (loopMetaAt idx items.size)) out
+          idx := idx + 1
+        return out
+    | some (.object pairs) =>
+      if pairs.isEmpty then
+        otherwise ctx out
+      else
+        let mut out := out
+        let mut idx := 0
+        for (key, value) in pairs do
+          out ← body (ctx.pushScope (wrapValue value) (loopMetaAt idx pairs.size (some key))) out
+          idx := idx + 1
+        return out
+    | _ => otherwise ctx out
+
+/-- With block: push the value as a section scope when truthy -/
+private def emitWith (path : String) (body otherwise : Emit) : Emit := fun ctx out =>
+  match ctx.lookup path with
+  | some v => if v.isTruthy then body (ctx.pushSectionScope v) out else otherwise ctx out
+  | none => otherwise ctx out
+
+/-- Let block: evaluate bindings and merge them into the data -/
+private def emitLet (bindings : List (String × Expr)) (body : Emit) : Emit := fun ctx out => do
+  let values ← bindings.mapM fun (name, expr) => do return (name, ← eval expr ctx)
+  body (ctx.mergeData (.object values.toArray)) out
+
+/-- Repeat block -/
+private def emitRepeat (countExpr : Expr) (body : Emit) : Emit := fun ctx out => do
+  let count := match ← eval countExpr ctx with
+    | .int n => if n > 0 then n.toNat else 0
+    | _ => 0
+  let mut out := out
+  for idx in [:count] do
+    out ← body (ctx.pushScope (.int idx) (loopMetaAt idx count)) out
+  return out
+
+/-- Range block -/
+private def emitRange (startExpr endExpr : Expr) (body : Emit) : Emit := fun ctx out => do
+  let startVal ← eval startExpr ctx
+  let endVal ← eval endExpr ctx
+  let (startN, endN) := match startVal, endVal with
+    | .int s, .int e => (s, e)
+    | _, _ => (0, 0)
+  if startN >= endN then
+    return out
+  let count := (endN - startN).toNat
+  let mut out := out
+  for offset in [:count] do
+    out ← body (ctx.pushScope (.int (startN + offset)) (loopMetaAt offset count)) out
+  return out
+
+/-- Context for a partial: optional context argument, hash params merged on top -/
+private def partialContext (context : Option Expr) (params : List (String × Expr))
+    (ctx : Context) : RenderResult Context := do
+  let base ← match context with
+    | some contextExpr => do pure (ctx.withData (← eval contextExpr ctx))
+    | none => pure ctx
+  if params.isEmpty then
+    return base
+  let values ← params.mapM fun (k, expr) => do return (k, ← eval expr ctx)
+  return base.mergeData (.object values.toArray)
+
+mutual
+  /-- Compile a node list, merging adjacent text and dropping comments -/
+  partial def compileNodes (partials : PartialRegistry) (depth : Nat) (nodes : List Node) : Emit := Id.run do
+    let mut parts : Array Emit := #[]
+    let mut text := ""
+    for node in nodes do
+      match node with
+      | .text s => text := text ++ s
+      | .comment _ => pure ()
+      | node =>
+        if !text.isEmpty then
+          parts := parts.push (emitText text)
+          text := ""
+        parts := parts.push (compileNode partials depth node)
+    if !text.isEmpty then
+      parts := parts.push (emitText text)
+    return emitSeq parts
+
+  /-- Inline a partial known at compile time; others are looked up at render time -/
+  partial def compilePartial (partials : PartialRegistry) (depth : Nat) (node : Node)
+      (name : String) (context : Option Expr) (params : List (String × Expr)) : Emit :=
+    match partials.get? name with
+    | some tmpl =>
+      if depth < maxInlineDepth then
+        let body := compileNodes partials (depth + 1) tmpl.nodes
+        fun ctx out => do body (← partialContext context params ctx) out
+      else
+        interpret node
+    | none => interpret node
+
+  /-- Compile a single node -/
+  partial def compileNode (partials : PartialRegistry) (depth : Nat) (node : Node) : Emit :=
+    let compileBody := compileNodes partials depth
+    match node with
+    | .text content => emitText content
+    | .comment _ => emitNone
+    | .variable ref => compileVariable ref
+    | .conditional branches elseBody inverted _ =>
+      emitBranches inverted (compileBody elseBody) (branches.map fun (c, b) => (c, compileBody b))
+    | .each config body elseBody _ => emitEach config (compileBody body) (compileBody elseBody)
+    | .«with» path body elseBody _ => emitWith path (compileBody body) (compileBody elseBody)
+    | .«let» bindings body _ => emitLet bindings (compileBody body)
+    | .repeat count body _ => emitRepeat count (compileBody body)
+    | .range start «end» body _ => emitRange start «end» (compileBody body)
+    | .«partial» name context params _ => compilePartial partials depth node name context params
+    -- Partial blocks, template inheritance and super depend on render-time
+    -- block state, so they stay interpreted
+    | .partialBlock .. | .extends .. | .block .. | .super .. => interpret node
+end
+
+/-- Compile a template. Partials found in `partials` are inlined and bound at
+    compile time, so recompile when they change; partials missing from the
+    registry are looked up in the render context as usual. Templates that
+    start with `extends` render through the interpreter. -/
+def compileTemplate (tmpl : Template) (partials : PartialRegistry := {}) : CompiledTemplate :=
+  match tmpl.nodes with
+  | .extends .. :: _ => ⟨fun ctx out => ((renderTemplate tmpl).run ctx).map (Html.renderInto out)⟩
+  | nodes => ⟨compileNodes partials 0 nodes⟩
+
+end Stencil.Render
+
+namespace Stencil.CompiledTemplate
+
+/-- Render a compiled template to a String -/
+def renderString (tmpl : CompiledTemplate) (ctx : Context) : RenderResult String :=
+  tmpl.run ctx ""
+
+/-- Render a compiled template, appending to an existing buffer -/
+def renderInto (tmpl : CompiledTemplate) (ctx : Context) (out : String) : RenderResult String :=
+  tmpl.run ctx out
+
+end Stencil.CompiledTemplate
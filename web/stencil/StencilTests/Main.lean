@@ -931,6 +931,117 @@ test "Parent path: in condition" := do
 
 
 
+-- Compiled Template Tests
+
+/-- Render through the interpreter and the compiled closures, expecting the same output -/
+def sameOutput (source : String) (ctx : Context) (partials : PartialRegistry := {}) : IO String := do
+  let tmpl ← shouldBeOk (parse source) "parsing"
+  let expected ← shouldBeOk (renderString tmpl ctx) "interpreting"
+  let actual ← shouldBeOk ((compileTemplate tmpl partials).renderString ctx) "running compiled"
+  actual ≡ expected
+  return actual
+
+test "Compiled: text, variables and escaping match the interpreter" := do
+  let ctx := context [("name", .string "<Tom & Jerry>"), ("html", .string "<b>bold</b>")]
+  let out ← sameOutput "Hi {{! note }}{{name}}, {{{html}}} and {{missing}}!" ctx
+  out ≡ "Hi &lt;Tom &amp; Jerry&gt;, <b>bold</b> and !"
+
+test "Compiled: sections match the interpreter" := do
+  let ctx := context [
+    ("prefix", .string "#"),
+    ("items", .array #[.string "a", .string "b", .string "c"]),
+    ("user", .object #[("name", .string "Ada")]),
+    ("dict", .object #[("x", .int 1), ("y", .int 2)]),
+    ("count", .int 2)
+  ]
+  let _ ← sameOutput "{{#each items}}{{../prefix}}{{@index}}={{this}}{{#if @last}}.{{else}},{{/if}}{{/each}}" ctx
+  let _ ← sameOutput "{{#each items as |item i|}}[{{i}}:{{item | uppercase}}]{{/each}}" ctx
+  let _ ← sameOutput "{{#each dict}}{{@key}}={{this}} {{/each}}{{#each nope}}x{{else}}empty{{/each}}" ctx
+  let _ ← sameOutput "{{#with user}}Hello {{name}}{{/with}}{{#with nope}}x{{else}}none{{/with}}" ctx
+  let _ ← sameOutput "{{#let x=5 y=\"hi\"}}{{x}}-{{y}}{{/let}}" ctx
+  let _ ← sameOutput "{{#repeat count}}{{@index}}{{/repeat}}|{{#range 1 4}}{{this}}{{/range}}" ctx
+  let out ← sameOutput "{{#if (count > 1) && (count < 5)}}many{{else if count}}one{{else}}none{{/if}}{{#unless nope}}!{{/unless}}" ctx
+  out ≡ "many!"
+
+test "Compiled: inlined partials match the interpreter" := do
+  let card ← shouldBeOk (parse "<div>{{title}}/{{name}}</div>") "parsing card"
+  let partials : PartialRegistry := ({} : PartialRegistry).insert "card" card
+  let ctx := { context [("name", .string "Bob"), ("person", .object #[("name", .string "Eve")])] with partials }
+  let _ ← sameOutput "{{> card title=\"Hello\"}}{{> card person}}" ctx partials
+  -- Partials missing from the compile-time registry are looked up at render time
+  let out ← sameOutput "{{> card title=\"Late\"}}" ctx
+  out ≡ "<div>Late/Bob</div>"
+
+test "Compiled: partial blocks and extends fall back to the interpreter" := do
+  let layout ← shouldBeOk (parse "<main>{{{@partialBlock}}}</main>") "parsing layout"
+  let base ← shouldBeOk (parse "<html>{{#block \"body\"}}Default{{/block}}</html>") "parsing base"
+  let ctx := Context.empty.addPartial "layout" layout |>.addPartial "base" base
+  let out ← sameOutput "{{#> layout}}<h1>Content</h1>{{/layout}}" ctx
+  out ≡ "<main><h1>Content</h1></main>"
+  let out ← sameOutput "{{#extends \"base\"}}{{#block \"body\"}}Custom{{/block}}" ctx
+  out ≡ "<html>Custom</html>"
+
+test "Compiled: custom filters registered at render time still win" := do
+  let customUpper : FilterFn := fun v _ _ => .ok (.string (v.toString.toUpper ++ "!"))
+  let ctx := context [("text", .string "hello")] |> (fun c => withFilter c "uppercase" customUpper)
+  let out ← sameOutput "{{text | uppercase}}" ctx
+  out ≡ "HELLO!"
+
+test "Compiled: unknown filter is still an error" := do
+  let tmpl ← shouldBeOk (parse "{{x | nosuchfilter}}") "parsing"
+  match (compileTemplate tmpl).renderString (context [("x", .int 1)]) with
+  | .error (.unknownFilter name _ _) => name ≡ "nosuchfilter"
+  | _ => throw (IO.userError "Expected unknownFilter")
+
+-- Template Cache Tests
+
+test "Cache evicts the least recently used entry" := do
+  let tmpl := parse! "x"
+  let cache := TemplateCache.withMaxSize 2
+    |>.putNamed "a" "a" tmpl
+    |>.putNamed "b" "b" tmpl
+  -- Touch "a" so "b" becomes the oldest
+  let (hit, cache) := cache.lookup ⟨"a", "a".hash⟩
+  shouldSatisfy hit.isSome "a should be cached"
+  let cache := cache.putNamed "c" "c" tmpl
+  cache.size ≡ 2
+  shouldSatisfy (cache.getNamed? "a" "a").isSome "recently used entry kept"
+  shouldSatisfy (cache.getNamed? "b" "b").isNone "oldest entry evicted"
+  shouldSatisfy (cache.getNamed? "c" "c").isSome "new entry added"
+
+test "Cache replacing an entry refreshes it instead of evicting" := do
+  let tmpl := parse! "x"
+  let cache := TemplateCache.withMaxSize 2
+    |>.putNamed "a" "a" tmpl
+    |>.putNamed "b" "b" tmpl
+    |>.putNamed "a" "a" tmpl
+  cache.size ≡ 2
+  -- "b" is now the oldest; repeated inserts keep evicting in order
+  let cache := cache.putNamed "c" "c" tmpl
+  shouldSatisfy (cache.getNamed? "b" "b").isNone "oldest entry evicted"
+  let cache := cache.putNamed "d" "d" tmpl
+  cache.size ≡ 2
+  shouldSatisfy (cache.getNamed? "a" "a").isNone "next oldest evicted"
+  shouldSatisfy (cache.getNamed? "c" "c").isSome "c kept"
+  shouldSatisfy (cache.getNamed? "d" "d").isSome "d added"
+
+test "Cache keys on name and content" := do
+  let cache := TemplateCache.empty
+    |>.putNamed "page" "v1" (parse! "one")
+    |>.putNamed "other" "v1" (parse! "two")
+  cache.size ≡ 2
+  shouldSatisfy (cache.getNamed? "page" "v2").isNone "changed content misses"
+
+test "Engine.compileCached reuses the compiled template" := do
+  let engine := Engine.new
+  let (r1, engine) := engine.compileCached "hello" "Hello {{name}}!"
+  let compiled ← shouldBeOk r1 "compiling"
+  let (r2, engine) := engine.compileCached "hello" "Hello {{name}}!"
+  let _ ← shouldBeOk r2 "cache hit"
+  engine.cacheSize ≡ 1
+  let out ← shouldBeOk (compiled.renderString (context [("name", .string "World")])) "rendering"
+  out ≡ "Hello World!"
+
 end Stencil.Tests
 
 def main : IO UInt32 := do